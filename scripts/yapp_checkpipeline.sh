@@ -0,0 +1,128 @@
+#!/bin/sh
+
+#
+# yapp_checkpipeline.sh
+# Check that the dedispersed time series of yapp_pipeline match those of
+#   yapp_dedisperse, for the same filterbank data file. The time series
+#   tapped from the pipeline end where its search ends, so only that much of
+#   the output of yapp_dedisperse is compared.
+#
+# Created by agent on 2026.10.19
+#
+
+PrintUsage()
+{
+    echo "Usage: $1 [options] <data-file>"
+    echo "    -h  --help                          Display this usage" \
+         "information"
+    echo "    -d  --dm <dm>[,<dm>...]             DMs to compare at"
+    echo "                                        (default is 0,50)"
+    echo "    -b  --bindir <dir>                  Directory of the YAPP" \
+         "binaries"
+    echo "                                        (default is to search" \
+         "\$PATH)"
+}
+
+ProgName=$0
+DMs="0,50"
+BinDir=""
+
+# parse the arguments
+while [ $# -gt 0 ]
+do
+    case "$1" in
+        -h|--help)
+            PrintUsage "$ProgName"
+            exit 0
+            ;;
+        -d|--dm)
+            DMs="$2"
+            shift 2
+            ;;
+        -b|--bindir)
+            BinDir="$2/"
+            shift 2
+            ;;
+        -*)
+            echo "ERROR: Unknown option $1!" >&2
+            PrintUsage "$ProgName"
+            exit 1
+            ;;
+        *)
+            break
+            ;;
+    esac
+done
+if [ $# -ne 1 ]
+then
+    echo "ERROR: Data file not specified!" >&2
+    PrintUsage "$ProgName"
+    exit 1
+fi
+FileData=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+FileStem=$(basename "$1" .fil)
+
+# run each program in a directory of its own, as both name their output files
+# after the data file
+WorkDir=$(mktemp -d) || exit 1
+trap 'rm -rf "$WorkDir"' EXIT
+mkdir "$WorkDir/dedisp" "$WorkDir/pipeline"
+ln -s "$FileData" "$WorkDir/dedisp/$FileStem.fil"
+ln -s "$FileData" "$WorkDir/pipeline/$FileStem.fil"
+
+(cd "$WorkDir/pipeline" \
+ && "${BinDir}yapp_pipeline" -d "$DMs" -o dedisp "$FileStem.fil") \
+    > "$WorkDir/pipeline.log" 2>&1
+if [ $? -ne 0 ]
+then
+    cat "$WorkDir/pipeline.log" >&2
+    echo "ERROR: yapp_pipeline failed!" >&2
+    exit 1
+fi
+
+for DM in $(echo "$DMs" | tr ',' ' ')
+do
+    (cd "$WorkDir/dedisp" \
+     && "${BinDir}yapp_dedisperse" -d "$DM" "$FileStem.fil") \
+        > "$WorkDir/dedisp.log" 2>&1
+    if [ $? -ne 0 ]
+    then
+        cat "$WorkDir/dedisp.log" >&2
+        echo "ERROR: yapp_dedisperse failed at DM $DM!" >&2
+        exit 1
+    fi
+done
+
+# both name a time series after the data file and its DM, so each time series
+# tapped from the pipeline has a counterpart of the same name
+Ret=0
+NumFiles=0
+for FileTim in $(cd "$WorkDir/pipeline" && ls *.tim)
+do
+    NumFiles=$((NumFiles + 1))
+    if [ ! -f "$WorkDir/dedisp/$FileTim" ]
+    then
+        echo "$FileTim: not written by yapp_dedisperse!"
+        Ret=1
+        continue
+    fi
+
+    # the headers and the samples must be the same, byte for byte
+    TapLen=$(wc -c < "$WorkDir/pipeline/$FileTim")
+    if cmp -n "$TapLen" \
+           "$WorkDir/dedisp/$FileTim" \
+           "$WorkDir/pipeline/$FileTim" > /dev/null
+    then
+        echo "$FileTim: matches."
+    else
+        echo "$FileTim: differs!"
+        Ret=1
+    fi
+done
+if [ $NumFiles -eq 0 ]
+then
+    echo "ERROR: yapp_pipeline wrote no time series!" >&2
+    exit 1
+fi
+
+exit $Ret
@@ -70,6 +70,9 @@ typedef enum CMap_e
 #define DEF_CMAP            CMAP_JET
 #define DEF_CMAP_STR        "jet"
 
+/* RGB values for all colour maps, defined in colourmap.c */
+extern const float g_aaafCMap[NUM_CMAPS][CMAP_LEVELS][3];
+
 int SetColourMap(int iCMap, float fColMin, float fColMax);
 int GetColourMapFromName(char *pcCMapName);
 /*
@@ -34,6 +34,8 @@
 
 #include <cpgplot.h>
 
+#include "yapp_lib.h"
+
 /**
  * @defgroup YAPPRet Standard YAPP return values.
  */
@@ -74,6 +76,8 @@
 #define EXT_DAT                     ".dat"
 #define EXT_INF                     ".inf"
 #define EXT_YAPP_PROFILE            ".ypr"
+#define EXT_CSV                     ".csv"
+#define EXT_SHM                     ".shm"
 
 enum tagFileFormats
 {
@@ -84,7 +88,9 @@ enum tagFileFormats
     /* dedispersed time series formats */
     YAPP_FORMAT_DTS_DDS,        /* Desh's dedispersed data format */
     YAPP_FORMAT_DTS_TIM,        /* SIGPROC time series format */
-    YAPP_FORMAT_DTS_DAT         /* PRESTO time series format */
+    YAPP_FORMAT_DTS_DAT,        /* PRESTO time series format */
+    /* streams */
+    YAPP_FORMAT_SHM             /* shared-memory ring buffer */
 };
 
 /* sample sizes in number of bits */
@@ -100,12 +106,16 @@ enum tagFileFormats
 
 #define INFIX_SMOOTH                "smooth"
 #define INFIX_SUB                   "sub"
+#define INFIX_CALC                  "calc"
 #define INFIX_FILTER                "filt"
 #define INFIX_DEDISPERSE            "dm"
 #define INFIX_SUBBAND               "band"
 #define INFIX_ADD                   "sum"
 #define INFIX_FOLD                  "fold"
 #define INFIX_STACK                 "stack"
+#define INFIX_ALLDM                 "alldm" /* merged across DMs */
+#define INFIX_COINC                 "coinc" /* multi-beam coincidences
+                                               removed */
 
 #define SUFFIX_CFG                  "_cfg"
 
@@ -126,6 +136,9 @@ enum tagFileFormats
    best the plots) doesn't happen properly */
 #define MAX_SIZE_BLOCK      65536   /**< @brief Maximum data read size */
 #define MAX_SIZE_BLOCK_FOLD 1048576  /**< @brief Maximum data read size */
+#define SIZE_COPY_BUF       1048576 /**< @brief Size of the buffer used to
+                                         copy data, when the kernel cannot
+                                         copy it directly */
 
 #define MAX_SNR_BINS        50      /**< @brief Number of SNR bins */
 #define MAX_PNUM_BINS       50
@@ -271,6 +284,20 @@ enum tagFileFormats
 
 #define YAPP_MAX_MEMTABLE       1024
 
+#define YAPP_SP_HDRBLOCK        8192    /* size of the first read of a SIGPROC
+                                           header - enough for the whole
+                                           header, unless it lists the
+                                           frequency of every channel */
+#define YAPP_SP_MAXHDRSIZE      (4 * 1024 * 1024)   /* largest SIGPROC header
+                                                       read - enough for the
+                                                       frequencies of 200k
+                                                       channels */
+
+#define YAPP_STATS_XATTR        "user.yapp.stats"   /* extended attribute
+                                                       holding the cached
+                                                       statistics of a file */
+#define YAPP_STATS_VERSION      1
+
 #define YAPP_DEGPERHOUR         15              /* degrees per hour */
 
 /**
@@ -399,6 +426,23 @@ typedef struct YUM_s
     float fThreshold;
 #endif
 } YUM_t;
+
+/**
+ * Statistics of a data file, as cached in YAPP_STATS_XATTR, with the size and
+ * modification time of the file when they were calculated
+ */
+typedef struct tagStatsCache
+{
+    int iVersion;
+    int iHeaderLen;
+    long int lSize;
+    long int lMTimeSec;
+    long int lMTimeNSec;
+    float fMin;
+    float fMax;
+    float fMean;
+    float fRMS;
+} YAPP_STATS_CACHE;
 /* TODO: call this YAPP_YUM */
 
 #if 0
@@ -489,7 +533,8 @@ int YAPP_ReadPSRFITSHeader(char *pcFileSpec, YUM_t *pstYUM);
 int YAPP_ReadDASCfg(char *pcFileSpec, YUM_t *pstYUM);
 
 /**
- * Read configuration information corresponding to a SIGPROC '.fil' file
+ * Read configuration information corresponding to a SIGPROC '.fil' file. The
+ * header is read into memory in one go, and parsed from there.
  *
  * @param[in]       pcFileSpec          Data filename
  * @param[in]       iFormat             Data file type
@@ -525,8 +570,43 @@ int YAPP_ReadData(FILE *pFData,
                   float fSampSize,
                   int iTotSampsPerBlock);
 
+/**
+ * Convert raw samples to floating-point. Unlike YAPP_ReadData(), this keeps no
+ * internal state, so it may be called from multiple threads.
+ *
+ * @param[in]       pcBuf               Raw data buffer
+ * @param[out]      pfBuf               Output data buffer
+ * @param[in]       fSampSize           Size of a sample, in bytes
+ * @param[in]       iNumItems           Number of samples to convert
+ */
+int YAPP_UnpackData(char *pcBuf,
+                    float *pfBuf,
+                    float fSampSize,
+                    int iNumItems);
+
+/**
+ * Describe filterbank data to the libyapp kernels. The channels are in the
+ * order of the data, so the first channel is the highest if the band is
+ * flipped.
+ *
+ * @param[in]       pstYUM              Metadata
+ * @param[out]      pstMeta             libyapp metadata
+ */
+void YAPP_GetLibMeta(YUM_t *pstYUM, YAPP_LIB_META *pstMeta);
+
 int YAPP_WriteMetadata(char *pcFileData, int iFormat, YUM_t stYUM);
 
+/**
+ * Copy the data in a file, from an offset to the end of the file, to the
+ * current position of an output file. Where possible, the data is copied by
+ * the kernel, without passing through user space.
+ *
+ * @param[in]       pcFileData          Input data filename
+ * @param[in]       lOffset             Offset of the data, in bytes
+ * @param[in]       pFOut               Output file
+ */
+int YAPP_CopyFileData(char *pcFileData, off_t lOffset, FILE *pFOut);
+
 /**
  * Calculates the threshold in terms of standard deviation.
  *
@@ -563,13 +643,40 @@ double YAPP_RAString2Double(char *pcRA);
 double YAPP_DecString2Double(char *pcDec);
 void YAPP_RADouble2String(double dRA, char *pcRA);
 void YAPP_DecDouble2String(double dDec, char *pcDec);
+/**
+ * Calculate the minimum, maximum, mean and RMS of the data in a file. If
+ * g_cWriteStatsCache is set, the statistics are cached in an extended
+ * attribute of the file, where supported. Cached values are used for as long
+ * as the file is unchanged, unless g_cUseStatsCache is cleared.
+ *
+ * @param[in]       pcFileData          Data filename
+ * @param[in]       iFormat             Data file type
+ * @param[inout]    pstYUM              YUM structure
+ */
 int YAPP_CalcStats(char *pcFileData, int iFormat, YUM_t *pstYUM);
+
+/**
+ * Read the statistics of a file from its cache, if they are still valid
+ *
+ * @param[in]       pcFileData          Data filename
+ * @param[inout]    pstYUM              YUM structure
+ */
+int YAPP_ReadStatsCache(char *pcFileData, YUM_t *pstYUM);
+
+/**
+ * Cache the statistics of a file, if the file system supports it
+ *
+ * @param[in]       pcFileData          Data filename
+ * @param[in]       pstYUM              YUM structure
+ */
+int YAPP_WriteStatsCache(char *pcFileData, YUM_t *pstYUM);
 float YAPP_CalcMean(float *pfBuf, int iLength, int iOffset, int iStride);
 float YAPP_CalcRMS(float *pfBuf,
                    int iLength,
                    int iOffset,
                    int iStride,
                    float fMean);
+float YAPP_CalcMedian(float *pfBuf, int iLength);
 /*
  * The memory allocator
  */
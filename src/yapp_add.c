@@ -1,13 +1,24 @@
 /*
  * @file yapp_add.c
  * Program to coherently add dedispersed time series data for different
- *  frequency bands.
+ *  frequency bands. Each band is read by its own thread, ahead of the
+ *  summing, and the bands are summed in band order, so that the output does
+ *  not depend on the order in which the reads complete. The dispersion
+ *  delay of each band is removed in two parts - whole samples are skipped,
+ *  and the remaining fraction of a sample is removed by a windowed-sinc
+ *  interpolating filter, so that narrow pulses are not smeared by the sum.
  *
  * @verbatim
  * Usage: yapp_add [options] <data-file-maxfreq> ... <data-file-minfreq>
  *     -h  --help                           Display this usage information
  *     -n  --nsamp <samples>                Number of samples read in one block
  *                                          (default is 4096 samples)
+ *     -w  --weight <scheme>                Band weighting scheme - 'bw'
+ *                                          (proportional to bandwidth),
+ *                                          'snr' (inversely proportional to
+ *                                          variance), or a comma-separated
+ *                                          list of weights, one per band
+ *                                          (default is equal weights)
  *     -g  --graphics                       Turn on plotting
  *     -i  --invert                         Invert the background and foreground
  *                                          colours in plots
@@ -20,8 +31,17 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
-
-int CalcOffset(float fFMax, float fFMin, double dTSamp, double dDM);
+#include "yapp_add.h"
+#include "yapp_lib.h"       /* for the dispersion delays */
+
+double CalcDelay(float fFMax, float fFMin, double dTSamp, double dDM);
+static void MakeFracDelayTaps(float fFrac, float *pfTaps);
+static int ReadSamps(YAPP_ADD_BAND *pstBand, float *pfBuf, int iNumSamps);
+static int StartReaders(int iNumBands);
+static float* WaitBlock(YAPP_ADD_BAND *pstBand, int iBuf);
+static void ReleaseBlock(YAPP_ADD_BAND *pstBand);
+static void StopReaders(void);
+static void CleanUp(void);
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -34,7 +54,8 @@ extern int g_iPGDev;
 
 /* the following are global only to enable cleaning up in case of abnormal
    termination, such as those triggered by SIGINT or SIGTERM */
-float **g_ppfBuf = NULL;
+YAPP_ADD_BAND *g_pstBands = NULL;
+int g_iNumReaders = 0;      /* number of reader threads running */
 float *g_pfOutBuf = NULL;
 float *g_pfXAxis = NULL;
 
@@ -49,8 +70,16 @@ int main(int argc, char *argv[])
     YUM_t stYUM = {{0}};
     float *pafMaxFreq = NULL;
     float *pafMinFreq = NULL;
+    float *pfWeight = NULL;
+    int iWeightScheme = YAPP_ADD_WEIGHT_NONE;
+    char *pcWeights = NULL;
+    char *pcToken = NULL;
+    float fWeight = 0.0;
+    float fWeightSum = 0.0;
+    YAPP_ADD_BAND *pstBand = NULL;
+    float *pfBand = NULL;
+    int iBuf = 0;
     int iBlockSize = DEF_SIZE_BLOCK;
-    int iTotSampsPerBlock = 0;  /* iBlockSize */
     double dTSampInSec = 0.0;   /* holds sampling time in s */
     int iNumReads = 0;
     int iTotNumReads = 0;
@@ -59,13 +88,13 @@ int main(int argc, char *argv[])
     int iRet = YAPP_RET_SUCCESS;
     float fDataMin = 0.0;
     float fDataMax = 0.0;
-    int iReadItems = 0;
     float fButX = 0.0;
     float fButY = 0.0;
     char cCurChar = 0;
     int iNumSamps = 0;
-    int iDiff = 0;
     int *paiOffset = NULL;
+    float *pfFracDelay = NULL;
+    double dDelay = 0.0;
     int i = 0;
     int j = 0;
     char acLabel[LEN_GENSTRING] = {0};
@@ -75,11 +104,12 @@ int main(int argc, char *argv[])
     const char *pcProgName = NULL;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hn:giev";
+    const char* const pcOptsShort = "hn:w:giev";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
         { "nsamp",                  1, NULL, 'n' },
+        { "weight",                 1, NULL, 'w' },
         { "graphics",               0, NULL, 'g' },
         { "invert",                 0, NULL, 'i' },
         { "non-interactive",        0, NULL, 'e' },
@@ -114,6 +144,25 @@ int main(int argc, char *argv[])
                 }
                 break;
 
+            case 'w':   /* -w or --weight */
+                /* set option */
+                if (0 == strcmp(optarg, "bw"))
+                {
+                    iWeightScheme = YAPP_ADD_WEIGHT_BW;
+                }
+                else if (0 == strcmp(optarg, "snr"))
+                {
+                    iWeightScheme = YAPP_ADD_WEIGHT_SNR;
+                }
+                else
+                {
+                    /* list of weights, parsed once the number of bands is
+                       known */
+                    iWeightScheme = YAPP_ADD_WEIGHT_LIST;
+                    pcWeights = optarg;
+                }
+                break;
+
             case 'g':   /* -g or --graphics */
                 /* set option */
                 cHasGraphics = YAPP_TRUE;
@@ -183,14 +232,14 @@ int main(int argc, char *argv[])
         {
             (void) fprintf(stderr,
                            "ERROR: File type determination failed!\n");
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
         if (iFormat != YAPP_FORMAT_DTS_TIM)
         {
             (void) fprintf(stderr,
                            "ERROR: Invalid file type!\n");
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
     }
@@ -209,7 +258,7 @@ int main(int argc, char *argv[])
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
     pafMinFreq = (float *) YAPP_Malloc((size_t) iNumBands,
@@ -220,7 +269,31 @@ int main(int argc, char *argv[])
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    /* allocate memory for the weights array */
+    pfWeight = (float *) YAPP_Malloc((size_t) iNumBands,
+                                     sizeof(float),
+                                     YAPP_FALSE);
+    if (NULL == pfWeight)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    /* allocate memory for the fractional delays array */
+    pfFracDelay = (float *) YAPP_Malloc((size_t) iNumBands,
+                                        sizeof(float),
+                                        YAPP_TRUE);
+    if (NULL == pfFracDelay)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
         return YAPP_RET_ERROR;
     }
     /* allocate memory for the offsets array */
@@ -232,7 +305,7 @@ int main(int argc, char *argv[])
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
     for (i = optind; i < argc; ++i)
@@ -244,14 +317,86 @@ int main(int argc, char *argv[])
             (void) fprintf(stderr,
                            "ERROR: Reading metadata failed for file %s!\n",
                            argv[i]);
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
         pafMaxFreq[i-optind] = stYUM.fFMax;
         pafMinFreq[i-optind] = stYUM.fFMin;
+        switch (iWeightScheme)
+        {
+            case YAPP_ADD_WEIGHT_BW:
+                pfWeight[i-optind] = stYUM.fBW;
+                break;
+
+            case YAPP_ADD_WEIGHT_SNR:
+                if (0.0 == stYUM.fRMS)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Zero variance in file %s!\n",
+                                   argv[i]);
+                    CleanUp();
+                    return YAPP_RET_ERROR;
+                }
+                pfWeight[i-optind] = 1.0 / (stYUM.fRMS * stYUM.fRMS);
+                break;
+
+            default:
+                pfWeight[i-optind] = 1.0;
+                break;
+        }
+    }
+
+    /* compute the weights - computed weights are normalised to a mean of 1,
+       so that the sum has the same scale as an unweighted sum, and weights
+       given by the user are used as they are */
+    if (YAPP_ADD_WEIGHT_LIST == iWeightScheme)
+    {
+        i = 0;
+        pcToken = strtok(pcWeights, ",");
+        while (pcToken != NULL)
+        {
+            if (i < iNumBands)
+            {
+                pfWeight[i] = atof(pcToken);
+            }
+            ++i;
+            pcToken = strtok(NULL, ",");
+        }
+        if (i != iNumBands)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Number of weights (%d) does not match "
+                           "number of bands (%d)!\n",
+                           i,
+                           iNumBands);
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+    else if (iWeightScheme != YAPP_ADD_WEIGHT_NONE)
+    {
+        fWeightSum = 0.0;
+        for (i = 0; i < iNumBands; ++i)
+        {
+            fWeightSum += pfWeight[i];
+        }
+        for (i = 0; i < iNumBands; ++i)
+        {
+            pfWeight[i] *= (iNumBands / fWeightSum);
+        }
+    }
+    if (iWeightScheme != YAPP_ADD_WEIGHT_NONE)
+    {
+        for (i = 0; i < iNumBands; ++i)
+        {
+            (void) printf("Weight of band %-2d                 : %g\n",
+                          i,
+                          pfWeight[i]);
+        }
     }
     /* calculate the maximum offsets in each band, relative to the highest
-       frequency one */
+       frequency one, as a whole number of samples, and the remaining
+       fraction of a sample */
     paiOffset[0] = 0;
     for (i = 1; i < iNumBands; ++i)
     {
@@ -262,13 +407,24 @@ int main(int argc, char *argv[])
         {
             (void) fprintf(stderr,
                            "ERROR: Files not in correct order!\n");
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
-        paiOffset[i] = CalcOffset(pafMaxFreq[0],
-                                  pafMaxFreq[i],
-                                  stYUM.dTSamp,
-                                  stYUM.dDM);
+        dDelay = CalcDelay(pafMaxFreq[0],
+                           pafMaxFreq[i],
+                           stYUM.dTSamp,
+                           stYUM.dDM);
+        paiOffset[i] = (int) floor(dDelay);
+        pfFracDelay[i] = (float) (dDelay - paiOffset[i]);
+        if (pfFracDelay[i] < YAPP_ADD_FRAC_MIN)
+        {
+            pfFracDelay[i] = 0.0;
+        }
+        else if (pfFracDelay[i] > (1.0 - YAPP_ADD_FRAC_MIN))
+        {
+            ++paiOffset[i];
+            pfFracDelay[i] = 0.0;
+        }
     }
 
     /* convert sampling interval to seconds */
@@ -277,9 +433,6 @@ int main(int argc, char *argv[])
     iNumReads = (int) ceilf(((float) stYUM.iTimeSamps) / iBlockSize);
     iTotNumReads = iNumReads;
 
-    /* optimisation - store some commonly used values in variables */
-    iTotSampsPerBlock = iBlockSize;
-
     /* open the time series data files for reading */
     /* allocate memory for the file pointer array */
     ppFIn = (FILE **) YAPP_Malloc((size_t) iNumBands,
@@ -290,7 +443,7 @@ int main(int argc, char *argv[])
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
     for (i = optind; i < argc; ++i)
@@ -302,7 +455,7 @@ int main(int argc, char *argv[])
                            "ERROR: Opening file %s failed! %s.\n",
                            argv[i],
                            strerror(errno));
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
 
@@ -315,32 +468,76 @@ int main(int argc, char *argv[])
                      SEEK_CUR);
     }
 
-    /* allocate memory for the buffer pointer array */
-    g_ppfBuf = (float **) YAPP_Malloc((size_t) iNumBands,
-                                      sizeof(float *),
-                                      YAPP_FALSE);
-    if (NULL == g_ppfBuf)
+    /* allocate memory for the reader state and buffers of each band */
+    g_pstBands = (YAPP_ADD_BAND *) YAPP_Malloc((size_t) iNumBands,
+                                               sizeof(YAPP_ADD_BAND),
+                                               YAPP_TRUE);
+    if (NULL == g_pstBands)
     {
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
-    /* allocate memory for the buffer */
     for (i = 0; i < iNumBands; ++i)
     {
-        g_ppfBuf[i] = (float *) YAPP_Malloc((size_t) iBlockSize,
-                                            sizeof(float),
-                                            YAPP_FALSE);
-        if (NULL == g_ppfBuf[i])
+        pstBand = &g_pstBands[i];
+        pstBand->pFIn = ppFIn[i];
+        pstBand->fSampSize = stYUM.fSampSize;
+        pstBand->iBlockSize = iBlockSize;
+        pstBand->iNumReads = iNumReads;
+        pstBand->pcRawBuf = (char *) YAPP_Malloc(
+                                (size_t) ((iBlockSize + YAPP_ADD_SINC_HALFLEN)
+                                          * stYUM.fSampSize),
+                                sizeof(char),
+                                YAPP_FALSE);
+        if (NULL == pstBand->pcRawBuf)
         {
             (void) fprintf(stderr,
                            "ERROR: Memory allocation failed! %s!\n",
                            strerror(errno));
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
+        if (pfFracDelay[i] != 0.0)
+        {
+            pstBand->pfTaps = (float *) YAPP_Malloc(
+                                            (size_t) (2
+                                                      * YAPP_ADD_SINC_HALFLEN),
+                                            sizeof(float),
+                                            YAPP_FALSE);
+            pstBand->pfLine = (float *) YAPP_Malloc(
+                                            (size_t) (iBlockSize
+                                                      + (2
+                                                      * YAPP_ADD_SINC_HALFLEN)
+                                                      - 1),
+                                            sizeof(float),
+                                            YAPP_TRUE);
+            if ((NULL == pstBand->pfTaps) || (NULL == pstBand->pfLine))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+            MakeFracDelayTaps(pfFracDelay[i], pstBand->pfTaps);
+        }
+        for (j = 0; j < YAPP_ADD_NUMBUFS; ++j)
+        {
+            pstBand->apfBuf[j] = (float *) YAPP_Malloc((size_t) iBlockSize,
+                                                       sizeof(float),
+                                                       YAPP_FALSE);
+            if (NULL == pstBand->apfBuf[j])
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
     }
 
     if (1 == iNumReads)
@@ -375,7 +572,7 @@ int main(int argc, char *argv[])
         (void) fprintf(stderr,
                        "ERROR: Writing metadata failed for file %s!\n",
                        acFileOut);
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
 
@@ -387,7 +584,7 @@ int main(int argc, char *argv[])
                        "ERROR: Opening file %s failed! %s.\n",
                        acFileOut,
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
 
@@ -401,7 +598,7 @@ int main(int argc, char *argv[])
                            "ERROR: Opening graphics device %s failed!\n",
                            PG_DEV);
             (void) fclose(pFOut);
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
 
@@ -425,7 +622,7 @@ int main(int argc, char *argv[])
                            "ERROR: Memory allocation for X-axis failed! %s!\n",
                            strerror(errno));
             (void) fclose(pFOut);
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
     }
@@ -441,7 +638,17 @@ int main(int argc, char *argv[])
                        "%s!\n",
                        strerror(errno));
         (void) fclose(pFOut);
-        YAPP_CleanUp();
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* start reading all bands */
+    iRet = StartReaders(iNumBands);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Starting reader threads failed!\n");
+        (void) fclose(pFOut);
+        CleanUp();
         return YAPP_RET_ERROR;
     }
 
@@ -452,48 +659,37 @@ int main(int argc, char *argv[])
                       iReadBlockCount + 1,
                       iTotNumReads);
         (void) fflush(stdout);
-        for (i = 0; i < iNumBands; ++i)
+        /* sum the time series in band order - the inner loop runs over
+           contiguous samples, so that it can be vectorised */
+        /* NOTE: iNumSamps is that of the shortest band; the other bands are
+                 zero-padded by the readers, so the samples beyond the end of
+                 a band do not contribute to the sum */
+        iBuf = iReadBlockCount % YAPP_ADD_NUMBUFS;
+        iNumSamps = iBlockSize;
+        (void) memset(g_pfOutBuf, '\0', sizeof(float) * iBlockSize);
+        for (j = 0; j < iNumBands; ++j)
         {
-            iReadItems = YAPP_ReadData(ppFIn[i],
-                                       g_ppfBuf[i],
-                                       stYUM.fSampSize,
-                                       iTotSampsPerBlock);
-            if (YAPP_RET_ERROR == iReadItems)
+            pfBand = WaitBlock(&g_pstBands[j], iBuf);
+            if (NULL == pfBand)
             {
                 (void) fprintf(stderr, "ERROR: Reading data failed!\n");
                 (void) fclose(pFOut);
-                YAPP_CleanUp();
+                CleanUp();
                 return YAPP_RET_ERROR;
             }
-
-            if (iReadItems < iTotSampsPerBlock)
+            if (g_pstBands[j].aiNumSamps[iBuf] < iNumSamps)
             {
-                iDiff = iBlockSize - iReadItems;
-
-                /* reset remaining elements to '\0' */
-                (void) memset((g_ppfBuf[0] + iReadItems),
-                              '\0',
-                              (sizeof(float) * iDiff));
+                iNumSamps = g_pstBands[j].aiNumSamps[iBuf];
             }
-
-            /* calculate the number of time samples in the block - this may not
-               be iBlockSize for the last block, and should be iBlockSize for
-               all other blocks */
-            iNumSamps = iReadItems;
-        }
-        --iNumReads;
-        ++iReadBlockCount;
-
-        /* zero the accumulator */
-        (void) memset(g_pfOutBuf, '\0', sizeof(float) * iBlockSize);
-        /* sum the time series */
-        for (i = 0; i < iBlockSize; ++i)
-        {
-            for (j = 0; j < iNumBands; ++j)
+            fWeight = pfWeight[j];
+            for (i = 0; i < iBlockSize; ++i)
             {
-                g_pfOutBuf[i] += g_ppfBuf[j][i];
+                g_pfOutBuf[i] += fWeight * pfBand[i];
             }
+            ReleaseBlock(&g_pstBands[j]);
         }
+        --iNumReads;
+        ++iReadBlockCount;
 
         /* write summed data to file */
         (void) fwrite(g_pfOutBuf,
@@ -615,7 +811,7 @@ int main(int argc, char *argv[])
                             (void) usleep(PG_BUT_CL_SLEEP);
 
                             (void) fclose(pFOut);
-                            YAPP_CleanUp();
+                            CleanUp();
                             return YAPP_RET_SUCCESS;
                         }
                     }
@@ -637,27 +833,316 @@ int main(int argc, char *argv[])
     (void) printf("DONE!\n");
 
     (void) fclose(pFOut);
-    YAPP_CleanUp();
+    CleanUp();
 
     return YAPP_RET_SUCCESS;
 }
 
 
 /*
- * Calculate start offset for a band
+ * Calculate the dispersion delay of a band, in samples
  */
-int CalcOffset(float fFMax, float fFMin, double dTSamp, double dDM)
+double CalcDelay(float fFMax, float fFMin, double dTSamp, double dDM)
 {
     double dDelay = 0.0;
-    int iOffset = 0;
 
-    dDelay = (double) -4.148741601e6
-             * (((double) 1.0 / pow(fFMax, 2.0))
-                - ((double) 1.0 / pow(fFMin, 2.0)))
-             * dDM;    /* in ms */
-    iOffset = (int) (dDelay / dTSamp);
+    dDelay = YAPP_LIB_CalcDelay(fFMin, fFMax, dDM, YAPP_LIB_LAW);  /* in s */
+
+    return ((dDelay * 1e3) / dTSamp);
+}
+
+
+/*
+ * Compute the taps of a filter that advances a time series by a fraction of
+ * a sample - tap j multiplies the sample (j - YAPP_ADD_SINC_HALFLEN + 1)
+ * samples after the output sample. The sinc is tapered by a Hann window, and
+ * the taps are normalised to unit gain at zero frequency.
+ */
+static void MakeFracDelayTaps(float fFrac, float *pfTaps)
+{
+    double dT = 0.0;
+    double dSum = 0.0;
+    int j = 0;
+
+    for (j = 0; j < (2 * YAPP_ADD_SINC_HALFLEN); ++j)
+    {
+        dT = (double) (j - YAPP_ADD_SINC_HALFLEN + 1) - fFrac;
+        pfTaps[j] = (float) ((sin(M_PI * dT) / (M_PI * dT))
+                             * 0.5 * (1.0 + cos(M_PI * dT
+                                                / YAPP_ADD_SINC_HALFLEN)));
+        dSum += pfTaps[j];
+    }
+    for (j = 0; j < (2 * YAPP_ADD_SINC_HALFLEN); ++j)
+    {
+        pfTaps[j] = (float) (pfTaps[j] / dSum);
+    }
+
+    return;
+}
+
+
+/*
+ * Reader thread
+ */
+void* YAPP_ADD_ReadBand(void *pvBand)
+{
+    YAPP_ADD_BAND *pstBand = (YAPP_ADD_BAND *) pvBand;
+    float *pfBuf = NULL;
+    float *pfLine = NULL;
+    float *pfTaps = NULL;
+    float fSum = 0.0;
+    long lNumLeft = 0;
+    int iReadItems = 0;
+    int iNumSamps = 0;
+    int iBlock = 0;
+    int iBuf = 0;
+    int i = 0;
+    int j = 0;
+
+    for (iBlock = 0; iBlock < pstBand->iNumReads; ++iBlock)
+    {
+        /* wait for a free buffer */
+        (void) pthread_mutex_lock(&pstBand->stMutex);
+        while ((YAPP_ADD_NUMBUFS == pstBand->iNumFilled) && !(pstBand->cStop))
+        {
+            (void) pthread_cond_wait(&pstBand->stCond, &pstBand->stMutex);
+        }
+        if (pstBand->cStop)
+        {
+            (void) pthread_mutex_unlock(&pstBand->stMutex);
+            break;
+        }
+        (void) pthread_mutex_unlock(&pstBand->stMutex);
 
-    return iOffset;
+        iBuf = iBlock % YAPP_ADD_NUMBUFS;
+        pfBuf = pstBand->apfBuf[iBuf];
+        if (NULL == pstBand->pfTaps)
+        {
+            iReadItems = ReadSamps(pstBand, pfBuf, pstBand->iBlockSize);
+            if (YAPP_RET_ERROR == iReadItems)
+            {
+                pstBand->iRet = YAPP_RET_ERROR;
+                break;
+            }
+            pstBand->aiNumSamps[iBuf] = iReadItems;
+        }
+        else
+        {
+            /* keep the samples of the line that the filter needs again, and
+               read the rest - the first read fills the look-ahead as well,
+               after YAPP_ADD_SINC_HALFLEN - 1 zeros of history */
+            if (0 == iBlock)
+            {
+                pfLine = pstBand->pfLine + (YAPP_ADD_SINC_HALFLEN - 1);
+                iNumSamps = pstBand->iBlockSize + YAPP_ADD_SINC_HALFLEN;
+            }
+            else
+            {
+                (void) memmove(pstBand->pfLine,
+                               pstBand->pfLine + pstBand->iBlockSize,
+                               (sizeof(float)
+                                * ((2 * YAPP_ADD_SINC_HALFLEN) - 1)));
+                pfLine = pstBand->pfLine + ((2 * YAPP_ADD_SINC_HALFLEN) - 1);
+                iNumSamps = pstBand->iBlockSize;
+            }
+            iReadItems = ReadSamps(pstBand, pfLine, iNumSamps);
+            if (YAPP_RET_ERROR == iReadItems)
+            {
+                pstBand->iRet = YAPP_RET_ERROR;
+                break;
+            }
+            pstBand->lNumAvail += iReadItems;
+
+            /* filter */
+            pfLine = pstBand->pfLine;
+            pfTaps = pstBand->pfTaps;
+            for (i = 0; i < pstBand->iBlockSize; ++i)
+            {
+                fSum = 0.0;
+                for (j = 0; j < (2 * YAPP_ADD_SINC_HALFLEN); ++j)
+                {
+                    fSum += pfTaps[j] * pfLine[i+j];
+                }
+                pfBuf[i] = fSum;
+            }
+
+            /* the number of samples of this block that were read */
+            lNumLeft = pstBand->lNumAvail
+                       - ((long) iBlock * pstBand->iBlockSize);
+            if (lNumLeft > pstBand->iBlockSize)
+            {
+                lNumLeft = pstBand->iBlockSize;
+            }
+            else if (lNumLeft < 0)
+            {
+                lNumLeft = 0;
+            }
+            pstBand->aiNumSamps[iBuf] = (int) lNumLeft;
+        }
+
+        /* hand the block over to the main thread */
+        (void) pthread_mutex_lock(&pstBand->stMutex);
+        ++pstBand->iNumFilled;
+        (void) pthread_cond_broadcast(&pstBand->stCond);
+        (void) pthread_mutex_unlock(&pstBand->stMutex);
+    }
+
+    (void) pthread_mutex_lock(&pstBand->stMutex);
+    pstBand->cIsDone = YAPP_TRUE;
+    (void) pthread_cond_broadcast(&pstBand->stCond);
+    (void) pthread_mutex_unlock(&pstBand->stMutex);
+
+    return NULL;
+}
+
+
+/*
+ * Read samples of a band, zero-padding the buffer past the end of the data,
+ * and return the number of samples read
+ */
+static int ReadSamps(YAPP_ADD_BAND *pstBand, float *pfBuf, int iNumSamps)
+{
+    int iReadItems = 0;
+
+    /* YAPP_ReadData() is not used, as its byte buffer is shared by all
+       callers */
+    iReadItems = fread(pstBand->pcRawBuf,
+                       sizeof(char),
+                       (size_t) (iNumSamps * pstBand->fSampSize),
+                       pstBand->pFIn);
+    if (ferror(pstBand->pFIn))
+    {
+        (void) fprintf(stderr, "ERROR: File read failed!\n");
+        return YAPP_RET_ERROR;
+    }
+    iReadItems = (int) ((float) iReadItems / pstBand->fSampSize);
+    (void) YAPP_UnpackData(pstBand->pcRawBuf,
+                           pfBuf,
+                           pstBand->fSampSize,
+                           iReadItems);
+    if (iReadItems < iNumSamps)
+    {
+        /* reset remaining elements to '\0' */
+        (void) memset((pfBuf + iReadItems),
+                      '\0',
+                      (sizeof(float) * (iNumSamps - iReadItems)));
+    }
+
+    return iReadItems;
+}
+
+
+/*
+ * Start the reader threads
+ */
+static int StartReaders(int iNumBands)
+{
+    YAPP_ADD_BAND *pstBand = NULL;
+    int iRet = 0;
+    int i = 0;
+
+    for (i = 0; i < iNumBands; ++i)
+    {
+        pstBand = &g_pstBands[i];
+        pstBand->iRet = YAPP_RET_SUCCESS;
+        (void) pthread_mutex_init(&pstBand->stMutex, NULL);
+        (void) pthread_cond_init(&pstBand->stCond, NULL);
+        iRet = pthread_create(&pstBand->stThread,
+                              NULL,
+                              YAPP_ADD_ReadBand,
+                              (void *) pstBand);
+        if (iRet != 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Creating thread failed! %s!\n",
+                           strerror(iRet));
+            (void) pthread_cond_destroy(&pstBand->stCond);
+            (void) pthread_mutex_destroy(&pstBand->stMutex);
+            StopReaders();
+            return YAPP_RET_ERROR;
+        }
+        ++g_iNumReaders;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Wait for the reader of a band to fill a block, and return the block, or
+ * return NULL if the reader failed or stopped before filling it
+ */
+static float* WaitBlock(YAPP_ADD_BAND *pstBand, int iBuf)
+{
+    float *pfBuf = NULL;
+
+    (void) pthread_mutex_lock(&pstBand->stMutex);
+    while ((0 == pstBand->iNumFilled) && !(pstBand->cIsDone))
+    {
+        (void) pthread_cond_wait(&pstBand->stCond, &pstBand->stMutex);
+    }
+    if (pstBand->iNumFilled > 0)
+    {
+        pfBuf = pstBand->apfBuf[iBuf];
+    }
+    (void) pthread_mutex_unlock(&pstBand->stMutex);
+
+    return pfBuf;
+}
+
+
+/*
+ * Return the oldest filled block of a band to its reader
+ */
+static void ReleaseBlock(YAPP_ADD_BAND *pstBand)
+{
+    (void) pthread_mutex_lock(&pstBand->stMutex);
+    --pstBand->iNumFilled;
+    (void) pthread_cond_broadcast(&pstBand->stCond);
+    (void) pthread_mutex_unlock(&pstBand->stMutex);
+
+    return;
+}
+
+
+/*
+ * Stop the reader threads that are running, and wait for them to exit
+ */
+static void StopReaders()
+{
+    YAPP_ADD_BAND *pstBand = NULL;
+    int i = 0;
+
+    for (i = 0; i < g_iNumReaders; ++i)
+    {
+        pstBand = &g_pstBands[i];
+        (void) pthread_mutex_lock(&pstBand->stMutex);
+        pstBand->cStop = YAPP_TRUE;
+        (void) pthread_cond_broadcast(&pstBand->stCond);
+        (void) pthread_mutex_unlock(&pstBand->stMutex);
+    }
+    for (i = 0; i < g_iNumReaders; ++i)
+    {
+        pstBand = &g_pstBands[i];
+        (void) pthread_join(pstBand->stThread, NULL);
+        (void) pthread_cond_destroy(&pstBand->stCond);
+        (void) pthread_mutex_destroy(&pstBand->stMutex);
+    }
+    g_iNumReaders = 0;
+
+    return;
+}
+
+
+/*
+ * Stop the reader threads, if running, and clean up
+ */
+static void CleanUp()
+{
+    StopReaders();
+    YAPP_CleanUp();
+
+    return;
 }
 
 
@@ -675,6 +1160,18 @@ void PrintUsage(const char *pcProgName)
     (void) printf("Number of samples read in one block\n");
     (void) printf("                                        ");
     (void) printf("(default is 4096 samples)\n");
+    (void) printf("    -w  --weight <scheme>               ");
+    (void) printf("Band weighting scheme - 'bw'\n");
+    (void) printf("                                        ");
+    (void) printf("(proportional to bandwidth), 'snr'\n");
+    (void) printf("                                        ");
+    (void) printf("(inversely proportional to variance),\n");
+    (void) printf("                                        ");
+    (void) printf("or a comma-separated list of weights,\n");
+    (void) printf("                                        ");
+    (void) printf("one per band\n");
+    (void) printf("                                        ");
+    (void) printf("(default is equal weights)\n");
     (void) printf("    -g  --graphics                      ");
     (void) printf("Turn on plotting\n");
     (void) printf("    -i  --invert                        ");
@@ -0,0 +1,77 @@
+/**
+ * @file yapp_add.h
+ * Header file for yapp_add
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_ADD_H__
+#define __YAPP_ADD_H__
+
+#include <pthread.h>
+
+#define YAPP_ADD_NUMBUFS        4       /* number of blocks of each band that
+                                           are read ahead of the sum */
+#define YAPP_ADD_SINC_HALFLEN   16      /* half the number of taps of the
+                                           fractional delay filter */
+#define YAPP_ADD_FRAC_MIN       1e-3    /* fractional delays, in samples,
+                                           closer than this to a whole sample
+                                           are rounded */
+
+/* band weighting schemes */
+#define YAPP_ADD_WEIGHT_NONE    0       /* all bands have unit weight */
+#define YAPP_ADD_WEIGHT_BW      1       /* weight proportional to the band
+                                           bandwidth */
+#define YAPP_ADD_WEIGHT_SNR     2       /* weight inversely proportional to the
+                                           band variance, which maximises the
+                                           S/N of a signal equally strong in
+                                           all bands */
+#define YAPP_ADD_WEIGHT_LIST    3       /* weights given by the user */
+
+/**
+ * Per-band reader state - each band is read by its own thread into a ring of
+ * YAPP_ADD_NUMBUFS buffers, which the main thread sums in block order. Bands
+ * with a fractional delay are filtered by the reader, which reads
+ * YAPP_ADD_SINC_HALFLEN samples ahead for the filter.
+ */
+typedef struct tagAddBand
+{
+    FILE *pFIn;
+    float fSampSize;                    /* sample size, in bytes */
+    int iBlockSize;
+    int iNumReads;                      /* number of blocks to read */
+    char *pcRawBuf;                     /* raw data, iBlockSize
+                                           + YAPP_ADD_SINC_HALFLEN samples */
+    float *pfTaps;                      /* fractional delay filter taps, or
+                                           NULL if the band has no fractional
+                                           delay */
+    float *pfLine;                      /* filter input - the last
+                                           YAPP_ADD_SINC_HALFLEN - 1 samples
+                                           of the previous block, the block,
+                                           and the first YAPP_ADD_SINC_HALFLEN
+                                           samples of the next block */
+    long lNumAvail;                     /* number of samples read so far */
+    float *apfBuf[YAPP_ADD_NUMBUFS];    /* ring of unpacked blocks */
+    int aiNumSamps[YAPP_ADD_NUMBUFS];   /* number of samples read into each
+                                           block */
+    int iNumFilled;                     /* number of blocks read and not yet
+                                           summed */
+    char cStop;                         /* set to stop the reader */
+    char cIsDone;                       /* set by the reader when it exits */
+    int iRet;
+    pthread_mutex_t stMutex;
+    pthread_cond_t stCond;              /* signalled when iNumFilled, cStop
+                                           or cIsDone change */
+    pthread_t stThread;
+} YAPP_ADD_BAND;
+
+/**
+ * Reader thread - reads the blocks of a band in order, waiting for the main
+ * thread whenever the ring is full
+ *
+ * @param[in]       pvBand          Pointer to a YAPP_ADD_BAND
+ */
+void* YAPP_ADD_ReadBand(void *pvBand);
+
+#endif  /* __YAPP_ADD_H__ */
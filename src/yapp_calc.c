@@ -0,0 +1,574 @@
+/*
+ * @file yapp_calc.c
+ * Program to evaluate an arithmetic expression over one or more aligned time
+ *  series, in a single streaming pass. This generalises yapp_subtract - for
+ *  instance, baseline subtraction and normalisation, which would otherwise
+ *  need yapp_smooth, yapp_subtract, and intermediate files, is
+ *  '(a - smooth(a, 50ms)) / rms(a)'.
+ *
+ * @verbatim
+ * Usage: yapp_calc [options] -x <expression> <data-file-a> ...
+ *     -h  --help                           Display this usage information
+ *     -s  --skip <time>                    The length of data in seconds, to be
+ *                                          skipped
+ *                                          (default is 0 s)
+ *     -p  --proc <time>                    The length of data in seconds, to be
+ *                                          processed
+ *                                          (default is all)
+ *     -n  --nsamp <samples>                Number of samples read in one block
+ *                                          (default is 4096 samples)
+ *     -x  --expr <expression>              Expression to evaluate, in terms of
+ *                                          the variables a, b, ..., the input
+ *                                          files in order
+ *     -v  --version                        Display the version @endverbatim
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_expr.h"
+
+static int ReadSamps(FILE *pFIn,
+                     char *pcRawBuf,
+                     float *pfBuf,
+                     float fSampSize,
+                     int iNumSamps);
+
+/**
+ * The build version string, maintained in the file version.c, which is
+ * generated by makever.c.
+ */
+extern const char *g_pcVersion;
+
+/* PGPLOT device ID */
+extern int g_iPGDev;
+
+/* the following are global only to enable cleaning up in case of abnormal
+   termination, such as those triggered by SIGINT or SIGTERM */
+float **g_ppfWin = NULL;
+char *g_pcRawBuf = NULL;
+
+int main(int argc, char *argv[])
+{
+    FILE **ppFIn = NULL;
+    FILE *pFOut = NULL;
+    char *pcExpr = NULL;
+    char *pcFileOut = NULL;
+    char acFileOut[LEN_GENSTRING] = {0};
+    int iNumInputs = 0;
+    int iFormat = DEF_FORMAT;
+    double dDataSkipTime = 0.0;
+    double dDataProcTime = 0.0;
+    YUM_t stYUM = {{0}};
+    YUM_t stYUMIn = {{0}};
+    int *piHeaderLen = NULL;
+    float *pfMean = NULL;
+    float *pfRMS = NULL;
+    int iNumSampsMin = 0;
+    double dTSampInSec = 0.0;   /* holds sampling time in s */
+    int iTimeSampsToSkip = 0;
+    int iTimeSampsToProc = 0;
+    int iBlockSize = DEF_SIZE_BLOCK;
+    int iNumReads = 0;
+    int iTotNumReads = 0;
+    int iReadBlockCount = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    YAPP_EXPR stExpr = {{{0}}};
+    int iMargin = 0;
+    int iWinLen = 0;
+    int iValidBeg = 0;
+    int iValidEnd = 0;
+    int iNumSamps = 0;
+    long lBlockStart = 0;
+    float *pfOut = NULL;
+    int i = 0;
+    int j = 0;
+    const char *pcProgName = NULL;
+    int iNextOpt = 0;
+    /* valid short options */
+    const char* const pcOptsShort = "hs:p:n:x:v";
+    /* valid long options */
+    const struct option stOptsLong[] = {
+        { "help",                   0, NULL, 'h' },
+        { "skip",                   1, NULL, 's' },
+        { "proc",                   1, NULL, 'p' },
+        { "nsamp",                  1, NULL, 'n' },
+        { "expr",                   1, NULL, 'x' },
+        { "version",                0, NULL, 'v' },
+        { NULL,                     0, NULL, 0   }
+    };
+
+    /* get the filename of the program from the argument list */
+    pcProgName = argv[0];
+
+    /* parse the input */
+    do
+    {
+        iNextOpt = getopt_long(argc, argv, pcOptsShort, stOptsLong, NULL);
+        switch (iNextOpt)
+        {
+            case 'h':   /* -h or --help */
+                /* print usage info and terminate */
+                PrintUsage(pcProgName);
+                return YAPP_RET_SUCCESS;
+
+            case 's':   /* -s or --skip */
+                /* set option */
+                dDataSkipTime = atof(optarg);
+                break;
+
+            case 'p':   /* -p or --proc */
+                /* set option */
+                dDataProcTime = atof(optarg);
+                break;
+
+            case 'n':   /* -n or --nsamp */
+                /* set option */
+                iBlockSize = atoi(optarg);
+                /* validate */
+                if (iBlockSize < 2)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of samples must be > 1!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'x':   /* -x or --expr */
+                /* set option */
+                pcExpr = optarg;
+                break;
+
+            case 'v':   /* -v or --version */
+                /* display the version */
+                (void) printf("%s\n", g_pcVersion);
+                return YAPP_RET_SUCCESS;
+
+            case '?':   /* user specified an invalid option */
+                /* print usage info and terminate with error */
+                (void) fprintf(stderr, "ERROR: Invalid option!\n");
+                PrintUsage(pcProgName);
+                return YAPP_RET_ERROR;
+
+            case -1:    /* done with options */
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+    } while (iNextOpt != -1);
+
+    /* no expression */
+    if (NULL == pcExpr)
+    {
+        (void) fprintf(stderr, "ERROR: Expression not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* no arguments */
+    if (argc <= optind)
+    {
+        (void) fprintf(stderr, "ERROR: Input file not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+    iNumInputs = argc - optind;
+    if (iNumInputs > YAPP_EXPR_MAXVARS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Number of input files must be <= %d!\n",
+                       YAPP_EXPR_MAXVARS);
+        return YAPP_RET_ERROR;
+    }
+
+    /* register the signal-handling function */
+    iRet = YAPP_RegisterSignalHandlers();
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Handler registration failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    piHeaderLen = (int *) YAPP_Malloc((size_t) iNumInputs,
+                                      sizeof(int),
+                                      YAPP_FALSE);
+    pfMean = (float *) YAPP_Malloc((size_t) iNumInputs,
+                                   sizeof(float),
+                                   YAPP_FALSE);
+    pfRMS = (float *) YAPP_Malloc((size_t) iNumInputs,
+                                  sizeof(float),
+                                  YAPP_FALSE);
+    ppFIn = (FILE **) YAPP_Malloc((size_t) iNumInputs,
+                                  sizeof(FILE *),
+                                  YAPP_TRUE);
+    g_ppfWin = (float **) YAPP_Malloc((size_t) iNumInputs,
+                                      sizeof(float *),
+                                      YAPP_TRUE);
+    if ((NULL == piHeaderLen) || (NULL == pfMean) || (NULL == pfRMS)
+        || (NULL == ppFIn) || (NULL == g_ppfWin))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* read the metadata of all files - the output metadata is that of the
+       first file, and the other files must have the same sampling interval,
+       and are assumed to start at the same time */
+    for (i = 0; i < iNumInputs; ++i)
+    {
+        iFormat = YAPP_GetFileType(argv[optind+i]);
+        if (YAPP_RET_ERROR == iFormat)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: File type determination failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (iFormat != YAPP_FORMAT_DTS_TIM)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Invalid file type!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        (void) memset(&stYUMIn, '\0', sizeof(YUM_t));
+        iRet = YAPP_ReadMetadata(argv[optind+i], iFormat, &stYUMIn);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading metadata failed for file %s!\n",
+                           argv[optind+i]);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (0 == i)
+        {
+            stYUM = stYUMIn;
+            iNumSampsMin = stYUMIn.iTimeSamps;
+        }
+        else
+        {
+            if (fabs(stYUMIn.dTSamp - stYUM.dTSamp) > (1e-6 * stYUM.dTSamp))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Sampling interval of %s differs from "
+                               "that of %s!\n",
+                               argv[optind+i],
+                               argv[optind]);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+            if (stYUMIn.iTimeSamps < iNumSampsMin)
+            {
+                iNumSampsMin = stYUMIn.iTimeSamps;
+            }
+        }
+        piHeaderLen[i] = stYUMIn.iHeaderLen;
+        pfMean[i] = stYUMIn.fMean;
+        pfRMS[i] = stYUMIn.fRMS;
+    }
+
+    /* convert sampling interval to seconds */
+    dTSampInSec = stYUM.dTSamp / 1e3;
+
+    /* compile the expression */
+    iRet = YAPP_EXPR_Compile(&stExpr,
+                             pcExpr,
+                             iNumInputs,
+                             dTSampInSec,
+                             pfMean,
+                             pfRMS);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Compiling expression failed!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    iMargin = stExpr.iMargin;
+
+    /* calculate samples to skip and process */
+    iTimeSampsToSkip = (int) floor(dDataSkipTime / dTSampInSec);
+    if (iTimeSampsToSkip >= iNumSampsMin)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Data to be skipped is greater than or equal to "
+                       "the length of the data!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    iTimeSampsToProc = iNumSampsMin - iTimeSampsToSkip;
+    if (dDataProcTime != 0.0)
+    {
+        if ((int) floor(dDataProcTime / dTSampInSec) > iTimeSampsToProc)
+        {
+            (void) fprintf(stderr,
+                           "WARNING: Input time is longer than length of "
+                           "data!\n");
+        }
+        else
+        {
+            iTimeSampsToProc = (int) floor(dDataProcTime / dTSampInSec);
+        }
+    }
+    if (iTimeSampsToProc < iBlockSize)
+    {
+        iBlockSize = iTimeSampsToProc;
+    }
+    iNumReads = (int) ceilf(((float) iTimeSampsToProc) / iBlockSize);
+    iTotNumReads = iNumReads;
+
+    (void) printf("Processing\n"
+                  "    %d of %d time samples\n"
+                  "    %.10g of %.10g seconds\n"
+                  "in %d reads with block size %d time samples, and a "
+                  "margin of %d samples...\n",
+                  iTimeSampsToProc,
+                  iNumSampsMin,
+                  (iTimeSampsToProc * dTSampInSec),
+                  (iNumSampsMin * dTSampInSec),
+                  iNumReads,
+                  iBlockSize,
+                  iMargin);
+
+    /* each input is read into a window of the block plus the margin on
+       either side - successive windows overlap by twice the margin */
+    iWinLen = iBlockSize + (2 * iMargin);
+    for (i = 0; i < stExpr.iNumVars; ++i)
+    {
+        g_ppfWin[i] = (float *) YAPP_Malloc((size_t) iWinLen,
+                                            sizeof(float),
+                                            YAPP_TRUE);
+        if (NULL == g_ppfWin[i])
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        ppFIn[i] = fopen(argv[optind+i], "r");
+        if (NULL == ppFIn[i])
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed! %s.\n",
+                           argv[optind+i],
+                           strerror(errno));
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        /* skip the header and the data to be skipped */
+        (void) fseek(ppFIn[i],
+                     (long) piHeaderLen[i]
+                     + (long) (iTimeSampsToSkip * stYUM.fSampSize),
+                     SEEK_SET);
+    }
+    g_pcRawBuf = (char *) YAPP_Malloc(
+                            (size_t) ((iBlockSize + iMargin) * stYUM.fSampSize),
+                            sizeof(char),
+                            YAPP_FALSE);
+    if (NULL == g_pcRawBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    iRet = YAPP_EXPR_Alloc(&stExpr, iWinLen);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* open the time series data file for writing */
+    pcFileOut = YAPP_GetFilenameFromPath(argv[optind]);
+    (void) sprintf(acFileOut,
+                   "%s.%s%s",
+                   pcFileOut,
+                   INFIX_CALC,
+                   EXT_TIM);
+    /* write metadata to disk */
+    iRet = YAPP_WriteMetadata(acFileOut, iFormat, stYUM);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing metadata failed for file %s!\n",
+                       acFileOut);
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    /* open file for appending data */
+    pFOut = fopen(acFileOut, "a");
+    if (NULL == pFOut)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileOut,
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    while (iNumReads > 0)
+    {
+        /* read data */
+        (void) printf("\rReading data block %d of %d.",
+                      iReadBlockCount + 1,
+                      iTotNumReads);
+        (void) fflush(stdout);
+        lBlockStart = (long) iReadBlockCount * iBlockSize;
+        for (i = 0; i < stExpr.iNumVars; ++i)
+        {
+            /* the first window starts with iMargin samples before the data,
+               and later windows start with the last 2 * iMargin samples of
+               the previous one */
+            if (0 == iReadBlockCount)
+            {
+                iRet = ReadSamps(ppFIn[i],
+                                 g_pcRawBuf,
+                                 g_ppfWin[i] + iMargin,
+                                 stYUM.fSampSize,
+                                 iBlockSize + iMargin);
+            }
+            else
+            {
+                (void) memmove(g_ppfWin[i],
+                               g_ppfWin[i] + iBlockSize,
+                               sizeof(float) * (2 * iMargin));
+                iRet = ReadSamps(ppFIn[i],
+                                 g_pcRawBuf,
+                                 g_ppfWin[i] + (2 * iMargin),
+                                 stYUM.fSampSize,
+                                 iBlockSize);
+            }
+            if (YAPP_RET_ERROR == iRet)
+            {
+                (void) fprintf(stderr, "ERROR: Reading data failed!\n");
+                (void) fclose(pFOut);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+        --iNumReads;
+        ++iReadBlockCount;
+
+        /* the part of the window that is within the data to be processed -
+           window sample j is data sample lBlockStart - iMargin + j */
+        iValidBeg = (lBlockStart < iMargin) ? (int) (iMargin - lBlockStart) : 0;
+        iValidEnd = iWinLen;
+        if ((lBlockStart - iMargin + iWinLen) > iTimeSampsToProc)
+        {
+            iValidEnd = (int) (iTimeSampsToProc - lBlockStart + iMargin);
+        }
+        iNumSamps = iBlockSize;
+        if ((lBlockStart + iNumSamps) > iTimeSampsToProc)
+        {
+            iNumSamps = (int) (iTimeSampsToProc - lBlockStart);
+        }
+
+        /* evaluate the expression */
+        pfOut = YAPP_EXPR_Eval(&stExpr, g_ppfWin, iValidBeg, iValidEnd);
+
+        /* write output data to file */
+        (void) fwrite(pfOut + iMargin,
+                      sizeof(float),
+                      (long) iNumSamps,
+                      pFOut);
+    }
+
+    (void) printf("DONE!\n");
+
+    for (j = 0; j < stExpr.iNumVars; ++j)
+    {
+        (void) fclose(ppFIn[j]);
+    }
+    (void) fclose(pFOut);
+    YAPP_CleanUp();
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Read samples, zero-padding the buffer past the end of the data, and return
+ * the number of samples read
+ */
+static int ReadSamps(FILE *pFIn,
+                     char *pcRawBuf,
+                     float *pfBuf,
+                     float fSampSize,
+                     int iNumSamps)
+{
+    int iReadItems = 0;
+
+    /* YAPP_ReadData() is not used, as its byte buffer is sized by its first
+       caller */
+    iReadItems = fread(pcRawBuf,
+                       sizeof(char),
+                       (size_t) (iNumSamps * fSampSize),
+                       pFIn);
+    if (ferror(pFIn))
+    {
+        (void) fprintf(stderr, "ERROR: File read failed!\n");
+        return YAPP_RET_ERROR;
+    }
+    iReadItems = (int) ((float) iReadItems / fSampSize);
+    (void) YAPP_UnpackData(pcRawBuf, pfBuf, fSampSize, iReadItems);
+    if (iReadItems < iNumSamps)
+    {
+        /* reset remaining elements to '\0' */
+        (void) memset((pfBuf + iReadItems),
+                      '\0',
+                      (sizeof(float) * (iNumSamps - iReadItems)));
+    }
+
+    return iReadItems;
+}
+
+
+/*
+ * Prints usage information
+ */
+void PrintUsage(const char *pcProgName)
+{
+    (void) printf("Usage: %s [options] -x <expression> <data-file-a> ...\n",
+                  pcProgName);
+    (void) printf("    -h  --help                          ");
+    (void) printf("Display this usage information\n");
+    (void) printf("    -s  --skip <time>                   ");
+    (void) printf("The length of data in seconds, to be\n");
+    (void) printf("                                        ");
+    (void) printf("skipped\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 0 s)\n");
+    (void) printf("    -p  --proc <time>                   ");
+    (void) printf("The length of data in seconds, to be\n");
+    (void) printf("                                        ");
+    (void) printf("processed\n");
+    (void) printf("                                        ");
+    (void) printf("(default is all)\n");
+    (void) printf("    -n  --nsamp <samples>               ");
+    (void) printf("Number of samples read in one block\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 4096 samples)\n");
+    (void) printf("    -x  --expr <expression>             ");
+    (void) printf("Expression to evaluate, in terms of\n");
+    (void) printf("                                        ");
+    (void) printf("the variables a, b, ..., the input\n");
+    (void) printf("                                        ");
+    (void) printf("files in order\n");
+    (void) printf("    -v  --version                       ");
+    (void) printf("Display the version\n");
+
+    return;
+}
@@ -0,0 +1,467 @@
+/*
+ * @file yapp_canddb.c
+ * Candidate database routines. The database is a file of chunks of
+ *  candidates, each sorted in time order and stored column by column, behind
+ *  a header holding the range of the values in the chunk. Writers append
+ *  chunks under an exclusive lock, so that multiple programs may add to the
+ *  same database. A query skips the chunks whose header does not overlap it,
+ *  and reads only the part of each column of the other chunks that falls in
+ *  its time range.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_canddb.h"
+
+static int WriteChunk(YAPP_CDB_WRITER *pstWriter);
+static int ReadColumn(FILE *pFDB,
+                      long lChunkStart,
+                      long lColOffset,
+                      size_t lSize,
+                      int iStart,
+                      int iNum,
+                      void *pvBuf);
+
+/*
+ * Open a database for appending
+ */
+int YAPP_CDB_Open(YAPP_CDB_WRITER *pstWriter, char *pcFileDB)
+{
+    pstWriter->iNumCands = 0;
+    pstWriter->pstBuf = (YAPP_CDB_CAND *) malloc(DEF_CDB_CHUNKSIZE
+                                                 * sizeof(YAPP_CDB_CAND));
+    if (NULL == pstWriter->pstBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    pstWriter->pFDB = fopen(pcFileDB, "a");
+    if (NULL == pstWriter->pFDB)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileDB,
+                       strerror(errno));
+        free(pstWriter->pstBuf);
+        pstWriter->pstBuf = NULL;
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Add a candidate to the database
+ */
+int YAPP_CDB_Add(YAPP_CDB_WRITER *pstWriter, YAPP_CDB_CAND *pstCand)
+{
+    pstWriter->pstBuf[pstWriter->iNumCands] = *pstCand;
+    ++pstWriter->iNumCands;
+    if (DEF_CDB_CHUNKSIZE == pstWriter->iNumCands)
+    {
+        return WriteChunk(pstWriter);
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Append the buffered candidates to the database, and close it
+ */
+int YAPP_CDB_Close(YAPP_CDB_WRITER *pstWriter)
+{
+    int iRet = YAPP_RET_SUCCESS;
+
+    if (NULL == pstWriter->pFDB)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    iRet = WriteChunk(pstWriter);
+    if (fclose(pstWriter->pFDB) != 0)
+    {
+        iRet = YAPP_RET_ERROR;
+    }
+    pstWriter->pFDB = NULL;
+    free(pstWriter->pstBuf);
+    pstWriter->pstBuf = NULL;
+
+    return iRet;
+}
+
+
+/*
+ * Sort the buffered candidates, and append them to the database as a chunk
+ */
+static int WriteChunk(YAPP_CDB_WRITER *pstWriter)
+{
+    YAPP_CDB_CAND *pstBuf = pstWriter->pstBuf;
+    int iNumCands = pstWriter->iNumCands;
+    YAPP_CDB_CHUNKHEADER stHeader = {{0}};
+    char *pcChunk = NULL;
+    double *pdMJD = NULL;
+    double *pdParam = NULL;
+    float *pfDM = NULL;
+    float *pfSNR = NULL;
+    int16_t *piBeam = NULL;
+    uint8_t *pcType = NULL;
+    size_t lChunkSize = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    if (0 == iNumCands)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    qsort(pstBuf, iNumCands, sizeof(YAPP_CDB_CAND), YAPP_CDB_CompareCands);
+
+    /* build the index */
+    (void) memcpy(stHeader.acMagic, YAPP_CDB_MAGIC, sizeof(stHeader.acMagic));
+    stHeader.iNumCands = iNumCands;
+    stHeader.dMJDMin = pstBuf[0].dMJD;
+    stHeader.dMJDMax = pstBuf[iNumCands-1].dMJD;
+    stHeader.fDMMin = pstBuf[0].fDM;
+    stHeader.fDMMax = pstBuf[0].fDM;
+    stHeader.fSNRMax = pstBuf[0].fSNR;
+    for (i = 0; i < iNumCands; ++i)
+    {
+        if (pstBuf[i].fDM < stHeader.fDMMin)
+        {
+            stHeader.fDMMin = pstBuf[i].fDM;
+        }
+        if (pstBuf[i].fDM > stHeader.fDMMax)
+        {
+            stHeader.fDMMax = pstBuf[i].fDM;
+        }
+        if (pstBuf[i].fSNR > stHeader.fSNRMax)
+        {
+            stHeader.fSNRMax = pstBuf[i].fSNR;
+        }
+        stHeader.iTypes |= pstBuf[i].cType;
+    }
+
+    /* lay out the columns */
+    lChunkSize = iNumCands * YAPP_CDB_RECSIZE;
+    pcChunk = (char *) malloc(lChunkSize);
+    if (NULL == pcChunk)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    pdMJD = (double *) pcChunk;
+    pdParam = pdMJD + iNumCands;
+    pfDM = (float *) (pdParam + iNumCands);
+    pfSNR = pfDM + iNumCands;
+    piBeam = (int16_t *) (pfSNR + iNumCands);
+    pcType = (uint8_t *) (piBeam + iNumCands);
+    for (i = 0; i < iNumCands; ++i)
+    {
+        pdMJD[i] = pstBuf[i].dMJD;
+        pdParam[i] = pstBuf[i].dParam;
+        pfDM[i] = pstBuf[i].fDM;
+        pfSNR[i] = pstBuf[i].fSNR;
+        piBeam[i] = pstBuf[i].iBeam;
+        pcType[i] = pstBuf[i].cType;
+    }
+
+    /* append the chunk under an exclusive lock, so that chunks from
+       different writers are not interleaved */
+    (void) flock(fileno(pstWriter->pFDB), LOCK_EX);
+    if ((fwrite(&stHeader, sizeof(stHeader), 1, pstWriter->pFDB) != 1)
+        || (fwrite(pcChunk, lChunkSize, 1, pstWriter->pFDB) != 1)
+        || (fflush(pstWriter->pFDB) != 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing to candidate database failed! %s.\n",
+                       strerror(errno));
+        iRet = YAPP_RET_ERROR;
+    }
+    (void) flock(fileno(pstWriter->pFDB), LOCK_UN);
+
+    free(pcChunk);
+    pstWriter->iNumCands = 0;
+
+    return iRet;
+}
+
+
+/*
+ * Initialise a query to match all candidates
+ */
+void YAPP_CDB_InitQuery(YAPP_CDB_QUERY *pstQuery)
+{
+    pstQuery->dMJDLo = -DBL_MAX;
+    pstQuery->dMJDHi = DBL_MAX;
+    pstQuery->fDMLo = -FLT_MAX;
+    pstQuery->fDMHi = FLT_MAX;
+    pstQuery->fSNRMin = -FLT_MAX;
+    pstQuery->iTypes = YAPP_CDB_TYPE_SP | YAPP_CDB_TYPE_PERIOD;
+    pstQuery->iBeam = -1;
+
+    return;
+}
+
+
+/*
+ * Read part of a column of a chunk
+ */
+static int ReadColumn(FILE *pFDB,
+                      long lChunkStart,
+                      long lColOffset,
+                      size_t lSize,
+                      int iStart,
+                      int iNum,
+                      void *pvBuf)
+{
+    if ((fseek(pFDB, lChunkStart + lColOffset + (long) (iStart * lSize),
+               SEEK_SET) != 0)
+        || (fread(pvBuf, lSize, iNum, pFDB) != (size_t) iNum))
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Find the candidates in a database that match a query
+ */
+long YAPP_CDB_Query(char *pcFileDB,
+                    YAPP_CDB_QUERY *pstQuery,
+                    int (*pfnFound)(YAPP_CDB_CAND *pstCand, void *pvArg),
+                    void *pvArg)
+{
+    FILE *pFDB = NULL;
+    YAPP_CDB_CHUNKHEADER stHeader = {{0}};
+    YAPP_CDB_CAND stCand = {0};
+    char *pcChunk = NULL;
+    int iMaxCands = 0;
+    double *pdMJD = NULL;
+    double *pdParam = NULL;
+    float *pfDM = NULL;
+    float *pfSNR = NULL;
+    int16_t *piBeam = NULL;
+    uint8_t *pcType = NULL;
+    long lChunkStart = 0;
+    long lNumFound = 0;
+    int n = 0;
+    int iLo = 0;
+    int iHi = 0;
+    int iMid = 0;
+    int iNum = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    pFDB = fopen(pcFileDB, "r");
+    if (NULL == pFDB)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileDB,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    while (1 == fread(&stHeader, sizeof(stHeader), 1, pFDB))
+    {
+        n = stHeader.iNumCands;
+        if ((memcmp(stHeader.acMagic,
+                    YAPP_CDB_MAGIC,
+                    sizeof(stHeader.acMagic)) != 0)
+            || (n < 1))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Invalid candidate database %s!\n",
+                           pcFileDB);
+            iRet = YAPP_RET_ERROR;
+            break;
+        }
+        lChunkStart = ftell(pFDB);
+
+        /* skip the chunk if its index does not overlap the query */
+        if ((stHeader.dMJDMax < pstQuery->dMJDLo)
+            || (stHeader.dMJDMin > pstQuery->dMJDHi)
+            || (stHeader.fDMMax < pstQuery->fDMLo)
+            || (stHeader.fDMMin > pstQuery->fDMHi)
+            || (stHeader.fSNRMax < pstQuery->fSNRMin)
+            || (0 == (stHeader.iTypes & pstQuery->iTypes)))
+        {
+            if (fseek(pFDB, lChunkStart + (long) (n * YAPP_CDB_RECSIZE),
+                      SEEK_SET) != 0)
+            {
+                iRet = YAPP_RET_ERROR;
+                break;
+            }
+            continue;
+        }
+
+        if (n > iMaxCands)
+        {
+            free(pcChunk);
+            pcChunk = (char *) malloc(n * YAPP_CDB_RECSIZE);
+            if (NULL == pcChunk)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
+                iRet = YAPP_RET_ERROR;
+                break;
+            }
+            iMaxCands = n;
+        }
+        /* the columns are laid out in memory as they are on disk */
+        pdMJD = (double *) pcChunk;
+        pdParam = pdMJD + n;
+        pfDM = (float *) (pdParam + n);
+        pfSNR = pfDM + n;
+        piBeam = (int16_t *) (pfSNR + n);
+        pcType = (uint8_t *) (piBeam + n);
+
+        /* find the time range of the query in the time column, and read only
+           that range of the other columns */
+        iRet = ReadColumn(pFDB, lChunkStart, 0, sizeof(double), 0, n, pdMJD);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            break;
+        }
+        iLo = 0;
+        iHi = n;
+        while (iLo < iHi)
+        {
+            iMid = (iLo + iHi) / 2;
+            if (pdMJD[iMid] < pstQuery->dMJDLo)
+            {
+                iLo = iMid + 1;
+            }
+            else
+            {
+                iHi = iMid;
+            }
+        }
+        i = iLo;
+        iHi = n;
+        while (iLo < iHi)
+        {
+            iMid = (iLo + iHi) / 2;
+            if (pdMJD[iMid] <= pstQuery->dMJDHi)
+            {
+                iLo = iMid + 1;
+            }
+            else
+            {
+                iHi = iMid;
+            }
+        }
+        iNum = iLo - i;
+        iLo = i;
+        if (iNum > 0)
+        {
+            if ((ReadColumn(pFDB, lChunkStart,
+                            (char *) pdParam - pcChunk,
+                            sizeof(double), iLo, iNum, pdParam + iLo)
+                 != YAPP_RET_SUCCESS)
+                || (ReadColumn(pFDB, lChunkStart,
+                               (char *) pfDM - pcChunk,
+                               sizeof(float), iLo, iNum, pfDM + iLo)
+                    != YAPP_RET_SUCCESS)
+                || (ReadColumn(pFDB, lChunkStart,
+                               (char *) pfSNR - pcChunk,
+                               sizeof(float), iLo, iNum, pfSNR + iLo)
+                    != YAPP_RET_SUCCESS)
+                || (ReadColumn(pFDB, lChunkStart,
+                               (char *) piBeam - pcChunk,
+                               sizeof(int16_t), iLo, iNum, piBeam + iLo)
+                    != YAPP_RET_SUCCESS)
+                || (ReadColumn(pFDB, lChunkStart,
+                               (char *) pcType - pcChunk,
+                               sizeof(uint8_t), iLo, iNum, pcType + iLo)
+                    != YAPP_RET_SUCCESS))
+            {
+                iRet = YAPP_RET_ERROR;
+                break;
+            }
+        }
+
+        for (i = iLo; i < iLo + iNum; ++i)
+        {
+            if ((pfDM[i] < pstQuery->fDMLo)
+                || (pfDM[i] > pstQuery->fDMHi)
+                || (pfSNR[i] < pstQuery->fSNRMin)
+                || (0 == (pcType[i] & pstQuery->iTypes))
+                || ((pstQuery->iBeam != -1) && (piBeam[i] != pstQuery->iBeam)))
+            {
+                continue;
+            }
+            stCand.dMJD = pdMJD[i];
+            stCand.dParam = pdParam[i];
+            stCand.fDM = pfDM[i];
+            stCand.fSNR = pfSNR[i];
+            stCand.iBeam = piBeam[i];
+            stCand.cType = pcType[i];
+            ++lNumFound;
+            iRet = (*pfnFound)(&stCand, pvArg);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                break;
+            }
+        }
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            break;
+        }
+
+        /* move to the next chunk */
+        if (fseek(pFDB, lChunkStart + (long) (n * YAPP_CDB_RECSIZE),
+                  SEEK_SET) != 0)
+        {
+            iRet = YAPP_RET_ERROR;
+            break;
+        }
+    }
+
+    free(pcChunk);
+    (void) fclose(pFDB);
+
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Reading candidate database %s failed!\n",
+                       pcFileDB);
+        return YAPP_RET_ERROR;
+    }
+
+    return lNumFound;
+}
+
+
+/*
+ * Candidate comparison function for qsort()
+ */
+int YAPP_CDB_CompareCands(const void *pvCand1, const void *pvCand2)
+{
+    const YAPP_CDB_CAND *pstCand1 = (const YAPP_CDB_CAND *) pvCand1;
+    const YAPP_CDB_CAND *pstCand2 = (const YAPP_CDB_CAND *) pvCand2;
+
+    if (pstCand1->dMJD < pstCand2->dMJD)
+    {
+        return -1;
+    }
+    if (pstCand1->dMJD > pstCand2->dMJD)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,158 @@
+/**
+ * @file yapp_canddb.h
+ * Header file for the candidate database routines, used to store single-pulse
+ *  and periodicity candidates from many observations, and to look them up by
+ *  time, DM and S/N
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_CANDDB_H__
+#define __YAPP_CANDDB_H__
+
+#include <stdint.h>
+#include <sys/file.h>
+
+#define EXT_YAPP_CANDDB         ".ycdb" /* candidate database */
+
+#define YAPP_CDB_MAGIC          "YCD1"  /* marks the start of a chunk, and
+                                           identifies the version */
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_CDB_CHUNKSIZE       4096    /**< @brief Maximum number of
+                                             candidates in a chunk */
+/* @} */
+
+/**
+ * Candidate types
+ */
+enum tagCandTypes
+{
+    YAPP_CDB_TYPE_SP = 1,           /* single pulse */
+    YAPP_CDB_TYPE_PERIOD = 2        /* periodicity */
+};
+
+/* the database consists of chunks of up to DEF_CDB_CHUNKSIZE candidates,
+   appended one after the other. each chunk is sorted in time order, and
+   consists of a header, which serves as the index, followed by the columns,
+   in the order dMJD, dParam, fDM, fSNR, iBeam, cType */
+#define YAPP_CDB_RECSIZE        (sizeof(double) + sizeof(double)              \
+                                 + sizeof(float) + sizeof(float)              \
+                                 + sizeof(int16_t) + sizeof(uint8_t))
+
+/**
+ * Chunk header - the range of the values in the chunk, so that chunks that
+ * cannot match a query can be skipped without reading them
+ */
+typedef struct tagCDBChunkHeader
+{
+    char acMagic[4];        /* YAPP_CDB_MAGIC */
+    int32_t iNumCands;
+    double dMJDMin;
+    double dMJDMax;
+    float fDMMin;
+    float fDMMax;
+    float fSNRMax;
+    int32_t iTypes;         /* bitwise OR of the types in the chunk */
+} YAPP_CDB_CHUNKHEADER;
+
+/**
+ * Candidate
+ */
+typedef struct tagCDBCand
+{
+    double dMJD;            /* time of the pulse, or the start of the
+                               observation, for periodicity candidates */
+    double dParam;          /* width, for single pulses, or period, for
+                               periodicity candidates, in s */
+    float fDM;              /* in cm^-3 pc */
+    float fSNR;             /* S/N, or significance in sigmas */
+    int16_t iBeam;          /* beam identifier */
+    uint8_t cType;          /* YAPP_CDB_TYPE_SP or YAPP_CDB_TYPE_PERIOD */
+} YAPP_CDB_CAND;
+
+/**
+ * Database writer - candidates are buffered, and appended as a chunk when the
+ * buffer is full or the writer is closed
+ */
+typedef struct tagCDBWriter
+{
+    FILE *pFDB;
+    YAPP_CDB_CAND *pstBuf;
+    int iNumCands;
+} YAPP_CDB_WRITER;
+
+/**
+ * Query - candidates that match all of the criteria are returned
+ */
+typedef struct tagCDBQuery
+{
+    double dMJDLo;
+    double dMJDHi;
+    float fDMLo;
+    float fDMHi;
+    float fSNRMin;
+    int iTypes;             /* bitwise OR of the types to return */
+    int iBeam;              /* beam identifier, or -1 for all beams */
+} YAPP_CDB_QUERY;
+
+/**
+ * Open a database for appending, creating it if it does not exist
+ *
+ * @param[out]      pstWriter       Writer
+ * @param[in]       pcFileDB        Database filename
+ */
+int YAPP_CDB_Open(YAPP_CDB_WRITER *pstWriter, char *pcFileDB);
+
+/**
+ * Add a candidate to the database
+ *
+ * @param[inout]    pstWriter       Writer
+ * @param[in]       pstCand         Candidate
+ */
+int YAPP_CDB_Add(YAPP_CDB_WRITER *pstWriter, YAPP_CDB_CAND *pstCand);
+
+/**
+ * Append the buffered candidates to the database, and close it
+ *
+ * @param[inout]    pstWriter       Writer
+ */
+int YAPP_CDB_Close(YAPP_CDB_WRITER *pstWriter);
+
+/**
+ * Initialise a query to match all candidates
+ *
+ * @param[out]      pstQuery        Query
+ */
+void YAPP_CDB_InitQuery(YAPP_CDB_QUERY *pstQuery);
+
+/**
+ * Find the candidates in a database that match a query - chunks whose index
+ * does not overlap the query are skipped, and within a chunk, only the time
+ * range of the query is read. Returns the number of candidates found, or
+ * YAPP_RET_ERROR
+ *
+ * @param[in]       pcFileDB        Database filename
+ * @param[in]       pstQuery        Query
+ * @param[in]       pfnFound        Function called for each candidate found,
+ *                                  in time order within each chunk - the
+ *                                  query fails if it does not return
+ *                                  YAPP_RET_SUCCESS
+ * @param[in]       pvArg           Argument passed to pfnFound
+ */
+long YAPP_CDB_Query(char *pcFileDB,
+                    YAPP_CDB_QUERY *pstQuery,
+                    int (*pfnFound)(YAPP_CDB_CAND *pstCand, void *pvArg),
+                    void *pvArg);
+
+/**
+ * Candidate comparison function for qsort() - sorts in time order
+ */
+int YAPP_CDB_CompareCands(const void *pvCand1, const void *pvCand2);
+
+#endif  /* __YAPP_CANDDB_H__ */
+
@@ -0,0 +1,575 @@
+/*
+ * @file yapp_coincidence.c
+ * Program to remove multi-beam coincidences from the single-pulse candidate
+ *  files of the beams of an observation, written by yapp_siftpulses.
+ *  Broadband RFI is seen in all beams at once, while a real pulse is seen in
+ *  one or a few beams, so candidates seen in too many beams at the same time
+ *  are rejected.
+ *
+ * @verbatim
+ * Usage: yapp_coincidence [options] <cand-file-beam0> ... <cand-file-beamN-1>
+ *     -h  --help                           Display this usage information
+ *     -k  --ttol <ms>                      Time tolerance
+ *                                          (default is 10 ms)
+ *     -m  --maxbeams <beams>               Maximum number of beams in which a
+ *                                          candidate may be seen
+ *                                          (default is half the number of
+ *                                          beams)
+ *     -v  --version                        Display the version @endverbatim
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_siftpulses.h"
+#include "yapp_coincidence.h"
+
+/**
+ * The build version string, maintained in the file version.c, which is
+ * generated by makever.c.
+ */
+extern const char *g_pcVersion;
+
+/* the following are global only to enable cleaning up in case of abnormal
+   termination, such as those triggered by SIGINT or SIGTERM */
+FILE *g_pFCandIn = NULL;
+FILE *g_pFCandBin = NULL;
+FILE *g_pFCandCSV = NULL;
+
+static void YAPP_CO_GetOutputName(char *pcFileCand,
+                                  const char *pcExt,
+                                  char *pcFileOut);
+static int YAPP_CO_WriteCands(char *pcFileCand,
+                              YAPP_SP_FILEHEADER *pstFileHeader,
+                              YAPP_SP_CAND *pstCands,
+                              char *pcRejected,
+                              long lNumCands,
+                              long *plNumKept);
+static void CleanUp(void);
+
+int main(int argc, char *argv[])
+{
+    int iNumBeams = 0;
+    YAPP_SP_FILEHEADER *pstFileHeaders = NULL;
+    long *plFirstCand = NULL;       /* index of the first candidate of each
+                                       beam, with the total at the end */
+    YAPP_SP_CAND *pstCands = NULL;
+    YAPP_CO_EVENT *pstEvents = NULL;
+    char *pcRejected = NULL;
+    int *piBeamCount = NULL;        /* number of events of each beam in the
+                                       window */
+    int iNumBeamsSeen = 0;          /* number of beams in the window */
+    long lNumCands = 0;
+    long lNumKept = 0;
+    long lTotNumKept = 0;
+    long lFileSize = 0;
+    double dTTol = DEF_CO_TTOL;     /* in ms */
+    int iMaxBeams = 0;
+    double dMJDRef = 0.0;
+    long lLo = 0;
+    long lHi = 0;
+    long l = 0;
+    int i = 0;
+    int j = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    const char *pcProgName = NULL;
+    int iNextOpt = 0;
+    /* valid short options */
+    const char* const pcOptsShort = "hk:m:v";
+    /* valid long options */
+    const struct option stOptsLong[] = {
+        { "help",                   0, NULL, 'h' },
+        { "ttol",                   1, NULL, 'k' },
+        { "maxbeams",               1, NULL, 'm' },
+        { "version",                0, NULL, 'v' },
+        { NULL,                     0, NULL, 0   }
+    };
+
+    /* get the filename of the program from the argument list */
+    pcProgName = argv[0];
+
+    /* parse the input */
+    do
+    {
+        iNextOpt = getopt_long(argc, argv, pcOptsShort, stOptsLong, NULL);
+        switch (iNextOpt)
+        {
+            case 'h':   /* -h or --help */
+                /* print usage info and terminate */
+                PrintUsage(pcProgName);
+                return YAPP_RET_SUCCESS;
+
+            case 'k':   /* -k or --ttol */
+                /* set option */
+                dTTol = atof(optarg);
+                /* validate */
+                if (dTTol < 0.0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Time tolerance must be >= 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'm':   /* -m or --maxbeams */
+                /* set option */
+                iMaxBeams = atoi(optarg);
+                /* validate */
+                if (iMaxBeams < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Maximum number of beams must be "
+                                   ">= 1!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'v':   /* -v or --version */
+                /* display the version */
+                (void) printf("%s\n", g_pcVersion);
+                return YAPP_RET_SUCCESS;
+
+            case '?':   /* user specified an invalid option */
+                /* print usage info and terminate with error */
+                (void) fprintf(stderr, "ERROR: Invalid option!\n");
+                PrintUsage(pcProgName);
+                return YAPP_RET_ERROR;
+
+            case -1:    /* done with options */
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+    } while (iNextOpt != -1);
+
+    /* no arguments */
+    if (argc <= optind)
+    {
+        (void) fprintf(stderr, "ERROR: Input file not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* each input file holds the candidates of one beam */
+    iNumBeams = argc - optind;
+    if (iNumBeams < 2)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: At least two input files are required!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+    if (0 == iMaxBeams)
+    {
+        iMaxBeams = iNumBeams / 2;
+    }
+    if (iMaxBeams >= iNumBeams)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Maximum number of beams must be less than the "
+                       "number of input files!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* register the signal-handling function */
+    iRet = YAPP_RegisterSignalHandlers();
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Handler registration failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    pstFileHeaders = (YAPP_SP_FILEHEADER *) YAPP_Malloc(
+                                                iNumBeams,
+                                                sizeof(YAPP_SP_FILEHEADER),
+                                                YAPP_FALSE);
+    plFirstCand = (long *) YAPP_Malloc(iNumBeams + 1,
+                                       sizeof(long),
+                                       YAPP_TRUE);
+    piBeamCount = (int *) YAPP_Malloc(iNumBeams, sizeof(int), YAPP_TRUE);
+    if ((NULL == pstFileHeaders) || (NULL == plFirstCand)
+        || (NULL == piBeamCount))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* read the file headers, and count the candidates of each beam from the
+       file sizes */
+    for (i = 0; i < iNumBeams; ++i)
+    {
+        g_pFCandIn = fopen(argv[optind+i], "r");
+        if (NULL == g_pFCandIn)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed! %s.\n",
+                           argv[optind+i],
+                           strerror(errno));
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if ((fread(&pstFileHeaders[i],
+                   sizeof(YAPP_SP_FILEHEADER),
+                   1,
+                   g_pFCandIn) != 1)
+            || (memcmp(pstFileHeaders[i].acMagic,
+                       YAPP_SP_MAGIC,
+                       sizeof(pstFileHeaders[i].acMagic)) != 0)
+            || (pstFileHeaders[i].iRecordSize != sizeof(YAPP_SP_CAND)))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Invalid candidate file %s!\n",
+                           argv[optind+i]);
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        (void) fseek(g_pFCandIn, 0, SEEK_END);
+        lFileSize = ftell(g_pFCandIn);
+        (void) fclose(g_pFCandIn);
+        g_pFCandIn = NULL;
+        lNumCands = (lFileSize - (long) sizeof(YAPP_SP_FILEHEADER))
+                    / (long) sizeof(YAPP_SP_CAND);
+        plFirstCand[i+1] = plFirstCand[i] + lNumCands;
+
+        /* the beams are placed on a common time axis, starting at the
+           earliest start time */
+        if ((0 == i) || (pstFileHeaders[i].dTStart < dMJDRef))
+        {
+            dMJDRef = pstFileHeaders[i].dTStart;
+        }
+    }
+    lNumCands = plFirstCand[iNumBeams];
+
+    pstCands = (YAPP_SP_CAND *) YAPP_Malloc(lNumCands + 1,
+                                            sizeof(YAPP_SP_CAND),
+                                            YAPP_FALSE);
+    pstEvents = (YAPP_CO_EVENT *) YAPP_Malloc(lNumCands + 1,
+                                              sizeof(YAPP_CO_EVENT),
+                                              YAPP_FALSE);
+    pcRejected = (char *) YAPP_Malloc(lNumCands + 1, sizeof(char), YAPP_TRUE);
+    if ((NULL == pstCands) || (NULL == pstEvents) || (NULL == pcRejected))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* read the candidates of all beams */
+    for (i = 0; i < iNumBeams; ++i)
+    {
+        lNumCands = plFirstCand[i+1] - plFirstCand[i];
+        g_pFCandIn = fopen(argv[optind+i], "r");
+        if (NULL == g_pFCandIn)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed! %s.\n",
+                           argv[optind+i],
+                           strerror(errno));
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if ((fseek(g_pFCandIn, sizeof(YAPP_SP_FILEHEADER), SEEK_SET) != 0)
+            || (fread(&pstCands[plFirstCand[i]],
+                      sizeof(YAPP_SP_CAND),
+                      lNumCands,
+                      g_pFCandIn) != (size_t) lNumCands))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading candidate file %s failed!\n",
+                           argv[optind+i]);
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        (void) fclose(g_pFCandIn);
+        g_pFCandIn = NULL;
+
+        for (l = plFirstCand[i]; l < plFirstCand[i+1]; ++l)
+        {
+            pstEvents[l].dTime = ((pstFileHeaders[i].dTStart - dMJDRef)
+                                  * 86400)
+                                 + pstCands[l].dTime;
+            pstEvents[l].iBeam = i;
+            pstEvents[l].lCand = l;
+        }
+    }
+    lNumCands = plFirstCand[iNumBeams];
+
+    /* sort the candidates of all beams in time order, and sweep a window of
+       width twice the tolerance along the time axis, keeping count of the
+       number of beams with events in the window - the window is centred on
+       each event in turn, and the event is rejected if it is seen in too
+       many beams */
+    qsort(pstEvents, lNumCands, sizeof(YAPP_CO_EVENT), YAPP_CO_CompareEvents);
+    dTTol /= 1e3;   /* convert to s */
+    for (l = 0; l < lNumCands; ++l)
+    {
+        /* add the events up to the end of the window */
+        while ((lHi < lNumCands)
+               && (pstEvents[lHi].dTime <= (pstEvents[l].dTime + dTTol)))
+        {
+            if (0 == piBeamCount[pstEvents[lHi].iBeam])
+            {
+                ++iNumBeamsSeen;
+            }
+            ++piBeamCount[pstEvents[lHi].iBeam];
+            ++lHi;
+        }
+        /* remove the events before the start of the window */
+        while (pstEvents[lLo].dTime < (pstEvents[l].dTime - dTTol))
+        {
+            --piBeamCount[pstEvents[lLo].iBeam];
+            if (0 == piBeamCount[pstEvents[lLo].iBeam])
+            {
+                --iNumBeamsSeen;
+            }
+            ++lLo;
+        }
+
+        if (iNumBeamsSeen > iMaxBeams)
+        {
+            pcRejected[pstEvents[l].lCand] = YAPP_TRUE;
+        }
+    }
+
+    /* the output files are written next to the input files, so that beams
+       in different directories with the same file name do not clash - a
+       file given twice would have its output written twice, so refuse it
+       before any are written */
+    for (i = 0; i < iNumBeams; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            if (0 == strcmp(argv[optind+i], argv[optind+j]))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: File %s given more than once!\n",
+                               argv[optind+i]);
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+    }
+
+    /* write the remaining candidates of each beam */
+    for (i = 0; i < iNumBeams; ++i)
+    {
+        iRet = YAPP_CO_WriteCands(argv[optind+i],
+                                  &pstFileHeaders[i],
+                                  &pstCands[plFirstCand[i]],
+                                  &pcRejected[plFirstCand[i]],
+                                  plFirstCand[i+1] - plFirstCand[i],
+                                  &lNumKept);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Writing candidates failed!\n");
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        (void) printf("Beam %d: %ld of %ld candidates kept.\n",
+                      pstFileHeaders[i].iBeamID,
+                      lNumKept,
+                      plFirstCand[i+1] - plFirstCand[i]);
+        lTotNumKept += lNumKept;
+    }
+    (void) printf("Rejected %ld of %ld candidates as seen in more than %d "
+                  "beams.\n",
+                  lNumCands - lTotNumKept,
+                  lNumCands,
+                  iMaxBeams);
+
+    CleanUp();
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Event comparison function for qsort() - sorts in time order, and then in
+ * beam order
+ */
+int YAPP_CO_CompareEvents(const void *pvEvent1, const void *pvEvent2)
+{
+    const YAPP_CO_EVENT *pstEvent1 = (const YAPP_CO_EVENT *) pvEvent1;
+    const YAPP_CO_EVENT *pstEvent2 = (const YAPP_CO_EVENT *) pvEvent2;
+
+    if (pstEvent1->dTime != pstEvent2->dTime)
+    {
+        return (pstEvent1->dTime < pstEvent2->dTime) ? -1 : 1;
+    }
+    if (pstEvent1->iBeam != pstEvent2->iBeam)
+    {
+        return (pstEvent1->iBeam < pstEvent2->iBeam) ? -1 : 1;
+    }
+
+    return (pstEvent1->lCand < pstEvent2->lCand) ? -1
+           : (pstEvent1->lCand > pstEvent2->lCand);
+}
+
+
+/*
+ * Build the name of an output file, next to the input file, with the input
+ * extension replaced by the coincidence infix and the given extension
+ */
+static void YAPP_CO_GetOutputName(char *pcFileCand,
+                                  const char *pcExt,
+                                  char *pcFileOut)
+{
+    char *pcSlash = strrchr(pcFileCand, '/');
+    char *pcDot = strrchr(pcFileCand, '.');
+    int iLen = (int) strlen(pcFileCand);
+
+    if ((pcDot != NULL) && ((NULL == pcSlash) || (pcDot > pcSlash)))
+    {
+        iLen = (int) (pcDot - pcFileCand);
+    }
+    (void) snprintf(pcFileOut,
+                    LEN_GENSTRING,
+                    "%.*s.%s%s",
+                    iLen,
+                    pcFileCand,
+                    INFIX_COINC,
+                    pcExt);
+
+    return;
+}
+
+
+/*
+ * Write the candidates of a beam that were not rejected, in their original
+ * order, to binary and CSV candidate files next to the input file
+ */
+static int YAPP_CO_WriteCands(char *pcFileCand,
+                              YAPP_SP_FILEHEADER *pstFileHeader,
+                              YAPP_SP_CAND *pstCands,
+                              char *pcRejected,
+                              long lNumCands,
+                              long *plNumKept)
+{
+    char acFileOut[LEN_GENSTRING] = {0};
+    long l = 0;
+
+    YAPP_CO_GetOutputName(pcFileCand, EXT_YAPP_SPCAND, acFileOut);
+    g_pFCandBin = fopen(acFileOut, "w");
+    if (NULL == g_pFCandBin)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileOut,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    YAPP_CO_GetOutputName(pcFileCand, EXT_CSV, acFileOut);
+    g_pFCandCSV = fopen(acFileOut, "w");
+    if (NULL == g_pFCandCSV)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileOut,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    if (fwrite(pstFileHeader, sizeof(YAPP_SP_FILEHEADER), 1, g_pFCandBin)
+        != 1)
+    {
+        return YAPP_RET_ERROR;
+    }
+    (void) fprintf(g_pFCandCSV, "sample,time,dm,snr,width,events\n");
+
+    *plNumKept = 0;
+    for (l = 0; l < lNumCands; ++l)
+    {
+        if (pcRejected[l])
+        {
+            continue;
+        }
+        if (fwrite(&pstCands[l], sizeof(YAPP_SP_CAND), 1, g_pFCandBin) != 1)
+        {
+            return YAPP_RET_ERROR;
+        }
+        (void) fprintf(g_pFCandCSV,
+                       "%ld,%.9f,%g,%g,%d,%d\n",
+                       (long) pstCands[l].lSamp,
+                       pstCands[l].dTime,
+                       pstCands[l].fDM,
+                       pstCands[l].fSNR,
+                       pstCands[l].iWidth,
+                       pstCands[l].iNumEvents);
+        ++(*plNumKept);
+    }
+
+    (void) fclose(g_pFCandBin);
+    g_pFCandBin = NULL;
+    (void) fclose(g_pFCandCSV);
+    g_pFCandCSV = NULL;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Cleans up
+ */
+static void CleanUp()
+{
+    if (g_pFCandIn != NULL)
+    {
+        (void) fclose(g_pFCandIn);
+        g_pFCandIn = NULL;
+    }
+    if (g_pFCandBin != NULL)
+    {
+        (void) fclose(g_pFCandBin);
+        g_pFCandBin = NULL;
+    }
+    if (g_pFCandCSV != NULL)
+    {
+        (void) fclose(g_pFCandCSV);
+        g_pFCandCSV = NULL;
+    }
+    YAPP_CleanUp();
+
+    return;
+}
+
+
+/*
+ * Prints usage information
+ */
+void PrintUsage(const char *pcProgName)
+{
+    (void) printf("Usage: %s [options] <cand-file-beam0> ... "
+                  "<cand-file-beamN-1>\n",
+                  pcProgName);
+    (void) printf("    -h  --help                          ");
+    (void) printf("Display this usage information\n");
+    (void) printf("    -k  --ttol <ms>                     ");
+    (void) printf("Time tolerance\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 10 ms)\n");
+    (void) printf("    -m  --maxbeams <beams>              ");
+    (void) printf("Maximum number of beams in which a\n");
+    (void) printf("                                        ");
+    (void) printf("candidate may be seen\n");
+    (void) printf("                                        ");
+    (void) printf("(default is half the number of\n");
+    (void) printf("                                        ");
+    (void) printf("beams)\n");
+    (void) printf("    -v  --version                       ");
+    (void) printf("Display the version\n");
+
+    return;
+}
+
@@ -0,0 +1,39 @@
+/**
+ * @file yapp_coincidence.h
+ * Header file for yapp_coincidence
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_COINCIDENCE_H__
+#define __YAPP_COINCIDENCE_H__
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_CO_TTOL             10.0    /**< @brief Default time tolerance,
+                                             in ms */
+/* @} */
+
+/**
+ * Candidate from one beam, placed on the common time axis of all beams
+ */
+typedef struct tagCOEvent
+{
+    double dTime;           /* time of the candidate, in s since the earliest
+                               start time of all beams */
+    int iBeam;              /* index of the input file */
+    long lCand;             /* index of the candidate in the candidates of all
+                               beams */
+} YAPP_CO_EVENT;
+
+/**
+ * Event comparison function for qsort() - sorts in time order, and then in
+ * beam order
+ */
+int YAPP_CO_CompareEvents(const void *pvEvent1, const void *pvEvent2);
+
+#endif  /* __YAPP_COINCIDENCE_H__ */
+
@@ -11,6 +11,11 @@
 #include "yapp_psrfits.h"
 #include "yapp_presto.h"
 #include <fitsio.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/xattr.h>
+#endif
 
 const char g_aacSP_ObsNames[YAPP_SP_NUMOBS][LEN_GENSTRING] = {
     YAPP_SP_OBS_FAKE,
@@ -36,6 +41,16 @@ int g_iPGDev = 0;
 /* data file */
 FILE *g_pFData = NULL;
 
+/* flag to use cached statistics */
+char g_cUseStatsCache = YAPP_TRUE;
+
+/* flag to cache statistics - off by default, so that reading the metadata of
+   a file does not modify it */
+char g_cWriteStatsCache = YAPP_FALSE;
+
+static char* ReadSIGPROCHeaderBlock(char *pcFileSpec, size_t *piLen);
+static void CloseSIGPROCHeaderBlock(char *pcHdr);
+
 /* data buffer */
 static float *g_pfBuf = NULL;
 
@@ -79,6 +94,10 @@ int YAPP_GetFileType(char *pcFile)
     {
         iFormat = YAPP_FORMAT_DTS_DAT;
     }
+    else if (0 == strcmp(pcExt, EXT_SHM))
+    {
+        iFormat = YAPP_FORMAT_SHM;
+    }
     else
     {
         (void) fprintf(stderr,
@@ -894,17 +913,25 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
     double dChanBW = 0.0;
     int iObsID = 0;
     char acTemp[LEN_GENSTRING] = {0};
+    char *pcHdr = NULL;
+    size_t iHdrBufLen = 0;
 
     assert((YAPP_FORMAT_FIL == iFormat) || (YAPP_FORMAT_DTS_TIM == iFormat));
 
-    /* open the data file for reading */
-    g_pFData = fopen(pcFileSpec, "r");
+    /* read the header in one go, and parse it from memory */
+    pcHdr = ReadSIGPROCHeaderBlock(pcFileSpec, &iHdrBufLen);
+    if (NULL == pcHdr)
+    {
+        return YAPP_RET_ERROR;
+    }
+    g_pFData = fmemopen(pcHdr, iHdrBufLen, "r");
     if (NULL == g_pFData)
     {
         (void) fprintf(stderr,
-                       "ERROR: Opening file %s failed! %s.\n",
+                       "ERROR: Opening header of %s failed! %s.\n",
                        pcFileSpec,
                        strerror(errno));
+        free(pcHdr);
         return YAPP_RET_ERROR;
     }
 
@@ -914,6 +941,8 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
     /* if this is a file with header, iLen should be strlen(HEADER_START) */
     if (iLen != strlen(YAPP_SP_LABEL_HDRSTART))
     {
+        CloseSIGPROCHeaderBlock(pcHdr);
+
         /* this must be a headerless/header-separated filterbank file, so open
            the external header file */
         iRet = YAPP_ReadSIGPROCHeaderFile(pcFileSpec, pstYUM);
@@ -931,6 +960,7 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
     {
         (void) fprintf(stderr,
                        "ERROR: Missing label %s!\n", YAPP_SP_LABEL_HDRSTART);
+        CloseSIGPROCHeaderBlock(pcHdr);
         return YAPP_RET_ERROR;
     }
     pstYUM->iHeaderLen += (sizeof(iLen) + iLen);
@@ -1155,6 +1185,7 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
                 (void) fprintf(stderr,
                                "ERROR: Unexpected label %s found!",
                                acLabel);
+                CloseSIGPROCHeaderBlock(pcHdr);
                 return YAPP_RET_ERROR;
             }
 
@@ -1169,6 +1200,7 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
                                "ERROR: Memory allocation for frequency "
                                " channel array failed! %s!\n",
                                strerror(errno));
+                CloseSIGPROCHeaderBlock(pcHdr);
                 return YAPP_RET_ERROR;
             }
 
@@ -1197,6 +1229,7 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
                         (void) fprintf(stderr,
                                        "WARNING: Unknown field label %s "
                                        "encountered!\n", acLabel);
+                        CloseSIGPROCHeaderBlock(pcHdr);
                         return YAPP_RET_ERROR;
                     }
                 }
@@ -1215,11 +1248,9 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
         }
     }
 
-    /* close the file, it may be opened later for reading data */
-    (void) fclose(g_pFData);
-    /* set the stream pointer to NULL so that YAPP_CleanUp does not try to
-       close it */
-    g_pFData = NULL;
+    /* close the header stream - the file may be opened later for reading
+       data */
+    CloseSIGPROCHeaderBlock(pcHdr);
 
     if (pstYUM->fChanBW < 0.0)
     {
@@ -1343,6 +1374,106 @@ int YAPP_ReadSIGPROCHeader(char *pcFileSpec, int iFormat, YUM_t *pstYUM)
 }
 
 
+/*
+ * Read the whole of a SIGPROC header into memory - the first block read
+ * normally holds the whole header, otherwise the buffer is grown until it holds
+ * the end-of-header label, or the whole file. A file that does not start with
+ * the start-of-header label is headerless, so only its first block is read.
+ */
+static char* ReadSIGPROCHeaderBlock(char *pcFileSpec, size_t *piLen)
+{
+    FILE *pFHdr = NULL;
+    char *pcHdr = NULL;
+    char *pcTemp = NULL;
+    size_t iSize = YAPP_SP_HDRBLOCK;
+    size_t iLen = 0;
+
+    /* open the data file for reading */
+    pFHdr = fopen(pcFileSpec, "r");
+    if (NULL == pFHdr)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileSpec,
+                       strerror(errno));
+        return NULL;
+    }
+
+    for (;;)
+    {
+        pcTemp = (char *) realloc(pcHdr, iSize);
+        if (NULL == pcTemp)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation for header failed! "
+                           "%s!\n",
+                           strerror(errno));
+            free(pcHdr);
+            (void) fclose(pFHdr);
+            return NULL;
+        }
+        pcHdr = pcTemp;
+
+        iLen += fread(pcHdr + iLen, sizeof(char), iSize - iLen, pFHdr);
+        if (ferror(pFHdr))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading header of %s failed!\n",
+                           pcFileSpec);
+            free(pcHdr);
+            (void) fclose(pFHdr);
+            return NULL;
+        }
+        if ((iLen < iSize)
+            || (iLen < (sizeof(int) + strlen(YAPP_SP_LABEL_HDRSTART)))
+            || (memcmp(pcHdr + sizeof(int),
+                       YAPP_SP_LABEL_HDRSTART,
+                       strlen(YAPP_SP_LABEL_HDRSTART)) != 0)
+            || (memmem(pcHdr,
+                       iLen,
+                       YAPP_SP_LABEL_HDREND,
+                       strlen(YAPP_SP_LABEL_HDREND)) != NULL))
+        {
+            break;
+        }
+        if (iSize >= YAPP_SP_MAXHDRSIZE)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: No label %s in the first %d bytes of %s!\n",
+                           YAPP_SP_LABEL_HDREND,
+                           YAPP_SP_MAXHDRSIZE,
+                           pcFileSpec);
+            free(pcHdr);
+            (void) fclose(pFHdr);
+            return NULL;
+        }
+        iSize *= 2;
+    }
+
+    (void) fclose(pFHdr);
+
+    *piLen = iLen;
+    return pcHdr;
+}
+
+
+/*
+ * Close the stream that a SIGPROC header is parsed from, and free the header
+ * read into memory - on every way out of YAPP_ReadSIGPROCHeader once the
+ * stream is open
+ */
+static void CloseSIGPROCHeaderBlock(char *pcHdr)
+{
+    (void) fclose(g_pFData);
+    /* set the stream pointer to NULL so that YAPP_CleanUp does not try to
+       close it */
+    g_pFData = NULL;
+    free(pcHdr);
+
+    return;
+}
+
+
 int YAPP_ReadSIGPROCHeaderFile(char *pcFileSpec, YUM_t *pstYUM)
 {
     FILE* pFHdr = NULL;
@@ -1677,7 +1808,6 @@ int YAPP_ReadData(FILE *pFData,
     static char cIsFirst = YAPP_TRUE;
     static char *pcBuf = NULL;
     int iReadItems = 0;
-    int i = 0;
 
     /* kludgy way to reset the static variable cIsFirst */
     if (NULL == pFData)
@@ -1716,60 +1846,198 @@ int YAPP_ReadData(FILE *pFData,
     }
     iReadItems = (int) ((float) iReadItems / fSampSize);
 
-    if (YAPP_SAMPSIZE_32 == (fSampSize * YAPP_BYTE2BIT_FACTOR))
+    (void) YAPP_UnpackData(pcBuf, pfBuf, fSampSize, iReadItems);
+
+    return iReadItems;
+}
+
+
+/*
+ * Convert raw samples to floating-point
+ */
+int YAPP_UnpackData(char *pcBuf,
+                    float *pfBuf,
+                    float fSampSize,
+                    int iNumItems)
+{
+    YAPP_LIB_Unpack(pcBuf,
+                    (int) (fSampSize * YAPP_BYTE2BIT_FACTOR),
+                    (long) iNumItems,
+                    pfBuf);
+
+    return iNumItems;
+}
+
+
+/*
+ * Describe filterbank data to the libyapp kernels
+ */
+void YAPP_GetLibMeta(YUM_t *pstYUM, YAPP_LIB_META *pstMeta)
+{
+    (void) memset(pstMeta, '\0', sizeof(YAPP_LIB_META));
+    pstMeta->iNumChans = pstYUM->iNumChans;
+    pstMeta->iNumBits = (int) (pstYUM->fSampSize * YAPP_BYTE2BIT_FACTOR);
+    pstMeta->iNumIFs = 1;
+    pstMeta->dTSamp = pstYUM->dTSamp / 1e3;
+    pstMeta->dTStart = pstYUM->dTStart;
+    if (pstYUM->cIsBandFlipped)
     {
-        /* 32-bit/4-byte data */
-        /* copy data from the byte buffer to the float buffer */
-        (void) memcpy(pfBuf, pcBuf, (int) (iTotSampsPerBlock * fSampSize));
+        pstMeta->dFChan1 = pstYUM->fFMax;
+        pstMeta->dChanBW = -pstYUM->fChanBW;
     }
-    else if (YAPP_SAMPSIZE_16 == (fSampSize * YAPP_BYTE2BIT_FACTOR))
+    else
     {
-        /* 16-bit/2-byte data */
-        short int* psBuf = (short int*) pcBuf;
-        for (i = 0; i < iReadItems; ++i)
-        {
-            pfBuf[i] = (float) psBuf[i];
-        }
+        pstMeta->dFChan1 = pstYUM->fFMin;
+        pstMeta->dChanBW = pstYUM->fChanBW;
+    }
+
+    return;
+}
+
+
+/*
+ * Copy the data in a file, from an offset to the end of the file, to the
+ * current position of an output file
+ */
+int YAPP_CopyFileData(char *pcFileData, off_t lOffset, FILE *pFOut)
+{
+    int iFDIn = -1;
+    int iFDOut = -1;
+    struct stat stFileStats = {0};
+    off_t lDataLen = 0;
+    off_t lByteCount = 0;
+    ssize_t lRet = 0;
+    ssize_t lWritten = 0;
+    ssize_t lOut = 0;
+    char *pcBuf = NULL;
+    /* copy methods, tried in order - copy_file_range() lets file systems that
+       support it share the data or copy it on the server, sendfile() copies
+       across file systems on older kernels, and the buffered copy works
+       everywhere */
+    enum { COPY_RANGE, COPY_SENDFILE, COPY_BUFFERED } eMethod = COPY_RANGE;
+
+    /* open the file */
+    iFDIn = open(pcFileData, O_RDONLY);
+    if (-1 == iFDIn)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileData,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    /* get the file size */
+    if (fstat(iFDIn, &stFileStats) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Failed to stat %s: %s!\n",
+                       pcFileData,
+                       strerror(errno));
+        (void) close(iFDIn);
+        return YAPP_RET_ERROR;
     }
-    else if (YAPP_SAMPSIZE_8 == (fSampSize * YAPP_BYTE2BIT_FACTOR))
+    lDataLen = stFileStats.st_size - lOffset;
+
+    /* skip header */
+    if (lseek(iFDIn, lOffset, SEEK_SET) != lOffset)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Seeking to data in %s failed! %s.\n",
+                       pcFileData,
+                       strerror(errno));
+        (void) close(iFDIn);
+        return YAPP_RET_ERROR;
+    }
+
+    /* write out anything buffered in the output stream, so that the data
+       follows it */
+    (void) fflush(pFOut);
+    iFDOut = fileno(pFOut);
+
+#ifndef __linux__
+    eMethod = COPY_BUFFERED;
+#endif
+
+    /* copy data */
+    while (lByteCount < lDataLen)
     {
-        /* 8-bit/1-byte data */
-        /* copy data from the byte buffer to the float buffer */
-        #if 0
-        //TODO: this works for VEGAS viewdata
-        for (i = 0; i < iReadItems; ++i)
+#ifdef __linux__
+        if (COPY_RANGE == eMethod)
+        {
+            lRet = copy_file_range(iFDIn,
+                                   NULL,
+                                   iFDOut,
+                                   NULL,
+                                   (size_t) (lDataLen - lByteCount),
+                                   0);
+        }
+        else if (COPY_SENDFILE == eMethod)
+        {
+            lRet = sendfile(iFDOut,
+                            iFDIn,
+                            NULL,
+                            (size_t) (lDataLen - lByteCount));
+        }
+        else
+#endif
         {
-            if (pcBuf[i] >= 0)
+            if (NULL == pcBuf)
             {
-                pcBuf[i] = 128 - pcBuf[i];
+                pcBuf = (char *) malloc(SIZE_COPY_BUF);
+                if (NULL == pcBuf)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Memory allocation for buffer "
+                                   "failed! %s!\n",
+                                   strerror(errno));
+                    (void) close(iFDIn);
+                    return YAPP_RET_ERROR;
+                }
             }
-            else
+            lRet = read(iFDIn, pcBuf, SIZE_COPY_BUF);
+            for (lWritten = 0; (lRet > 0) && (lWritten < lRet); )
             {
-                pcBuf[i] = 128 + pcBuf[i];
+                lOut = write(iFDOut,
+                             pcBuf + lWritten,
+                             (size_t) (lRet - lWritten));
+                if (lOut <= 0)
+                {
+                    lRet = -1;
+                    break;
+                }
+                lWritten += lOut;
             }
-            pfBuf[i] = (float) pcBuf[i];
         }
-        #else
-        for (i = 0; i < iReadItems; ++i)
+        if ((-1 == lRet) && (eMethod != COPY_BUFFERED))
         {
-            pfBuf[i] = (float) pcBuf[i];
+            /* not supported for these files, so fall back to the next
+               method - a real I/O error will recur, and be reported, with the
+               buffered copy */
+            ++eMethod;
+            continue;
         }
-        #endif
-    }
-    else if (YAPP_SAMPSIZE_4 == (fSampSize * YAPP_BYTE2BIT_FACTOR))
-    {
-        /* 4-bit/0.5-byte data */
-        /* copy data from the byte buffer to the float buffer */
-        for (i = 0; i < (iReadItems / 2); ++i)
+        if (lRet <= 0)
         {
-            /* copy lower 4 bits */
-            pfBuf[2*i] = pcBuf[i] & 0x0F;
-            /* copy upper 4 bits */
-            pfBuf[(2*i)+1] = (pcBuf[i] & 0xF0) >> 4;
+            break;
         }
+        lByteCount += lRet;
     }
 
-    return iReadItems;
+    free(pcBuf);
+    (void) close(iFDIn);
+
+    /* check if all data has been copied */
+    if (lByteCount != lDataLen)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Data copy failed! Copied %ld of %ld bytes.\n",
+                       (long int) lByteCount,
+                       (long int) lDataLen);
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
 }
 
 
@@ -2150,6 +2418,14 @@ int YAPP_CalcStats(char *pcFileData, int iFormat, YUM_t *pstYUM)
         assert(pstYUM->iHeaderLen != 0);
     }
 
+    /* use the cached statistics, if the file has not changed since they were
+       calculated */
+    if ((YAPP_TRUE == g_cUseStatsCache)
+        && (YAPP_RET_SUCCESS == YAPP_ReadStatsCache(pcFileData, pstYUM)))
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
     /* open the data file for reading */
     g_pFData = fopen(pcFileData, "r");
     if (NULL == g_pFData)
@@ -2262,10 +2538,96 @@ int YAPP_CalcStats(char *pcFileData, int iFormat, YUM_t *pstYUM)
        close it */
     g_pFData = NULL;
 
+    /* a file that cannot be written to, or a file system that does not support
+       extended attributes, means that the statistics are calculated every
+       time, which is not an error */
+    if (YAPP_TRUE == g_cWriteStatsCache)
+    {
+        (void) YAPP_WriteStatsCache(pcFileData, pstYUM);
+    }
+
     return YAPP_RET_SUCCESS;
 }
 
 
+/*
+ * Read the statistics of a file from its cache
+ */
+int YAPP_ReadStatsCache(char *pcFileData, YUM_t *pstYUM)
+{
+#ifdef __linux__
+    YAPP_STATS_CACHE stCache = {0};
+    struct stat stFileStats = {0};
+    ssize_t lLen = 0;
+
+    if (stat(pcFileData, &stFileStats) != 0)
+    {
+        return YAPP_RET_ERROR;
+    }
+    lLen = getxattr(pcFileData, YAPP_STATS_XATTR, &stCache, sizeof(stCache));
+    if ((lLen != sizeof(stCache))
+        || (stCache.iVersion != YAPP_STATS_VERSION)
+        || (stCache.iHeaderLen != pstYUM->iHeaderLen)
+        || (stCache.lSize != (long int) stFileStats.st_size)
+        || (stCache.lMTimeSec != (long int) stFileStats.st_mtim.tv_sec)
+        || (stCache.lMTimeNSec != (long int) stFileStats.st_mtim.tv_nsec))
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    pstYUM->fMin = stCache.fMin;
+    pstYUM->fMax = stCache.fMax;
+    pstYUM->fMean = stCache.fMean;
+    pstYUM->fRMS = stCache.fRMS;
+
+    return YAPP_RET_SUCCESS;
+#else
+    return YAPP_RET_ERROR;
+#endif
+}
+
+
+/*
+ * Cache the statistics of a file
+ */
+int YAPP_WriteStatsCache(char *pcFileData, YUM_t *pstYUM)
+{
+#ifdef __linux__
+    YAPP_STATS_CACHE stCache = {0};
+    struct stat stFileStats = {0};
+
+    if (stat(pcFileData, &stFileStats) != 0)
+    {
+        return YAPP_RET_ERROR;
+    }
+    stCache.iVersion = YAPP_STATS_VERSION;
+    stCache.iHeaderLen = pstYUM->iHeaderLen;
+    stCache.lSize = (long int) stFileStats.st_size;
+    stCache.lMTimeSec = (long int) stFileStats.st_mtim.tv_sec;
+    stCache.lMTimeNSec = (long int) stFileStats.st_mtim.tv_nsec;
+    stCache.fMin = pstYUM->fMin;
+    stCache.fMax = pstYUM->fMax;
+    stCache.fMean = pstYUM->fMean;
+    stCache.fRMS = pstYUM->fRMS;
+
+    /* setting an extended attribute does not change the modification time,
+       so the cache stays valid */
+    if (setxattr(pcFileData,
+                 YAPP_STATS_XATTR,
+                 &stCache,
+                 sizeof(stCache),
+                 0) != 0)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+#else
+    return YAPP_RET_ERROR;
+#endif
+}
+
+
 /*
  * Calculate signal mean
  */
@@ -2307,6 +2669,58 @@ float YAPP_CalcRMS(float *pfBuf,
 }
 
 
+/*
+ * Compute the median of a buffer, in place, using Wirth's selection
+ * algorithm
+ */
+float YAPP_CalcMedian(float *pfBuf, int iLength)
+{
+    int iK = iLength / 2;
+    int iLo = 0;
+    int iHi = iLength - 1;
+    int i = 0;
+    int j = 0;
+    float fPivot = 0.0;
+    float fTemp = 0.0;
+
+    while (iLo < iHi)
+    {
+        fPivot = pfBuf[iK];
+        i = iLo;
+        j = iHi;
+        do
+        {
+            while (pfBuf[i] < fPivot)
+            {
+                ++i;
+            }
+            while (fPivot < pfBuf[j])
+            {
+                --j;
+            }
+            if (i <= j)
+            {
+                fTemp = pfBuf[i];
+                pfBuf[i] = pfBuf[j];
+                pfBuf[j] = fTemp;
+                ++i;
+                --j;
+            }
+        } while (i <= j);
+        if (j < iK)
+        {
+            iLo = i;
+        }
+        if (iK < i)
+        {
+            iHi = j;
+        }
+    }
+
+    return pfBuf[iK];
+}
+
+
 /*
  * The memory allocator
  */
@@ -2362,6 +2776,9 @@ void YAPP_CleanUp()
             g_apvMemTable[i] = NULL;
         }
     }
+    /* the table is empty, so that it can be filled again, for instance, when
+       processing many files in turn */
+    g_iMemTableSize = 0;
 
     #if 0
     /* close PGPLOT device, if open */
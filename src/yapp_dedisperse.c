@@ -23,6 +23,16 @@
  *     -o  --out-format <format>            Output format - 'dds', 'tim', or
  *                                          'fil'
  *                                          (default is 'tim')
+ *     -r  --rfi <sigmas>                   Flag RFI at this threshold, using
+ *                                          spectral kurtosis and clipping,
+ *                                          and write the flags to a mask file
+ *                                          (default is no RFI flagging)
+ *     -z  --zerodm                         Subtract the zero-DM time series
+ *     -k  --mask <mask-file>               Replace the samples flagged in this
+ *                                          RFI mask file with channel means
+ *     -y  --pol <pol>                      Polarization to read from
+ *                                          PSRFITS data - 'X', 'Y', or
+ *                                          'sum' (default is 'sum')
  *     -g  --graphics                       Turn on plotting
  *     -m  --colour-map <name>              Colour map for plotting
  *                                          (default is 'jet')
@@ -37,7 +47,10 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_psrfits.h"   /* for PSRFITS file format support */
+#include "yapp_shm.h"      /* for shared-memory ring buffer input */
 #include "colourmap.h"
+#include "yapp_rfi.h"
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -89,7 +102,6 @@ int main(int argc, char *argv[])
     float fStatBW = 0.0;
     float fNoiseRMS = 0.0;
     double dTNextBF = 0.0;
-    double dTSamp = 0.0;        /* holds sampling time in ms */
     double dTSampInSec = 0.0;   /* holds sampling time in s */
     double dTNow = 0.0;
     int iTimeSect = 0;
@@ -134,17 +146,24 @@ int main(int argc, char *argv[])
     int k = 0;
     int l = 0;
     int m = 0;
-    double dDelay = 0.0;
+    YAPP_LIB_META stMeta = {{0}};
     int iStartOffset = 0;
     float fStartOffset = 0.0;
     char cHasGraphics = YAPP_FALSE;
     int iColourMap = DEF_CMAP;
+    YAPP_RFI stRFI = {0};
+    float fRFIThreshold = 0.0;
+    char cZeroDM = YAPP_FALSE;
+    char acFileMask[LEN_GENSTRING] = {0};
+    YAPP_RFI_MASK stMask = {{{0}}};
+    char *pcFileMaskIn = NULL;
     int iInvCols = YAPP_FALSE;
     char cIsNonInteractive = YAPP_FALSE;
     const char *pcProgName = NULL;
+    int iPol = YAPP_PF_POL_SUM;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hs:p:n:d:l:b:u:o:gm:iev";
+    const char* const pcOptsShort = "hs:p:n:d:l:b:u:o:r:zk:y:gm:iev";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
@@ -156,6 +175,10 @@ int main(int argc, char *argv[])
         { "nsubband",               1, NULL, 'b' },
         { "subband",                1, NULL, 'u' },
         { "out-format",             1, NULL, 'o' },
+        { "rfi",                    1, NULL, 'r' },
+        { "zerodm",                 0, NULL, 'z' },
+        { "mask",                   1, NULL, 'k' },
+        { "pol",                    1, NULL, 'y' },
         { "graphics",               0, NULL, 'g' },
         { "colour-map",             1, NULL, 'm' },
         { "invert",                 0, NULL, 'i' },
@@ -246,6 +269,39 @@ int main(int argc, char *argv[])
                 }
                 break;
 
+            case 'r':   /* -r or --rfi */
+                /* set option */
+                fRFIThreshold = atof(optarg);
+                /* validate */
+                if (fRFIThreshold <= 0.0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: RFI threshold must be > 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'z':   /* -z or --zerodm */
+                /* set option */
+                cZeroDM = YAPP_TRUE;
+                break;
+
+            case 'k':   /* -k or --mask */
+                /* set option */
+                pcFileMaskIn = optarg;
+                break;
+
+            case 'y':   /* -y or --pol */
+                /* set option */
+                iPol = YAPP_PF_GetPolFromName(optarg);
+                if (YAPP_RET_ERROR == iPol)
+                {
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
             case 'g':   /* -g or --graphics */
                 /* set option */
                 cHasGraphics = YAPP_TRUE;
@@ -341,24 +397,60 @@ int main(int argc, char *argv[])
                        "ERROR: File type determination failed!\n");
         return YAPP_RET_ERROR;
     }
-    if (!((YAPP_FORMAT_FIL == iFormat) || (YAPP_FORMAT_SPEC == iFormat)))
+    if (!((YAPP_FORMAT_FIL == iFormat)
+          || (YAPP_FORMAT_SPEC == iFormat)
+          || (YAPP_FORMAT_PSRFITS == iFormat)
+          || (YAPP_FORMAT_SHM == iFormat)))
     {
         (void) fprintf(stderr,
                        "ERROR: Invalid file type!\n");
         return YAPP_RET_ERROR;
     }
 
-    /* read metadata */
-    iRet = YAPP_ReadMetadata(pcFileSpec, iFormat, &stYUM);
-    if (iRet != YAPP_RET_SUCCESS)
+    if (YAPP_FORMAT_SHM == iFormat)
     {
-        (void) fprintf(stderr,
-                       "ERROR: Reading metadata failed for file %s!\n",
-                       pcFileSpec);
-        return YAPP_RET_ERROR;
+        /* attach to the ring buffer, which is read as a headerless
+           filterbank file as the producer fills it - the metadata comes from
+           the header of the ring */
+        g_pFData = YAPP_SHM_Open(pcFileSpec, YAPP_SHM_DATA_FIL, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Attaching to ring buffer %s failed!\n",
+                           pcFileSpec);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iFormat = YAPP_FORMAT_FIL;
+    }
+    else
+    {
+        /* read metadata */
+        iRet = YAPP_ReadMetadata(pcFileSpec, iFormat, &stYUM);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading metadata failed for file %s!\n",
+                           pcFileSpec);
+            return YAPP_RET_ERROR;
+        }
+    }
+    if (YAPP_FORMAT_PSRFITS == iFormat)
+    {
+        /* open the PSRFITS files as a stream of scaled, single-polarization
+           data, which is read as a headerless filterbank file from here on */
+        g_pFData = YAPP_PF_Open(pcFileSpec, iPol, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed!\n",
+                           pcFileSpec);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iFormat = YAPP_FORMAT_FIL;
     }
 
-    dTSamp = stYUM.dTSamp;
     /* convert sampling interval to seconds */
     dTSampInSec = stYUM.dTSamp / 1e3;
     fChanBW = stYUM.fChanBW;
@@ -404,11 +496,8 @@ int main(int argc, char *argv[])
     }
 
     /* calculate the corrected start time */
-    dDelay = (double) -4.148741601e6
-             * (((double) 1.0 / pow(INFINITY, fLaw))
-                - ((double) 1.0 / pow(stYUM.fFMax, fLaw)))
-             * dDM;    /* in ms */
-    iStartOffset = (int) (dDelay / stYUM.dTSamp);
+    YAPP_GetLibMeta(&stYUM, &stMeta);
+    iStartOffset = YAPP_LIB_CalcStartOffset(&stMeta, dDM, fLaw);
     fStartOffset = iStartOffset * dTSampInSec;
 
     /* ensure that the block size is at least equivalent to the maximum offset,
@@ -603,11 +692,16 @@ int main(int argc, char *argv[])
 
     fStatBW = stYUMOut.iNumGoodChans * fChanBW;  /* in MHz */
     (void) printf("Usable bandwidth                  : %g MHz\n", fStatBW);
-    fNoiseRMS = 1.0 / sqrt(fStatBW * dTSamp * 1e3);
+    fNoiseRMS = (float) YAPP_LIB_CalcNoiseRMS(stYUMOut.iNumGoodChans,
+                                              fChanBW,
+                                              dTSampInSec);
     (void) printf("Expected noise RMS                : %g\n", fNoiseRMS);
 
     /* open the data file for reading */
-    g_pFData = fopen(pcFileSpec, "r");
+    if (NULL == g_pFData)
+    {
+        g_pFData = fopen(pcFileSpec, "r");
+    }
     if (NULL == g_pFData)
     {
         (void) fprintf(stderr,
@@ -675,6 +769,53 @@ int main(int argc, char *argv[])
         (void) fseek(g_pFData, lBytesToSkip, SEEK_SET);
     }
 
+    /* read the RFI mask to be applied, if any - this is done before RFI
+       excision is set up, as the mask written by it may overwrite this */
+    if (pcFileMaskIn != NULL)
+    {
+        iRet = YAPP_RFI_ReadMask(&stMask,
+                                 pcFileMaskIn,
+                                 iNumChans,
+                                 dTSampInSec);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading RFI mask failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    /* set up RFI excision - the flags are written to a mask file only if
+       RFI is flagged */
+    if ((fRFIThreshold > 0.0) || cZeroDM)
+    {
+        if (fRFIThreshold > 0.0)
+        {
+            pcFilename = YAPP_GetFilenameFromPath(pcFileSpec);
+            (void) snprintf(acFileMask,
+                            LEN_GENSTRING,
+                            "%s%s",
+                            pcFilename,
+                            EXT_YAPP_RFIMASK);
+        }
+        iRet = YAPP_RFI_Init(&stRFI,
+                             iNumChans,
+                             iBlockSize,
+                             fRFIThreshold,
+                             cZeroDM,
+                             (fRFIThreshold > 0.0) ? acFileMask : NULL,
+                             dTSampInSec,
+                             stYUM.dTStart);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: RFI excision setup failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
     /* read the first block of data */
     (void) printf("Reading data block %d.", iReadBlockCount);
     (void) fflush(stdout);
@@ -757,6 +898,28 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* apply the RFI mask */
+    if (pcFileMaskIn != NULL)
+    {
+        YAPP_RFI_ApplyMask(&stMask, pfPriBuf, iNumSamps, iTimeSampsSkip);
+    }
+
+    /* excise RFI */
+    if ((fRFIThreshold > 0.0) || cZeroDM)
+    {
+        iRet = YAPP_RFI_Clean(&stRFI,
+                              pfPriBuf,
+                              iNumSamps,
+                              stYUM.pcIsChanGood,
+                              iTimeSampsSkip);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr, "ERROR: RFI excision failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
     if (cHasGraphics)
     {
         /* open the PGPLOT graphics device */
@@ -1151,6 +1314,38 @@ int main(int argc, char *argv[])
 
                 dTNow += dTSampInSec;   /* in s */
             }
+
+            /* apply the RFI mask */
+            if (pcFileMaskIn != NULL)
+            {
+                YAPP_RFI_ApplyMask(&stMask,
+                                   pfSecBuf,
+                                   iNumSamps,
+                                   iTimeSampsSkip
+                                   + ((long) iReadBlockCount * iBlockSize));
+            }
+
+            /* excise RFI */
+            if ((fRFIThreshold > 0.0) || cZeroDM)
+            {
+                iRet = YAPP_RFI_Clean(&stRFI,
+                                      pfSecBuf,
+                                      iNumSamps,
+                                      stYUM.pcIsChanGood,
+                                      iTimeSampsSkip
+                                      + ((long) iReadBlockCount * iBlockSize));
+                if (iRet != YAPP_RET_SUCCESS)
+                {
+                    (void) fprintf(stderr, "ERROR: RFI excision failed!\n");
+                    if (cHasGraphics)
+                    {
+                        cpgclos();
+                    }
+                    (void) fclose(pFDedispData);
+                    YAPP_CleanUp();
+                    return YAPP_RET_ERROR;
+                }
+            }
         }
 
         /* clear the g_pfDedispData array */
@@ -1461,6 +1656,22 @@ int main(int argc, char *argv[])
 
     (void) printf("DONE!\n");
 
+    if (pcFileMaskIn != NULL)
+    {
+        (void) printf("Replaced %ld samples flagged in the RFI mask.\n",
+                      stMask.lNumFlags);
+    }
+    if (fRFIThreshold > 0.0)
+    {
+        (void) printf("Flagged %ld channel-blocks and %ld samples as RFI.\n",
+                      stRFI.lNumChanFlags,
+                      stRFI.lNumSampFlags);
+    }
+    if (YAPP_RFI_Close(&stRFI) != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Writing mask file failed!\n");
+    }
+
     if (cHasGraphics)
     {
         cpgclos();
@@ -1515,6 +1726,26 @@ void PrintUsage(const char *pcProgName)
     (void) printf("Output format - 'dds', 'tim', or 'fil'\n");
     (void) printf("                                        ");
     (void) printf("(default is 'tim')\n");
+    (void) printf("    -r  --rfi <sigmas>                  ");
+    (void) printf("Flag RFI at this threshold, using\n");
+    (void) printf("                                        ");
+    (void) printf("spectral kurtosis and clipping,\n");
+    (void) printf("                                        ");
+    (void) printf("and write the flags to a mask file\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no RFI flagging)\n");
+    (void) printf("    -z  --zerodm                        ");
+    (void) printf("Subtract the zero-DM time series\n");
+    (void) printf("    -k  --mask <mask-file>              ");
+    (void) printf("Replace the samples flagged in this\n");
+    (void) printf("                                        ");
+    (void) printf("RFI mask file with channel means\n");
+    (void) printf("    -y  --pol <pol>                     ");
+    (void) printf("Polarization to read from PSRFITS\n");
+    (void) printf("                                        ");
+    (void) printf("data - 'X', 'Y', or 'sum'\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 'sum')\n");
     (void) printf("    -g  --graphics                      ");
     (void) printf("Turn on plotting\n");
     (void) printf("    -m  --colour-map <name>             ");
@@ -1538,11 +1769,7 @@ int YAPP_CalcDelays(double dDM,
                     float fLaw,
                     int* piMaxOffset)
 {
-    int i = 0;
-    float fF1 = 0.0;
-    float fF2 = 0.0;
-    double dDelay = 0.0;
-    float fFMaxCalc = stYUM.fFMax;     /* reference frequency */
+    YAPP_LIB_META stMeta = {{0}};
 
     g_piOffsetTab = (int *) YAPP_Malloc((size_t) stYUM.iNumChans,
                                         sizeof(int),
@@ -1556,12 +1783,21 @@ int YAPP_CalcDelays(double dDM,
         return YAPP_RET_ERROR;
     }
 
-    /* calculate quadratic delays */
+    /* calculate the delays with the same kernel as yapp_pipeline */
     /* NOTE: delay may not be 0 for the highest frequency channel,
        but the offset samples may be (depending on the sampling rate) */
+    YAPP_GetLibMeta(&stYUM, &stMeta);
+    if (dDM < 0)
+    {
+        /* negative DMs are applied with the band reversed */
+        stMeta.dFChan1 += (stMeta.iNumChans - 1) * stMeta.dChanBW;
+        stMeta.dChanBW = -stMeta.dChanBW;
+    }
+    *piMaxOffset = YAPP_LIB_CalcOffsets(&stMeta, dDM, fLaw, g_piOffsetTab);
 #ifdef DEBUG
     {
         FILE *pFFileDelaysQuad = NULL;
+        int i = 0;
 
         pFFileDelaysQuad = fopen(YAPP_FILE_DELAYS_QUAD, "w");
         if (NULL == pFFileDelaysQuad)
@@ -1573,102 +1809,14 @@ int YAPP_CalcDelays(double dDM,
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
-#endif
-    if (dDM < 0)
-    {
-        if (stYUM.cIsBandFlipped)
-        {
-            fF1 = fFMaxCalc;
-            fF2 = stYUM.fFMax;
-            for (i = stYUM.iNumChans - 1; i >= 0; --i)
-            {
-                dDelay = (double) -4.148741601e6
-                         * (((double) 1.0 / pow(fF1, fLaw))
-                            - ((double) 1.0 / pow(fF2, fLaw)))
-                         * dDM;    /* in ms */
-                g_piOffsetTab[i] = (int) (dDelay / stYUM.dTSamp);
-#ifdef DEBUG
-                (void) fprintf(pFFileDelaysQuad,
-                               "%d %g %d\n",
-                               i,
-                               dDelay,
-                               g_piOffsetTab[i]);
-#endif
-                fF2 -= stYUM.fChanBW;
-            }
-            *piMaxOffset = g_piOffsetTab[0];
-        }
-        else
+        for (i = 0; i < stYUM.iNumChans; ++i)
         {
-            fF1 = fFMaxCalc;
-            fF2 = stYUM.fFMax;
-            for (i = 0; i < stYUM.iNumChans; ++i)
-            {
-                dDelay = (double) -4.148741601e6
-                         * (((double) 1.0 / pow(fF1, fLaw))
-                            - ((double) 1.0 / pow(fF2, fLaw)))
-                         * dDM;    /* in ms */
-                g_piOffsetTab[i] = (int) (dDelay / stYUM.dTSamp);
-#ifdef DEBUG
-                (void) fprintf(pFFileDelaysQuad,
-                               "%d %g %d\n",
-                               i,
-                               dDelay,
-                               g_piOffsetTab[i]);
-#endif
-                fF2 -= stYUM.fChanBW;
-            }
-            *piMaxOffset = g_piOffsetTab[stYUM.iNumChans-1];
+            (void) fprintf(pFFileDelaysQuad,
+                           "%d %g %d\n",
+                           i,
+                           g_piOffsetTab[i] * stYUM.dTSamp,
+                           g_piOffsetTab[i]);
         }
-    }
-    else
-    {
-        if (stYUM.cIsBandFlipped)
-        {
-            fF1 = fFMaxCalc;
-            fF2 = stYUM.fFMax;
-            for (i = 0; i < stYUM.iNumChans; ++i)
-            {
-                dDelay = (double) -4.148741601e6
-                         * (((double) 1.0 / pow(fF1, fLaw))
-                            - ((double) 1.0 / pow(fF2, fLaw)))
-                         * dDM;    /* in ms */
-                g_piOffsetTab[i] = (int) (dDelay / stYUM.dTSamp);
-#ifdef DEBUG
-                (void) fprintf(pFFileDelaysQuad,
-                               "%d %g %d\n",
-                               i,
-                               dDelay,
-                               g_piOffsetTab[i]);
-#endif
-                fF2 -= stYUM.fChanBW;
-            }
-            *piMaxOffset = g_piOffsetTab[stYUM.iNumChans-1];
-        }
-        else
-        {
-            fF1 = fFMaxCalc;
-            fF2 = stYUM.fFMax;
-            for (i = stYUM.iNumChans - 1; i >= 0; --i)
-            {
-                dDelay = (double) -4.148741601e6
-                         * (((double) 1.0 / pow(fF1, fLaw))
-                            - ((double) 1.0 / pow(fF2, fLaw)))
-                         * dDM;    /* in ms */
-                g_piOffsetTab[i] = (int) (dDelay / stYUM.dTSamp);
-#ifdef DEBUG
-                (void) fprintf(pFFileDelaysQuad,
-                               "%d %g %d\n",
-                               i,
-                               dDelay,
-                               g_piOffsetTab[i]);
-#endif
-                fF2 -= stYUM.fChanBW;
-            }
-            *piMaxOffset = g_piOffsetTab[0];
-        }
-    }
-#ifdef DEBUG
         (void) fclose(pFFileDelaysQuad);
     }
 #endif
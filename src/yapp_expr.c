@@ -0,0 +1,931 @@
+/*
+ * @file yapp_expr.c
+ * Time series expression routines. An expression is parsed into a tree,
+ *  constant subexpressions are folded, and the tree is compiled into a
+ *  postfix program. Each operation of the program works on a whole window
+ *  of samples in a single loop, so that the loops vectorise, and binary
+ *  operations with a constant operand take it as a scalar. Moving means need
+ *  samples on either side of a block, so the margin that the whole
+ *  expression needs is computed at compile time, and the caller reads
+ *  windows that overlap by that much.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_expr.h"
+
+/* expression tree node */
+typedef struct tagExprNode
+{
+    int iOp;
+    int iVar;
+    float fValue;
+    int iWidth;
+    int iLeft;              /* operand, or the only operand */
+    int iRight;             /* second operand, or -1 */
+} YAPP_EXPR_NODE;
+
+/* parser state */
+typedef struct tagExprParser
+{
+    const char *pcExpr;
+    const char *pcPos;
+    YAPP_EXPR_NODE astNodes[YAPP_EXPR_MAXNODES];
+    int iNumNodes;
+    int iNumInputs;
+    double dTSamp;
+    float *pfMean;
+    float *pfRMS;
+    int iNumVars;
+} YAPP_EXPR_PARSER;
+
+static int ParseSum(YAPP_EXPR_PARSER *pstParser);
+static int ParseProduct(YAPP_EXPR_PARSER *pstParser);
+static int ParseUnary(YAPP_EXPR_PARSER *pstParser);
+static int ParsePrimary(YAPP_EXPR_PARSER *pstParser);
+static int ParseWidth(YAPP_EXPR_PARSER *pstParser);
+static int NewNode(YAPP_EXPR_PARSER *pstParser,
+                   int iOp,
+                   int iLeft,
+                   int iRight);
+static int NewConst(YAPP_EXPR_PARSER *pstParser, float fValue);
+static char Expect(YAPP_EXPR_PARSER *pstParser, char cChar);
+static void ParseError(YAPP_EXPR_PARSER *pstParser, const char *pcMsg);
+static int Emit(YAPP_EXPR *pstExpr,
+                YAPP_EXPR_NODE *pstNodes,
+                int iNode,
+                int iSlot);
+static void Smooth(float *pfIn,
+                   float *pfOut,
+                   double *pdCum,
+                   int iLen,
+                   int iWidth,
+                   int iValidBeg,
+                   int iValidEnd);
+
+/*
+ * Compile an expression
+ */
+int YAPP_EXPR_Compile(YAPP_EXPR *pstExpr,
+                      const char *pcExpr,
+                      int iNumInputs,
+                      double dTSamp,
+                      float *pfMean,
+                      float *pfRMS)
+{
+    YAPP_EXPR_PARSER *pstParser = NULL;
+    int iRoot = 0;
+    int iMargin = 0;
+
+    /* the parser is large, so keep it off the stack */
+    pstParser = (YAPP_EXPR_PARSER *) malloc(sizeof(YAPP_EXPR_PARSER));
+    if (NULL == pstParser)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    (void) memset(pstParser, '\0', sizeof(YAPP_EXPR_PARSER));
+    pstParser->pcExpr = pcExpr;
+    pstParser->pcPos = pcExpr;
+    pstParser->iNumInputs = iNumInputs;
+    pstParser->dTSamp = dTSamp;
+    pstParser->pfMean = pfMean;
+    pstParser->pfRMS = pfRMS;
+
+    iRoot = ParseSum(pstParser);
+    if (iRoot != YAPP_RET_ERROR)
+    {
+        while (isspace((unsigned char) *pstParser->pcPos))
+        {
+            ++pstParser->pcPos;
+        }
+        if (*pstParser->pcPos != '\0')
+        {
+            ParseError(pstParser, "Unexpected character");
+            iRoot = YAPP_RET_ERROR;
+        }
+    }
+    if (YAPP_RET_ERROR == iRoot)
+    {
+        free(pstParser);
+        return YAPP_RET_ERROR;
+    }
+
+    (void) memset(pstExpr, '\0', sizeof(YAPP_EXPR));
+    iMargin = Emit(pstExpr, pstParser->astNodes, iRoot, 0);
+    pstExpr->iNumVars = pstParser->iNumVars;
+    free(pstParser);
+    if (YAPP_RET_ERROR == iMargin)
+    {
+        return YAPP_RET_ERROR;
+    }
+    pstExpr->iMargin = iMargin;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Allocate the buffers needed to evaluate an expression
+ */
+int YAPP_EXPR_Alloc(YAPP_EXPR *pstExpr, int iLen)
+{
+    int i = 0;
+
+    pstExpr->iLen = iLen;
+    for (i = 0; i < pstExpr->iDepth; ++i)
+    {
+        pstExpr->apfSlot[i] = (float *) YAPP_Malloc((size_t) iLen,
+                                                    sizeof(float),
+                                                    YAPP_TRUE);
+        if (NULL == pstExpr->apfSlot[i])
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+    }
+    pstExpr->pdCum = (double *) YAPP_Malloc((size_t) iLen + 1,
+                                            sizeof(double),
+                                            YAPP_TRUE);
+    if (NULL == pstExpr->pdCum)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Evaluate an expression over a window of each input
+ */
+float* YAPP_EXPR_Eval(YAPP_EXPR *pstExpr,
+                      float **ppfVars,
+                      int iValidBeg,
+                      int iValidEnd)
+{
+    /* partial results - an entry points either to a slot buffer, or to the
+       window of an input, so that inputs are not copied */
+    float *apfStack[YAPP_EXPR_MAXDEPTH] = {NULL};
+    YAPP_EXPR_OP *pstOp = NULL;
+    float *pfDst = NULL;
+    float *pfA = NULL;
+    float *pfB = NULL;
+    float fValue = 0.0;
+    int iLen = pstExpr->iLen;
+    int iTop = 0;
+    int i = 0;
+    int k = 0;
+
+    for (k = 0; k < pstExpr->iNumOps; ++k)
+    {
+        pstOp = &pstExpr->astOps[k];
+        fValue = pstOp->fValue;
+
+        switch (pstOp->iOp)
+        {
+            case YAPP_EXPR_OP_CONST:
+                pfDst = pstExpr->apfSlot[iTop];
+                for (i = 0; i < iLen; ++i)
+                {
+                    pfDst[i] = fValue;
+                }
+                apfStack[iTop] = pfDst;
+                ++iTop;
+                continue;
+
+            case YAPP_EXPR_OP_VAR:
+                apfStack[iTop] = ppfVars[pstOp->iVar];
+                ++iTop;
+                continue;
+
+            default:
+                break;
+        }
+
+        /* the remaining operations replace the top of the stack, or the top
+           two entries, with their result */
+        if ((pstOp->iOp >= YAPP_EXPR_OP_ADD)
+            && (pstOp->iOp <= YAPP_EXPR_OP_DIV)
+            && !(pstOp->cHasScalar || pstOp->cScalarFirst))
+        {
+            --iTop;
+            pfB = apfStack[iTop];
+        }
+        pfA = apfStack[iTop-1];
+        pfDst = pstExpr->apfSlot[iTop-1];
+
+        switch (pstOp->iOp)
+        {
+            case YAPP_EXPR_OP_ADD:
+                if (pstOp->cHasScalar || pstOp->cScalarFirst)
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] + fValue;
+                    }
+                }
+                else
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] + pfB[i];
+                    }
+                }
+                break;
+
+            case YAPP_EXPR_OP_SUB:
+                if (pstOp->cHasScalar)
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] - fValue;
+                    }
+                }
+                else if (pstOp->cScalarFirst)
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = fValue - pfA[i];
+                    }
+                }
+                else
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] - pfB[i];
+                    }
+                }
+                break;
+
+            case YAPP_EXPR_OP_MUL:
+                if (pstOp->cHasScalar || pstOp->cScalarFirst)
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] * fValue;
+                    }
+                }
+                else
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] * pfB[i];
+                    }
+                }
+                break;
+
+            case YAPP_EXPR_OP_DIV:
+                if (pstOp->cHasScalar)
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] / fValue;
+                    }
+                }
+                else if (pstOp->cScalarFirst)
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = fValue / pfA[i];
+                    }
+                }
+                else
+                {
+                    for (i = 0; i < iLen; ++i)
+                    {
+                        pfDst[i] = pfA[i] / pfB[i];
+                    }
+                }
+                break;
+
+            case YAPP_EXPR_OP_NEG:
+                for (i = 0; i < iLen; ++i)
+                {
+                    pfDst[i] = -pfA[i];
+                }
+                break;
+
+            case YAPP_EXPR_OP_ABS:
+                for (i = 0; i < iLen; ++i)
+                {
+                    pfDst[i] = fabsf(pfA[i]);
+                }
+                break;
+
+            case YAPP_EXPR_OP_SQRT:
+                for (i = 0; i < iLen; ++i)
+                {
+                    pfDst[i] = sqrtf(pfA[i]);
+                }
+                break;
+
+            case YAPP_EXPR_OP_SMOOTH:
+                Smooth(pfA,
+                       pfDst,
+                       pstExpr->pdCum,
+                       iLen,
+                       pstOp->iWidth,
+                       iValidBeg,
+                       iValidEnd);
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+        apfStack[iTop-1] = pfDst;
+    }
+
+    return apfStack[0];
+}
+
+
+/*
+ * Parse a sum or difference of products
+ */
+static int ParseSum(YAPP_EXPR_PARSER *pstParser)
+{
+    int iLeft = 0;
+    int iRight = 0;
+    int iOp = 0;
+
+    iLeft = ParseProduct(pstParser);
+    while (iLeft != YAPP_RET_ERROR)
+    {
+        if (Expect(pstParser, '+'))
+        {
+            iOp = YAPP_EXPR_OP_ADD;
+        }
+        else if (Expect(pstParser, '-'))
+        {
+            iOp = YAPP_EXPR_OP_SUB;
+        }
+        else
+        {
+            break;
+        }
+        iRight = ParseProduct(pstParser);
+        if (YAPP_RET_ERROR == iRight)
+        {
+            return YAPP_RET_ERROR;
+        }
+        iLeft = NewNode(pstParser, iOp, iLeft, iRight);
+    }
+
+    return iLeft;
+}
+
+
+/*
+ * Parse a product or quotient of unary terms
+ */
+static int ParseProduct(YAPP_EXPR_PARSER *pstParser)
+{
+    int iLeft = 0;
+    int iRight = 0;
+    int iOp = 0;
+
+    iLeft = ParseUnary(pstParser);
+    while (iLeft != YAPP_RET_ERROR)
+    {
+        if (Expect(pstParser, '*'))
+        {
+            iOp = YAPP_EXPR_OP_MUL;
+        }
+        else if (Expect(pstParser, '/'))
+        {
+            iOp = YAPP_EXPR_OP_DIV;
+        }
+        else
+        {
+            break;
+        }
+        iRight = ParseUnary(pstParser);
+        if (YAPP_RET_ERROR == iRight)
+        {
+            return YAPP_RET_ERROR;
+        }
+        iLeft = NewNode(pstParser, iOp, iLeft, iRight);
+    }
+
+    return iLeft;
+}
+
+
+/*
+ * Parse a term, optionally negated
+ */
+static int ParseUnary(YAPP_EXPR_PARSER *pstParser)
+{
+    int iNode = 0;
+
+    if (Expect(pstParser, '-'))
+    {
+        iNode = ParseUnary(pstParser);
+        if (YAPP_RET_ERROR == iNode)
+        {
+            return YAPP_RET_ERROR;
+        }
+        return NewNode(pstParser, YAPP_EXPR_OP_NEG, iNode, -1);
+    }
+    if (Expect(pstParser, '+'))
+    {
+        return ParseUnary(pstParser);
+    }
+
+    return ParsePrimary(pstParser);
+}
+
+
+/*
+ * Parse a number, a variable, a function call, or a parenthesised
+ * expression
+ */
+static int ParsePrimary(YAPP_EXPR_PARSER *pstParser)
+{
+    char acName[LEN_GENSTRING] = {0};
+    const char *pcStart = NULL;
+    char *pcEnd = NULL;
+    double dValue = 0.0;
+    int iNode = 0;
+    int iVar = 0;
+    int iNumVars = 0;
+    int iOp = 0;
+    int iWidth = 0;
+    int iLen = 0;
+
+    if (Expect(pstParser, '('))
+    {
+        iNode = ParseSum(pstParser);
+        if (YAPP_RET_ERROR == iNode)
+        {
+            return YAPP_RET_ERROR;
+        }
+        if (!Expect(pstParser, ')'))
+        {
+            ParseError(pstParser, "Expected ')'");
+            return YAPP_RET_ERROR;
+        }
+        return iNode;
+    }
+
+    pcStart = pstParser->pcPos;
+    if (isdigit((unsigned char) *pcStart) || ('.' == *pcStart))
+    {
+        dValue = strtod(pcStart, &pcEnd);
+        pstParser->pcPos = pcEnd;
+        return NewConst(pstParser, (float) dValue);
+    }
+
+    /* read a name */
+    while (isalnum((unsigned char) pstParser->pcPos[iLen])
+           || ('_' == pstParser->pcPos[iLen]))
+    {
+        if (iLen < (LEN_GENSTRING - 1))
+        {
+            acName[iLen] = pstParser->pcPos[iLen];
+        }
+        ++iLen;
+    }
+    if (0 == iLen)
+    {
+        ParseError(pstParser, "Expected a number, variable, or function");
+        return YAPP_RET_ERROR;
+    }
+    pstParser->pcPos += iLen;
+
+    if (!Expect(pstParser, '('))
+    {
+        /* mean and rms without an argument are those of the first input */
+        if ((0 == strcmp(acName, "mean")) || (0 == strcmp(acName, "rms")))
+        {
+            return NewConst(pstParser,
+                            ('m' == acName[0])
+                            ? pstParser->pfMean[0]
+                            : pstParser->pfRMS[0]);
+        }
+        /* variable */
+        if ((iLen != 1) || !islower((unsigned char) acName[0]))
+        {
+            pstParser->pcPos = pcStart;
+            ParseError(pstParser, "Unknown variable");
+            return YAPP_RET_ERROR;
+        }
+        iVar = acName[0] - 'a';
+        if (iVar >= pstParser->iNumInputs)
+        {
+            pstParser->pcPos = pcStart;
+            ParseError(pstParser, "Variable has no input file");
+            return YAPP_RET_ERROR;
+        }
+        if (iVar >= pstParser->iNumVars)
+        {
+            pstParser->iNumVars = iVar + 1;
+        }
+        iNode = NewNode(pstParser, YAPP_EXPR_OP_VAR, -1, -1);
+        if (iNode != YAPP_RET_ERROR)
+        {
+            pstParser->astNodes[iNode].iVar = iVar;
+        }
+        return iNode;
+    }
+
+    /* function */
+    if ((0 == strcmp(acName, "mean")) || (0 == strcmp(acName, "rms")))
+    {
+        /* statistics of a whole input are constants, and do not need the
+           input to be read */
+        iNumVars = pstParser->iNumVars;
+        iNode = ParsePrimary(pstParser);
+        pstParser->iNumVars = iNumVars;
+        if (YAPP_RET_ERROR == iNode)
+        {
+            return YAPP_RET_ERROR;
+        }
+        if (pstParser->astNodes[iNode].iOp != YAPP_EXPR_OP_VAR)
+        {
+            ParseError(pstParser, "Expected a variable");
+            return YAPP_RET_ERROR;
+        }
+        iVar = pstParser->astNodes[iNode].iVar;
+        if (!Expect(pstParser, ')'))
+        {
+            ParseError(pstParser, "Expected ')'");
+            return YAPP_RET_ERROR;
+        }
+        return NewConst(pstParser,
+                        ('m' == acName[0])
+                        ? pstParser->pfMean[iVar]
+                        : pstParser->pfRMS[iVar]);
+    }
+    else if (0 == strcmp(acName, "abs"))
+    {
+        iOp = YAPP_EXPR_OP_ABS;
+    }
+    else if (0 == strcmp(acName, "sqrt"))
+    {
+        iOp = YAPP_EXPR_OP_SQRT;
+    }
+    else if (0 == strcmp(acName, "smooth"))
+    {
+        iOp = YAPP_EXPR_OP_SMOOTH;
+    }
+    else
+    {
+        pstParser->pcPos = pcStart;
+        ParseError(pstParser, "Unknown function");
+        return YAPP_RET_ERROR;
+    }
+
+    iNode = ParseSum(pstParser);
+    if (YAPP_RET_ERROR == iNode)
+    {
+        return YAPP_RET_ERROR;
+    }
+    if (YAPP_EXPR_OP_SMOOTH == iOp)
+    {
+        if (!Expect(pstParser, ','))
+        {
+            ParseError(pstParser, "Expected ','");
+            return YAPP_RET_ERROR;
+        }
+        iWidth = ParseWidth(pstParser);
+        if (YAPP_RET_ERROR == iWidth)
+        {
+            return YAPP_RET_ERROR;
+        }
+    }
+    if (!Expect(pstParser, ')'))
+    {
+        ParseError(pstParser, "Expected ')'");
+        return YAPP_RET_ERROR;
+    }
+    iNode = NewNode(pstParser, iOp, iNode, -1);
+    if ((iNode != YAPP_RET_ERROR)
+        && (YAPP_EXPR_OP_SMOOTH == pstParser->astNodes[iNode].iOp))
+    {
+        pstParser->astNodes[iNode].iWidth = iWidth;
+    }
+
+    return iNode;
+}
+
+
+/*
+ * Parse a boxcar width - a number of samples, or a time with the suffix 'ms'
+ * or 's' - and return it in samples
+ */
+static int ParseWidth(YAPP_EXPR_PARSER *pstParser)
+{
+    char *pcEnd = NULL;
+    double dValue = 0.0;
+    int iWidth = 0;
+
+    while (isspace((unsigned char) *pstParser->pcPos))
+    {
+        ++pstParser->pcPos;
+    }
+    dValue = strtod(pstParser->pcPos, &pcEnd);
+    if (pcEnd == pstParser->pcPos)
+    {
+        ParseError(pstParser, "Expected a width");
+        return YAPP_RET_ERROR;
+    }
+    pstParser->pcPos = pcEnd;
+    if (0 == strncmp(pstParser->pcPos, "ms", 2))
+    {
+        dValue = (dValue * 1e-3) / pstParser->dTSamp;
+        pstParser->pcPos += 2;
+    }
+    else if ('s' == *pstParser->pcPos)
+    {
+        dValue = dValue / pstParser->dTSamp;
+        ++pstParser->pcPos;
+    }
+    iWidth = (int) round(dValue);
+    if (iWidth < 1)
+    {
+        ParseError(pstParser, "Width must be at least one sample");
+        return YAPP_RET_ERROR;
+    }
+
+    return iWidth;
+}
+
+
+/*
+ * Add a node to the tree, folding it into a constant if its operands are
+ * constants
+ */
+static int NewNode(YAPP_EXPR_PARSER *pstParser,
+                   int iOp,
+                   int iLeft,
+                   int iRight)
+{
+    YAPP_EXPR_NODE *pstNodes = pstParser->astNodes;
+    YAPP_EXPR_NODE *pstNode = NULL;
+    float fA = 0.0;
+    float fB = 0.0;
+
+    /* fold constant operations - the moving mean of a constant is the
+       constant */
+    if ((iLeft >= 0)
+        && (YAPP_EXPR_OP_CONST == pstNodes[iLeft].iOp)
+        && ((iRight < 0) || (YAPP_EXPR_OP_CONST == pstNodes[iRight].iOp)))
+    {
+        fA = pstNodes[iLeft].fValue;
+        fB = (iRight >= 0) ? pstNodes[iRight].fValue : 0.0;
+        switch (iOp)
+        {
+            case YAPP_EXPR_OP_ADD:
+                fA = fA + fB;
+                break;
+
+            case YAPP_EXPR_OP_SUB:
+                fA = fA - fB;
+                break;
+
+            case YAPP_EXPR_OP_MUL:
+                fA = fA * fB;
+                break;
+
+            case YAPP_EXPR_OP_DIV:
+                fA = fA / fB;
+                break;
+
+            case YAPP_EXPR_OP_NEG:
+                fA = -fA;
+                break;
+
+            case YAPP_EXPR_OP_ABS:
+                fA = fabsf(fA);
+                break;
+
+            case YAPP_EXPR_OP_SQRT:
+                fA = sqrtf(fA);
+                break;
+
+            default:
+                break;
+        }
+        pstNodes[iLeft].fValue = fA;
+        return iLeft;
+    }
+
+    if (YAPP_EXPR_MAXNODES == pstParser->iNumNodes)
+    {
+        ParseError(pstParser, "Expression too long");
+        return YAPP_RET_ERROR;
+    }
+    pstNode = &pstNodes[pstParser->iNumNodes];
+    pstNode->iOp = iOp;
+    pstNode->iLeft = iLeft;
+    pstNode->iRight = iRight;
+
+    return pstParser->iNumNodes++;
+}
+
+
+/*
+ * Add a constant node to the tree
+ */
+static int NewConst(YAPP_EXPR_PARSER *pstParser, float fValue)
+{
+    int iNode = 0;
+
+    iNode = NewNode(pstParser, YAPP_EXPR_OP_CONST, -1, -1);
+    if (iNode != YAPP_RET_ERROR)
+    {
+        pstParser->astNodes[iNode].fValue = fValue;
+    }
+
+    return iNode;
+}
+
+
+/*
+ * Skip white space, and consume the next character if it is the one
+ * expected
+ */
+static char Expect(YAPP_EXPR_PARSER *pstParser, char cChar)
+{
+    while (isspace((unsigned char) *pstParser->pcPos))
+    {
+        ++pstParser->pcPos;
+    }
+    if (cChar == *pstParser->pcPos)
+    {
+        ++pstParser->pcPos;
+        return YAPP_TRUE;
+    }
+
+    return YAPP_FALSE;
+}
+
+
+/*
+ * Report a parse error, and where it occurred
+ */
+static void ParseError(YAPP_EXPR_PARSER *pstParser, const char *pcMsg)
+{
+    (void) fprintf(stderr,
+                   "ERROR: %s at position %d of expression '%s'!\n",
+                   pcMsg,
+                   (int) (pstParser->pcPos - pstParser->pcExpr) + 1,
+                   pstParser->pcExpr);
+
+    return;
+}
+
+
+/*
+ * Emit the operations of a subtree, with its result in a given stack slot,
+ * and return the margin that the subtree needs
+ */
+static int Emit(YAPP_EXPR *pstExpr,
+                YAPP_EXPR_NODE *pstNodes,
+                int iNode,
+                int iSlot)
+{
+    YAPP_EXPR_NODE *pstNode = &pstNodes[iNode];
+    YAPP_EXPR_OP *pstOp = NULL;
+    int iMargin = 0;
+    int iMarginRight = 0;
+    char cHasScalar = YAPP_FALSE;
+    char cScalarFirst = YAPP_FALSE;
+    float fValue = 0.0;
+
+    if ((iSlot + 2) > YAPP_EXPR_MAXDEPTH)
+    {
+        (void) fprintf(stderr, "ERROR: Expression nested too deeply!\n");
+        return YAPP_RET_ERROR;
+    }
+    if ((iSlot + 1) > pstExpr->iDepth)
+    {
+        pstExpr->iDepth = iSlot + 1;
+    }
+
+    switch (pstNode->iOp)
+    {
+        case YAPP_EXPR_OP_CONST:
+        case YAPP_EXPR_OP_VAR:
+            break;
+
+        case YAPP_EXPR_OP_ADD:
+        case YAPP_EXPR_OP_SUB:
+        case YAPP_EXPR_OP_MUL:
+        case YAPP_EXPR_OP_DIV:
+            /* a constant operand is taken as a scalar - both cannot be
+               constants, as those are folded */
+            if (YAPP_EXPR_OP_CONST == pstNodes[pstNode->iRight].iOp)
+            {
+                cHasScalar = YAPP_TRUE;
+                fValue = pstNodes[pstNode->iRight].fValue;
+                iMargin = Emit(pstExpr, pstNodes, pstNode->iLeft, iSlot);
+            }
+            else if (YAPP_EXPR_OP_CONST == pstNodes[pstNode->iLeft].iOp)
+            {
+                cScalarFirst = YAPP_TRUE;
+                fValue = pstNodes[pstNode->iLeft].fValue;
+                iMargin = Emit(pstExpr, pstNodes, pstNode->iRight, iSlot);
+            }
+            else
+            {
+                iMargin = Emit(pstExpr, pstNodes, pstNode->iLeft, iSlot);
+                iMarginRight = Emit(pstExpr,
+                                    pstNodes,
+                                    pstNode->iRight,
+                                    iSlot + 1);
+                if (YAPP_RET_ERROR == iMarginRight)
+                {
+                    return YAPP_RET_ERROR;
+                }
+                if (iMarginRight > iMargin)
+                {
+                    iMargin = iMarginRight;
+                }
+            }
+            break;
+
+        default:
+            /* unary operations */
+            iMargin = Emit(pstExpr, pstNodes, pstNode->iLeft, iSlot);
+            if (YAPP_EXPR_OP_SMOOTH == pstNode->iOp)
+            {
+                iMargin += pstNode->iWidth / 2;
+            }
+            break;
+    }
+    if (YAPP_RET_ERROR == iMargin)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    pstOp = &pstExpr->astOps[pstExpr->iNumOps];
+    ++pstExpr->iNumOps;
+    pstOp->iOp = pstNode->iOp;
+    pstOp->iVar = pstNode->iVar;
+    pstOp->fValue = (YAPP_EXPR_OP_CONST == pstNode->iOp)
+                    ? pstNode->fValue
+                    : fValue;
+    pstOp->cHasScalar = cHasScalar;
+    pstOp->cScalarFirst = cScalarFirst;
+    pstOp->iWidth = pstNode->iWidth;
+
+    return iMargin;
+}
+
+
+/*
+ * Centred moving mean - the boxcar for sample i spans samples
+ * [i - iWidth / 2, i + (iWidth - 1) / 2], and only the samples within
+ * [iValidBeg, iValidEnd) are averaged
+ */
+static void Smooth(float *pfIn,
+                   float *pfOut,
+                   double *pdCum,
+                   int iLen,
+                   int iWidth,
+                   int iValidBeg,
+                   int iValidEnd)
+{
+    int iLo = 0;
+    int iHi = 0;
+    int i = 0;
+
+    /* the cumulative sum is complete before any output is written, so pfIn
+       and pfOut may be the same */
+    pdCum[0] = 0.0;
+    for (i = 0; i < iLen; ++i)
+    {
+        pdCum[i+1] = pdCum[i]
+                     + (((i >= iValidBeg) && (i < iValidEnd)) ? pfIn[i] : 0.0);
+    }
+    for (i = 0; i < iLen; ++i)
+    {
+        iLo = i - (iWidth / 2);
+        iHi = i + ((iWidth - 1) / 2) + 1;
+        if (iLo < iValidBeg)
+        {
+            iLo = iValidBeg;
+        }
+        if (iHi > iValidEnd)
+        {
+            iHi = iValidEnd;
+        }
+        pfOut[i] = (iHi > iLo)
+                   ? (float) ((pdCum[iHi] - pdCum[iLo]) / (iHi - iLo))
+                   : 0.0;
+    }
+
+    return;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file yapp_expr.h
+ * Header file for the time series expression routines - an arithmetic
+ *  expression over aligned time series is compiled into a short program of
+ *  block-wide operations, and evaluated block by block as the time series
+ *  are read, without intermediate files
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_EXPR_H__
+#define __YAPP_EXPR_H__
+
+#include <ctype.h>
+
+#define YAPP_EXPR_MAXVARS       26      /* variables are named 'a' to 'z' */
+#define YAPP_EXPR_MAXNODES      256     /* maximum number of terms in an
+                                           expression */
+#define YAPP_EXPR_MAXDEPTH      32      /* maximum number of partial results
+                                           held at a time */
+
+/* operations */
+#define YAPP_EXPR_OP_CONST      0
+#define YAPP_EXPR_OP_VAR        1
+#define YAPP_EXPR_OP_ADD        2
+#define YAPP_EXPR_OP_SUB        3
+#define YAPP_EXPR_OP_MUL        4
+#define YAPP_EXPR_OP_DIV        5
+#define YAPP_EXPR_OP_NEG        6
+#define YAPP_EXPR_OP_ABS        7
+#define YAPP_EXPR_OP_SQRT       8
+#define YAPP_EXPR_OP_SMOOTH     9
+
+/**
+ * An operation of a compiled expression - operations work on a stack of
+ * partial results, each a whole window of samples. A binary operation with
+ * a constant operand takes the constant as a scalar, instead of from the
+ * stack.
+ */
+typedef struct tagExprOp
+{
+    int iOp;
+    int iVar;               /* variable, for YAPP_EXPR_OP_VAR */
+    float fValue;           /* constant, or scalar operand */
+    char cHasScalar;        /* fValue is the right operand */
+    char cScalarFirst;      /* fValue is the left operand */
+    int iWidth;             /* boxcar width, in samples, for
+                               YAPP_EXPR_OP_SMOOTH */
+} YAPP_EXPR_OP;
+
+/**
+ * Compiled expression
+ */
+typedef struct tagExpr
+{
+    YAPP_EXPR_OP astOps[YAPP_EXPR_MAXNODES];
+    int iNumOps;
+    int iNumVars;           /* number of variables referenced, counting from
+                               'a' */
+    int iMargin;            /* number of samples before and after a block
+                               needed to evaluate it */
+    int iDepth;             /* maximum number of partial results held at a
+                               time */
+    int iLen;               /* window length */
+    float *apfSlot[YAPP_EXPR_MAXDEPTH];     /* partial result buffers */
+    double *pdCum;          /* cumulative sums, for YAPP_EXPR_OP_SMOOTH */
+} YAPP_EXPR;
+
+/**
+ * Compile an expression. Variables 'a', 'b', ... refer to the input time
+ * series, in order. The operators are +, -, *, / and parentheses, and the
+ * functions are abs(x), sqrt(x), smooth(x, width), which is the centred
+ * moving mean of x, with width given in samples, or in time with the suffix
+ * 'ms' or 's', and mean(v) and rms(v), which are the mean and RMS of the
+ * whole of input v - mean and rms alone are those of 'a'.
+ *
+ * @param[out]      pstExpr         Compiled expression
+ * @param[in]       pcExpr          Expression
+ * @param[in]       iNumInputs      Number of input time series
+ * @param[in]       dTSamp          Sampling interval, in s
+ * @param[in]       pfMean          Mean of each input time series
+ * @param[in]       pfRMS           RMS of each input time series
+ */
+int YAPP_EXPR_Compile(YAPP_EXPR *pstExpr,
+                      const char *pcExpr,
+                      int iNumInputs,
+                      double dTSamp,
+                      float *pfMean,
+                      float *pfRMS);
+
+/**
+ * Allocate the buffers needed to evaluate an expression over windows of a
+ * given length
+ *
+ * @param[inout]    pstExpr         Compiled expression
+ * @param[in]       iLen            Window length - a block plus
+ *                                  pstExpr->iMargin samples on either side
+ */
+int YAPP_EXPR_Alloc(YAPP_EXPR *pstExpr, int iLen);
+
+/**
+ * Evaluate an expression over a window of each input, and return the result
+ * window - only the samples at least pstExpr->iMargin samples from either
+ * edge of the window are exact. Samples outside [iValidBeg, iValidEnd) are
+ * beyond the data, and are excluded from moving means.
+ *
+ * @param[inout]    pstExpr         Compiled expression
+ * @param[in]       ppfVars         Window of each input
+ * @param[in]       iValidBeg       First sample of the windows that is data
+ * @param[in]       iValidEnd       One past the last sample of the windows
+ *                                  that is data
+ */
+float* YAPP_EXPR_Eval(YAPP_EXPR *pstExpr,
+                      float **ppfVars,
+                      int iValidBeg,
+                      int iValidEnd);
+
+#endif  /* __YAPP_EXPR_H__ */
@@ -16,6 +16,11 @@
  *     -i  --invert                         Invert the background and foreground
  *                                          colours in plots
  *     -e  --non-interactive                Run in non-interactive mode
+ *     -o  --ooc <memsize>                  Compute FFTs out of core, using
+ *                                          scratch files in the current
+ *                                          directory and at most memsize MB
+ *                                          (default is to compute FFTs in
+ *                                          memory)
  *     -v  --version                        Display the version @endverbatim
  *
  * @author Jayanth Chennamangalam
@@ -24,7 +29,7 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
-#include <fftw3.h>
+#include "yapp_oocfft.h"
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -47,6 +52,14 @@ fftwf_plan g_stPlanFwd = {0};
 fftwf_plan g_stPlanBwd = {0};
 char *g_pcFilter = NULL;
 
+static int YAPP_FilterOOC(FILE *pFOut,
+                          float fSampSize,
+                          int iBlockSize,
+                          int iFFTUsableSize,
+                          int iTimeSampsToProc,
+                          int iNumReads,
+                          size_t lMemSize);
+
 int main(int argc, char *argv[])
 {
     FILE *pFFilter = NULL;
@@ -84,10 +97,11 @@ int main(int argc, char *argv[])
     char cHasGraphics = YAPP_FALSE;
     int iInvCols = YAPP_FALSE;
     char cIsNonInteractive = YAPP_FALSE;
+    int iOOCMemSize = 0;
     const char *pcProgName = NULL;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hs:p:f:giev";
+    const char* const pcOptsShort = "hs:p:f:gieo:v";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
@@ -97,6 +111,7 @@ int main(int argc, char *argv[])
         { "graphics",               0, NULL, 'g' },
         { "invert",                 0, NULL, 'i' },
         { "non-interactive",        0, NULL, 'e' },
+        { "ooc",                    1, NULL, 'o' },
         { "version",                0, NULL, 'v' },
         { NULL,                     0, NULL, 0   }
     };
@@ -145,6 +160,19 @@ int main(int argc, char *argv[])
                 cIsNonInteractive = YAPP_TRUE;
                 break;
 
+            case 'o':  /* -o or --ooc */
+                /* set option */
+                iOOCMemSize = atoi(optarg);
+                if (iOOCMemSize < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Memory size must be at least "
+                                   "1 MB!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
             case 'v':   /* -v or --version */
                 /* display the version */
                 (void) printf("%s\n", g_pcVersion);
@@ -172,6 +200,16 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
+    /* the filtered data are never in memory in an out-of-core FFT */
+    if (cHasGraphics && (iOOCMemSize > 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Plotting is not supported with out-of-core "
+                       "FFTs!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
     /* register the signal-handling function */
     iRet = YAPP_RegisterSignalHandlers();
     if (iRet != YAPP_RET_SUCCESS)
@@ -252,31 +290,55 @@ int main(int argc, char *argv[])
     iFFTUsableSize = (int) stFileStats.st_size;
     iBlockSize = 2 * (iFFTUsableSize - 1);
 
-    g_pcFilter = (char *) YAPP_Malloc((size_t) iFFTUsableSize,
-                                      sizeof(char),
-                                      YAPP_FALSE);
-    if (NULL == g_pcFilter)
+    if (iOOCMemSize > 0)
     {
-        (void) fprintf(stderr,
-                       "ERROR: Memory allocation failed! %s!\n",
-                       strerror(errno));
+        /* the mask is as long as the spectrum, so map it instead of reading
+           it into memory */
+        g_pcFilter = (char *) mmap(NULL,
+                                   (size_t) iFFTUsableSize,
+                                   PROT_READ,
+                                   MAP_PRIVATE,
+                                   fileno(pFFilter),
+                                   0);
         (void) fclose(pFFilter);
-        YAPP_CleanUp();
-        return YAPP_RET_ERROR;
+        if (MAP_FAILED == g_pcFilter)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Mapping filter file failed! %s.\n",
+                           strerror(errno));
+            g_pcFilter = NULL;
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
     }
-
-    iRet = fread(g_pcFilter, sizeof(char), iFFTUsableSize, pFFilter);
-    if (iRet < iFFTUsableSize)
+    else
     {
-        (void) fprintf(stderr,
-                       "ERROR: Reading filter file failed!\n");
+        g_pcFilter = (char *) YAPP_Malloc((size_t) iFFTUsableSize,
+                                          sizeof(char),
+                                          YAPP_FALSE);
+        if (NULL == g_pcFilter)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            (void) fclose(pFFilter);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        iRet = fread(g_pcFilter, sizeof(char), iFFTUsableSize, pFFilter);
+        if (iRet < iFFTUsableSize)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading filter file failed!\n");
+            (void) fclose(pFFilter);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
         (void) fclose(pFFilter);
-        YAPP_CleanUp();
-        return YAPP_RET_ERROR;
     }
 
-    (void) fclose(pFFilter);
-
     lBytesToSkip = (long) floor((dDataSkipTime / dTSampInSec)
                                                     /* number of samples */
                            * stYUM.fSampSize);
@@ -356,40 +418,43 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
-    /* allocate memory for the buffer, based on the number of channels and time
-       samples */
-    g_pfBuf = (float *) YAPP_Malloc((size_t) iBlockSize,
-                                    sizeof(float),
-                                    YAPP_FALSE);
-    if (NULL == g_pfBuf)
+    if (0 == iOOCMemSize)
     {
-        (void) fprintf(stderr,
-                       "ERROR: Memory allocation for buffer failed! %s!\n",
-                       strerror(errno));
-        YAPP_CleanUp();
-        return YAPP_RET_ERROR;
-    }
+        /* allocate memory for the buffer, based on the number of channels
+           and time samples */
+        g_pfBuf = (float *) YAPP_Malloc((size_t) iBlockSize,
+                                        sizeof(float),
+                                        YAPP_FALSE);
+        if (NULL == g_pfBuf)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation for buffer failed! %s!\n",
+                           strerror(errno));
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
 
-    g_pfcFFTBuf = (fftwf_complex *) fftwf_malloc(iBlockSize
-                                                 * sizeof(fftwf_complex));
-    if (NULL == g_pfcFFTBuf)
-    {
-        (void) fprintf(stderr,
-                       "ERROR: Memory allocation failed! %s!\n",
-                       strerror(errno));
-        YAPP_CleanUp();
-        return YAPP_RET_ERROR;
-    }
+        g_pfcFFTBuf = (fftwf_complex *) fftwf_malloc(iBlockSize
+                                                     * sizeof(fftwf_complex));
+        if (NULL == g_pfcFFTBuf)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
 
-    /* create FFT plan */
-    g_stPlanFwd = fftwf_plan_dft_r2c_1d(iBlockSize,
-                                        g_pfBuf,
-                                        g_pfcFFTBuf,
-                                        FFTW_MEASURE);
-    g_stPlanBwd = fftwf_plan_dft_c2r_1d(iBlockSize,
-                                        g_pfcFFTBuf,
-                                        g_pfBuf,
-                                        FFTW_MEASURE);
+        /* create FFT plan */
+        g_stPlanFwd = fftwf_plan_dft_r2c_1d(iBlockSize,
+                                            g_pfBuf,
+                                            g_pfcFFTBuf,
+                                            FFTW_MEASURE);
+        g_stPlanBwd = fftwf_plan_dft_c2r_1d(iBlockSize,
+                                            g_pfcFFTBuf,
+                                            g_pfBuf,
+                                            FFTW_MEASURE);
+    }
 
     if (1 == iNumReads)
     {
@@ -422,6 +487,28 @@ int main(int argc, char *argv[])
     /* skip data, if any are to be skipped */
     (void) fseek(g_pFData, lBytesToSkip, SEEK_CUR);
 
+    if (iOOCMemSize > 0)
+    {
+        iRet = YAPP_FilterOOC(pFOut,
+                              stYUM.fSampSize,
+                              iBlockSize,
+                              iFFTUsableSize,
+                              iTimeSampsToProc,
+                              iNumReads,
+                              (size_t) iOOCMemSize * YAPP_MB2BYTE_FACTOR);
+        (void) fclose(pFOut);
+        (void) munmap(g_pcFilter, (size_t) iFFTUsableSize);
+        g_pcFilter = NULL;
+        YAPP_CleanUp();
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr, "ERROR: Filtering failed!\n");
+            return YAPP_RET_ERROR;
+        }
+        (void) printf("DONE!\n");
+        return YAPP_RET_SUCCESS;
+    }
+
     /* open the PGPLOT graphics device */
     if (cHasGraphics)
     {
@@ -715,6 +802,148 @@ int main(int argc, char *argv[])
     return YAPP_RET_SUCCESS;
 }
 
+/*
+ * Filter the data a block at a time using out-of-core FFTs - the spectrum of
+ * each block is masked through a mapping of the scratch file, and the
+ * filtered data are written out a buffer at a time
+ */
+static int YAPP_FilterOOC(FILE *pFOut,
+                          float fSampSize,
+                          int iBlockSize,
+                          int iFFTUsableSize,
+                          int iTimeSampsToProc,
+                          int iNumReads,
+                          size_t lMemSize)
+{
+    fftwf_complex *pfcSpec = NULL;
+    float *pfBuf = NULL;
+    long lNumSamps = 0;
+    long lChunk = 0;
+    long lStart = 0;
+    long lNum = 0;
+    long i = 0;
+    int iNumBins = (iBlockSize / 2) + 1;
+    int iFd = 0;
+    int iBlock = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    if ((iBlockSize % 2) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Out-of-core FFT length must be even!\n");
+        return YAPP_RET_ERROR;
+    }
+    if (iFFTUsableSize < iNumBins)
+    {
+        iNumBins = iFFTUsableSize;
+    }
+
+    lChunk = (long) (lMemSize / sizeof(float));
+    if (lChunk > iBlockSize)
+    {
+        lChunk = iBlockSize;
+    }
+    pfBuf = (float *) YAPP_Malloc((size_t) lChunk, sizeof(float), YAPP_FALSE);
+    if (NULL == pfBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation for buffer failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    iFd = YAPP_OOCFFT_OpenScratch();
+    if (YAPP_RET_ERROR == iFd)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    for (iBlock = 0; iBlock < iNumReads; ++iBlock)
+    {
+        (void) printf("\rFiltering data block %d.", iBlock + 1);
+        (void) fflush(stdout);
+
+        /* the last block may be short, in which case it is zero-padded */
+        lNumSamps = (long) iTimeSampsToProc - ((long) iBlock * iBlockSize);
+        if (lNumSamps > iBlockSize)
+        {
+            lNumSamps = iBlockSize;
+        }
+        iRet = YAPP_OOCFFT_R2C(g_pFData,
+                               fSampSize,
+                               lNumSamps,
+                               (long) iBlockSize,
+                               iFd,
+                               lMemSize);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) close(iFd);
+            return YAPP_RET_ERROR;
+        }
+
+        /* filter data */
+        pfcSpec = (fftwf_complex *) mmap(NULL,
+                                         iNumBins * sizeof(fftwf_complex),
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_SHARED,
+                                         iFd,
+                                         0);
+        if (MAP_FAILED == pfcSpec)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Mapping scratch file failed! %s.\n",
+                           strerror(errno));
+            (void) close(iFd);
+            return YAPP_RET_ERROR;
+        }
+        for (i = 0; i < iNumBins; ++i)
+        {
+            if (0.0 == g_pcFilter[i])
+            {
+                pfcSpec[i][0] = 0.0;    /* real part */
+                pfcSpec[i][1] = 0.0;    /* imaginary part */
+            }
+        }
+        (void) munmap(pfcSpec, iNumBins * sizeof(fftwf_complex));
+
+        iRet = YAPP_OOCFFT_C2R(iFd, (long) iBlockSize, lMemSize);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) close(iFd);
+            return YAPP_RET_ERROR;
+        }
+
+        /* normalize, and write filtered data to file */
+        for (lStart = 0; lStart < lNumSamps; lStart += lChunk)
+        {
+            lNum = ((lNumSamps - lStart) < lChunk)
+                   ? (lNumSamps - lStart)
+                   : lChunk;
+            if (pread(iFd,
+                      pfBuf,
+                      lNum * sizeof(float),
+                      (off_t) lStart * sizeof(float))
+                != (ssize_t) (lNum * sizeof(float)))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Reading scratch file failed! %s.\n",
+                               strerror(errno));
+                (void) close(iFd);
+                return YAPP_RET_ERROR;
+            }
+            for (i = 0; i < lNum; ++i)
+            {
+                pfBuf[i] /= iBlockSize;
+            }
+            (void) fwrite(pfBuf, sizeof(float), lNum, pFOut);
+        }
+    }
+    (void) printf("\n");
+    (void) close(iFd);
+
+    return YAPP_RET_SUCCESS;
+}
+
 /*
  * Prints usage information
  */
@@ -746,6 +975,14 @@ void PrintUsage(const char *pcProgName)
     (void) printf("colours in plots\n");
     (void) printf("    -e  --non-interactive               ");
     (void) printf("Run in non-interactive mode\n");
+    (void) printf("    -o  --ooc <memsize>                 ");
+    (void) printf("Compute FFTs out of core, using\n");
+    (void) printf("                                        ");
+    (void) printf("scratch files in the current\n");
+    (void) printf("                                        ");
+    (void) printf("directory and at most memsize MB\n");
+    (void) printf("                                        ");
+    (void) printf("(default is to compute FFTs in memory)\n");
     (void) printf("    -v  --version                       ");
     (void) printf("Display the version\n");
 
@@ -13,18 +13,40 @@
  *                                          processed
  *                                          (default is all)
  *     -t  --period <period>                Folding period in milliseconds
+ *     -d  --dm <dm>                        DM at which to dedisperse
+ *                                          filterbank data while folding
+ *                                          (default is no dedispersion)
  *     -w  --waterfall <numpulses>          Show a waterfall plot (pulse number
  *                                          versus phase) instead of a folded
  *                                          profile
  *     -x  --waterfallgs <numpulses>        Show a grayscale waterfall plot
  *                                          (pulse number versus phase) instead
  *                                          of a folded profile
+ *     -r  --rfi <sigmas>                   Flag RFI in filterbank data at
+ *                                          this threshold, using spectral
+ *                                          kurtosis and clipping, and write
+ *                                          the flags to a mask file
+ *                                          (default is no RFI flagging)
+ *     -z  --zerodm                         Subtract the zero-DM time series
+ *                                          from filterbank data
+ *     -k  --mask <mask-file>               Replace the samples of filterbank
+ *                                          data flagged in this RFI mask file
+ *                                          with channel means
+ *     -y  --pol <pol>                      Polarization to read from
+ *                                          PSRFITS data - 'X', 'Y', or
+ *                                          'sum' (default is 'sum')
  *     -m  --colour-map <name>              Colour map for plotting
  *                                          (default is 'jet')
  *     -f  --file                           Plot to file, instead of to screen
  *     -i  --invert                         Invert the background and foreground
  *                                          colours in plots
  *     -e  --non-interactive                Run in non-interactive mode
+ *     -o  --png                            Render the plots to PNG files,
+ *                                          without a graphics device
+ *     -j  --threads <numthreads>           Number of threads rendering PNG
+ *                                          files
+ *                                          (default is the number of
+ *                                          processors)
  *     -v  --version                        Display the version @endverbatim
  *
  * @author Jayanth Chennamangalam
@@ -33,7 +55,11 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_psrfits.h"   /* for PSRFITS file format support */
 #include "colourmap.h"
+#include "yapp_rfi.h"
+#include "yapp_png.h"       /* for plotting to PNG files */
+#include "yapp_lib.h"       /* for the dispersion delays */
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -57,6 +83,10 @@ float *g_pfPlotBuf = NULL;
 double *g_pdPhase = NULL;
 float *g_pfPhase = NULL;
 float *g_pfYAxis = NULL;
+int *g_piBinShift = NULL;
+float *g_pfDedispProf = NULL;
+
+static int CloseOutput(YAPP_PNG_POOL *pstPool, char cPlotToPNG);
 
 int main(int argc, char *argv[])
 {
@@ -100,6 +130,10 @@ int main(int argc, char *argv[])
     char cCurChar = 0;
     int iNumSamps = 0;
     double dPeriod = 0.0;
+    char cIsDMGiven = YAPP_FALSE;
+    double dDM = 0.0;
+    double dDelay = 0.0;
+    float fFChan = 0.0;
     double dPhase = 0.0;
     double dPhaseStep = 0.0;
     int iSampsPerPeriod = 0;
@@ -117,6 +151,13 @@ int main(int argc, char *argv[])
     int m = 0;
     char acLabel[LEN_GENSTRING] = {0};
     int iColourMap = DEF_CMAP;
+    YAPP_RFI stRFI = {0};
+    float fRFIThreshold = 0.0;
+    char cZeroDM = YAPP_FALSE;
+    char cHasRFIExcision = YAPP_FALSE;
+    char acFileMask[LEN_GENSTRING] = {0};
+    YAPP_RFI_MASK stMask = {{{0}}};
+    char *pcFileMaskIn = NULL;
     char cPlotToFile = YAPP_FALSE;
     char *pcFilename = NULL;
     char acDev[LEN_GENSTRING] = {0};
@@ -124,21 +165,33 @@ int main(int argc, char *argv[])
     int iInvCols = YAPP_FALSE;
     char cIsNonInteractive = YAPP_FALSE;
     const char *pcProgName = NULL;
+    int iPol = YAPP_PF_POL_SUM;
+    char cPlotToPNG = YAPP_FALSE;
+    int iNumThreads = 0;
+    YAPP_PNG_POOL stPool = {0};
+    YAPP_PNG_PLOT stPlot = {{0}};
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hs:p:t:w:x:m:fiev";
+    const char* const pcOptsShort = "hs:p:t:d:w:x:r:zk:y:m:fieoj:v";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
         { "skip",                   1, NULL, 's' },
         { "proc",                   1, NULL, 'p' },
         { "period",                 1, NULL, 't' },
+        { "dm",                     1, NULL, 'd' },
         { "waterfall",              1, NULL, 'w' },
         { "waterfallgs",            1, NULL, 'x' },
+        { "rfi",                    1, NULL, 'r' },
+        { "zerodm",                 0, NULL, 'z' },
+        { "mask",                   1, NULL, 'k' },
+        { "pol",                    1, NULL, 'y' },
         { "colour-map",             1, NULL, 'm' },
         { "file",                   0, NULL, 'f' },
         { "invert",                 0, NULL, 'i' },
         { "non-interactive",        0, NULL, 'e' },
+        { "png",                    0, NULL, 'o' },
+        { "threads",                1, NULL, 'j' },
         { "version",                0, NULL, 'v' },
         { NULL,                     0, NULL, 0   }
     };
@@ -172,6 +225,12 @@ int main(int argc, char *argv[])
                 dPeriod = atof(optarg);
                 break;
 
+            case 'd':   /* -d or --dm */
+                /* set option */
+                dDM = atof(optarg);
+                cIsDMGiven = YAPP_TRUE;
+                break;
+
             case 'w':   /* -w or --waterfall */
                 /* set option */
                 iNumPulses = atoi(optarg);
@@ -202,6 +261,39 @@ int main(int argc, char *argv[])
                 }
                 break;
 
+            case 'r':   /* -r or --rfi */
+                /* set option */
+                fRFIThreshold = atof(optarg);
+                /* validate */
+                if (fRFIThreshold <= 0.0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: RFI threshold must be > 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'z':   /* -z or --zerodm */
+                /* set option */
+                cZeroDM = YAPP_TRUE;
+                break;
+
+            case 'k':   /* -k or --mask */
+                /* set option */
+                pcFileMaskIn = optarg;
+                break;
+
+            case 'y':   /* -y or --pol */
+                /* set option */
+                iPol = YAPP_PF_GetPolFromName(optarg);
+                if (YAPP_RET_ERROR == iPol)
+                {
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
             case 'm':   /* -m or --colour-map */
                 /* set option */
                 iColourMap = GetColourMapFromName(optarg);
@@ -222,6 +314,25 @@ int main(int argc, char *argv[])
                 cIsNonInteractive = YAPP_TRUE;
                 break;
 
+            case 'o':   /* -o or --png */
+                /* set option */
+                cPlotToPNG = YAPP_TRUE;
+                break;
+
+            case 'j':   /* -j or --threads */
+                /* set option */
+                iNumThreads = atoi(optarg);
+                if ((iNumThreads < 1) || (iNumThreads > YAPP_PNG_MAXTHREADS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of threads must be between "
+                                   "1 and %d!\n",
+                                   YAPP_PNG_MAXTHREADS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
             case 'v':   /* -v or --version */
                 /* display the version */
                 (void) printf("%s\n", g_pcVersion);
@@ -256,6 +367,28 @@ int main(int argc, char *argv[])
         PrintUsage(pcProgName);
         return YAPP_RET_ERROR;
     }
+    if (cPlotToPNG && cPlotToFile)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Cannot plot to both PostScript and PNG "
+                       "files!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* render PNG files on one thread per processor, by default */
+    if (cPlotToPNG && (0 == iNumThreads))
+    {
+        iNumThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (iNumThreads < 1)
+        {
+            iNumThreads = 1;
+        }
+        else if (iNumThreads > YAPP_PNG_MAXTHREADS)
+        {
+            iNumThreads = YAPP_PNG_MAXTHREADS;
+        }
+    }
 
     /* register the signal-handling function */
     iRet = YAPP_RegisterSignalHandlers();
@@ -279,6 +412,7 @@ int main(int argc, char *argv[])
     }
     if (!((YAPP_FORMAT_FIL == iFormat)
           || (YAPP_FORMAT_SPEC == iFormat)
+          || (YAPP_FORMAT_PSRFITS == iFormat)
           || (YAPP_FORMAT_DTS_TIM == iFormat)
           || (YAPP_FORMAT_DTS_DAT == iFormat)))
     {
@@ -288,7 +422,9 @@ int main(int argc, char *argv[])
     }
 
     /* user input validation */
-    if (((YAPP_FORMAT_FIL == iFormat) || (YAPP_FORMAT_SPEC == iFormat))
+    if (((YAPP_FORMAT_FIL == iFormat)
+         || (YAPP_FORMAT_SPEC == iFormat)
+         || (YAPP_FORMAT_PSRFITS == iFormat))
         && (iWaterfallType != 0))
     {
         (void) fprintf(stderr,
@@ -297,6 +433,15 @@ int main(int argc, char *argv[])
         PrintUsage(pcProgName);
         return YAPP_RET_ERROR;
     }
+    if (((YAPP_FORMAT_DTS_TIM == iFormat) || (YAPP_FORMAT_DTS_DAT == iFormat))
+        && cIsDMGiven)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: "
+                       "Dedispersion is supported only for filterbank data!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
 
     /* read metadata */
     iRet = YAPP_ReadMetadata(pcFileData, iFormat, &stYUM);
@@ -307,6 +452,21 @@ int main(int argc, char *argv[])
                        pcFileData);
         return YAPP_RET_ERROR;
     }
+    if (YAPP_FORMAT_PSRFITS == iFormat)
+    {
+        /* open the PSRFITS files as a stream of scaled, single-polarization
+           data, which is read as a headerless filterbank file from here on */
+        g_pFData = YAPP_PF_Open(pcFileData, iPol, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed!\n",
+                           pcFileData);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iFormat = YAPP_FORMAT_FIL;
+    }
     /* kludge: the rest of the code expects stYUM.iNumChans = 1 for time series
        data, so make it 1 */
     if ((YAPP_FORMAT_DTS_TIM == iFormat)
@@ -495,7 +655,10 @@ int main(int argc, char *argv[])
     }
 
     /* open the data file for reading */
-    g_pFData = fopen(pcFileData, "r");
+    if (NULL == g_pFData)
+    {
+        g_pFData = fopen(pcFileData, "r");
+    }
     if (NULL == g_pFData)
     {
         (void) fprintf(stderr,
@@ -541,8 +704,23 @@ int main(int argc, char *argv[])
 
     pcFilename = YAPP_GetFilenameFromPath(pcFileData);
 
+    if (cPlotToPNG)
+    {
+        /* start the threads that render the plots, instead of opening a
+           graphics device */
+        iRet = YAPP_PNG_Start(&stPool, iNumThreads);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Starting rendering threads failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        stPlot.iColourMap = iColourMap;
+        stPlot.iInvCols = iInvCols;
+    }
     /* open the PGPLOT graphics device */
-    if (cPlotToFile)
+    else if (cPlotToFile)
     {
         /* build the name of the PGPLOT device */
         (void) strcpy(acDev, pcFilename);
@@ -556,25 +734,28 @@ int main(int argc, char *argv[])
     {
         g_iPGDev = cpgopen(PG_DEV);
     }
-    if (g_iPGDev <= 0)
+    if (!cPlotToPNG)
     {
-        (void) fprintf(stderr,
-                       "ERROR: Opening graphics device %s failed!\n",
-                       PG_DEV);
-        YAPP_CleanUp();
-        return YAPP_RET_ERROR;
-    }
+        if (g_iPGDev <= 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening graphics device %s failed!\n",
+                           PG_DEV);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
 
-    /* set the background colour to white and the foreground colour to
-       black, if user requires so */
-    if (YAPP_TRUE == iInvCols)
-    {
-        cpgscr(0, 1.0, 1.0, 1.0);
-        cpgscr(1, 0.0, 0.0, 0.0);
-    }
+        /* set the background colour to white and the foreground colour to
+           black, if user requires so */
+        if (YAPP_TRUE == iInvCols)
+        {
+            cpgscr(0, 1.0, 1.0, 1.0);
+            cpgscr(1, 0.0, 0.0, 0.0);
+        }
 
-    /* set character height */
-    cpgsch(PG_CH);
+        /* set character height */
+        cpgsch(PG_CH);
+    }
 
     /* the phase array */
     g_pdPhase = (double *) YAPP_Malloc(iSampsPerPeriod,
@@ -586,7 +767,7 @@ int main(int argc, char *argv[])
                        "ERROR: Memory allocation for phase array failed! "
                        "%s!\n",
                        strerror(errno));
-        cpgclos();
+        (void) CloseOutput(&stPool, cPlotToPNG);
         YAPP_CleanUp();
         return YAPP_RET_ERROR;
     }
@@ -600,7 +781,7 @@ int main(int argc, char *argv[])
                        "ERROR: Memory allocation for phase plot array failed! "
                        "%s!\n",
                        strerror(errno));
-        cpgclos();
+        (void) CloseOutput(&stPool, cPlotToPNG);
         YAPP_CleanUp();
         return YAPP_RET_ERROR;
     }
@@ -626,6 +807,7 @@ int main(int argc, char *argv[])
                                "ERROR: Memory allocation for plot buffer "
                                "failed! %s!\n",
                                strerror(errno));
+                (void) CloseOutput(&stPool, cPlotToPNG);
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
@@ -644,6 +826,7 @@ int main(int argc, char *argv[])
                                "ERROR: Memory allocation for plot buffer "
                                "failed! %s!\n",
                                strerror(errno));
+                (void) CloseOutput(&stPool, cPlotToPNG);
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
@@ -655,6 +838,7 @@ int main(int argc, char *argv[])
                 (void) fprintf(stderr,
                                "ERROR: Memory allocation for Y-axis failed! %s!\n",
                                strerror(errno));
+                (void) CloseOutput(&stPool, cPlotToPNG);
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
@@ -675,6 +859,7 @@ int main(int argc, char *argv[])
                            "ERROR: Memory allocation for profile buffer failed! "
                            "%s!\n",
                            strerror(errno));
+            (void) CloseOutput(&stPool, cPlotToPNG);
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
@@ -687,6 +872,7 @@ int main(int argc, char *argv[])
                            "ERROR: Memory allocation for plot buffer failed! "
                            "%s!\n",
                            strerror(errno));
+            (void) CloseOutput(&stPool, cPlotToPNG);
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
@@ -698,6 +884,7 @@ int main(int argc, char *argv[])
             (void) fprintf(stderr,
                            "ERROR: Memory allocation for Y-axis failed! %s!\n",
                            strerror(errno));
+            (void) CloseOutput(&stPool, cPlotToPNG);
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
@@ -715,12 +902,114 @@ int main(int argc, char *argv[])
                 g_pfYAxis[i] = stYUM.fFMin + i * stYUM.fChanBW;
             }
         }
+
+        /* per-channel profile rotation, in bins, that corrects for the
+           dispersion delay with respect to the highest frequency channel -
+           all zeros if no DM is given */
+        g_piBinShift = (int *) YAPP_Malloc(stYUM.iNumChans,
+                                           sizeof(int),
+                                           YAPP_TRUE);
+        if (NULL == g_piBinShift)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation for bin shift table "
+                           "failed! %s!\n",
+                           strerror(errno));
+            (void) CloseOutput(&stPool, cPlotToPNG);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (cIsDMGiven)
+        {
+            for (i = 0; i < stYUM.iNumChans; ++i)
+            {
+                /* g_pfYAxis holds the channel frequencies in data order */
+                fFChan = g_pfYAxis[i];
+                dDelay = YAPP_LIB_CalcDelay(fFChan,
+                                            stYUM.fFMax,
+                                            dDM,
+                                            DEF_LAW);   /* in s */
+                g_piBinShift[i] = YAPP_LIB_CalcBinShift(dDelay,
+                                                        dPeriod / 1e3,
+                                                        iSampsPerPeriod);
+            }
+
+            g_pfDedispProf = (float *) YAPP_Malloc(iSampsPerPeriod,
+                                                   sizeof(float),
+                                                   YAPP_FALSE);
+            if (NULL == g_pfDedispProf)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation for dedispersed "
+                               "profile failed! %s!\n",
+                               strerror(errno));
+                (void) CloseOutput(&stPool, cPlotToPNG);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
     }
 
     /* build the name of the output profile file */
     (void) strcpy(acFileProf, pcFilename);
     (void) strcat(acFileProf, EXT_YAPP_PROFILE);
 
+    /* read the RFI mask to be applied, if any - this is done before RFI
+       excision is set up, as the mask written by it may overwrite this */
+    if (pcFileMaskIn != NULL)
+    {
+        if ((iFormat != YAPP_FORMAT_FIL) && (iFormat != YAPP_FORMAT_SPEC))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: RFI masks can be applied only to "
+                           "filterbank data!\n");
+            (void) CloseOutput(&stPool, cPlotToPNG);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iRet = YAPP_RFI_ReadMask(&stMask,
+                                 pcFileMaskIn,
+                                 stYUM.iNumChans,
+                                 dTSampInSec);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading RFI mask failed!\n");
+            (void) CloseOutput(&stPool, cPlotToPNG);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    /* set up RFI excision, for filterbank data - the flags are written to a
+       mask file only if RFI is flagged */
+    if (((fRFIThreshold > 0.0) || cZeroDM)
+        && ((YAPP_FORMAT_FIL == iFormat) || (YAPP_FORMAT_SPEC == iFormat)))
+    {
+        cHasRFIExcision = YAPP_TRUE;
+        (void) snprintf(acFileMask,
+                        LEN_GENSTRING,
+                        "%s%s",
+                        pcFilename,
+                        EXT_YAPP_RFIMASK);
+        iRet = YAPP_RFI_Init(&stRFI,
+                             stYUM.iNumChans,
+                             iBlockSize,
+                             fRFIThreshold,
+                             cZeroDM,
+                             (fRFIThreshold > 0.0) ? acFileMask : NULL,
+                             dTSampInSec,
+                             stYUM.dTStart);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: RFI excision setup failed!\n");
+            (void) CloseOutput(&stPool, cPlotToPNG);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
     while (iNumReads > 0)
     {
         /* read data */
@@ -733,7 +1022,7 @@ int main(int argc, char *argv[])
         if (YAPP_RET_ERROR == iReadItems)
         {
             (void) fprintf(stderr, "ERROR: Reading data failed!\n");
-            cpgclos();
+            (void) CloseOutput(&stPool, cPlotToPNG);
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
@@ -788,7 +1077,7 @@ int main(int argc, char *argv[])
                         (void) fprintf(stderr,
                                        "ERROR: Beam flip time section anomaly "
                                        "detected!\n");
-                        cpgclos();
+                        (void) CloseOutput(&stPool, cPlotToPNG);
                         YAPP_CleanUp();
                         return YAPP_RET_ERROR;
                     }
@@ -814,6 +1103,35 @@ int main(int argc, char *argv[])
             }
         }
 
+        /* apply the RFI mask */
+        if (pcFileMaskIn != NULL)
+        {
+            YAPP_RFI_ApplyMask(&stMask,
+                               g_pfBuf,
+                               iNumSamps,
+                               iTimeSampsToSkip
+                               + ((long) (iReadBlockCount - 1) * iBlockSize));
+        }
+
+        /* excise RFI */
+        if (cHasRFIExcision)
+        {
+            iRet = YAPP_RFI_Clean(&stRFI,
+                                  g_pfBuf,
+                                  iNumSamps,
+                                  stYUM.pcIsChanGood,
+                                  iTimeSampsToSkip
+                                  + ((long) (iReadBlockCount - 1)
+                                     * iBlockSize));
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                (void) fprintf(stderr, "ERROR: RFI excision failed!\n");
+                (void) CloseOutput(&stPool, cPlotToPNG);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+
         if ((YAPP_FORMAT_DTS_TIM == iFormat)
             || (YAPP_FORMAT_DTS_DAT == iFormat))    /* time series format */
         {
@@ -872,7 +1190,6 @@ int main(int argc, char *argv[])
                 /* compute the index into the profile array */
                 j = dPhase * iSampsPerPeriod;
                 pfSpectrum = g_pfBuf + i * stYUM.iNumChans;
-                pfProfSpec = g_pfProfBuf + j * stYUM.iNumChans;
                 for (k = 0; k < stYUM.iNumChans; ++k)
                 {
                     /* calculate these per channel, at the first sample
@@ -890,6 +1207,14 @@ int main(int argc, char *argv[])
                                                      fMeanNoise);
                     }
 
+                    /* rotate the channel profile by its dispersion delay
+                       while accumulating */
+                    l = j - g_piBinShift[k];
+                    if (l < 0)
+                    {
+                        l += iSampsPerPeriod;
+                    }
+                    pfProfSpec = g_pfProfBuf + l * stYUM.iNumChans;
                     pfProfSpec[k] += (((pfSpectrum[k] - afMeanNoise[k])
                                        / afRMSNoise[k])
                                       / DEF_FOLD_PULSES);
@@ -903,7 +1228,10 @@ int main(int argc, char *argv[])
         {
             if (0 == iWaterfallType)
             {
-                cpgeras();
+                if (!cPlotToPNG)
+                {
+                    cpgeras();
+                }
                 fDataMin = g_pfProfBuf[0];
                 fDataMax = g_pfProfBuf[0];
                 for (i = 0; i < iSampsPerPeriod; ++i)
@@ -925,16 +1253,32 @@ int main(int argc, char *argv[])
                               fDataMax);
                 #endif
 
-                cpgsvp(PG_VP_ML, PG_VP_MR, PG_VP_MB, PG_VP_MT);
-                cpgswin(g_pfPhase[0],
-                        g_pfPhase[iSampsPerPeriod-1],
-                        fDataMin,
-                        fDataMax);
-                cpglab("Phase", "Power (arbitrary units)", "Folded Profile");
-                cpgbox("BCNST", 0.0, 0, "BCNST", 0.0, 0);
-                cpgsci(PG_CI_PLOT);
-                cpgline(iSampsPerPeriod, g_pfPhase, g_pfProfBuf);
-                cpgsci(PG_CI_DEF);
+                if (cPlotToPNG)
+                {
+                    stPlot.iType = YAPP_PNG_TYPE_LINES;
+                    stPlot.pfData = g_pfProfBuf;
+                    stPlot.iLenX = iSampsPerPeriod;
+                    stPlot.iLenY = 1;
+                    stPlot.fDataMin = fDataMin;
+                    stPlot.fDataMax = fDataMax;
+                    stPlot.fYMin = fDataMin;
+                    stPlot.fYMax = fDataMax;
+                    (void) strcpy(stPlot.acYLabel, "Power (arbitrary units)");
+                    (void) strcpy(stPlot.acTitle, "Folded Profile");
+                }
+                else
+                {
+                    cpgsvp(PG_VP_ML, PG_VP_MR, PG_VP_MB, PG_VP_MT);
+                    cpgswin(g_pfPhase[0],
+                            g_pfPhase[iSampsPerPeriod-1],
+                            fDataMin,
+                            fDataMax);
+                    cpglab("Phase", "Power (arbitrary units)", "Folded Profile");
+                    cpgbox("BCNST", 0.0, 0, "BCNST", 0.0, 0);
+                    cpgsci(PG_CI_PLOT);
+                    cpgline(iSampsPerPeriod, g_pfPhase, g_pfProfBuf);
+                    cpgsci(PG_CI_DEF);
+                }
             }
             else
             {
@@ -965,7 +1309,42 @@ int main(int argc, char *argv[])
                               fDataMax);
                 #endif
 
-                if (PLOT_WATERFALL_GS == iWaterfallType)
+                if (cPlotToPNG && (PLOT_WATERFALL_GS == iWaterfallType))
+                {
+                    stPlot.iType = YAPP_PNG_TYPE_IMAGE;
+                    stPlot.pfData = g_pf2DProfBuf;
+                    stPlot.iLenX = iSampsPerPeriod;
+                    stPlot.iLenY = iNumPulses;
+                    stPlot.fDataMin = fDataMin;
+                    stPlot.fDataMax = fDataMax;
+                    stPlot.fYMin = g_pfYAxis[0];
+                    stPlot.fYMax = g_pfYAxis[iNumPulses-1];
+                    (void) strcpy(stPlot.acYLabel, "");
+                    (void) strcpy(stPlot.acTitle, "");
+                }
+                else if (cPlotToPNG)
+                {
+                    /* offset the pulses, as below, and plot them as lines */
+                    for (i = 0; i < iNumPulses; ++i)
+                    {
+                        pfProfSpec = g_pfBuf + i * iSampsPerPeriod;
+                        for (j = 0; j < iSampsPerPeriod; ++j)
+                        {
+                            pfProfSpec[j] += (i * WATERFALL_OFFSET_SCALE * (fDataMax - fDataMin));
+                        }
+                    }
+                    stPlot.iType = YAPP_PNG_TYPE_LINES;
+                    stPlot.pfData = g_pfBuf;
+                    stPlot.iLenX = iSampsPerPeriod;
+                    stPlot.iLenY = iNumPulses;
+                    stPlot.fDataMin = fDataMin;
+                    stPlot.fDataMax = fDataMax + ((fDataMax - fDataMin) * WATERFALL_OFFSET_SCALE * iNumPulses);
+                    stPlot.fYMin = stPlot.fDataMin;
+                    stPlot.fYMax = stPlot.fDataMax;
+                    (void) strcpy(stPlot.acYLabel, "");
+                    (void) strcpy(stPlot.acTitle, "");
+                }
+                else if (PLOT_WATERFALL_GS == iWaterfallType)
                 {
                     /* plot grayscale waterfall plot */
                     if (!cIsFirst)
@@ -1053,18 +1432,64 @@ int main(int argc, char *argv[])
                 ++m;
             }
 
-            if (!cIsFirst)
+            if (cPlotToPNG)
+            {
+                stPlot.iType = YAPP_PNG_TYPE_IMAGE;
+                stPlot.pfData = g_pfPlotBuf;
+                stPlot.iLenX = iSampsPerPeriod;
+                stPlot.iLenY = stYUM.iNumChans;
+                stPlot.fDataMin = fDataMin;
+                stPlot.fDataMax = fDataMax;
+                stPlot.fYMin = g_pfYAxis[0];
+                stPlot.fYMax = g_pfYAxis[stYUM.iNumChans-1];
+                (void) strcpy(stPlot.acYLabel, "Frequency (MHz)");
+                (void) strcpy(stPlot.acTitle, "Folded Dynamic Spectrum");
+            }
+            else
+            {
+                if (!cIsFirst)
+                {
+                    cpgsci(0);      /* background */
+                    cpgsvp(PG_WEDG_VP_ML, PG_WEDG_VP_MR, PG_WEDG_VP_MB, PG_WEDG_VP_MT);
+                    cpgwedg("TI", 0.0, 3.0, fDataMinOld, fDataMaxOld, "");
+                    cpgsci(PG_CI_DEF);
+                }
+                Plot2D(g_pfPlotBuf, fDataMin, fDataMax,
+                       g_pfPhase, iSampsPerPeriod, dPhaseStep,
+                       g_pfYAxis, stYUM.iNumChans, stYUM.fChanBW,
+                       "Phase", "Frequency (MHz)", "Folded Dynamic Spectrum",
+                       iColourMap);
+            }
+        }
+
+        if (cPlotToPNG)
+        {
+            /* queue the plot, and go on to the next block while it is being
+               rendered */
+            (void) snprintf(stPlot.acFile,
+                            LEN_GENSTRING,
+                            "%s.%s.%06d%s",
+                            pcFilename,
+                            INFIX_FOLD,
+                            iReadBlockCount,
+                            EXT_PNG);
+            stPlot.fXMin = g_pfPhase[0];
+            stPlot.fXMax = g_pfPhase[iSampsPerPeriod-1];
+            (void) strcpy(stPlot.acXLabel, "Phase");
+            iRet = YAPP_PNG_Submit(&stPool, &stPlot);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                (void) fprintf(stderr, "ERROR: Rendering plot failed!\n");
+                (void) YAPP_PNG_Stop(&stPool);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+            if (1 == iNumReads)
             {
-                cpgsci(0);      /* background */
-                cpgsvp(PG_WEDG_VP_ML, PG_WEDG_VP_MR, PG_WEDG_VP_MB, PG_WEDG_VP_MT);
-                cpgwedg("TI", 0.0, 3.0, fDataMinOld, fDataMaxOld, "");
-                cpgsci(PG_CI_DEF);
+                cIsLastBlock = YAPP_TRUE;
             }
-            Plot2D(g_pfPlotBuf, fDataMin, fDataMax,
-                   g_pfPhase, iSampsPerPeriod, dPhaseStep,
-                   g_pfYAxis, stYUM.iNumChans, stYUM.fChanBW,
-                   "Phase", "Frequency (MHz)", "Folded Dynamic Spectrum",
-                   iColourMap);
+            cIsFirst = YAPP_FALSE;
+            continue;
         }
 
         if (!cPlotToFile)
@@ -1158,8 +1583,61 @@ int main(int argc, char *argv[])
         cIsFirst = YAPP_FALSE;
     }
 
+    /* for dedispersed filterbank data, sum the aligned channel profiles to
+       get the dedispersed profile */
+    if (cIsDMGiven)
+    {
+        for (i = 0; i < iSampsPerPeriod; ++i)
+        {
+            pfProfSpec = g_pfProfBuf + i * stYUM.iNumChans;
+            g_pfDedispProf[i] = 0.0;
+            for (j = 0; j < stYUM.iNumChans; ++j)
+            {
+                g_pfDedispProf[i] += pfProfSpec[j];
+            }
+            g_pfDedispProf[i] /= stYUM.iNumGoodChans;
+        }
+
+        /* open the output profile file */
+        pFProfile = fopen(acFileProf, "w");
+        if (NULL == pFProfile)
+        {
+            fprintf(stderr,
+                    "ERROR: Opening file %s failed! %s.\n",
+                    acFileProf,
+                    strerror(errno));
+            (void) CloseOutput(&stPool, cPlotToPNG);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        /* write necessary metadata */
+        (void) fprintf(pFProfile,
+                       "# Centre frequency                  : %.10g MHz\n",
+                        stYUM.fFCentre);
+        (void) fprintf(pFProfile,
+                       "# Original channel bandwidth        : %.10g MHz\n",
+                        stYUM.fChanBW);
+        (void) fprintf(pFProfile,
+                       "# Bandwidth                         : %.10g MHz\n",
+                       stYUM.fBW);
+        (void) fprintf(pFProfile,
+                       "# Duration of data                  : %g s\n",
+                       (stYUM.iTimeSamps * (stYUM.dTSamp / 1e3)));
+        (void) fprintf(pFProfile,
+                       "# Dispersion measure                : %g cm^-3 pc\n",
+                       dDM);
+        /* write profile bins */
+        for (i = 0; i < iSampsPerPeriod; ++i)
+        {
+            (void) fprintf(pFProfile, "%.10g\n", g_pfDedispProf[i]);
+        }
+
+        (void) fclose(pFProfile);
+    }
+
     /* write profile to file */
-    /* NOTE: no support for filterbank format data */
+    /* NOTE: filterbank format data is written above, only if dedispersed */
     if ((YAPP_FORMAT_DTS_TIM == iFormat)
         || (YAPP_FORMAT_DTS_DAT == iFormat))    /* time series format */
     {
@@ -1174,7 +1652,7 @@ int main(int argc, char *argv[])
                         "ERROR: Opening file %s failed! %s.\n",
                         acFileProf,
                         strerror(errno));
-                cpgclos();
+                (void) CloseOutput(&stPool, cPlotToPNG);
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
@@ -1202,14 +1680,53 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* wait for the plots to be rendered, or close the graphics device */
+    iRet = CloseOutput(&stPool, cPlotToPNG);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Rendering plots failed!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
     (void) printf("DONE!\n");
 
-    cpgclos();
+    if (pcFileMaskIn != NULL)
+    {
+        (void) printf("Replaced %ld samples flagged in the RFI mask.\n",
+                      stMask.lNumFlags);
+    }
+    if (cHasRFIExcision && (fRFIThreshold > 0.0))
+    {
+        (void) printf("Flagged %ld channel-blocks and %ld samples as RFI.\n",
+                      stRFI.lNumChanFlags,
+                      stRFI.lNumSampFlags);
+    }
+    if (YAPP_RFI_Close(&stRFI) != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Writing mask file failed!\n");
+    }
+
     YAPP_CleanUp();
 
     return YAPP_RET_SUCCESS;
 }
 
+/*
+ * Closes the graphics output - waits for the plots to be rendered and stops
+ * the rendering threads, or closes the PGPLOT device
+ */
+static int CloseOutput(YAPP_PNG_POOL *pstPool, char cPlotToPNG)
+{
+    if (cPlotToPNG)
+    {
+        return YAPP_PNG_Stop(pstPool);
+    }
+    cpgclos();
+
+    return YAPP_RET_SUCCESS;
+}
+
 /*
  * Prints usage information
  */
@@ -1233,6 +1750,12 @@ void PrintUsage(const char *pcProgName)
     (void) printf("(default is all)\n");
     (void) printf("    -t  --period <period>               ");
     (void) printf("Folding period in milliseconds\n");
+    (void) printf("    -d  --dm <dm>                       ");
+    (void) printf("DM at which to dedisperse\n");
+    (void) printf("                                        ");
+    (void) printf("filterbank data while folding\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no dedispersion)\n");
     (void) printf("    -w  --waterfall <numpulses>         ");
     (void) printf("Show a waterfall plot (pulse number\n");
     (void) printf("                                        ");
@@ -1245,6 +1768,32 @@ void PrintUsage(const char *pcProgName)
     (void) printf("number versus phase) instead of a\n");
     (void) printf("                                        ");
     (void) printf("folded profile\n");
+    (void) printf("    -r  --rfi <sigmas>                  ");
+    (void) printf("Flag RFI in filterbank data at\n");
+    (void) printf("                                        ");
+    (void) printf("this threshold, using spectral\n");
+    (void) printf("                                        ");
+    (void) printf("kurtosis and clipping, and write\n");
+    (void) printf("                                        ");
+    (void) printf("the flags to a mask file\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no RFI flagging)\n");
+    (void) printf("    -z  --zerodm                        ");
+    (void) printf("Subtract the zero-DM time series\n");
+    (void) printf("                                        ");
+    (void) printf("from filterbank data\n");
+    (void) printf("    -k  --mask <mask-file>              ");
+    (void) printf("Replace the samples of filterbank\n");
+    (void) printf("                                        ");
+    (void) printf("data flagged in this RFI mask file\n");
+    (void) printf("                                        ");
+    (void) printf("with channel means\n");
+    (void) printf("    -y  --pol <pol>                     ");
+    (void) printf("Polarization to read from PSRFITS\n");
+    (void) printf("                                        ");
+    (void) printf("data - 'X', 'Y', or 'sum'\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 'sum')\n");
     (void) printf("    -m  --colour-map <name>             ");
     (void) printf("Colour map for plotting\n");
     (void) printf("                                        ");
@@ -1257,6 +1806,14 @@ void PrintUsage(const char *pcProgName)
     (void) printf("colours in plots\n");
     (void) printf("    -e  --non-interactive               ");
     (void) printf("Run in non-interactive mode\n");
+    (void) printf("    -o  --png                           ");
+    (void) printf("Render the plots to PNG files, without\n");
+    (void) printf("                                        ");
+    (void) printf("a graphics device\n");
+    (void) printf("    -j  --threads <numthreads>          ");
+    (void) printf("Number of threads rendering PNG files\n");
+    (void) printf("                                        ");
+    (void) printf("(default is the number of processors)\n");
     (void) printf("    -v  --version                       ");
     (void) printf("Display the version\n");
 
@@ -12,7 +12,11 @@
  *                                          processed
  *                                          (default is all)
  *     -l  --tsamp <tsamp>                  Sampling time in s
+ *                                          (default for a ring buffer is the
+ *                                          value in its header)
  *     -f  --centre-freq <freq>             Centre frequency of observing band
+ *                                          (default for a ring buffer is the
+ *                                          value in its header)
  *     -b  --pfb                            Do polyphase filter bank
  *     -t  --ntaps <ntaps>                  Number of taps in the PFB
  *                                          (default is 8)
@@ -33,6 +37,7 @@
 
 #include "yapp.h"
 #include "yapp_ft.h"
+#include "yapp_shm.h"      /* for shared-memory ring buffer input */
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -43,6 +48,9 @@ extern const char *g_pcVersion;
 /* PGPLOT device ID */
 extern int g_iPGDev;
 
+/* data file */
+extern FILE *g_pFData;
+
 /* the following are global only to enable cleaning up in case of abnormal
    termination, such as those triggered by SIGINT or SIGTERM */
 float *g_pfXAxis = NULL;
@@ -63,7 +71,6 @@ float *g_pfSumStokesIm = NULL;
 char g_cDoPFB = YAPP_FALSE;
 char g_acFileData[LEN_GENSTRING] = {0};
 char g_acFileCoeff[LEN_GENSTRING] = {0};
-int g_iFileData = 0;
 float* g_pfPFBCoeff = NULL;
 
 int main(int argc, char *argv[])
@@ -106,6 +113,7 @@ int main(int argc, char *argv[])
     char acHdrBuf[LEN_GENSTRING] = {0};
     char acSite[LEN_GENSTRING] = {0};
     char acPulsar[MAX_LEN_PSRNAME] = {0};
+    char *pcExt = NULL;
     int i = 0;
     int j = 0;
     char cHasGraphics = YAPP_FALSE;
@@ -241,20 +249,6 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
-    if (0.0 == dTSampInSec)
-    {
-        (void) fprintf(stderr, "ERROR: Sampling interval not specified!\n");
-        PrintUsage(pcProgName);
-        return YAPP_RET_ERROR;
-    }
-
-    if (0.0 == fFreqCen)
-    {
-        (void) fprintf(stderr, "ERROR: Centre frequency not specified!\n");
-        PrintUsage(pcProgName);
-        return YAPP_RET_ERROR;
-    }
-
     if ((g_cDoPFB) && (1 == iNTaps))
     {
         /* set default number of taps */
@@ -276,18 +270,72 @@ int main(int argc, char *argv[])
     /* get the input filename */
     (void) strncpy(g_acFileData, argv[optind], LEN_GENSTRING); 
 
+    pcExt = strrchr(g_acFileData, '.');
+    if ((pcExt != NULL) && (0 == strcmp(pcExt, EXT_SHM)))
+    {
+        /* attach to the ring buffer, which is read as a raw data file as the
+           producer fills it */
+        g_pFData = YAPP_SHM_Open(g_acFileData, YAPP_SHM_DATA_RAW, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Attaching to ring buffer %s failed!\n",
+                           g_acFileData);
+            CleanUp(iNTaps);
+            return YAPP_RET_ERROR;
+        }
+        lDataSizeTotal = stYUM.lDataSizeTotal;
 
-    iRet = stat(g_acFileData, &stFileStats);
-    if (iRet != YAPP_RET_SUCCESS)
+        /* the header of the ring gives the metadata that is not given on
+           the command line */
+        if (0.0 == dTSampInSec)
+        {
+            dTSampInSec = stYUM.dTSamp / 1e3;
+        }
+        if (0.0 == fFreqCen)
+        {
+            fFreqCen = stYUM.fFCentre;
+        }
+        if ('\0' == acSite[0])
+        {
+            (void) strncpy(acSite, stYUM.acSite, LEN_GENSTRING);
+        }
+        if ('\0' == acPulsar[0])
+        {
+            (void) strncpy(acPulsar, stYUM.acPulsar, MAX_LEN_PSRNAME);
+        }
+    }
+    else
     {
-        (void) fprintf(stderr,
-                       "ERROR: Failed to stat %s: %s!\n",
-                       g_acFileData,
-                       strerror(errno));
+        iRet = stat(g_acFileData, &stFileStats);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Failed to stat %s: %s!\n",
+                           g_acFileData,
+                           strerror(errno));
+            CleanUp(iNTaps);
+            return YAPP_RET_ERROR;
+        }
+        lDataSizeTotal = (long) stFileStats.st_size;
+    }
+
+    if (0.0 == dTSampInSec)
+    {
+        (void) fprintf(stderr, "ERROR: Sampling interval not specified!\n");
+        PrintUsage(pcProgName);
         CleanUp(iNTaps);
         return YAPP_RET_ERROR;
     }
-    lDataSizeTotal = (long) stFileStats.st_size;
+
+    if (0.0 == fFreqCen)
+    {
+        (void) fprintf(stderr, "ERROR: Centre frequency not specified!\n");
+        PrintUsage(pcProgName);
+        CleanUp(iNTaps);
+        return YAPP_RET_ERROR;
+    }
+
     fSampSize = NUM_BYTES_PER_SAMP * sizeof(char); 
     iTimeSamps = (int) floor(((double) lDataSizeTotal) / fSampSize);
 
@@ -312,7 +360,7 @@ int main(int argc, char *argv[])
                                                     /* number of samples */
                            * fSampSize);
 
-    if (lBytesToSkip >= stYUM.lDataSizeTotal)
+    if (lBytesToSkip >= lDataSizeTotal)
     {
         (void) fprintf(stderr,
                        "ERROR: Data to be skipped is greater than or equal to "
@@ -367,8 +415,11 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
-    g_iFileData = open(g_acFileData, O_RDONLY);
-    if (g_iFileData < YAPP_RET_SUCCESS)
+    if (NULL == g_pFData)
+    {
+        g_pFData = fopen(g_acFileData, "r");
+    }
+    if (NULL == g_pFData)
     {
         (void) fprintf(stderr,
                        "ERROR! Opening data file %s failed! %s.\n",
@@ -513,7 +564,7 @@ int main(int argc, char *argv[])
     }
 
     /* skip data, if any are to be skipped */
-    (void) lseek(g_iFileData, lBytesToSkip, SEEK_SET);
+    (void) fseek(g_pFData, lBytesToSkip, SEEK_SET);
 
     if (cHasGraphics)
     {
@@ -1012,8 +1063,11 @@ int ReadData(char cIsFirst, int iNTaps, int iNFFT)
         /* ASSUMPTION: there is at least iNTaps blocks of data */
         for (i = 0; i < iNTaps; ++i)
         {
-            iRet = read(g_iFileData, g_astPFBData[i].pcData, iNFFT * NUM_BYTES_PER_SAMP);
-            if (iRet < YAPP_RET_SUCCESS)
+            iRet = (int) fread(g_astPFBData[i].pcData,
+                               sizeof(char),
+                               iNFFT * NUM_BYTES_PER_SAMP,
+                               g_pFData);
+            if (ferror(g_pFData))
             {
                 (void) fprintf(stderr,
                                "ERROR: Data reading failed! %s.\n",
@@ -1045,8 +1099,11 @@ int ReadData(char cIsFirst, int iNTaps, int iNFFT)
     else
     {
         /* write new data to the write buffer */
-        iRet = read(g_iFileData, g_astPFBData[g_iPFBWriteIdx].pcData, iNFFT * NUM_BYTES_PER_SAMP);
-        if (iRet < YAPP_RET_SUCCESS)
+        iRet = (int) fread(g_astPFBData[g_iPFBWriteIdx].pcData,
+                           sizeof(char),
+                           iNFFT * NUM_BYTES_PER_SAMP,
+                           g_pFData);
+        if (ferror(g_pFData))
         {
             (void) fprintf(stderr,
                            "ERROR: Data reading failed! %s.\n",
@@ -1180,12 +1237,6 @@ void CleanUp(int iNTaps)
 
     fftwf_cleanup();
 
-    if (g_iFileData != 0)
-    {
-        (void) close(g_iFileData);
-        g_iFileData = 0;
-    }
-
     /* free all memory allocated using YAPP_Malloc() */
     YAPP_CleanUp();
 
@@ -1215,10 +1266,18 @@ void PrintUsage(const char *pcProgName)
     (void) printf("(default is all)\n");
     (void) printf("    -l  --tsamp <tsamp>                 ");
     (void) printf("Sampling time in s\n");
+    (void) printf("                                        ");
+    (void) printf("(default for a ring buffer is the\n");
+    (void) printf("                                        ");
+    (void) printf("value in its header)\n");
     (void) printf("    -f  --centre-freq <freq>            ");
     (void) printf("Centre frequency of observing band,\n");
     (void) printf("                                        ");
     (void) printf("in MHz\n");
+    (void) printf("                                        ");
+    (void) printf("(default for a ring buffer is the\n");
+    (void) printf("                                        ");
+    (void) printf("value in its header)\n");
     (void) printf("    -b  --pfb                           ");
     (void) printf("Do polyphase filter bank\n");
     (void) printf("    -t  --ntaps <ntaps>                 ");
@@ -49,7 +49,7 @@ typedef struct tagPFBData
 int InitPFB(int iNTaps, int iNFFT);
 
 /**
- * Reads one block (32MB) of data form memory.
+ * Reads one block of data from the input file or ring buffer.
  */
 int ReadData(char cIsFirst, int iNTaps, int iNFFT);
 
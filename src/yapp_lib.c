@@ -0,0 +1,1387 @@
+/*
+ * @file yapp_lib.c
+ * libyapp - reentrant readers, dedispersion, folding, smoothing and
+ *  statistics, and rings and a pipeline executor to run them concurrently in
+ *  one process. All state lives in the contexts passed in, all memory is
+ *  allocated with malloc() and freed by the corresponding close function,
+ *  and nothing here uses PGPLOT or YAPP_Malloc(), so that the kernels can be
+ *  embedded in other programs.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "yapp_lib.h"
+#include "yapp_sigproc.h"
+
+#define LEN_LABEL               80      /* maximum length of a header label */
+
+/* types of the values of SIGPROC header fields */
+#define SP_TYPE_NONE            0
+#define SP_TYPE_INT             1
+#define SP_TYPE_DOUBLE          2
+#define SP_TYPE_STRING          3
+
+/**
+ * SIGPROC header field
+ */
+typedef struct tagSPField
+{
+    const char *pcLabel;
+    int iType;
+} SP_FIELD;
+
+static const SP_FIELD g_astSPFields[] = {
+    { YAPP_SP_LABEL_RAWFILENAME,    SP_TYPE_STRING },
+    { YAPP_SP_LABEL_SRCNAME,        SP_TYPE_STRING },
+    { YAPP_SP_LABEL_DATATYPE,       SP_TYPE_INT },
+    { YAPP_SP_LABEL_NUMCHANS,       SP_TYPE_INT },
+    { YAPP_SP_LABEL_FCHAN1,         SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_CHANBW,         SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_NUMBEAMS,       SP_TYPE_INT },
+    { YAPP_SP_LABEL_BEAMID,         SP_TYPE_INT },
+    { YAPP_SP_LABEL_NUMBITS,        SP_TYPE_INT },
+    { YAPP_SP_LABEL_NUMIFS,         SP_TYPE_INT },
+    { YAPP_SP_LABEL_TSAMP,          SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_TSTART,         SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_OBSID,          SP_TYPE_INT },
+    { YAPP_SP_LABEL_BEID,           SP_TYPE_INT },
+    { YAPP_SP_LABEL_SRCRA,          SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_SRCDEC,         SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_AZSTART,        SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_ZASTART,        SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_DM,             SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_FLAGBARY,       SP_TYPE_INT },
+    { YAPP_SP_LABEL_FREQSTART,      SP_TYPE_NONE },
+    { YAPP_SP_LABEL_FREQEND,        SP_TYPE_NONE },
+    { YAPP_SP_LABEL_FREQCHAN,       SP_TYPE_DOUBLE },
+    { YAPP_SP_LABEL_HDREND,         SP_TYPE_NONE }
+};
+
+static int ReadLabel(FILE *pFData, char *pcLabel, long *plHeaderLen);
+static int ReadHeader(FILE *pFData, YAPP_LIB_META *pstMeta);
+static double GetDelay(const YAPP_LIB_META *pstMeta,
+                       int iChan,
+                       double dFMax,
+                       double dDM);
+static double GetFMax(const YAPP_LIB_META *pstMeta);
+static void* RunStage(void *pvStage);
+static void AbortPipe(YAPP_LIB_PIPE *pstPipe);
+
+/*
+ * Open a SIGPROC filterbank or time series file, and read its header
+ */
+int YAPP_LIB_Open(YAPP_LIB_READER *pstReader, const char *pcFileData)
+{
+    YAPP_LIB_META *pstMeta = &pstReader->stMeta;
+    struct stat stFileStats = {0};
+    long lBitsPerSpec = 0;
+
+    (void) memset(pstReader, '\0', sizeof(YAPP_LIB_READER));
+    pstMeta->iNumIFs = 1;
+
+    pstReader->pFData = fopen(pcFileData, "r");
+    if (NULL == pstReader->pFData)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileData,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    if (ReadHeader(pstReader->pFData, pstMeta) != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Reading header of %s failed!\n",
+                       pcFileData);
+        (void) YAPP_LIB_Close(pstReader);
+        return YAPP_RET_ERROR;
+    }
+
+    /* only byte-aligned spectra of a single IF are supported */
+    lBitsPerSpec = (long) pstMeta->iNumChans * pstMeta->iNumBits;
+    if ((pstMeta->iNumChans < 1)
+        || ((pstMeta->iNumBits != 1)
+            && (pstMeta->iNumBits != 2)
+            && (pstMeta->iNumBits != 4)
+            && (pstMeta->iNumBits != 8)
+            && (pstMeta->iNumBits != 16)
+            && (pstMeta->iNumBits != 32))
+        || (lBitsPerSpec % 8 != 0)
+        || (pstMeta->iNumIFs > 1)
+        || (pstMeta->dTSamp <= 0.0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Unsupported data in %s - %d channels, %d bits "
+                       "per sample, %d IFs!\n",
+                       pcFileData,
+                       pstMeta->iNumChans,
+                       pstMeta->iNumBits,
+                       pstMeta->iNumIFs);
+        (void) YAPP_LIB_Close(pstReader);
+        return YAPP_RET_ERROR;
+    }
+
+    if (fstat(fileno(pstReader->pFData), &stFileStats) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Failed to stat %s: %s!\n",
+                       pcFileData,
+                       strerror(errno));
+        (void) YAPP_LIB_Close(pstReader);
+        return YAPP_RET_ERROR;
+    }
+    pstMeta->lNumSamps = (long) ((stFileStats.st_size - pstMeta->lHeaderLen)
+                                 / (lBitsPerSpec / 8));
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Go to a time sample
+ */
+int YAPP_LIB_Seek(YAPP_LIB_READER *pstReader, long lSamp)
+{
+    YAPP_LIB_META *pstMeta = &pstReader->stMeta;
+    off_t lOffset = 0;
+
+    if ((lSamp < 0) || (lSamp > pstMeta->lNumSamps))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Time sample %ld out of range!\n",
+                       lSamp);
+        return YAPP_RET_ERROR;
+    }
+
+    lOffset = (off_t) pstMeta->lHeaderLen
+              + ((off_t) lSamp * pstMeta->iNumChans * pstMeta->iNumBits / 8);
+    if (fseeko(pstReader->pFData, lOffset, SEEK_SET) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Seeking in data file failed! %s.\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    pstReader->lPos = lSamp;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Read time samples, as 32-bit floating-point spectra
+ */
+int YAPP_LIB_Read(YAPP_LIB_READER *pstReader, float *pfBuf, int iNumSamps)
+{
+    YAPP_LIB_META *pstMeta = &pstReader->stMeta;
+    size_t iSpecLen = (size_t) pstMeta->iNumChans * pstMeta->iNumBits / 8;
+    size_t iLen = iSpecLen * iNumSamps;
+    size_t iReadLen = 0;
+
+    if (iNumSamps < 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid number of time samples %d!\n",
+                       iNumSamps);
+        return YAPP_RET_ERROR;
+    }
+
+    /* grow the raw buffer as needed */
+    if (iLen > pstReader->iRawLen)
+    {
+        char *pcRaw = (char *) realloc(pstReader->pcRaw, iLen);
+        if (NULL == pcRaw)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+        pstReader->pcRaw = pcRaw;
+        pstReader->iRawLen = iLen;
+    }
+
+    iReadLen = fread(pstReader->pcRaw, 1, iLen, pstReader->pFData);
+    if (ferror(pstReader->pFData))
+    {
+        (void) fprintf(stderr, "ERROR: File read failed!\n");
+        return YAPP_RET_ERROR;
+    }
+    /* drop a partial spectrum at the end of the file */
+    iNumSamps = (int) (iReadLen / iSpecLen);
+
+    YAPP_LIB_Unpack(pstReader->pcRaw,
+                    pstMeta->iNumBits,
+                    (long) iNumSamps * pstMeta->iNumChans,
+                    pfBuf);
+    pstReader->lPos += iNumSamps;
+
+    return iNumSamps;
+}
+
+
+/*
+ * Close a reader
+ */
+int YAPP_LIB_Close(YAPP_LIB_READER *pstReader)
+{
+    if (pstReader->pFData != NULL)
+    {
+        (void) fclose(pstReader->pFData);
+        pstReader->pFData = NULL;
+    }
+    free(pstReader->pcRaw);
+    pstReader->pcRaw = NULL;
+    pstReader->iRawLen = 0;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Convert raw samples to floating-point
+ */
+void YAPP_LIB_Unpack(const char *pcRaw,
+                     int iNumBits,
+                     long lNumSamps,
+                     float *pfBuf)
+{
+    int iSampsPerByte = 0;
+    unsigned char cMask = 0;
+    long i = 0;
+    int j = 0;
+
+    if (32 == iNumBits)
+    {
+        (void) memcpy(pfBuf, pcRaw, sizeof(float) * lNumSamps);
+    }
+    else if (16 == iNumBits)
+    {
+        const int16_t *psRaw = (const int16_t *) pcRaw;
+        for (i = 0; i < lNumSamps; ++i)
+        {
+            pfBuf[i] = (float) psRaw[i];
+        }
+    }
+    else if (8 == iNumBits)
+    {
+        for (i = 0; i < lNumSamps; ++i)
+        {
+            pfBuf[i] = (float) pcRaw[i];
+        }
+    }
+    else
+    {
+        iSampsPerByte = 8 / iNumBits;
+        cMask = (unsigned char) ((1 << iNumBits) - 1);
+        for (i = 0; i < lNumSamps / iSampsPerByte; ++i)
+        {
+            for (j = 0; j < iSampsPerByte; ++j)
+            {
+                pfBuf[(i*iSampsPerByte)+j]
+                    = (float) (((unsigned char) pcRaw[i] >> (j * iNumBits))
+                               & cMask);
+            }
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * Get the dispersion delay of a frequency relative to a reference frequency,
+ * in s
+ */
+double YAPP_LIB_CalcDelay(double dFChan,
+                          double dFRef,
+                          double dDM,
+                          double dLaw)
+{
+    return YAPP_LIB_KDM * dDM * ((1.0 / pow(dFChan, dLaw))
+                                 - (1.0 / pow(dFRef, dLaw)));
+}
+
+
+/*
+ * Tabulate the dispersion delay of each channel relative to the highest
+ * frequency, in samples
+ */
+int YAPP_LIB_CalcOffsets(const YAPP_LIB_META *pstMeta,
+                         double dDM,
+                         double dLaw,
+                         int *piOffset)
+{
+    double dFMax = GetFMax(pstMeta);
+    double dFChan = 0.0;
+    int i = 0;
+
+    for (i = 0; i < pstMeta->iNumChans; ++i)
+    {
+        dFChan = pstMeta->dFChan1 + (i * pstMeta->dChanBW);
+        piOffset[i] = (int) (YAPP_LIB_CalcDelay(dFChan, dFMax, dDM, dLaw)
+                             / pstMeta->dTSamp);
+    }
+
+    return (pstMeta->dChanBW < 0.0) ? piOffset[pstMeta->iNumChans-1]
+                                    : piOffset[0];
+}
+
+
+/*
+ * Get the dispersion delay of the highest frequency relative to infinite
+ * frequency, in samples
+ */
+int YAPP_LIB_CalcStartOffset(const YAPP_LIB_META *pstMeta,
+                             double dDM,
+                             double dLaw)
+{
+    return (int) (YAPP_LIB_CalcDelay(GetFMax(pstMeta), INFINITY, dDM, dLaw)
+                  / pstMeta->dTSamp);
+}
+
+
+/*
+ * Get the expected noise RMS of the mean over channels
+ */
+double YAPP_LIB_CalcNoiseRMS(int iNumChans, double dChanBW, double dTSamp)
+{
+    /* bandwidth in Hz, times integration time in s */
+    return 1.0 / sqrt(iNumChans * fabs(dChanBW) * 1e6 * dTSamp);
+}
+
+
+/*
+ * Set up a dedisperser
+ */
+int YAPP_LIB_DedispInit(YAPP_LIB_DEDISP *pstDedisp,
+                        const YAPP_LIB_META *pstMeta,
+                        const char *pcIsChanGood,
+                        double dDM,
+                        int iBlockSize)
+{
+    int i = 0;
+    int j = 0;
+
+    (void) memset(pstDedisp, '\0', sizeof(YAPP_LIB_DEDISP));
+    if (iBlockSize < 1)
+    {
+        (void) fprintf(stderr, "ERROR: Invalid block size %d!\n", iBlockSize);
+        return YAPP_RET_ERROR;
+    }
+    pstDedisp->iNumChans = pstMeta->iNumChans;
+    pstDedisp->iBlockSize = iBlockSize;
+
+    pstDedisp->piOffset = (int *) malloc(sizeof(int) * pstMeta->iNumChans);
+    pstDedisp->piChan = (int *) malloc(sizeof(int) * pstMeta->iNumChans);
+    if ((NULL == pstDedisp->piOffset) || (NULL == pstDedisp->piChan))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) YAPP_LIB_DedispClose(pstDedisp);
+        return YAPP_RET_ERROR;
+    }
+
+    /* tabulate the delays of all channels, and keep those of the good
+       channels */
+    (void) YAPP_LIB_CalcOffsets(pstMeta,
+                                dDM,
+                                YAPP_LIB_LAW,
+                                pstDedisp->piOffset);
+    for (i = 0; i < pstMeta->iNumChans; ++i)
+    {
+        if ((pcIsChanGood != NULL) && !pcIsChanGood[i])
+        {
+            continue;
+        }
+        pstDedisp->piChan[j] = i;
+        pstDedisp->piOffset[j] = pstDedisp->piOffset[i];
+        if (pstDedisp->piOffset[j] > pstDedisp->iMaxOffset)
+        {
+            pstDedisp->iMaxOffset = pstDedisp->piOffset[j];
+        }
+        ++j;
+    }
+    pstDedisp->iNumGoodChans = j;
+    if (0 == pstDedisp->iNumGoodChans)
+    {
+        (void) fprintf(stderr, "ERROR: No good channels to dedisperse!\n");
+        (void) YAPP_LIB_DedispClose(pstDedisp);
+        return YAPP_RET_ERROR;
+    }
+    pstDedisp->fNoiseRMS = (float) YAPP_LIB_CalcNoiseRMS(
+                                                pstDedisp->iNumGoodChans,
+                                                pstMeta->dChanBW,
+                                                pstMeta->dTSamp);
+
+    pstDedisp->pfBuf = (float *) malloc(sizeof(float)
+                                        * ((size_t) pstDedisp->iMaxOffset
+                                           + iBlockSize)
+                                        * pstMeta->iNumChans);
+    if (NULL == pstDedisp->pfBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) YAPP_LIB_DedispClose(pstDedisp);
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Dedisperse a block of filterbank data
+ */
+int YAPP_LIB_Dedisperse(YAPP_LIB_DEDISP *pstDedisp,
+                        const float *pfIn,
+                        int iNumSamps,
+                        float *pfOut)
+{
+    int iNumChans = pstDedisp->iNumChans;
+    int iNumOut = 0;
+    float fSum = 0.0;
+    const float *pfSpectrum = NULL;
+    int i = 0;
+    int j = 0;
+
+    if ((iNumSamps < 0) || (iNumSamps > pstDedisp->iBlockSize))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid number of time samples %d!\n",
+                       iNumSamps);
+        return YAPP_RET_ERROR;
+    }
+
+    /* append the block to the spectra kept from the previous call */
+    (void) memcpy(pstDedisp->pfBuf
+                  + (size_t) pstDedisp->iNumPending * iNumChans,
+                  pfIn,
+                  sizeof(float) * iNumSamps * iNumChans);
+    pstDedisp->iNumPending += iNumSamps;
+
+    /* the time samples for which all channels are available */
+    iNumOut = pstDedisp->iNumPending - pstDedisp->iMaxOffset;
+    if (iNumOut <= 0)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < iNumOut; ++i)
+    {
+        fSum = 0.0;
+        pfSpectrum = pstDedisp->pfBuf + (size_t) i * iNumChans;
+        for (j = 0; j < pstDedisp->iNumGoodChans; ++j)
+        {
+            fSum += pfSpectrum[((size_t) pstDedisp->piOffset[j] * iNumChans)
+                               + pstDedisp->piChan[j]];
+        }
+        pfOut[i] = (fSum / pstDedisp->iNumGoodChans) / pstDedisp->fNoiseRMS;
+    }
+
+    /* keep the spectra that the later time samples need */
+    (void) memmove(pstDedisp->pfBuf,
+                   pstDedisp->pfBuf + (size_t) iNumOut * iNumChans,
+                   sizeof(float) * pstDedisp->iMaxOffset * iNumChans);
+    pstDedisp->iNumPending = pstDedisp->iMaxOffset;
+
+    return iNumOut;
+}
+
+
+/*
+ * Free a dedisperser
+ */
+int YAPP_LIB_DedispClose(YAPP_LIB_DEDISP *pstDedisp)
+{
+    free(pstDedisp->piOffset);
+    free(pstDedisp->piChan);
+    free(pstDedisp->pfBuf);
+    (void) memset(pstDedisp, '\0', sizeof(YAPP_LIB_DEDISP));
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Convert a delay to a number of profile bins, wrapped to within one period
+ */
+int YAPP_LIB_CalcBinShift(double dDelay, double dPeriod, int iNumBins)
+{
+    int iBinShift = (int) (lround((dDelay / dPeriod) * iNumBins) % iNumBins);
+
+    if (iBinShift < 0)
+    {
+        iBinShift += iNumBins;
+    }
+
+    return iBinShift;
+}
+
+
+/*
+ * Set up a folder
+ */
+int YAPP_LIB_FoldInit(YAPP_LIB_FOLD *pstFold,
+                      const YAPP_LIB_META *pstMeta,
+                      double dPeriod,
+                      int iNumBins,
+                      double dDM)
+{
+    double dFMax = GetFMax(pstMeta);
+    size_t iLen = (size_t) iNumBins * pstMeta->iNumChans;
+    int i = 0;
+
+    (void) memset(pstFold, '\0', sizeof(YAPP_LIB_FOLD));
+    if ((dPeriod <= 0.0) || (iNumBins < 1))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid period %g or number of bins %d!\n",
+                       dPeriod,
+                       iNumBins);
+        return YAPP_RET_ERROR;
+    }
+    pstFold->iNumChans = pstMeta->iNumChans;
+    pstFold->iNumBins = iNumBins;
+    pstFold->dPeriod = dPeriod;
+    pstFold->dTSamp = pstMeta->dTSamp;
+
+    pstFold->piBinShift = (int *) malloc(sizeof(int) * pstMeta->iNumChans);
+    pstFold->pdSum = (double *) calloc(iLen, sizeof(double));
+    pstFold->plCount = (long *) calloc(iLen, sizeof(long));
+    if ((NULL == pstFold->piBinShift)
+        || (NULL == pstFold->pdSum)
+        || (NULL == pstFold->plCount))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) YAPP_LIB_FoldClose(pstFold);
+        return YAPP_RET_ERROR;
+    }
+
+    for (i = 0; i < pstMeta->iNumChans; ++i)
+    {
+        pstFold->piBinShift[i] = YAPP_LIB_CalcBinShift(GetDelay(pstMeta,
+                                                                i,
+                                                                dFMax,
+                                                                dDM),
+                                                       dPeriod,
+                                                       iNumBins);
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Fold a block of data, continuing from the previous block
+ */
+int YAPP_LIB_Fold(YAPP_LIB_FOLD *pstFold, const float *pfIn, int iNumSamps)
+{
+    int iNumChans = pstFold->iNumChans;
+    int iNumBins = pstFold->iNumBins;
+    const float *pfSpectrum = NULL;
+    double dPhase = 0.0;
+    size_t iIdx = 0;
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    int l = 0;
+
+    for (i = 0; i < iNumSamps; ++i)
+    {
+        /* compute the phase, and the bin it falls into */
+        dPhase = (double) pstFold->lSampCount
+                 * (pstFold->dTSamp / pstFold->dPeriod);
+        dPhase = dPhase - floor(dPhase);
+        j = (int) (dPhase * iNumBins);
+        if (j >= iNumBins)
+        {
+            j = iNumBins - 1;
+        }
+        pfSpectrum = pfIn + (size_t) i * iNumChans;
+        for (k = 0; k < iNumChans; ++k)
+        {
+            /* rotate the channel profile by its dispersion delay while
+               accumulating */
+            l = j - pstFold->piBinShift[k];
+            if (l < 0)
+            {
+                l += iNumBins;
+            }
+            iIdx = ((size_t) l * iNumChans) + k;
+            pstFold->pdSum[iIdx] += pfSpectrum[k];
+            ++pstFold->plCount[iIdx];
+        }
+        ++pstFold->lSampCount;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Get the folded profile
+ */
+int YAPP_LIB_FoldGetProfile(const YAPP_LIB_FOLD *pstFold, float *pfProf)
+{
+    double dSum = 0.0;
+    int iNumChans = 0;
+    size_t iIdx = 0;
+    int i = 0;
+    int j = 0;
+
+    for (i = 0; i < pstFold->iNumBins; ++i)
+    {
+        dSum = 0.0;
+        iNumChans = 0;
+        for (j = 0; j < pstFold->iNumChans; ++j)
+        {
+            iIdx = ((size_t) i * pstFold->iNumChans) + j;
+            if (pstFold->plCount[iIdx] > 0)
+            {
+                dSum += pstFold->pdSum[iIdx] / pstFold->plCount[iIdx];
+                ++iNumChans;
+            }
+        }
+        pfProf[i] = (iNumChans > 0) ? (float) (dSum / iNumChans) : 0.0;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Free a folder
+ */
+int YAPP_LIB_FoldClose(YAPP_LIB_FOLD *pstFold)
+{
+    free(pstFold->piBinShift);
+    free(pstFold->pdSum);
+    free(pstFold->plCount);
+    (void) memset(pstFold, '\0', sizeof(YAPP_LIB_FOLD));
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Smooth a time series with a boxcar, using a running sum
+ */
+int YAPP_LIB_Smooth(const float *pfIn,
+                    int iNumSamps,
+                    int iWidth,
+                    float *pfOut)
+{
+    double dSum = 0.0;
+    int i = 0;
+
+    if ((iWidth < 1) || (iWidth > iNumSamps))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid boxcar width %d for %d samples!\n",
+                       iWidth,
+                       iNumSamps);
+        return YAPP_RET_ERROR;
+    }
+
+    for (i = 0; i < iWidth; ++i)
+    {
+        dSum += pfIn[i];
+    }
+    pfOut[0] = (float) (dSum / iWidth);
+    for (i = iWidth; i < iNumSamps; ++i)
+    {
+        dSum += pfIn[i] - pfIn[i-iWidth];
+        pfOut[i-iWidth+1] = (float) (dSum / iWidth);
+    }
+
+    return iNumSamps - iWidth + 1;
+}
+
+
+/*
+ * Reset running statistics
+ */
+void YAPP_LIB_StatsInit(YAPP_LIB_STATS *pstStats)
+{
+    (void) memset(pstStats, '\0', sizeof(YAPP_LIB_STATS));
+
+    return;
+}
+
+
+/*
+ * Add samples to running statistics - the statistics of the block are
+ * computed on their own, and then merged with the running statistics, which
+ * is both faster and more accurate than updating them a sample at a time
+ */
+void YAPP_LIB_StatsAdd(YAPP_LIB_STATS *pstStats,
+                       const float *pfBuf,
+                       long lLen,
+                       int iStride)
+{
+    long lCount = 0;
+    double dSum = 0.0;
+    double dMean = 0.0;
+    double dM2 = 0.0;
+    double dDelta = 0.0;
+    float fMin = 0.0;
+    float fMax = 0.0;
+    long i = 0;
+
+    if (lLen <= 0)
+    {
+        return;
+    }
+
+    fMin = pfBuf[0];
+    fMax = pfBuf[0];
+    for (i = 0; i < lLen; i += iStride)
+    {
+        dSum += pfBuf[i];
+        if (pfBuf[i] < fMin)
+        {
+            fMin = pfBuf[i];
+        }
+        if (pfBuf[i] > fMax)
+        {
+            fMax = pfBuf[i];
+        }
+        ++lCount;
+    }
+    dMean = dSum / lCount;
+    for (i = 0; i < lLen; i += iStride)
+    {
+        dM2 += (pfBuf[i] - dMean) * (pfBuf[i] - dMean);
+    }
+
+    if (0 == pstStats->lCount)
+    {
+        pstStats->fMin = fMin;
+        pstStats->fMax = fMax;
+    }
+    else
+    {
+        if (fMin < pstStats->fMin)
+        {
+            pstStats->fMin = fMin;
+        }
+        if (fMax > pstStats->fMax)
+        {
+            pstStats->fMax = fMax;
+        }
+    }
+    dDelta = dMean - pstStats->dMean;
+    pstStats->dM2 += dM2 + (dDelta * dDelta
+                            * ((double) pstStats->lCount * lCount)
+                            / (pstStats->lCount + lCount));
+    pstStats->dMean += dDelta * lCount / (pstStats->lCount + lCount);
+    pstStats->lCount += lCount;
+
+    return;
+}
+
+
+/*
+ * Get the mean and standard deviation from running statistics
+ */
+void YAPP_LIB_StatsGet(const YAPP_LIB_STATS *pstStats,
+                       float *pfMean,
+                       float *pfRMS)
+{
+    *pfMean = (float) pstStats->dMean;
+    *pfRMS = (pstStats->lCount > 1)
+             ? (float) sqrt(pstStats->dM2 / (pstStats->lCount - 1))
+             : 0.0;
+
+    return;
+}
+
+
+/*
+ * Set up a ring
+ */
+int YAPP_LIB_RingInit(YAPP_LIB_RING *pstRing, int iNumSlots, int iSlotLen)
+{
+    (void) memset(pstRing, '\0', sizeof(YAPP_LIB_RING));
+
+    if ((iNumSlots < 1) || (iSlotLen < 1))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid ring size %d x %d!\n",
+                       iNumSlots,
+                       iSlotLen);
+        return YAPP_RET_ERROR;
+    }
+
+    pstRing->pfBuf = (float *) malloc(sizeof(float) * iNumSlots * iSlotLen);
+    pstRing->piLen = (int *) malloc(sizeof(int) * iNumSlots);
+    if ((NULL == pstRing->pfBuf) || (NULL == pstRing->piLen))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        free(pstRing->pfBuf);
+        free(pstRing->piLen);
+        pstRing->pfBuf = NULL;
+        pstRing->piLen = NULL;
+        return YAPP_RET_ERROR;
+    }
+    pstRing->iNumSlots = iNumSlots;
+    pstRing->iSlotLen = iSlotLen;
+    (void) pthread_mutex_init(&pstRing->stLock, NULL);
+    (void) pthread_cond_init(&pstRing->stCond, NULL);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Get the next free slot - the producer and the consumer wait on the same
+ * condition variable, as only one of them can be waiting at a time
+ */
+float* YAPP_LIB_RingAcquire(YAPP_LIB_RING *pstRing)
+{
+    float *pfSlot = NULL;
+
+    (void) pthread_mutex_lock(&pstRing->stLock);
+    while ((pstRing->iCount == pstRing->iNumSlots) && !(pstRing->iAborted))
+    {
+        (void) pthread_cond_wait(&pstRing->stCond, &pstRing->stLock);
+    }
+    if (!(pstRing->iAborted))
+    {
+        pfSlot = pstRing->pfBuf
+                 + (size_t) ((pstRing->iHead + pstRing->iCount)
+                             % pstRing->iNumSlots)
+                   * pstRing->iSlotLen;
+    }
+    (void) pthread_mutex_unlock(&pstRing->stLock);
+
+    return pfSlot;
+}
+
+
+/*
+ * Pass a filled slot to the consumer
+ */
+void YAPP_LIB_RingCommit(YAPP_LIB_RING *pstRing, int iLen)
+{
+    (void) pthread_mutex_lock(&pstRing->stLock);
+    pstRing->piLen[(pstRing->iHead + pstRing->iCount) % pstRing->iNumSlots]
+                                                                    = iLen;
+    ++pstRing->iCount;
+    (void) pthread_cond_signal(&pstRing->stCond);
+    (void) pthread_mutex_unlock(&pstRing->stLock);
+
+    return;
+}
+
+
+/*
+ * Get the oldest full slot
+ */
+int YAPP_LIB_RingPeek(YAPP_LIB_RING *pstRing, const float **ppfBuf)
+{
+    int iLen = 0;
+
+    *ppfBuf = NULL;
+    (void) pthread_mutex_lock(&pstRing->stLock);
+    while ((0 == pstRing->iCount)
+           && !(pstRing->iClosed)
+           && !(pstRing->iAborted))
+    {
+        (void) pthread_cond_wait(&pstRing->stCond, &pstRing->stLock);
+    }
+    if (pstRing->iAborted)
+    {
+        iLen = YAPP_RET_ERROR;
+    }
+    else if (pstRing->iCount > 0)
+    {
+        *ppfBuf = pstRing->pfBuf
+                  + (size_t) pstRing->iHead * pstRing->iSlotLen;
+        iLen = pstRing->piLen[pstRing->iHead];
+    }
+    (void) pthread_mutex_unlock(&pstRing->stLock);
+
+    return iLen;
+}
+
+
+/*
+ * Return a slot to the producer
+ */
+void YAPP_LIB_RingRelease(YAPP_LIB_RING *pstRing)
+{
+    (void) pthread_mutex_lock(&pstRing->stLock);
+    pstRing->iHead = (pstRing->iHead + 1) % pstRing->iNumSlots;
+    --pstRing->iCount;
+    (void) pthread_cond_signal(&pstRing->stCond);
+    (void) pthread_mutex_unlock(&pstRing->stLock);
+
+    return;
+}
+
+
+/*
+ * Mark the end of the data
+ */
+void YAPP_LIB_RingClose(YAPP_LIB_RING *pstRing)
+{
+    (void) pthread_mutex_lock(&pstRing->stLock);
+    pstRing->iClosed = 1;
+    (void) pthread_cond_broadcast(&pstRing->stCond);
+    (void) pthread_mutex_unlock(&pstRing->stLock);
+
+    return;
+}
+
+
+/*
+ * Fail both sides of a ring
+ */
+void YAPP_LIB_RingAbort(YAPP_LIB_RING *pstRing)
+{
+    (void) pthread_mutex_lock(&pstRing->stLock);
+    pstRing->iAborted = 1;
+    (void) pthread_cond_broadcast(&pstRing->stCond);
+    (void) pthread_mutex_unlock(&pstRing->stLock);
+
+    return;
+}
+
+
+/*
+ * Free a ring
+ */
+int YAPP_LIB_RingFree(YAPP_LIB_RING *pstRing)
+{
+    if (pstRing->pfBuf != NULL)
+    {
+        (void) pthread_mutex_destroy(&pstRing->stLock);
+        (void) pthread_cond_destroy(&pstRing->stCond);
+    }
+    free(pstRing->pfBuf);
+    free(pstRing->piLen);
+    (void) memset(pstRing, '\0', sizeof(YAPP_LIB_RING));
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Set up an empty pipeline
+ */
+void YAPP_LIB_PipeInit(YAPP_LIB_PIPE *pstPipe, int iNumSlots)
+{
+    (void) memset(pstPipe, '\0', sizeof(YAPP_LIB_PIPE));
+    pstPipe->iNumSlots = iNumSlots;
+
+    return;
+}
+
+
+/*
+ * Add a stage to the end of a pipeline
+ */
+int YAPP_LIB_PipeAdd(YAPP_LIB_PIPE *pstPipe,
+                     YAPP_LIB_STAGEFUNC pfnRun,
+                     void *pvCtx,
+                     int iOutLen)
+{
+    YAPP_LIB_STAGE *pstStage = NULL;
+
+    if (YAPP_LIB_MAXSTAGES == pstPipe->iNumStages)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Too many pipeline stages! Maximum is %d.\n",
+                       YAPP_LIB_MAXSTAGES);
+        return YAPP_RET_ERROR;
+    }
+
+    pstStage = &pstPipe->astStages[pstPipe->iNumStages];
+    pstStage->pfnRun = pfnRun;
+    pstStage->pvCtx = pvCtx;
+    pstStage->iOutLen = iOutLen;
+    pstStage->pstPipe = pstPipe;
+    ++pstPipe->iNumStages;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Run a pipeline
+ */
+int YAPP_LIB_PipeRun(YAPP_LIB_PIPE *pstPipe)
+{
+    YAPP_LIB_STAGE *pstStage = NULL;
+    int iNumStarted = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    if (pstPipe->iNumStages < 1)
+    {
+        (void) fprintf(stderr, "ERROR: Pipeline has no stages!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    /* connect each stage to the next by a ring that holds its output */
+    for (i = 0; i < pstPipe->iNumStages; ++i)
+    {
+        pstStage = &pstPipe->astStages[i];
+        pstStage->pstIn = (i > 0) ? &pstPipe->astRings[i-1] : NULL;
+        pstStage->pstOut = NULL;
+        pstStage->iRet = YAPP_RET_SUCCESS;
+        if (i < pstPipe->iNumStages - 1)
+        {
+            pstStage->pstOut = &pstPipe->astRings[i];
+            iRet = YAPP_LIB_RingInit(pstStage->pstOut,
+                                     pstPipe->iNumSlots,
+                                     pstStage->iOutLen);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                break;
+            }
+        }
+    }
+
+    if (YAPP_RET_SUCCESS == iRet)
+    {
+        for (i = 0; i < pstPipe->iNumStages; ++i)
+        {
+            iRet = pthread_create(&pstPipe->astStages[i].stThread,
+                                  NULL,
+                                  RunStage,
+                                  (void *) &pstPipe->astStages[i]);
+            if (iRet != 0)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Creating thread failed! %s!\n",
+                               strerror(iRet));
+                iRet = YAPP_RET_ERROR;
+                AbortPipe(pstPipe);
+                break;
+            }
+            ++iNumStarted;
+        }
+        for (i = 0; i < iNumStarted; ++i)
+        {
+            (void) pthread_join(pstPipe->astStages[i].stThread, NULL);
+            if (pstPipe->astStages[i].iRet != YAPP_RET_SUCCESS)
+            {
+                iRet = YAPP_RET_ERROR;
+            }
+        }
+    }
+
+    for (i = 0; i < pstPipe->iNumStages - 1; ++i)
+    {
+        (void) YAPP_LIB_RingFree(&pstPipe->astRings[i]);
+    }
+
+    return iRet;
+}
+
+
+/*
+ * Read a header label, or a string value, which is preceded by its length
+ */
+static int ReadLabel(FILE *pFData, char *pcLabel, long *plHeaderLen)
+{
+    int32_t iLen = 0;
+
+    if ((fread(&iLen, sizeof(iLen), 1, pFData) != 1)
+        || (iLen < 0)
+        || (iLen >= LEN_LABEL)
+        || (fread(pcLabel, sizeof(char), iLen, pFData) != (size_t) iLen))
+    {
+        return YAPP_RET_ERROR;
+    }
+    pcLabel[iLen] = '\0';
+    *plHeaderLen += (long) (sizeof(iLen) + iLen);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Read a SIGPROC header
+ */
+static int ReadHeader(FILE *pFData, YAPP_LIB_META *pstMeta)
+{
+    char acLabel[LEN_LABEL] = {0};
+    char acValue[LEN_LABEL] = {0};
+    int32_t iValue = 0;
+    double dValue = 0.0;
+    int iNumFreqs = 0;
+    int iType = 0;
+    size_t i = 0;
+
+    if ((ReadLabel(pFData, acLabel, &pstMeta->lHeaderLen) != YAPP_RET_SUCCESS)
+        || (strcmp(acLabel, YAPP_SP_LABEL_HDRSTART) != 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Missing label %s!\n",
+                       YAPP_SP_LABEL_HDRSTART);
+        return YAPP_RET_ERROR;
+    }
+
+    while (strcmp(acLabel, YAPP_SP_LABEL_HDREND) != 0)
+    {
+        if (ReadLabel(pFData, acLabel, &pstMeta->lHeaderLen)
+            != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr, "ERROR: Truncated header!\n");
+            return YAPP_RET_ERROR;
+        }
+        for (i = 0; i < sizeof(g_astSPFields) / sizeof(g_astSPFields[0]); ++i)
+        {
+            if (0 == strcmp(acLabel, g_astSPFields[i].pcLabel))
+            {
+                break;
+            }
+        }
+        if (sizeof(g_astSPFields) / sizeof(g_astSPFields[0]) == i)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Unknown field %s in header!\n",
+                           acLabel);
+            return YAPP_RET_ERROR;
+        }
+
+        /* read the value of the field */
+        iType = g_astSPFields[i].iType;
+        if (((SP_TYPE_STRING == iType)
+             && (ReadLabel(pFData, acValue, &pstMeta->lHeaderLen)
+                 != YAPP_RET_SUCCESS))
+            || ((SP_TYPE_INT == iType)
+                && (fread(&iValue, sizeof(iValue), 1, pFData) != 1))
+            || ((SP_TYPE_DOUBLE == iType)
+                && (fread(&dValue, sizeof(dValue), 1, pFData) != 1)))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading value of %s failed!\n",
+                           acLabel);
+            return YAPP_RET_ERROR;
+        }
+        if (SP_TYPE_INT == iType)
+        {
+            pstMeta->lHeaderLen += sizeof(iValue);
+        }
+        else if (SP_TYPE_DOUBLE == iType)
+        {
+            pstMeta->lHeaderLen += sizeof(dValue);
+        }
+
+        if (0 == strcmp(acLabel, YAPP_SP_LABEL_SRCNAME))
+        {
+            (void) snprintf(pstMeta->acPulsar,
+                            MAX_LEN_PSRNAME,
+                            "%.*s",
+                            MAX_LEN_PSRNAME - 1,
+                            acValue);
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_NUMCHANS))
+        {
+            pstMeta->iNumChans = iValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_NUMBITS))
+        {
+            pstMeta->iNumBits = iValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_NUMIFS))
+        {
+            pstMeta->iNumIFs = iValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_TSAMP))
+        {
+            pstMeta->dTSamp = dValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_TSTART))
+        {
+            pstMeta->dTStart = dValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_FCHAN1))
+        {
+            pstMeta->dFChan1 = dValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_CHANBW))
+        {
+            pstMeta->dChanBW = dValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_DM))
+        {
+            pstMeta->dDM = dValue;
+        }
+        else if (0 == strcmp(acLabel, YAPP_SP_LABEL_FREQCHAN))
+        {
+            /* a table of channel frequencies - only uniformly spaced
+               channels are supported, so keep the first two */
+            if (0 == iNumFreqs)
+            {
+                pstMeta->dFChan1 = dValue;
+            }
+            else if (1 == iNumFreqs)
+            {
+                pstMeta->dChanBW = dValue - pstMeta->dFChan1;
+            }
+            ++iNumFreqs;
+        }
+    }
+
+    /* a time series may have no channel count */
+    if (0 == pstMeta->iNumChans)
+    {
+        pstMeta->iNumChans = 1;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Get the dispersion delay of a channel relative to the highest frequency,
+ * in s
+ */
+static double GetDelay(const YAPP_LIB_META *pstMeta,
+                       int iChan,
+                       double dFMax,
+                       double dDM)
+{
+    double dFChan = pstMeta->dFChan1 + (iChan * pstMeta->dChanBW);
+
+    /* a time series may have no frequency */
+    if (0.0 == dDM)
+    {
+        return 0.0;
+    }
+
+    return YAPP_LIB_CalcDelay(dFChan, dFMax, dDM, YAPP_LIB_LAW);
+}
+
+
+/*
+ * Get the highest channel frequency, in MHz
+ */
+static double GetFMax(const YAPP_LIB_META *pstMeta)
+{
+    if (pstMeta->dChanBW < 0.0)
+    {
+        return pstMeta->dFChan1;
+    }
+
+    return pstMeta->dFChan1
+           + ((pstMeta->iNumChans - 1) * pstMeta->dChanBW);
+}
+
+
+/*
+ * Pipeline stage thread - calls the stage function until the input ends, and
+ * then closes the output, so that the next stage sees the end. If any stage
+ * fails, all rings are aborted, so that no stage is left waiting.
+ */
+static void* RunStage(void *pvStage)
+{
+    YAPP_LIB_STAGE *pstStage = (YAPP_LIB_STAGE *) pvStage;
+    const float *pfIn = NULL;
+    float *pfOut = NULL;
+    int iInLen = 0;
+    int iOutLen = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    for (;;)
+    {
+        if (pstStage->pstIn != NULL)
+        {
+            iInLen = YAPP_LIB_RingPeek(pstStage->pstIn, &pfIn);
+            if (YAPP_RET_ERROR == iInLen)
+            {
+                iRet = YAPP_RET_ERROR;
+                break;
+            }
+        }
+        if (pstStage->pstOut != NULL)
+        {
+            pfOut = YAPP_LIB_RingAcquire(pstStage->pstOut);
+            if (NULL == pfOut)
+            {
+                iRet = YAPP_RET_ERROR;
+                break;
+            }
+        }
+
+        iOutLen = 0;
+        iRet = pstStage->pfnRun(pstStage->pvCtx,
+                                pfIn,
+                                iInLen,
+                                pfOut,
+                                &iOutLen);
+        if (pfIn != NULL)
+        {
+            YAPP_LIB_RingRelease(pstStage->pstIn);
+        }
+        if (YAPP_RET_ERROR == iRet)
+        {
+            break;
+        }
+        if ((pstStage->pstOut != NULL) && (iOutLen > 0))
+        {
+            YAPP_LIB_RingCommit(pstStage->pstOut, iOutLen);
+        }
+
+        /* a source ends when it says so, and any other stage when it has
+           been called with the end of its input */
+        if ((YAPP_LIB_RET_END == iRet)
+            || ((pstStage->pstIn != NULL) && (NULL == pfIn)))
+        {
+            iRet = YAPP_RET_SUCCESS;
+            break;
+        }
+    }
+
+    if (YAPP_RET_SUCCESS == iRet)
+    {
+        if (pstStage->pstOut != NULL)
+        {
+            YAPP_LIB_RingClose(pstStage->pstOut);
+        }
+    }
+    else
+    {
+        AbortPipe(pstStage->pstPipe);
+    }
+    pstStage->iRet = iRet;
+
+    return NULL;
+}
+
+
+/*
+ * Abort all rings of a pipeline
+ */
+static void AbortPipe(YAPP_LIB_PIPE *pstPipe)
+{
+    int i = 0;
+
+    for (i = 0; i < pstPipe->iNumStages - 1; ++i)
+    {
+        YAPP_LIB_RingAbort(&pstPipe->astRings[i]);
+    }
+
+    return;
+}
@@ -0,0 +1,516 @@
+/**
+ * @file yapp_lib.h
+ * Header file for libyapp - the processing kernels of YAPP as a library, for
+ *  use in-process by other programs. Every function works on an explicit
+ *  context, so that any number of contexts can be used at the same time, from
+ *  any number of threads, one thread per context, except for rings, which
+ *  connect a producer thread and a consumer thread. The library has no global
+ *  state, does not use PGPLOT, and does not depend on the rest of YAPP, so
+ *  this is the only header a program that links with it needs.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_LIB_H__
+#define __YAPP_LIB_H__
+
+#include <stdio.h>
+#include <pthread.h>
+
+/* these are the same as in yapp.h */
+#define YAPP_RET_SUCCESS        0
+#define YAPP_RET_ERROR          -1
+#define MAX_LEN_PSRNAME         12
+
+#define YAPP_LIB_KDM            4.148741601e3   /* dispersion constant, in
+                                                   MHz^2 s pc^-1 cm^3 */
+#define YAPP_LIB_LAW            2.0             /* power law of the
+                                                   dispersion delay */
+
+#define YAPP_LIB_RET_END        1       /* returned by a source stage when it
+                                           has no more data */
+#define YAPP_LIB_MAXSTAGES      16      /* maximum number of pipeline
+                                           stages */
+
+/**
+ * Metadata of a SIGPROC filterbank or time series file. A time series has
+ * one channel.
+ */
+typedef struct tagLibMeta
+{
+    char acPulsar[MAX_LEN_PSRNAME];
+    int iNumChans;
+    int iNumBits;
+    int iNumIFs;
+    double dTSamp;          /* in s */
+    double dTStart;         /* in MJD */
+    double dFChan1;         /* frequency of the first channel, in MHz */
+    double dChanBW;         /* in MHz, negative if the first channel is the
+                               highest */
+    double dDM;             /* DM of a time series */
+    long lHeaderLen;        /* in bytes */
+    long lNumSamps;         /* number of time samples */
+} YAPP_LIB_META;
+
+/**
+ * Reader of a SIGPROC filterbank or time series file
+ */
+typedef struct tagLibReader
+{
+    YAPP_LIB_META stMeta;
+    FILE *pFData;
+    char *pcRaw;            /* raw samples of the last block read */
+    size_t iRawLen;         /* size of pcRaw, in bytes */
+    long lPos;              /* next time sample to be read */
+} YAPP_LIB_READER;
+
+/**
+ * Incoherent dedisperser. Time sample i of the output is the mean over the
+ * good channels of time sample (i + delay) of each channel, where the delay
+ * is relative to the highest frequency, divided by the expected noise RMS of
+ * the mean, as in the output of yapp_dedisperse.
+ */
+typedef struct tagLibDedisp
+{
+    int iNumChans;
+    int iBlockSize;         /* maximum number of time samples per call */
+    int *piOffset;          /* delay of each good channel, in samples */
+    int *piChan;            /* good channels */
+    int iNumGoodChans;
+    int iMaxOffset;
+    float fNoiseRMS;        /* expected noise RMS of the mean over the good
+                               channels */
+    float *pfBuf;           /* spectra not yet dedispersed, followed by the
+                               new block */
+    int iNumPending;        /* number of spectra in pfBuf */
+} YAPP_LIB_DEDISP;
+
+/**
+ * Folder. Each channel is folded with a phase rotation corresponding to its
+ * dispersion delay, so that the profiles of the channels are aligned.
+ */
+typedef struct tagLibFold
+{
+    int iNumChans;
+    int iNumBins;
+    double dPeriod;         /* in s */
+    double dTSamp;          /* in s */
+    int *piBinShift;        /* dispersion delay of each channel, in bins */
+    double *pdSum;          /* sum of each bin of each channel, bin-major */
+    long *plCount;          /* number of samples in each bin of each
+                               channel, bin-major */
+    long lSampCount;        /* number of time samples folded */
+} YAPP_LIB_FOLD;
+
+/**
+ * Running statistics, updated a block at a time
+ */
+typedef struct tagLibStats
+{
+    long lCount;
+    double dMean;
+    double dM2;             /* sum of squared deviations from the mean */
+    float fMin;
+    float fMax;
+} YAPP_LIB_STATS;
+
+/**
+ * Bounded single-producer, single-consumer queue of blocks. The producer fills
+ * a slot in place and commits it, and the consumer reads it in place and
+ * releases it, so that blocks are never copied.
+ */
+typedef struct tagLibRing
+{
+    float *pfBuf;           /* iNumSlots x iSlotLen */
+    int *piLen;             /* number of values in each full slot */
+    int iNumSlots;
+    int iSlotLen;           /* capacity of a slot */
+    int iHead;              /* oldest full slot */
+    int iCount;             /* number of full slots */
+    int iClosed;            /* set when the producer is done */
+    int iAborted;           /* set when either side has failed */
+    pthread_mutex_t stLock;
+    pthread_cond_t stCond;
+} YAPP_LIB_RING;
+
+/**
+ * Pipeline stage function. A source stage, the first of a pipeline, is called
+ * with no input until it returns YAPP_LIB_RET_END. Any other stage is called
+ * once for each block from the stage before, and then once with pfIn NULL, so
+ * that it can output what it has kept back. A stage writes up to the output
+ * length it was added with to pfOut, and sets *piOutLen to the number of
+ * values written, or 0 to output nothing. The last stage has no output.
+ * Returns YAPP_RET_SUCCESS, YAPP_LIB_RET_END, or YAPP_RET_ERROR.
+ */
+typedef int (*YAPP_LIB_STAGEFUNC)(void *pvCtx,
+                                  const float *pfIn,
+                                  int iInLen,
+                                  float *pfOut,
+                                  int *piOutLen);
+
+/**
+ * Pipeline stage, run on a thread of its own
+ */
+typedef struct tagLibStage
+{
+    YAPP_LIB_STAGEFUNC pfnRun;
+    void *pvCtx;
+    int iOutLen;            /* maximum number of values output per call */
+    YAPP_LIB_RING *pstIn;   /* NULL for the source */
+    YAPP_LIB_RING *pstOut;  /* NULL for the last stage */
+    struct tagLibPipe *pstPipe;
+    int iRet;
+    pthread_t stThread;
+} YAPP_LIB_STAGE;
+
+/**
+ * Pipeline - a chain of stages, connected by rings
+ */
+typedef struct tagLibPipe
+{
+    YAPP_LIB_STAGE astStages[YAPP_LIB_MAXSTAGES];
+    YAPP_LIB_RING astRings[YAPP_LIB_MAXSTAGES-1];
+    int iNumStages;
+    int iNumSlots;          /* number of slots in each ring */
+} YAPP_LIB_PIPE;
+
+/**
+ * Open a SIGPROC filterbank or time series file, and read its header
+ *
+ * @param[out]      pstReader       Reader
+ * @param[in]       pcFileData      Data file name
+ */
+int YAPP_LIB_Open(YAPP_LIB_READER *pstReader, const char *pcFileData);
+
+/**
+ * Go to a time sample
+ *
+ * @param[inout]    pstReader       Reader
+ * @param[in]       lSamp           Time sample
+ */
+int YAPP_LIB_Seek(YAPP_LIB_READER *pstReader, long lSamp);
+
+/**
+ * Read time samples, as 32-bit floating-point spectra, unpacked with
+ * YAPP_LIB_Unpack().
+ * Returns the number of time samples read, 0 at the end of the data, or
+ * YAPP_RET_ERROR.
+ *
+ * @param[inout]    pstReader       Reader
+ * @param[out]      pfBuf           Data, iNumSamps * iNumChans
+ * @param[in]       iNumSamps       Number of time samples
+ */
+int YAPP_LIB_Read(YAPP_LIB_READER *pstReader, float *pfBuf, int iNumSamps);
+
+/**
+ * Close a reader
+ *
+ * @param[inout]    pstReader       Reader
+ */
+int YAPP_LIB_Close(YAPP_LIB_READER *pstReader);
+
+/**
+ * Convert raw samples to 32-bit floating-point. This is the conversion used
+ * by all YAPP tools. 16-bit samples are signed, 8-bit samples are of type
+ * char, and samples of fewer than 8 bits are unsigned, and are unpacked with
+ * the first sample in the least significant bits of a byte.
+ *
+ * @param[in]       pcRaw           Raw samples
+ * @param[in]       iNumBits        Number of bits per sample
+ * @param[in]       lNumSamps       Number of samples
+ * @param[out]      pfBuf           Data
+ */
+void YAPP_LIB_Unpack(const char *pcRaw,
+                     int iNumBits,
+                     long lNumSamps,
+                     float *pfBuf);
+
+/**
+ * Get the dispersion delay of a frequency relative to a reference frequency,
+ * in s. The reference may be INFINITY.
+ *
+ * @param[in]       dFChan          Frequency, in MHz
+ * @param[in]       dFRef           Reference frequency, in MHz
+ * @param[in]       dDM             DM
+ * @param[in]       dLaw            Power law of the delay, 2 for cold plasma
+ */
+double YAPP_LIB_CalcDelay(double dFChan,
+                          double dFRef,
+                          double dDM,
+                          double dLaw);
+
+/**
+ * Tabulate the dispersion delay of each channel relative to the highest
+ * frequency, in samples, rounded towards zero. Returns the delay of the lowest
+ * frequency channel.
+ *
+ * @param[in]       pstMeta         Metadata of the filterbank data
+ * @param[in]       dDM             DM
+ * @param[in]       dLaw            Power law of the delay, 2 for cold plasma
+ * @param[out]      piOffset        Delay of each channel, iNumChans
+ */
+int YAPP_LIB_CalcOffsets(const YAPP_LIB_META *pstMeta,
+                         double dDM,
+                         double dLaw,
+                         int *piOffset);
+
+/**
+ * Get the dispersion delay of the highest frequency relative to infinite
+ * frequency, in samples, rounded towards zero - the number of samples by
+ * which the start of a dedispersed time series is later than the start of
+ * the filterbank data, when both are referred to infinite frequency
+ *
+ * @param[in]       pstMeta         Metadata of the filterbank data
+ * @param[in]       dDM             DM
+ * @param[in]       dLaw            Power law of the delay, 2 for cold plasma
+ */
+int YAPP_LIB_CalcStartOffset(const YAPP_LIB_META *pstMeta,
+                             double dDM,
+                             double dLaw);
+
+/**
+ * Get the expected noise RMS of the mean over channels, for data normalized
+ * to the radiometer equation
+ *
+ * @param[in]       iNumChans       Number of channels averaged
+ * @param[in]       dChanBW         Channel bandwidth, in MHz
+ * @param[in]       dTSamp          Sampling interval, in s
+ */
+double YAPP_LIB_CalcNoiseRMS(int iNumChans, double dChanBW, double dTSamp);
+
+/**
+ * Set up a dedisperser
+ *
+ * @param[out]      pstDedisp       Dedisperser
+ * @param[in]       pstMeta         Metadata of the filterbank data
+ * @param[in]       pcIsChanGood    Flag of each channel, 0 for a channel to
+ *                                  be left out, or NULL to use all channels
+ * @param[in]       dDM             DM
+ * @param[in]       iBlockSize      Maximum number of time samples per call
+ */
+int YAPP_LIB_DedispInit(YAPP_LIB_DEDISP *pstDedisp,
+                        const YAPP_LIB_META *pstMeta,
+                        const char *pcIsChanGood,
+                        double dDM,
+                        int iBlockSize);
+
+/**
+ * Dedisperse a block of filterbank data. The last iMaxOffset time samples
+ * of the data are kept until the next call, so the output lags the input by
+ * that many samples, and the last iMaxOffset samples of the data are never
+ * output. Returns the number of time samples output, or YAPP_RET_ERROR.
+ *
+ * @param[inout]    pstDedisp       Dedisperser
+ * @param[in]       pfIn            Data, iNumSamps * iNumChans
+ * @param[in]       iNumSamps       Number of time samples
+ * @param[out]      pfOut           Dedispersed time series, up to
+ *                                  iNumSamps samples
+ */
+int YAPP_LIB_Dedisperse(YAPP_LIB_DEDISP *pstDedisp,
+                        const float *pfIn,
+                        int iNumSamps,
+                        float *pfOut);
+
+/**
+ * Free a dedisperser
+ *
+ * @param[inout]    pstDedisp       Dedisperser
+ */
+int YAPP_LIB_DedispClose(YAPP_LIB_DEDISP *pstDedisp);
+
+/**
+ * Convert a delay to a number of profile bins, wrapped to within one period
+ *
+ * @param[in]       dDelay          Delay, in s
+ * @param[in]       dPeriod         Period, in s
+ * @param[in]       iNumBins        Number of bins in a period
+ */
+int YAPP_LIB_CalcBinShift(double dDelay, double dPeriod, int iNumBins);
+
+/**
+ * Set up a folder
+ *
+ * @param[out]      pstFold         Folder
+ * @param[in]       pstMeta         Metadata of the data
+ * @param[in]       dPeriod         Folding period, in s
+ * @param[in]       iNumBins        Number of bins in a period
+ * @param[in]       dDM             DM at which the channels are aligned, or
+ *                                  0 for no alignment
+ */
+int YAPP_LIB_FoldInit(YAPP_LIB_FOLD *pstFold,
+                      const YAPP_LIB_META *pstMeta,
+                      double dPeriod,
+                      int iNumBins,
+                      double dDM);
+
+/**
+ * Fold a block of data, continuing from the previous block
+ *
+ * @param[inout]    pstFold         Folder
+ * @param[in]       pfIn            Data, iNumSamps * iNumChans
+ * @param[in]       iNumSamps       Number of time samples
+ */
+int YAPP_LIB_Fold(YAPP_LIB_FOLD *pstFold, const float *pfIn, int iNumSamps);
+
+/**
+ * Get the folded profile - the mean of each bin, averaged over the channels,
+ * or 0 for a bin that no sample has fallen into
+ *
+ * @param[in]       pstFold         Folder
+ * @param[out]      pfProf          Profile, iNumBins
+ */
+int YAPP_LIB_FoldGetProfile(const YAPP_LIB_FOLD *pstFold, float *pfProf);
+
+/**
+ * Free a folder
+ *
+ * @param[inout]    pstFold         Folder
+ */
+int YAPP_LIB_FoldClose(YAPP_LIB_FOLD *pstFold);
+
+/**
+ * Smooth a time series with a boxcar. Sample i of the output is the mean of
+ * samples i to i + iWidth - 1 of the input. Returns the number of samples
+ * output, iNumSamps - iWidth + 1, or YAPP_RET_ERROR.
+ *
+ * @param[in]       pfIn            Time series
+ * @param[in]       iNumSamps       Number of samples
+ * @param[in]       iWidth          Width of the boxcar, in samples
+ * @param[out]      pfOut           Smoothed time series
+ */
+int YAPP_LIB_Smooth(const float *pfIn,
+                    int iNumSamps,
+                    int iWidth,
+                    float *pfOut);
+
+/**
+ * Reset running statistics
+ *
+ * @param[out]      pstStats        Statistics
+ */
+void YAPP_LIB_StatsInit(YAPP_LIB_STATS *pstStats);
+
+/**
+ * Add samples to running statistics
+ *
+ * @param[inout]    pstStats        Statistics
+ * @param[in]       pfBuf           Data
+ * @param[in]       lLen            Number of samples
+ * @param[in]       iStride         Distance between samples, for instance,
+ *                                  the number of channels to take the
+ *                                  statistics of one channel
+ */
+void YAPP_LIB_StatsAdd(YAPP_LIB_STATS *pstStats,
+                       const float *pfBuf,
+                       long lLen,
+                       int iStride);
+
+/**
+ * Get the mean and standard deviation from running statistics
+ *
+ * @param[in]       pstStats        Statistics
+ * @param[out]      pfMean          Mean
+ * @param[out]      pfRMS           Standard deviation
+ */
+void YAPP_LIB_StatsGet(const YAPP_LIB_STATS *pstStats,
+                       float *pfMean,
+                       float *pfRMS);
+
+/**
+ * Set up a ring
+ *
+ * @param[out]      pstRing         Ring
+ * @param[in]       iNumSlots       Number of slots
+ * @param[in]       iSlotLen        Capacity of a slot, in values
+ */
+int YAPP_LIB_RingInit(YAPP_LIB_RING *pstRing, int iNumSlots, int iSlotLen);
+
+/**
+ * Get the next free slot, waiting until there is one. Returns NULL if the
+ * ring has been aborted.
+ *
+ * @param[inout]    pstRing         Ring
+ */
+float* YAPP_LIB_RingAcquire(YAPP_LIB_RING *pstRing);
+
+/**
+ * Pass the slot got from YAPP_LIB_RingAcquire() to the consumer
+ *
+ * @param[inout]    pstRing         Ring
+ * @param[in]       iLen            Number of values in the slot
+ */
+void YAPP_LIB_RingCommit(YAPP_LIB_RING *pstRing, int iLen);
+
+/**
+ * Get the oldest full slot, waiting until there is one. Returns the number of
+ * values in the slot, 0 if the ring has been closed and is empty, or
+ * YAPP_RET_ERROR if it has been aborted.
+ *
+ * @param[inout]    pstRing         Ring
+ * @param[out]      ppfBuf          Slot
+ */
+int YAPP_LIB_RingPeek(YAPP_LIB_RING *pstRing, const float **ppfBuf);
+
+/**
+ * Return the slot got from YAPP_LIB_RingPeek() to the producer
+ *
+ * @param[inout]    pstRing         Ring
+ */
+void YAPP_LIB_RingRelease(YAPP_LIB_RING *pstRing);
+
+/**
+ * Mark the end of the data - the consumer sees the end once it has read all
+ * full slots
+ *
+ * @param[inout]    pstRing         Ring
+ */
+void YAPP_LIB_RingClose(YAPP_LIB_RING *pstRing);
+
+/**
+ * Wake up and fail both sides, for instance, when a stage has failed
+ *
+ * @param[inout]    pstRing         Ring
+ */
+void YAPP_LIB_RingAbort(YAPP_LIB_RING *pstRing);
+
+/**
+ * Free a ring
+ *
+ * @param[inout]    pstRing         Ring
+ */
+int YAPP_LIB_RingFree(YAPP_LIB_RING *pstRing);
+
+/**
+ * Set up an empty pipeline
+ *
+ * @param[out]      pstPipe         Pipeline
+ * @param[in]       iNumSlots       Number of blocks that can be queued between
+ *                                  two stages
+ */
+void YAPP_LIB_PipeInit(YAPP_LIB_PIPE *pstPipe, int iNumSlots);
+
+/**
+ * Add a stage to the end of a pipeline
+ *
+ * @param[inout]    pstPipe         Pipeline
+ * @param[in]       pfnRun          Stage function
+ * @param[in]       pvCtx           Context passed to the stage function
+ * @param[in]       iOutLen         Maximum number of values output per call,
+ *                                  0 for the last stage
+ */
+int YAPP_LIB_PipeAdd(YAPP_LIB_PIPE *pstPipe,
+                     YAPP_LIB_STAGEFUNC pfnRun,
+                     void *pvCtx,
+                     int iOutLen);
+
+/**
+ * Run all stages of a pipeline concurrently, one thread each, until the source
+ * ends and all stages have finished, or until any stage fails
+ *
+ * @param[inout]    pstPipe         Pipeline
+ */
+int YAPP_LIB_PipeRun(YAPP_LIB_PIPE *pstPipe);
+
+#endif  /* __YAPP_LIB_H__ */
+
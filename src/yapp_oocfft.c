@@ -0,0 +1,707 @@
+/*
+ * @file yapp_oocfft.c
+ * Out-of-core FFT routines, used to transform time series that are too long to
+ *  be transformed in memory. A real FFT of length N is computed as a complex
+ *  FFT of length N / 2 on consecutive pairs of samples, which is in turn
+ *  computed with the four-step algorithm: the data are treated as an
+ *  N1 x N2 matrix on disk, N1-point FFTs are computed along the columns, in
+ *  tiles of as many columns as fit in memory, twiddle factors are applied,
+ *  N2-point FFTs are computed along the rows, and the result is written
+ *  transposed. Memory use is bounded by the size of one tile.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_oocfft.h"
+
+/* the FFTW planner is not thread-safe, and the out-of-core FFT may be
+   called from multiple threads */
+static pthread_mutex_t g_stOOCFFTPlanMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int ReadBlock(int iFd, void *pvBuf, size_t lBytes, off_t lOffset);
+static int WriteBlock(int iFd, const void *pvBuf, size_t lBytes,
+                      off_t lOffset);
+static long FactorLength(long lLen);
+static fftwf_plan MakePlan(fftwf_plan stPlan,
+                           int iLen,
+                           int iHowMany,
+                           int iStride,
+                           int iDist,
+                           fftwf_complex *pfcBuf,
+                           int iSign);
+static void DestroyPlan(fftwf_plan stPlan);
+static int FourStep(int iFdIn,
+                    int iFdOut,
+                    long lLen,
+                    int iSign,
+                    fftwf_complex *pfcBuf,
+                    long lBufLen);
+
+/*
+ * Create a scratch file for an out-of-core FFT
+ */
+int YAPP_OOCFFT_OpenScratch()
+{
+    char acFileScratch[LEN_GENSTRING] = {0};
+    int iFd = 0;
+
+    (void) strcpy(acFileScratch, YAPP_OOCFFT_SCRATCH);
+    iFd = mkstemp(acFileScratch);
+    if (-1 == iFd)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Creating scratch file failed! %s.\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    (void) unlink(acFileScratch);
+
+    return iFd;
+}
+
+
+/*
+ * Returns the largest even FFT length not greater than the given length, for
+ * which the out-of-core FFT is efficient
+ */
+long YAPP_OOCFFT_GoodLength(long lLen)
+{
+    long lHalf = lLen / 2;
+    long lN1 = 1;
+
+    /* make the half-length a multiple of the largest power of 2 not greater
+       than its square root, so that it has a factor of about that size */
+    while (((lN1 * 2) * (lN1 * 2)) <= lHalf)
+    {
+        lN1 *= 2;
+    }
+
+    return 2 * ((lHalf / lN1) * lN1);
+}
+
+
+/*
+ * Out-of-core real-to-complex FFT
+ */
+int YAPP_OOCFFT_R2C(FILE *pFIn,
+                    float fSampSize,
+                    long lNumSamps,
+                    long lLen,
+                    int iFd,
+                    size_t lMemSize)
+{
+    long lHalf = lLen / 2;
+    long lBufLen = (long) (lMemSize / sizeof(fftwf_complex));
+    fftwf_complex *pfcBuf = NULL;
+    fftwf_complex *pfcA = NULL;
+    fftwf_complex *pfcB = NULL;
+    fftwf_complex *pfcX = NULL;
+    fftwf_complex fcZ0 = {0};
+    float *pfBuf = NULL;
+    char *pcRawBuf = NULL;
+    long lChunk = 0;
+    long lNum = 0;
+    long lNumValid = 0;
+    long lLo = 0;
+    long lStart = 0;
+    long k = 0;
+    long i = 0;
+    size_t lReadBytes = 0;
+    double dEvenRe = 0.0;
+    double dEvenIm = 0.0;
+    double dOddRe = 0.0;
+    double dOddIm = 0.0;
+    double dWRe = 0.0;
+    double dWIm = 0.0;
+    double dStepRe = 0.0;
+    double dStepIm = 0.0;
+    double dTemp = 0.0;
+    int iFdScratch = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    pfcBuf = (fftwf_complex *) fftwf_malloc(lBufLen * sizeof(fftwf_complex));
+    if (NULL == pfcBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    /* read the time series - consecutive pairs of samples are the real and
+       imaginary parts of the half-length complex sequence, so the samples
+       are written as they are, with the raw data read into the second half
+       of the buffer */
+    pfBuf = (float *) pfcBuf;
+    pcRawBuf = (char *) (pfBuf + lBufLen);
+    lChunk = lBufLen - (lBufLen % 2);
+    for (lStart = 0; lStart < lLen; lStart += lChunk)
+    {
+        lNum = ((lLen - lStart) < lChunk) ? (lLen - lStart) : lChunk;
+        lNumValid = lNumSamps - lStart;
+        if (lNumValid > lNum)
+        {
+            lNumValid = lNum;
+        }
+        else if (lNumValid < 0)
+        {
+            lNumValid = 0;
+        }
+        if (lNumValid > 0)
+        {
+            lReadBytes = (size_t) (lNumValid * fSampSize);
+            if (fread(pcRawBuf, sizeof(char), lReadBytes, pFIn) != lReadBytes)
+            {
+                (void) fprintf(stderr, "ERROR: Reading data failed!\n");
+                fftwf_free(pfcBuf);
+                return YAPP_RET_ERROR;
+            }
+            (void) YAPP_UnpackData(pcRawBuf, pfBuf, fSampSize, (int) lNumValid);
+        }
+        (void) memset(pfBuf + lNumValid,
+                      '\0',
+                      (lNum - lNumValid) * sizeof(float));
+        iRet = WriteBlock(iFd, pfBuf, lNum * sizeof(float),
+                          (off_t) lStart * sizeof(float));
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            fftwf_free(pfcBuf);
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    iFdScratch = YAPP_OOCFFT_OpenScratch();
+    if (YAPP_RET_ERROR == iFdScratch)
+    {
+        fftwf_free(pfcBuf);
+        return YAPP_RET_ERROR;
+    }
+
+    /* transform the half-length sequence into the scratch file */
+    iRet = FourStep(iFd, iFdScratch, lHalf, FFTW_FORWARD, pfcBuf, lBufLen);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) close(iFdScratch);
+        fftwf_free(pfcBuf);
+        return YAPP_RET_ERROR;
+    }
+
+    /* separate the transforms of the even and odd samples, and combine them
+       into the transform of the real sequence - with Z the half-length
+       transform, for k = 0 to N / 2,
+           E[k] = (Z[k] + Z*[N/2 - k]) / 2,
+           O[k] = (Z[k] - Z*[N/2 - k]) / 2i,
+           X[k] = E[k] + exp(-2 pi i k / N) O[k],
+       where Z[N/2] = Z[0] */
+    iRet = ReadBlock(iFdScratch, fcZ0, sizeof(fftwf_complex), 0);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) close(iFdScratch);
+        fftwf_free(pfcBuf);
+        return YAPP_RET_ERROR;
+    }
+    lChunk = lBufLen / 3;
+    pfcA = pfcBuf;
+    pfcB = pfcBuf + lChunk;
+    pfcX = pfcBuf + (2 * lChunk);
+    dStepRe = cos(-M_PI / lHalf);
+    dStepIm = sin(-M_PI / lHalf);
+    for (lStart = 0; lStart <= lHalf; lStart += lChunk)
+    {
+        lNum = ((lHalf + 1 - lStart) < lChunk) ? (lHalf + 1 - lStart) : lChunk;
+
+        /* Z[k], for k = lStart to (lStart + lNum - 1) */
+        i = ((lStart + lNum) > lHalf) ? (lHalf - lStart) : lNum;
+        iRet = ReadBlock(iFdScratch, pfcA, i * sizeof(fftwf_complex),
+                         (off_t) lStart * sizeof(fftwf_complex));
+        if (i < lNum)
+        {
+            pfcA[i][0] = fcZ0[0];
+            pfcA[i][1] = fcZ0[1];
+        }
+        /* Z[N/2 - k], stored from the lowest index, lLo */
+        lLo = lHalf - (lStart + lNum - 1);
+        i = (0 == lStart) ? (lNum - 1) : lNum;
+        if (YAPP_RET_SUCCESS == iRet)
+        {
+            iRet = ReadBlock(iFdScratch, pfcB, i * sizeof(fftwf_complex),
+                             (off_t) lLo * sizeof(fftwf_complex));
+        }
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) close(iFdScratch);
+            fftwf_free(pfcBuf);
+            return YAPP_RET_ERROR;
+        }
+        if (i < lNum)
+        {
+            pfcB[i][0] = fcZ0[0];
+            pfcB[i][1] = fcZ0[1];
+        }
+
+        for (i = 0; i < lNum; ++i)
+        {
+            k = lStart + i;
+            if (0 == (i % YAPP_OOCFFT_TWID_RESEED))
+            {
+                dWRe = cos(-M_PI * k / lHalf);
+                dWIm = sin(-M_PI * k / lHalf);
+            }
+            /* Z*[N/2 - k] */
+            dTemp = pfcB[lHalf - k - lLo][0];
+            dEvenRe = (pfcA[i][0] + dTemp) / 2;
+            dOddIm = -(pfcA[i][0] - dTemp) / 2;
+            dTemp = -pfcB[lHalf - k - lLo][1];
+            dEvenIm = (pfcA[i][1] + dTemp) / 2;
+            dOddRe = (pfcA[i][1] - dTemp) / 2;
+            pfcX[i][0] = (float) (dEvenRe + (dWRe * dOddRe) - (dWIm * dOddIm));
+            pfcX[i][1] = (float) (dEvenIm + (dWRe * dOddIm) + (dWIm * dOddRe));
+            /* advance the twiddle factor */
+            dTemp = dWRe;
+            dWRe = (dTemp * dStepRe) - (dWIm * dStepIm);
+            dWIm = (dTemp * dStepIm) + (dWIm * dStepRe);
+        }
+
+        iRet = WriteBlock(iFd, pfcX, lNum * sizeof(fftwf_complex),
+                          (off_t) lStart * sizeof(fftwf_complex));
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) close(iFdScratch);
+            fftwf_free(pfcBuf);
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    (void) close(iFdScratch);
+    fftwf_free(pfcBuf);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Out-of-core complex-to-real FFT
+ */
+int YAPP_OOCFFT_C2R(int iFd, long lLen, size_t lMemSize)
+{
+    long lHalf = lLen / 2;
+    long lBufLen = (long) (lMemSize / sizeof(fftwf_complex));
+    fftwf_complex *pfcBuf = NULL;
+    fftwf_complex *pfcA = NULL;
+    fftwf_complex *pfcB = NULL;
+    fftwf_complex *pfcZ = NULL;
+    long lChunk = 0;
+    long lNum = 0;
+    long lLo = 0;
+    long lStart = 0;
+    long k = 0;
+    long i = 0;
+    double dSumRe = 0.0;
+    double dSumIm = 0.0;
+    double dDiffRe = 0.0;
+    double dDiffIm = 0.0;
+    double dWRe = 0.0;
+    double dWIm = 0.0;
+    double dStepRe = 0.0;
+    double dStepIm = 0.0;
+    double dTemp = 0.0;
+    int iFdScratch = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    pfcBuf = (fftwf_complex *) fftwf_malloc(lBufLen * sizeof(fftwf_complex));
+    if (NULL == pfcBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    iFdScratch = YAPP_OOCFFT_OpenScratch();
+    if (YAPP_RET_ERROR == iFdScratch)
+    {
+        fftwf_free(pfcBuf);
+        return YAPP_RET_ERROR;
+    }
+
+    /* form the half-length sequence whose inverse transform holds the even
+       and odd samples in its real and imaginary parts - the inverse of the
+       post-processing in YAPP_OOCFFT_R2C(), for k = 0 to (N / 2) - 1,
+           Z[k] = (X[k] + X*[N/2 - k])
+                  + i exp(2 pi i k / N) (X[k] - X*[N/2 - k]),
+       which is twice the transform of the half-length sequence, so that the
+       result is scaled by N, as by FFTW */
+    lChunk = lBufLen / 3;
+    pfcA = pfcBuf;
+    pfcB = pfcBuf + lChunk;
+    pfcZ = pfcBuf + (2 * lChunk);
+    dStepRe = cos(M_PI / lHalf);
+    dStepIm = sin(M_PI / lHalf);
+    for (lStart = 0; lStart < lHalf; lStart += lChunk)
+    {
+        lNum = ((lHalf - lStart) < lChunk) ? (lHalf - lStart) : lChunk;
+        lLo = lHalf - (lStart + lNum - 1);
+        iRet = ReadBlock(iFd, pfcA, lNum * sizeof(fftwf_complex),
+                         (off_t) lStart * sizeof(fftwf_complex));
+        if (YAPP_RET_SUCCESS == iRet)
+        {
+            iRet = ReadBlock(iFd, pfcB, lNum * sizeof(fftwf_complex),
+                             (off_t) lLo * sizeof(fftwf_complex));
+        }
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) close(iFdScratch);
+            fftwf_free(pfcBuf);
+            return YAPP_RET_ERROR;
+        }
+
+        for (i = 0; i < lNum; ++i)
+        {
+            k = lStart + i;
+            if (0 == (i % YAPP_OOCFFT_TWID_RESEED))
+            {
+                dWRe = cos(M_PI * k / lHalf);
+                dWIm = sin(M_PI * k / lHalf);
+            }
+            /* X*[N/2 - k] */
+            dTemp = pfcB[lHalf - k - lLo][0];
+            dSumRe = pfcA[i][0] + dTemp;
+            dDiffRe = pfcA[i][0] - dTemp;
+            dTemp = -pfcB[lHalf - k - lLo][1];
+            dSumIm = pfcA[i][1] + dTemp;
+            dDiffIm = pfcA[i][1] - dTemp;
+            /* i W (X - X*) = i W D = -(W D).im + i (W D).re */
+            pfcZ[i][0] = (float) (dSumRe
+                                  - ((dWRe * dDiffIm) + (dWIm * dDiffRe)));
+            pfcZ[i][1] = (float) (dSumIm
+                                  + ((dWRe * dDiffRe) - (dWIm * dDiffIm)));
+            /* advance the twiddle factor */
+            dTemp = dWRe;
+            dWRe = (dTemp * dStepRe) - (dWIm * dStepIm);
+            dWIm = (dTemp * dStepIm) + (dWIm * dStepRe);
+        }
+
+        iRet = WriteBlock(iFdScratch, pfcZ, lNum * sizeof(fftwf_complex),
+                          (off_t) lStart * sizeof(fftwf_complex));
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) close(iFdScratch);
+            fftwf_free(pfcBuf);
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    /* transform back, into the input file - its real and imaginary parts are
+       the even and odd samples, in order */
+    iRet = FourStep(iFdScratch, iFd, lHalf, FFTW_BACKWARD, pfcBuf, lBufLen);
+    (void) close(iFdScratch);
+    fftwf_free(pfcBuf);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        return YAPP_RET_ERROR;
+    }
+    if (ftruncate(iFd, (off_t) lLen * sizeof(float)) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Truncating scratch file failed! %s.\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Four-step FFT of a complex sequence of length lLen = N1 x N2, stored as an
+ * N1 x N2 matrix in row-major order - with the input index n = N2 n1 + n2 and
+ * the output index k = k1 + N1 k2, N1-point FFTs over n1 are computed along
+ * the columns, each element is multiplied by exp(-/+ 2 pi i n2 k1 / lLen),
+ * N2-point FFTs over n2 are computed along the rows, and the matrix is
+ * transposed, to get the output in order. The input file is overwritten.
+ */
+static int FourStep(int iFdIn,
+                    int iFdOut,
+                    long lLen,
+                    int iSign,
+                    fftwf_complex *pfcBuf,
+                    long lBufLen)
+{
+    long lN1 = FactorLength(lLen);
+    long lN2 = lLen / lN1;
+    fftwf_complex *pfcCol = NULL;
+    fftwf_plan stPlan = NULL;
+    long lTile = 0;
+    long lCol = 0;
+    long lRow = 0;
+    long lNum = 0;
+    long lNumPlanned = 0;
+    long k1 = 0;
+    long k2 = 0;
+    long c = 0;
+    double dStepRe = 0.0;
+    double dStepIm = 0.0;
+    double dWRe = 0.0;
+    double dWIm = 0.0;
+    double dTemp = 0.0;
+    double dRe = 0.0;
+    double dIm = 0.0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    /* both passes need room for at least one row of the longer dimension,
+       and a column of the shorter one */
+    if ((lN2 + 1) > lBufLen)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: FFT length %ld cannot be split into transforms "
+                       "that fit in memory!\n",
+                       2 * lLen);
+        return YAPP_RET_ERROR;
+    }
+
+    /* pass 1 - column transforms, in tiles of lTile columns, stored as
+       N1 rows of lTile elements */
+    lTile = lBufLen / lN1;
+    if (lTile > lN2)
+    {
+        lTile = lN2;
+    }
+    for (lCol = 0; lCol < lN2; lCol += lTile)
+    {
+        lNum = ((lN2 - lCol) < lTile) ? (lN2 - lCol) : lTile;
+        for (k1 = 0; k1 < lN1; ++k1)
+        {
+            iRet = ReadBlock(iFdIn, pfcBuf + (k1 * lNum),
+                             lNum * sizeof(fftwf_complex),
+                             (off_t) ((k1 * lN2) + lCol)
+                             * sizeof(fftwf_complex));
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                DestroyPlan(stPlan);
+                return YAPP_RET_ERROR;
+            }
+        }
+
+        if (lNum != lNumPlanned)
+        {
+            stPlan = MakePlan(stPlan, (int) lN1, (int) lNum, (int) lNum, 1,
+                              pfcBuf, iSign);
+            lNumPlanned = lNum;
+        }
+        fftwf_execute_dft(stPlan, pfcBuf, pfcBuf);
+
+        /* apply the twiddle factors - along row k1, they advance by
+           exp(-/+ 2 pi i k1 / lLen) per column */
+        for (k1 = 1; k1 < lN1; ++k1)
+        {
+            dStepRe = cos(2 * M_PI * k1 / lLen);
+            dStepIm = iSign * sin(2 * M_PI * k1 / lLen);
+            for (c = 0; c < lNum; ++c)
+            {
+                if (0 == (c % YAPP_OOCFFT_TWID_RESEED))
+                {
+                    /* reduce the argument exactly, in integer arithmetic */
+                    dTemp = 2 * M_PI * (double) ((k1 * (lCol + c)) % lLen)
+                            / lLen;
+                    dWRe = cos(dTemp);
+                    dWIm = iSign * sin(dTemp);
+                }
+                dRe = pfcBuf[(k1*lNum)+c][0];
+                dIm = pfcBuf[(k1*lNum)+c][1];
+                pfcBuf[(k1*lNum)+c][0] = (float) ((dRe * dWRe) - (dIm * dWIm));
+                pfcBuf[(k1*lNum)+c][1] = (float) ((dRe * dWIm) + (dIm * dWRe));
+                dTemp = dWRe;
+                dWRe = (dTemp * dStepRe) - (dWIm * dStepIm);
+                dWIm = (dTemp * dStepIm) + (dWIm * dStepRe);
+            }
+        }
+
+        for (k1 = 0; k1 < lN1; ++k1)
+        {
+            iRet = WriteBlock(iFdIn, pfcBuf + (k1 * lNum),
+                              lNum * sizeof(fftwf_complex),
+                              (off_t) ((k1 * lN2) + lCol)
+                              * sizeof(fftwf_complex));
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                DestroyPlan(stPlan);
+                return YAPP_RET_ERROR;
+            }
+        }
+    }
+
+    /* pass 2 - row transforms, in tiles of lTile rows, each written out
+       transposed, one column of the tile at a time through pfcCol */
+    lTile = lBufLen / (lN2 + 1);
+    if (lTile > lN1)
+    {
+        lTile = lN1;
+    }
+    pfcCol = pfcBuf + (lTile * lN2);
+    lNumPlanned = 0;
+    for (lRow = 0; lRow < lN1; lRow += lTile)
+    {
+        lNum = ((lN1 - lRow) < lTile) ? (lN1 - lRow) : lTile;
+        iRet = ReadBlock(iFdIn, pfcBuf,
+                         lNum * lN2 * sizeof(fftwf_complex),
+                         (off_t) lRow * lN2 * sizeof(fftwf_complex));
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            DestroyPlan(stPlan);
+            return YAPP_RET_ERROR;
+        }
+
+        if (lNum != lNumPlanned)
+        {
+            stPlan = MakePlan(stPlan, (int) lN2, (int) lNum, 1, (int) lN2,
+                              pfcBuf, iSign);
+            lNumPlanned = lNum;
+        }
+        fftwf_execute_dft(stPlan, pfcBuf, pfcBuf);
+
+        for (k2 = 0; k2 < lN2; ++k2)
+        {
+            for (k1 = 0; k1 < lNum; ++k1)
+            {
+                pfcCol[k1][0] = pfcBuf[(k1*lN2)+k2][0];
+                pfcCol[k1][1] = pfcBuf[(k1*lN2)+k2][1];
+            }
+            iRet = WriteBlock(iFdOut, pfcCol,
+                              lNum * sizeof(fftwf_complex),
+                              (off_t) ((k2 * lN1) + lRow)
+                              * sizeof(fftwf_complex));
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                DestroyPlan(stPlan);
+                return YAPP_RET_ERROR;
+            }
+        }
+    }
+    DestroyPlan(stPlan);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Returns the largest factor of lLen not greater than its square root
+ */
+static long FactorLength(long lLen)
+{
+    long lN1 = (long) sqrt((double) lLen);
+
+    while ((lN1 > 1) && ((lLen % lN1) != 0))
+    {
+        --lN1;
+    }
+
+    return lN1;
+}
+
+
+/*
+ * Create an in-place plan for a batch of transforms, destroying the previous
+ * one - FFTW_ESTIMATE is used, as the planner would otherwise overwrite the
+ * buffer
+ */
+static fftwf_plan MakePlan(fftwf_plan stPlan,
+                           int iLen,
+                           int iHowMany,
+                           int iStride,
+                           int iDist,
+                           fftwf_complex *pfcBuf,
+                           int iSign)
+{
+    (void) pthread_mutex_lock(&g_stOOCFFTPlanMutex);
+    if (stPlan != NULL)
+    {
+        fftwf_destroy_plan(stPlan);
+    }
+    stPlan = fftwf_plan_many_dft(1, &iLen, iHowMany,
+                                 pfcBuf, NULL, iStride, iDist,
+                                 pfcBuf, NULL, iStride, iDist,
+                                 iSign, FFTW_ESTIMATE);
+    (void) pthread_mutex_unlock(&g_stOOCFFTPlanMutex);
+
+    return stPlan;
+}
+
+
+static void DestroyPlan(fftwf_plan stPlan)
+{
+    if (stPlan != NULL)
+    {
+        (void) pthread_mutex_lock(&g_stOOCFFTPlanMutex);
+        fftwf_destroy_plan(stPlan);
+        (void) pthread_mutex_unlock(&g_stOOCFFTPlanMutex);
+    }
+
+    return;
+}
+
+
+/*
+ * Read from a file at the given offset, retrying short reads
+ */
+static int ReadBlock(int iFd, void *pvBuf, size_t lBytes, off_t lOffset)
+{
+    char *pcBuf = (char *) pvBuf;
+    ssize_t lRet = 0;
+
+    while (lBytes > 0)
+    {
+        lRet = pread(iFd, pcBuf, lBytes, lOffset);
+        if (lRet <= 0)
+        {
+            if ((lRet < 0) && (EINTR == errno))
+            {
+                continue;
+            }
+            (void) fprintf(stderr,
+                           "ERROR: Reading scratch file failed! %s.\n",
+                           (0 == lRet) ? "Unexpected end of file"
+                                       : strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+        pcBuf += lRet;
+        lBytes -= (size_t) lRet;
+        lOffset += lRet;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Write to a file at the given offset, retrying short writes
+ */
+static int WriteBlock(int iFd, const void *pvBuf, size_t lBytes,
+                      off_t lOffset)
+{
+    const char *pcBuf = (const char *) pvBuf;
+    ssize_t lRet = 0;
+
+    while (lBytes > 0)
+    {
+        lRet = pwrite(iFd, pcBuf, lBytes, lOffset);
+        if (lRet < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            (void) fprintf(stderr,
+                           "ERROR: Writing scratch file failed! %s.\n",
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+        pcBuf += lRet;
+        lBytes -= (size_t) lRet;
+        lOffset += lRet;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
@@ -0,0 +1,85 @@
+/**
+ * @file yapp_oocfft.h
+ * Header file for the out-of-core FFT routines, used to transform time series
+ *  that are too long to be transformed in memory
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_OOCFFT_H__
+#define __YAPP_OOCFFT_H__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <fftw3.h>
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_OOCFFT_MEMSIZE      256     /**< @brief Default memory used by an
+                                             out-of-core FFT, in MB */
+/* @} */
+
+/* scratch file name template - scratch files are created in the current
+   directory, as it is where the output goes, and /tmp may be in memory */
+#define YAPP_OOCFFT_SCRATCH     "yapp_oocfft.XXXXXX"
+/* number of twiddle factors computed by recurrence before being computed
+   exactly again, to bound the accumulated rounding error */
+#define YAPP_OOCFFT_TWID_RESEED 256
+
+#define YAPP_MB2BYTE_FACTOR     (1024 * 1024)
+
+/**
+ * Create a scratch file for an out-of-core FFT - the file is unlinked
+ * immediately, so that it is removed when closed, even on abnormal
+ * termination
+ */
+int YAPP_OOCFFT_OpenScratch(void);
+
+/**
+ * Returns the largest even FFT length not greater than the given length,
+ * whose half splits into two factors of similar size, so that both passes of
+ * the out-of-core FFT are short transforms
+ *
+ * @param[in]       lLen            Length of the time series
+ */
+long YAPP_OOCFFT_GoodLength(long lLen);
+
+/**
+ * Out-of-core real-to-complex FFT of a time series read from a stream, using
+ * the four-step algorithm on a half-length complex transform - the result,
+ * (lLen / 2) + 1 complex values, is written to the start of a file, unscaled,
+ * as by fftwf_plan_dft_r2c_1d()
+ *
+ * @param[in]       pFIn            Input stream, positioned at the first
+ *                                  sample
+ * @param[in]       fSampSize       Sample size, in bytes
+ * @param[in]       lNumSamps       Number of samples to read - the rest of
+ *                                  the transform is zero-padded
+ * @param[in]       lLen            FFT length, even
+ * @param[in]       iFd             Output file descriptor
+ * @param[in]       lMemSize        Memory to use, in bytes
+ */
+int YAPP_OOCFFT_R2C(FILE *pFIn,
+                    float fSampSize,
+                    long lNumSamps,
+                    long lLen,
+                    int iFd,
+                    size_t lMemSize);
+
+/**
+ * Out-of-core complex-to-real FFT, in place - the file holds (lLen / 2) + 1
+ * complex values on input, and lLen real values on output, unscaled, as by
+ * fftwf_plan_dft_c2r_1d()
+ *
+ * @param[in]       iFd             File descriptor
+ * @param[in]       lLen            FFT length, even
+ * @param[in]       lMemSize        Memory to use, in bytes
+ */
+int YAPP_OOCFFT_C2R(int iFd, long lLen, size_t lMemSize);
+
+#endif  /* __YAPP_OOCFFT_H__ */
+
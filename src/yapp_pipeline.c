@@ -0,0 +1,1323 @@
+/*
+ * @file yapp_pipeline.c
+ * Program to dedisperse filterbank data at a set of DMs, optionally subtract a
+ *  smoothed baseline, and search the time series for single pulses, in one
+ *  process. The stages run concurrently, one thread each, and pass blocks to
+ *  each other in memory, so that the only files written are the candidate
+ *  files, and the time series of any stage that is tapped.
+ *
+ * @verbatim
+ * Usage: yapp_pipeline [options] <data-file>
+ *     -h  --help                           Display this usage information
+ *     -n  --nsamp <samples>                Number of samples read in one block
+ *                                          (default is 4096 samples)
+ *     -d  --dm <dm>[,<dm>...]              DMs at which to de-disperse,
+ *                                          separated by commas
+ *     -a  --smooth <width>                 Subtract a copy of the dedispersed
+ *                                          data smoothed with a boxcar of
+ *                                          this width in ms, as yapp_smooth
+ *                                          and yapp_subtract do
+ *                                          (default is no baseline
+ *                                          subtraction)
+ *     -t  --threshold <sigmas>             Threshold in sigmas
+ *     -w  --maxwidth <samples>             Maximum boxcar width, rounded down
+ *                                          to a power of 2
+ *                                          (default is 1 sample)
+ *     -k  --ttol <samples>                 Time linking length for clustering
+ *                                          (default is 8 samples)
+ *     -l  --dmtol <trials>                 DM linking length for clustering
+ *                                          (default is 1 DM trial)
+ *     -m  --statwin <blocks>               Length of the window over which the
+ *                                          median and median absolute
+ *                                          deviation are computed, for
+ *                                          normalisation
+ *                                          (default is 8 blocks)
+ *     -b  --nblocks <blocks>               Number of blocks queued between two
+ *                                          stages
+ *                                          (default is 4 blocks)
+ *     -o  --tap <stage>                    Also write the time series output
+ *                                          by this stage - 'dedisp' or
+ *                                          'baseline'
+ *                                          (default is no intermediate
+ *                                          output)
+ *     -y  --pol <pol>                      Polarization to read from
+ *                                          PSRFITS data - 'X', 'Y', or
+ *                                          'sum' (default is 'sum')
+ *     -v  --version                        Display the version @endverbatim
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_psrfits.h"   /* for PSRFITS file format support */
+#include "yapp_shm.h"      /* for shared-memory ring buffer input */
+#include "yapp_pipeline.h"
+
+/**
+ * The build version string, maintained in the file version.c, which is
+ * generated by makever.c.
+ */
+extern const char *g_pcVersion;
+
+/* data file */
+extern FILE *g_pFData;
+
+/* the following are global only to enable cleaning up in case of abnormal
+   termination, such as those triggered by SIGINT or SIGTERM */
+YAPP_PL_DEDISP g_stDedisp = {0};
+YAPP_PL_BASELINE g_stBaseline = {0};
+YAPP_PL_TAP g_stTap = {0};
+YAPP_PL_SIFT g_stSift = {{0}};
+
+static int WriteCands(YAPP_PL_SIFT *pstSift, int iNumDone);
+static void CleanUp(void);
+
+int main(int argc, char *argv[])
+{
+    char *pcFileSpec = NULL;
+    char *pcFilename = NULL;
+    int iFormat = DEF_FORMAT;
+    YUM_t stYUM = {{0}};
+    YUM_t stYUMOut = {{0}};
+    YAPP_LIB_META stMeta = {{0}};
+    YAPP_LIB_PIPE stPipe = {{{0}}};
+    YAPP_PL_SOURCE stSource = {0};
+    YAPP_SP_JOB *pstJob = &g_stSift.stJob;
+    YAPP_SP_WORKER *pstWorker = &g_stSift.stWorker;
+    YAPP_SP_CLUSTERER *pstClr = &g_stSift.stClr;
+    YAPP_SP_FILEHEADER stFileHeader = {{0}};
+    int iBlockSize = DEF_SIZE_BLOCK;
+    double dTSampInSec = 0.0;   /* holds sampling time in s */
+    double dTStartLag = 0.0;    /* in days */
+    float afDM[YAPP_PL_MAXDMS] = {0};
+    double adTStart[YAPP_PL_MAXDMS] = {0};
+    int iNumDMs = 0;
+    char *pcDMs = NULL;
+    char *pcToken = NULL;
+    float fWidth = 0.0;         /* in ms */
+    float fThreshold = 0.0;
+    int iMaxWidth = DEF_SP_MAXWIDTH;
+    int iNumWidths = 0;
+    int iNumSlots = DEF_PL_NUMSLOTS;
+    int iTap = YAPP_PL_TAP_NONE;
+    int iPol = YAPP_PF_POL_SUM;
+    int iMaxOffset = 0;
+    int iStartOffset = 0;
+    char acFileOut[LEN_GENSTRING] = {0};
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+    const char *pcProgName = NULL;
+    int iNextOpt = 0;
+    /* valid short options */
+    const char* const pcOptsShort = "hn:d:a:t:w:k:l:m:b:o:y:v";
+    /* valid long options */
+    const struct option stOptsLong[] = {
+        { "help",                   0, NULL, 'h' },
+        { "nsamp",                  1, NULL, 'n' },
+        { "dm",                     1, NULL, 'd' },
+        { "smooth",                 1, NULL, 'a' },
+        { "threshold",              1, NULL, 't' },
+        { "maxwidth",               1, NULL, 'w' },
+        { "ttol",                   1, NULL, 'k' },
+        { "dmtol",                  1, NULL, 'l' },
+        { "statwin",                1, NULL, 'm' },
+        { "nblocks",                1, NULL, 'b' },
+        { "tap",                    1, NULL, 'o' },
+        { "pol",                    1, NULL, 'y' },
+        { "version",                0, NULL, 'v' },
+        { NULL,                     0, NULL, 0   }
+    };
+
+    pstJob->iStatWin = DEF_SP_STATWIN;
+    pstClr->lTTol = DEF_SP_TTOL;
+    pstClr->iDMTol = DEF_SP_DMTOL;
+
+    /* get the filename of the program from the argument list */
+    pcProgName = argv[0];
+
+    /* parse the input */
+    do
+    {
+        iNextOpt = getopt_long(argc, argv, pcOptsShort, stOptsLong, NULL);
+        switch (iNextOpt)
+        {
+            case 'h':   /* -h or --help */
+                /* print usage info and terminate */
+                PrintUsage(pcProgName);
+                return YAPP_RET_SUCCESS;
+
+            case 'n':   /* -n or --nsamp */
+                /* set option */
+                iBlockSize = atoi(optarg);
+                /* validate */
+                if (iBlockSize < 2)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of samples must be > 1!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'd':   /* -d or --dm */
+                /* set option */
+                pcDMs = optarg;
+                break;
+
+            case 'a':   /* -a or --smooth */
+                /* set option */
+                fWidth = atof(optarg);
+                /* validate */
+                if (fWidth <= 0.0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Boxcar width must be > 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 't':  /* -t or --threshold */
+                fThreshold = atof(optarg);
+                break;
+
+            case 'w':   /* -w or --maxwidth */
+                /* set option */
+                iMaxWidth = atoi(optarg);
+                /* validate */
+                if ((iMaxWidth < 1)
+                    || iMaxWidth >= (1 << YAPP_SP_MAXWIDTHS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Maximum width must be > 0 and "
+                                   "< %d!\n",
+                                   1 << YAPP_SP_MAXWIDTHS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'k':   /* -k or --ttol */
+                /* set option */
+                pstClr->lTTol = atol(optarg);
+                /* validate */
+                if (pstClr->lTTol < 0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Time linking length must be "
+                                   ">= 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'l':   /* -l or --dmtol */
+                /* set option */
+                pstClr->iDMTol = atoi(optarg);
+                /* validate */
+                if (pstClr->iDMTol < 0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: DM linking length must be "
+                                   ">= 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'm':   /* -m or --statwin */
+                /* set option */
+                pstJob->iStatWin = atoi(optarg);
+                /* validate */
+                if (pstJob->iStatWin < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Normalisation window must be "
+                                   "> 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'b':   /* -b or --nblocks */
+                /* set option */
+                iNumSlots = atoi(optarg);
+                /* validate */
+                if (iNumSlots < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of blocks must be > 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'o':   /* -o or --tap */
+                /* set option */
+                if (0 == strcmp(optarg, YAPP_PL_TAPSTR_DEDISP))
+                {
+                    iTap = YAPP_PL_TAP_DEDISP;
+                }
+                else if (0 == strcmp(optarg, YAPP_PL_TAPSTR_BASELINE))
+                {
+                    iTap = YAPP_PL_TAP_BASELINE;
+                }
+                else
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Invalid stage %s!\n",
+                                   optarg);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'y':   /* -y or --pol */
+                /* set option */
+                iPol = YAPP_PF_GetPolFromName(optarg);
+                if (YAPP_RET_ERROR == iPol)
+                {
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'v':   /* -v or --version */
+                /* display the version */
+                (void) printf("%s\n", g_pcVersion);
+                return YAPP_RET_SUCCESS;
+
+            case '?':   /* user specified an invalid option */
+                /* print usage info and terminate with error */
+                (void) fprintf(stderr, "ERROR: Invalid option!\n");
+                PrintUsage(pcProgName);
+                return YAPP_RET_ERROR;
+
+            case -1:    /* done with options */
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+    } while (iNextOpt != -1);
+
+    /* no arguments */
+    if (argc <= optind)
+    {
+        (void) fprintf(stderr, "ERROR: Input file not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    if (NULL == pcDMs)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Required option not given! DM is required.\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* get the DMs - DM trials next to each other in the list are linked when
+       clustering */
+    pcToken = strtok(pcDMs, ",");
+    while (pcToken != NULL)
+    {
+        if (YAPP_PL_MAXDMS == iNumDMs)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Too many DMs! Maximum is %d.\n",
+                           YAPP_PL_MAXDMS);
+            return YAPP_RET_ERROR;
+        }
+        afDM[iNumDMs] = atof(pcToken);
+        ++iNumDMs;
+        pcToken = strtok(NULL, ",");
+    }
+    if (0 == iNumDMs)
+    {
+        (void) fprintf(stderr, "ERROR: No DM given!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    if ((YAPP_PL_TAP_BASELINE == iTap) && (0.0 == fWidth))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Baseline tap requires a boxcar width!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* register the signal-handling function */
+    iRet = YAPP_RegisterSignalHandlers();
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Handler registration failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    /* get the input filename */
+    pcFileSpec = argv[optind];
+
+    /* determine the file type */
+    iFormat = YAPP_GetFileType(pcFileSpec);
+    if (YAPP_RET_ERROR == iFormat)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: File type determination failed!\n");
+        return YAPP_RET_ERROR;
+    }
+    if (!((YAPP_FORMAT_FIL == iFormat)
+          || (YAPP_FORMAT_PSRFITS == iFormat)
+          || (YAPP_FORMAT_SHM == iFormat)))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid file type!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    if (iFormat != YAPP_FORMAT_SHM)
+    {
+        /* read metadata */
+        iRet = YAPP_ReadMetadata(pcFileSpec, iFormat, &stYUM);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading metadata failed for file %s!\n",
+                           pcFileSpec);
+            return YAPP_RET_ERROR;
+        }
+    }
+    if (YAPP_FORMAT_SHM == iFormat)
+    {
+        /* attach to the ring buffer, which is read as a headerless
+           filterbank file as the producer fills it, so that single pulses
+           are found while the data comes in - the metadata comes from the
+           header of the ring */
+        g_pFData = YAPP_SHM_Open(pcFileSpec, YAPP_SHM_DATA_FIL, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Attaching to ring buffer %s failed!\n",
+                           pcFileSpec);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+    else if (YAPP_FORMAT_PSRFITS == iFormat)
+    {
+        /* open the PSRFITS files as a stream of scaled, single-polarization
+           data, which is read as a headerless filterbank file from here on */
+        g_pFData = YAPP_PF_Open(pcFileSpec, iPol, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed!\n",
+                           pcFileSpec);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+    else
+    {
+        g_pFData = fopen(pcFileSpec, "r");
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed! %s.\n",
+                           pcFileSpec,
+                           strerror(errno));
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        (void) fseek(g_pFData, (long) stYUM.iHeaderLen, SEEK_SET);
+    }
+
+    /* convert sampling interval to seconds */
+    dTSampInSec = stYUM.dTSamp / 1e3;
+
+    /* describe the data to the dedispersers as yapp_dedisperse does - the
+       stream is in channel order, as floating-point samples */
+    YAPP_GetLibMeta(&stYUM, &stMeta);
+    stMeta.iNumBits = YAPP_SAMPSIZE_32;
+
+    /* set up the source */
+    stSource.pFData = g_pFData;
+    stSource.fSampSize = stYUM.fSampSize;
+    stSource.iNumChans = stYUM.iNumChans;
+    stSource.iBlockSize = iBlockSize;
+    stSource.iTotNumReads = (int) ceilf(((float) stYUM.iTimeSamps)
+                                        / iBlockSize);
+
+    /* set up the dedispersers */
+    g_stDedisp.iNumDMs = iNumDMs;
+    g_stDedisp.iNumChans = stYUM.iNumChans;
+    g_stDedisp.pstDedisp = (YAPP_LIB_DEDISP *) calloc((size_t) iNumDMs,
+                                                      sizeof(YAPP_LIB_DEDISP));
+    g_stDedisp.piNumHeld = (int *) calloc((size_t) iNumDMs, sizeof(int));
+    if ((NULL == g_stDedisp.pstDedisp) || (NULL == g_stDedisp.piNumHeld))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    for (i = 0; i < iNumDMs; ++i)
+    {
+        iRet = YAPP_LIB_DedispInit(&g_stDedisp.pstDedisp[i],
+                                   &stMeta,
+                                   stYUM.pcIsChanGood,
+                                   afDM[i],
+                                   iBlockSize);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Setting up dedispersion at DM %g "
+                           "failed!\n",
+                           afDM[i]);
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (g_stDedisp.pstDedisp[i].iMaxOffset > iMaxOffset)
+        {
+            iMaxOffset = g_stDedisp.pstDedisp[i].iMaxOffset;
+        }
+
+        /* each time series starts at the highest frequency, so correct its
+           start time to infinite frequency, as yapp_dedisperse does */
+        iStartOffset = YAPP_LIB_CalcStartOffset(&stMeta,
+                                                afDM[i],
+                                                YAPP_LIB_LAW);
+        adTStart[i] = stYUM.dTStart - ((iStartOffset * dTSampInSec) / 86400);
+        if ((0 == i) || (adTStart[i] < g_stSift.dTStartRef))
+        {
+            g_stSift.dTStartRef = adTStart[i];
+        }
+    }
+    if (iMaxOffset >= stYUM.iTimeSamps)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Maximum dispersion delay of %d samples is "
+                       "longer than the data!\n",
+                       iMaxOffset);
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    g_stDedisp.iHoldLen = iBlockSize + iMaxOffset;
+    g_stDedisp.pfHold = (float *) malloc(sizeof(float)
+                                         * iNumDMs
+                                         * g_stDedisp.iHoldLen);
+    if (NULL == g_stDedisp.pfHold)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* set up baseline subtraction */
+    if (fWidth > 0.0)
+    {
+        /* calculate the number of samples in one boxcar window */
+        g_stBaseline.iWidth = (int) round(fWidth / stYUM.dTSamp);
+        /* make the number of samples odd */
+        if (0 == (g_stBaseline.iWidth % 2))
+        {
+            g_stBaseline.iWidth += 1;
+            (void) fprintf(stderr,
+                           "WARNING: Number of samples per window modified to "
+                           "be odd, new boxcar window width is %g ms.\n",
+                           stYUM.dTSamp * g_stBaseline.iWidth);
+        }
+        g_stBaseline.iNumDMs = iNumDMs;
+        g_stBaseline.iWorkLen = g_stBaseline.iWidth - 1 + iBlockSize;
+        g_stBaseline.pfWork = (float *) malloc(sizeof(float)
+                                               * iNumDMs
+                                               * g_stBaseline.iWorkLen);
+        g_stBaseline.pfSmooth = (float *) malloc(sizeof(float)
+                                                 * g_stBaseline.iWorkLen);
+        if ((NULL == g_stBaseline.pfWork) || (NULL == g_stBaseline.pfSmooth))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        (void) printf("Boxcar window width is %d time samples.\n",
+                      g_stBaseline.iWidth);
+    }
+
+    pcFilename = YAPP_GetFilenameFromPath(pcFileSpec);
+
+    /* open the tap files, named as yapp_dedisperse and yapp_subtract name
+       them, and write their headers */
+    if (iTap != YAPP_PL_TAP_NONE)
+    {
+        g_stTap.iNumDMs = iNumDMs;
+        g_stTap.ppFOut = (FILE **) calloc((size_t) iNumDMs, sizeof(FILE *));
+        if (NULL == g_stTap.ppFOut)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        stYUMOut = stYUM;
+        stYUMOut.iNumBits = YAPP_SAMPSIZE_32;
+        stYUMOut.cIsBandFlipped = YAPP_FALSE;
+        if (YAPP_PL_TAP_BASELINE == iTap)
+        {
+            /* the first sample of the output is the centre of the first
+               boxcar */
+            dTStartLag = ((g_stBaseline.iWidth / 2) * dTSampInSec) / 86400;
+        }
+        for (i = 0; i < iNumDMs; ++i)
+        {
+            stYUMOut.dTStart = adTStart[i] + dTStartLag;
+            if (YAPP_PL_TAP_DEDISP == iTap)
+            {
+                (void) snprintf(acFileOut,
+                                LEN_GENSTRING,
+                                "%s.%s%g%s",
+                                pcFilename,
+                                INFIX_DEDISPERSE,
+                                afDM[i],
+                                EXT_TIM);
+            }
+            else
+            {
+                (void) snprintf(acFileOut,
+                                LEN_GENSTRING,
+                                "%s.%s%g.%s%s",
+                                pcFilename,
+                                INFIX_DEDISPERSE,
+                                afDM[i],
+                                INFIX_SUB,
+                                EXT_TIM);
+            }
+            stYUMOut.dDM = afDM[i];
+            iRet = YAPP_WriteMetadata(acFileOut,
+                                      YAPP_FORMAT_DTS_TIM,
+                                      stYUMOut);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Writing metadata failed for file %s!\n",
+                               acFileOut);
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+            g_stTap.ppFOut[i] = fopen(acFileOut, "a");
+            if (NULL == g_stTap.ppFOut[i])
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Opening file %s failed! %s.\n",
+                               acFileOut,
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+    }
+
+    /* set up the search, as yapp_siftpulses does - boxcar widths are powers
+       of 2, up to the maximum width */
+    for (iNumWidths = 1; (1 << iNumWidths) <= iMaxWidth; ++iNumWidths)
+        ;
+    iMaxWidth = 1 << (iNumWidths - 1);
+    pstJob->iBlockSize = iBlockSize;
+    pstJob->iNumWidths = iNumWidths;
+    pstJob->iHistLen = iMaxWidth - 1;
+    pstJob->iRowLen = pstJob->iHistLen + iBlockSize;
+    pstJob->fThreshold = fThreshold;
+    pstJob->pfBuf = (float *) calloc((size_t) iNumDMs * pstJob->iRowLen,
+                                     sizeof(float));
+    pstJob->pfMedRing = (float *) malloc(sizeof(float)
+                                         * iNumDMs
+                                         * pstJob->iStatWin);
+    pstJob->pfMADRing = (float *) malloc(sizeof(float)
+                                         * iNumDMs
+                                         * pstJob->iStatWin);
+    pstWorker->pstJob = pstJob;
+    pstWorker->iNumDMs = iNumDMs;
+    pstWorker->iMaxEvents = DEF_SP_MAXEVENTS;
+    pstWorker->pstEvents = (YAPP_SP_EVENT *) malloc(sizeof(YAPP_SP_EVENT)
+                                                    * pstWorker->iMaxEvents);
+    pstWorker->pdCum = (double *) malloc(sizeof(double)
+                                         * (pstJob->iRowLen + 1));
+    pstWorker->pfSNR = (float *) malloc(sizeof(float) * iBlockSize);
+    pstWorker->pfScratch = (float *) malloc(sizeof(float) * iBlockSize);
+    pstClr->iNumDMs = iNumDMs;
+    pstClr->iNumWidths = iNumWidths;
+    pstClr->iMaxClusters = DEF_SP_MAXCLUSTERS;
+    pstClr->iFree = -1;
+    pstClr->plCellLastSamp = (long *) malloc(sizeof(long)
+                                             * iNumDMs
+                                             * iNumWidths);
+    pstClr->piCellCluster = (int *) malloc(sizeof(int)
+                                           * iNumDMs
+                                           * iNumWidths);
+    pstClr->pstClusters = (YAPP_SP_CLUSTER *) malloc(sizeof(YAPP_SP_CLUSTER)
+                                                     * pstClr->iMaxClusters);
+    g_stSift.pstDone = (YAPP_SP_CLUSTER *) malloc(sizeof(YAPP_SP_CLUSTER)
+                                                  * pstClr->iMaxClusters);
+    if ((NULL == pstJob->pfBuf) || (NULL == pstJob->pfMedRing)
+        || (NULL == pstJob->pfMADRing) || (NULL == pstWorker->pstEvents)
+        || (NULL == pstWorker->pdCum) || (NULL == pstWorker->pfSNR)
+        || (NULL == pstWorker->pfScratch) || (NULL == pstClr->plCellLastSamp)
+        || (NULL == pstClr->piCellCluster) || (NULL == pstClr->pstClusters)
+        || (NULL == g_stSift.pstDone))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    for (i = 0; i < iNumDMs * iNumWidths; ++i)
+    {
+        pstClr->plCellLastSamp[i] = -1;
+    }
+    g_stSift.pfDM = afDM;
+    g_stSift.lLag = g_stBaseline.iWidth / 2;
+    g_stSift.dTSamp = dTSampInSec;
+    g_stSift.pdTStart = adTStart;
+
+    /* open the candidate files */
+    (void) snprintf(acFileOut,
+                    LEN_GENSTRING,
+                    "%s.%s%s",
+                    pcFilename,
+                    INFIX_ALLDM,
+                    EXT_YAPP_SPCAND);
+    g_stSift.pFCandBin = fopen(acFileOut, "w");
+    if (NULL == g_stSift.pFCandBin)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileOut,
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    (void) snprintf(acFileOut,
+                    LEN_GENSTRING,
+                    "%s.%s%s",
+                    pcFilename,
+                    INFIX_ALLDM,
+                    EXT_CSV);
+    g_stSift.pFCandCSV = fopen(acFileOut, "w");
+    if (NULL == g_stSift.pFCandCSV)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileOut,
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* write the file headers */
+    (void) memcpy(stFileHeader.acMagic,
+                  YAPP_SP_MAGIC,
+                  sizeof(stFileHeader.acMagic));
+    stFileHeader.iRecordSize = sizeof(YAPP_SP_CAND);
+    stFileHeader.iNumDMs = iNumDMs;
+    stFileHeader.fThreshold = fThreshold;
+    stFileHeader.dTSamp = dTSampInSec;
+    stFileHeader.dTStart = g_stSift.dTStartRef;
+    stFileHeader.iBeamID = stYUM.iBeamID;
+    stFileHeader.iNumBeams = stYUM.iNumBeams;
+    if (fwrite(&stFileHeader, sizeof(stFileHeader), 1, g_stSift.pFCandBin)
+        != 1)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing candidate file header failed!\n");
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    (void) fprintf(g_stSift.pFCandCSV, "sample,time,dm,snr,width,events\n");
+
+    /* build the pipeline - a block of the dedispersion stage onwards holds
+       one row per DM trial */
+    YAPP_LIB_PipeInit(&stPipe, iNumSlots);
+    (void) YAPP_LIB_PipeAdd(&stPipe,
+                            YAPP_PL_Read,
+                            &stSource,
+                            iBlockSize * stYUM.iNumChans);
+    (void) YAPP_LIB_PipeAdd(&stPipe,
+                            YAPP_PL_Dedisperse,
+                            &g_stDedisp,
+                            iNumDMs * iBlockSize);
+    if (YAPP_PL_TAP_DEDISP == iTap)
+    {
+        (void) YAPP_LIB_PipeAdd(&stPipe,
+                                YAPP_PL_WriteTap,
+                                &g_stTap,
+                                iNumDMs * iBlockSize);
+    }
+    if (g_stBaseline.iWidth > 0)
+    {
+        (void) YAPP_LIB_PipeAdd(&stPipe,
+                                YAPP_PL_SubtractBaseline,
+                                &g_stBaseline,
+                                iNumDMs * iBlockSize);
+    }
+    if (YAPP_PL_TAP_BASELINE == iTap)
+    {
+        (void) YAPP_LIB_PipeAdd(&stPipe,
+                                YAPP_PL_WriteTap,
+                                &g_stTap,
+                                iNumDMs * iBlockSize);
+    }
+    (void) YAPP_LIB_PipeAdd(&stPipe, YAPP_PL_Sift, &g_stSift, 0);
+
+    (void) printf("Processing %d DM trials in %d stages...\n",
+                  iNumDMs,
+                  stPipe.iNumStages);
+
+    /* run the stages until all data has been searched */
+    iRet = YAPP_LIB_PipeRun(&stPipe);
+    (void) printf("\n");
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Pipeline failed!\n");
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    if (g_stSift.lNumDropped > 0)
+    {
+        (void) fprintf(stderr,
+                       "WARNING: %ld events dropped as the event buffer or "
+                       "cluster table was full! Consider raising the "
+                       "threshold.\n",
+                       g_stSift.lNumDropped);
+    }
+    (void) printf("%ld events detected.\n", g_stSift.lNumEvents);
+    (void) printf("%d candidates written to %s.%s%s and %s.%s%s.\n",
+                  g_stSift.iNumCands,
+                  pcFilename,
+                  INFIX_ALLDM,
+                  EXT_YAPP_SPCAND,
+                  pcFilename,
+                  INFIX_ALLDM,
+                  EXT_CSV);
+
+    (void) printf("DONE!\n");
+
+    CleanUp();
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Source stage - reads a block of filterbank data
+ */
+int YAPP_PL_Read(void *pvCtx,
+                 const float *pfIn,
+                 int iInLen,
+                 float *pfOut,
+                 int *piOutLen)
+{
+    YAPP_PL_SOURCE *pstSource = (YAPP_PL_SOURCE *) pvCtx;
+    int iReadItems = 0;
+
+    /* YAPP_ReadData() is not reentrant, but this is the only thread that
+       reads */
+    iReadItems = YAPP_ReadData(pstSource->pFData,
+                               pfOut,
+                               pstSource->fSampSize,
+                               pstSource->iBlockSize * pstSource->iNumChans);
+    if (YAPP_RET_ERROR == iReadItems)
+    {
+        (void) fprintf(stderr, "ERROR: Reading data failed!\n");
+        return YAPP_RET_ERROR;
+    }
+    /* a partial spectrum at the end of the file is left out */
+    iReadItems -= iReadItems % pstSource->iNumChans;
+    if (0 == iReadItems)
+    {
+        return YAPP_LIB_RET_END;
+    }
+
+    ++pstSource->iReadBlockCount;
+    (void) printf("\rReading data block %d of %d.",
+                  pstSource->iReadBlockCount,
+                  pstSource->iTotNumReads);
+    (void) fflush(stdout);
+
+    *piOutLen = iReadItems;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Dedispersion stage
+ */
+int YAPP_PL_Dedisperse(void *pvCtx,
+                       const float *pfIn,
+                       int iInLen,
+                       float *pfOut,
+                       int *piOutLen)
+{
+    YAPP_PL_DEDISP *pstDedisp = (YAPP_PL_DEDISP *) pvCtx;
+    float *pfHold = NULL;
+    int iNumOut = 0;
+    int iMinHeld = INT_MAX;
+    int i = 0;
+
+    /* the end of the data cannot be dedispersed, so nothing is kept back */
+    if (NULL == pfIn)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    for (i = 0; i < pstDedisp->iNumDMs; ++i)
+    {
+        pfHold = pstDedisp->pfHold + (size_t) i * pstDedisp->iHoldLen;
+        iNumOut = YAPP_LIB_Dedisperse(&pstDedisp->pstDedisp[i],
+                                      pfIn,
+                                      iInLen / pstDedisp->iNumChans,
+                                      pfHold + pstDedisp->piNumHeld[i]);
+        if (YAPP_RET_ERROR == iNumOut)
+        {
+            (void) fprintf(stderr, "ERROR: Dedispersion failed!\n");
+            return YAPP_RET_ERROR;
+        }
+        pstDedisp->piNumHeld[i] += iNumOut;
+        if (pstDedisp->piNumHeld[i] < iMinHeld)
+        {
+            iMinHeld = pstDedisp->piNumHeld[i];
+        }
+    }
+
+    /* output the samples that all DM trials have, and hold back the rest */
+    for (i = 0; i < pstDedisp->iNumDMs; ++i)
+    {
+        pfHold = pstDedisp->pfHold + (size_t) i * pstDedisp->iHoldLen;
+        (void) memcpy(pfOut + (size_t) i * iMinHeld,
+                      pfHold,
+                      sizeof(float) * iMinHeld);
+        pstDedisp->piNumHeld[i] -= iMinHeld;
+        (void) memmove(pfHold,
+                       pfHold + iMinHeld,
+                       sizeof(float) * pstDedisp->piNumHeld[i]);
+    }
+    *piOutLen = pstDedisp->iNumDMs * iMinHeld;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Baseline subtraction stage
+ */
+int YAPP_PL_SubtractBaseline(void *pvCtx,
+                             const float *pfIn,
+                             int iInLen,
+                             float *pfOut,
+                             int *piOutLen)
+{
+    YAPP_PL_BASELINE *pstBaseline = (YAPP_PL_BASELINE *) pvCtx;
+    int iHalf = pstBaseline->iWidth / 2;
+    int iNumSamps = 0;
+    int iLen = 0;
+    int iNumOut = 0;
+    float *pfRow = NULL;
+    float *pfOutRow = NULL;
+    int i = 0;
+    int j = 0;
+
+    /* as with yapp_smooth, the last half boxcar of the data is not output */
+    if (NULL == pfIn)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    iNumSamps = iInLen / pstBaseline->iNumDMs;
+    iLen = pstBaseline->iNumHist + iNumSamps;
+    iNumOut = iLen - pstBaseline->iWidth + 1;
+    for (i = 0; i < pstBaseline->iNumDMs; ++i)
+    {
+        pfRow = pstBaseline->pfWork + (size_t) i * pstBaseline->iWorkLen;
+        (void) memcpy(pfRow + pstBaseline->iNumHist,
+                      pfIn + (size_t) i * iNumSamps,
+                      sizeof(float) * iNumSamps);
+        if (iNumOut <= 0)
+        {
+            continue;
+        }
+
+        /* subtract the mean of the boxcar centred on each sample */
+        (void) YAPP_LIB_Smooth(pfRow,
+                               iLen,
+                               pstBaseline->iWidth,
+                               pstBaseline->pfSmooth);
+        pfOutRow = pfOut + (size_t) i * iNumOut;
+        for (j = 0; j < iNumOut; ++j)
+        {
+            pfOutRow[j] = pfRow[j+iHalf] - pstBaseline->pfSmooth[j];
+        }
+
+        /* keep the samples that the next boxcars need */
+        (void) memmove(pfRow,
+                       pfRow + iNumOut,
+                       sizeof(float) * (pstBaseline->iWidth - 1));
+    }
+
+    if (iNumOut > 0)
+    {
+        pstBaseline->iNumHist = pstBaseline->iWidth - 1;
+        *piOutLen = pstBaseline->iNumDMs * iNumOut;
+    }
+    else
+    {
+        pstBaseline->iNumHist = iLen;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Tap stage
+ */
+int YAPP_PL_WriteTap(void *pvCtx,
+                     const float *pfIn,
+                     int iInLen,
+                     float *pfOut,
+                     int *piOutLen)
+{
+    YAPP_PL_TAP *pstTap = (YAPP_PL_TAP *) pvCtx;
+    int iNumSamps = 0;
+    int i = 0;
+
+    if (NULL == pfIn)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    iNumSamps = iInLen / pstTap->iNumDMs;
+    for (i = 0; i < pstTap->iNumDMs; ++i)
+    {
+        if (fwrite(pfIn + (size_t) i * iNumSamps,
+                   sizeof(float),
+                   iNumSamps,
+                   pstTap->ppFOut[i]) != (size_t) iNumSamps)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Writing data failed! %s.\n",
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    (void) memcpy(pfOut, pfIn, sizeof(float) * iInLen);
+    *piOutLen = iInLen;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Single-pulse search stage
+ */
+int YAPP_PL_Sift(void *pvCtx,
+                 const float *pfIn,
+                 int iInLen,
+                 float *pfOut,
+                 int *piOutLen)
+{
+    YAPP_PL_SIFT *pstSift = (YAPP_PL_SIFT *) pvCtx;
+    YAPP_SP_JOB *pstJob = &pstSift->stJob;
+    YAPP_SP_WORKER *pstWorker = &pstSift->stWorker;
+    YAPP_SP_CLUSTERER *pstClr = &pstSift->stClr;
+    int iNumDMs = pstWorker->iNumDMs;
+    int iNumSamps = 0;
+    int iNumDone = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    if (pfIn != NULL)
+    {
+        iNumSamps = iInLen / iNumDMs;
+        pstJob->iStatIdx = pstSift->iBlockCount % pstJob->iStatWin;
+        if (pstJob->iNumStats < pstJob->iStatWin)
+        {
+            ++pstJob->iNumStats;
+        }
+        ++pstSift->iBlockCount;
+
+        /* search each DM trial, after the samples kept from the previous
+           block */
+        pstWorker->iNumEvents = 0;
+        for (i = 0; i < iNumDMs; ++i)
+        {
+            (void) memcpy(pstJob->pfBuf
+                          + (size_t) i * pstJob->iRowLen
+                          + pstJob->iHistLen,
+                          pfIn + (size_t) i * iNumSamps,
+                          sizeof(float) * iNumSamps);
+            YAPP_SP_SearchRow(pstWorker, i, iNumSamps);
+        }
+        pstSift->lNumEvents += pstWorker->iNumEvents;
+        pstSift->lNumDropped += pstWorker->lNumDropped;
+        pstWorker->lNumDropped = 0;
+
+        /* cluster the events in time order */
+        qsort(pstWorker->pstEvents,
+              pstWorker->iNumEvents,
+              sizeof(YAPP_SP_EVENT),
+              YAPP_SP_CompareEvents);
+        for (i = 0; i < pstWorker->iNumEvents; ++i)
+        {
+            iRet = YAPP_SP_AddEvent(pstClr, &pstWorker->pstEvents[i]);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                /* the cluster table is full - write out the clusters that
+                   can no longer grow, and try again */
+                iNumDone = YAPP_SP_FinishClusters(
+                                            pstClr,
+                                            pstWorker->pstEvents[i].lSamp,
+                                            pstSift->pstDone,
+                                            pstClr->iMaxClusters);
+                iRet = WriteCands(pstSift, iNumDone);
+                if (iRet != YAPP_RET_SUCCESS)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Writing candidates failed!\n");
+                    return YAPP_RET_ERROR;
+                }
+                iRet = YAPP_SP_AddEvent(pstClr, &pstWorker->pstEvents[i]);
+                if (iRet != YAPP_RET_SUCCESS)
+                {
+                    ++pstSift->lNumDropped;
+                }
+            }
+        }
+        pstJob->lBlockStart += iNumSamps;
+    }
+
+    /* write out the clusters that events in the following blocks cannot
+       join, or all clusters at the end of the data */
+    iNumDone = YAPP_SP_FinishClusters(pstClr,
+                                      (pfIn != NULL)
+                                      ? pstJob->lBlockStart
+                                      : LONG_MAX,
+                                      pstSift->pstDone,
+                                      pstClr->iMaxClusters);
+    iRet = WriteCands(pstSift, iNumDone);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Writing candidates failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Write finished clusters to the candidate files, in the format of
+ * yapp_siftpulses, with the samples counted from the start of the time series
+ * of their DM trial, and the times from the earliest start time of all DM
+ * trials
+ */
+static int WriteCands(YAPP_PL_SIFT *pstSift, int iNumDone)
+{
+    YAPP_SP_CLUSTER *pstDone = pstSift->pstDone;
+    YAPP_SP_CAND stCand = {0};
+    int i = 0;
+
+    qsort(pstDone, iNumDone, sizeof(YAPP_SP_CLUSTER), YAPP_SP_ComparePeaks);
+    for (i = 0; i < iNumDone; ++i)
+    {
+        stCand.iWidth = 1 << pstDone[i].stPeak.iWidth;
+        stCand.lSamp = pstDone[i].stPeak.lSamp - stCand.iWidth + 1
+                       + pstSift->lLag;
+        stCand.dTime = ((stCand.lSamp + (stCand.iWidth - 1) / 2.0)
+                        * pstSift->dTSamp)
+                       + ((pstSift->pdTStart[pstDone[i].stPeak.iDM]
+                           - pstSift->dTStartRef) * 86400);
+        stCand.fDM = pstSift->pfDM[pstDone[i].stPeak.iDM];
+        stCand.fSNR = pstDone[i].stPeak.fSNR;
+        stCand.iNumEvents = pstDone[i].iNumEvents;
+
+        if (fwrite(&stCand, sizeof(stCand), 1, pstSift->pFCandBin) != 1)
+        {
+            return YAPP_RET_ERROR;
+        }
+        (void) fprintf(pstSift->pFCandCSV,
+                       "%ld,%.9f,%g,%g,%d,%d\n",
+                       (long) stCand.lSamp,
+                       stCand.dTime,
+                       stCand.fDM,
+                       stCand.fSNR,
+                       stCand.iWidth,
+                       stCand.iNumEvents);
+    }
+    pstSift->iNumCands += iNumDone;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Cleans up all allocated memory and open files
+ */
+static void CleanUp()
+{
+    YAPP_SP_JOB *pstJob = &g_stSift.stJob;
+    YAPP_SP_WORKER *pstWorker = &g_stSift.stWorker;
+    YAPP_SP_CLUSTERER *pstClr = &g_stSift.stClr;
+    int i = 0;
+
+    if (g_stDedisp.pstDedisp != NULL)
+    {
+        for (i = 0; i < g_stDedisp.iNumDMs; ++i)
+        {
+            (void) YAPP_LIB_DedispClose(&g_stDedisp.pstDedisp[i]);
+        }
+    }
+    free(g_stDedisp.pstDedisp);
+    free(g_stDedisp.pfHold);
+    free(g_stDedisp.piNumHeld);
+    (void) memset(&g_stDedisp, '\0', sizeof(g_stDedisp));
+
+    free(g_stBaseline.pfWork);
+    free(g_stBaseline.pfSmooth);
+    (void) memset(&g_stBaseline, '\0', sizeof(g_stBaseline));
+
+    if (g_stTap.ppFOut != NULL)
+    {
+        for (i = 0; i < g_stTap.iNumDMs; ++i)
+        {
+            if (g_stTap.ppFOut[i] != NULL)
+            {
+                (void) fclose(g_stTap.ppFOut[i]);
+            }
+        }
+    }
+    free(g_stTap.ppFOut);
+    (void) memset(&g_stTap, '\0', sizeof(g_stTap));
+
+    free(pstJob->pfBuf);
+    free(pstJob->pfMedRing);
+    free(pstJob->pfMADRing);
+    free(pstWorker->pstEvents);
+    free(pstWorker->pdCum);
+    free(pstWorker->pfSNR);
+    free(pstWorker->pfScratch);
+    free(pstClr->plCellLastSamp);
+    free(pstClr->piCellCluster);
+    free(pstClr->pstClusters);
+    free(g_stSift.pstDone);
+    if (g_stSift.pFCandBin != NULL)
+    {
+        (void) fclose(g_stSift.pFCandBin);
+    }
+    if (g_stSift.pFCandCSV != NULL)
+    {
+        (void) fclose(g_stSift.pFCandCSV);
+    }
+    (void) memset(&g_stSift, '\0', sizeof(g_stSift));
+
+    YAPP_CleanUp();
+
+    return;
+}
+
+
+/*
+ * Prints usage information
+ */
+void PrintUsage(const char *pcProgName)
+{
+    (void) printf("Usage: %s [options] <data-file>\n",
+                  pcProgName);
+    (void) printf("    -h  --help                          ");
+    (void) printf("Display this usage information\n");
+    (void) printf("    -n  --nsamp <samples>               ");
+    (void) printf("Number of samples read in one block\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 4096 samples)\n");
+    (void) printf("    -d  --dm <dm>[,<dm>...]             ");
+    (void) printf("DMs at which to de-disperse,\n");
+    (void) printf("                                        ");
+    (void) printf("separated by commas\n");
+    (void) printf("    -a  --smooth <width>                ");
+    (void) printf("Subtract a copy of the dedispersed\n");
+    (void) printf("                                        ");
+    (void) printf("data smoothed with a boxcar of\n");
+    (void) printf("                                        ");
+    (void) printf("this width in ms, as yapp_smooth\n");
+    (void) printf("                                        ");
+    (void) printf("and yapp_subtract do\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no baseline\n");
+    (void) printf("                                        ");
+    (void) printf("subtraction)\n");
+    (void) printf("    -t  --threshold <sigmas>            ");
+    (void) printf("Threshold in sigmas\n");
+    (void) printf("    -w  --maxwidth <samples>            ");
+    (void) printf("Maximum boxcar width, rounded down\n");
+    (void) printf("                                        ");
+    (void) printf("to a power of 2\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 1 sample)\n");
+    (void) printf("    -k  --ttol <samples>                ");
+    (void) printf("Time linking length for clustering\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 8 samples)\n");
+    (void) printf("    -l  --dmtol <trials>                ");
+    (void) printf("DM linking length for clustering\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 1 DM trial)\n");
+    (void) printf("    -m  --statwin <blocks>              ");
+    (void) printf("Length of the window over which the\n");
+    (void) printf("                                        ");
+    (void) printf("median and median absolute\n");
+    (void) printf("                                        ");
+    (void) printf("deviation are computed, for\n");
+    (void) printf("                                        ");
+    (void) printf("normalisation\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 8 blocks)\n");
+    (void) printf("    -b  --nblocks <blocks>              ");
+    (void) printf("Number of blocks queued between two\n");
+    (void) printf("                                        ");
+    (void) printf("stages\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 4 blocks)\n");
+    (void) printf("    -o  --tap <stage>                   ");
+    (void) printf("Also write the time series output\n");
+    (void) printf("                                        ");
+    (void) printf("by this stage - 'dedisp' or\n");
+    (void) printf("                                        ");
+    (void) printf("'baseline'\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no intermediate\n");
+    (void) printf("                                        ");
+    (void) printf("output)\n");
+    (void) printf("    -y  --pol <pol>                     ");
+    (void) printf("Polarization to read from\n");
+    (void) printf("                                        ");
+    (void) printf("PSRFITS data - 'X', 'Y', or\n");
+    (void) printf("                                        ");
+    (void) printf("'sum' (default is 'sum')\n");
+    (void) printf("    -v  --version                       ");
+    (void) printf("Display the version\n");
+
+    return;
+}
+
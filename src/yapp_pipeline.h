@@ -0,0 +1,146 @@
+/**
+ * @file yapp_pipeline.h
+ * Header file for yapp_pipeline
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_PIPELINE_H__
+#define __YAPP_PIPELINE_H__
+
+#include "yapp_lib.h"
+#include "yapp_siftpulses.h"
+
+#define YAPP_PL_MAXDMS          4096    /* maximum number of DM trials */
+
+#define YAPP_PL_TAP_NONE        0       /* no intermediate output */
+#define YAPP_PL_TAP_DEDISP      1       /* write the dedispersed time
+                                           series */
+#define YAPP_PL_TAP_BASELINE    2       /* write the time series after
+                                           baseline subtraction */
+
+#define YAPP_PL_TAPSTR_DEDISP   "dedisp"
+#define YAPP_PL_TAPSTR_BASELINE "baseline"
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_PL_NUMSLOTS         4       /**< @brief Default number of blocks
+                                             queued between two stages */
+/* @} */
+
+/**
+ * Source stage - reads blocks of filterbank data
+ */
+typedef struct tagPLSource
+{
+    FILE *pFData;
+    float fSampSize;        /* sample size, in bytes */
+    int iNumChans;
+    int iBlockSize;
+    int iTotNumReads;
+    int iReadBlockCount;
+} YAPP_PL_SOURCE;
+
+/**
+ * Dedispersion stage - outputs one row per DM trial. As the dedispersers of
+ * different DM trials lag the input by different amounts, the samples that
+ * the dedisperser with the largest lag has not yet output are held back, so
+ * that the rows of a block are aligned in time.
+ */
+typedef struct tagPLDedisp
+{
+    int iNumDMs;
+    int iNumChans;
+    YAPP_LIB_DEDISP *pstDedisp; /* one per DM trial */
+    float *pfHold;          /* samples held back, iNumDMs x iHoldLen */
+    int iHoldLen;
+    int *piNumHeld;         /* number of samples held back, per DM trial */
+} YAPP_PL_DEDISP;
+
+/**
+ * Baseline subtraction stage - subtracts from each row a copy smoothed with
+ * a boxcar, as yapp_smooth and yapp_subtract do, so that the output lags the
+ * input by half the width of the boxcar
+ */
+typedef struct tagPLBaseline
+{
+    int iNumDMs;
+    int iWidth;             /* width of the boxcar, odd, in samples */
+    int iNumHist;           /* number of samples kept from the previous
+                               block, iWidth - 1 once enough have come in */
+    float *pfWork;          /* kept samples followed by the new block, one
+                               row per DM trial, iWorkLen long */
+    int iWorkLen;
+    float *pfSmooth;        /* smoothed row */
+} YAPP_PL_BASELINE;
+
+/**
+ * Tap stage - writes its input to one time series file per DM trial, and
+ * passes it on unchanged
+ */
+typedef struct tagPLTap
+{
+    int iNumDMs;
+    FILE **ppFOut;
+} YAPP_PL_TAP;
+
+/**
+ * Single-pulse search stage - searches each block as yapp_siftpulses does,
+ * and writes the candidates
+ */
+typedef struct tagPLSift
+{
+    YAPP_SP_JOB stJob;
+    YAPP_SP_WORKER stWorker;
+    YAPP_SP_CLUSTERER stClr;
+    YAPP_SP_CLUSTER *pstDone;   /* finished clusters */
+    float *pfDM;
+    long lLag;              /* number of input samples that the first
+                               sample searched lags the first sample read */
+    double dTSamp;          /* in s */
+    double *pdTStart;       /* start time of each DM trial, corrected for
+                               its dispersion delay, in MJD */
+    double dTStartRef;      /* earliest of them, that candidate times are
+                               counted from */
+    FILE *pFCandBin;
+    FILE *pFCandCSV;
+    int iBlockCount;
+    long lNumEvents;
+    long lNumDropped;
+    int iNumCands;
+} YAPP_PL_SIFT;
+
+/**
+ * Stage functions, of type YAPP_LIB_STAGEFUNC
+ */
+int YAPP_PL_Read(void *pvCtx,
+                 const float *pfIn,
+                 int iInLen,
+                 float *pfOut,
+                 int *piOutLen);
+int YAPP_PL_Dedisperse(void *pvCtx,
+                       const float *pfIn,
+                       int iInLen,
+                       float *pfOut,
+                       int *piOutLen);
+int YAPP_PL_SubtractBaseline(void *pvCtx,
+                             const float *pfIn,
+                             int iInLen,
+                             float *pfOut,
+                             int *piOutLen);
+int YAPP_PL_WriteTap(void *pvCtx,
+                     const float *pfIn,
+                     int iInLen,
+                     float *pfOut,
+                     int *piOutLen);
+int YAPP_PL_Sift(void *pvCtx,
+                 const float *pfIn,
+                 int iInLen,
+                 float *pfOut,
+                 int *piOutLen);
+
+#endif  /* __YAPP_PIPELINE_H__ */
+
@@ -0,0 +1,634 @@
+/*
+ * @file yapp_png.c
+ * PNG plotting routines. Plots are rendered into an RGB raster, laid out as
+ *  the PGPLOT plots are, using the same colour maps, and written as PNG files
+ *  compressed with zlib. No graphics device is needed, so plots can be
+ *  generated on machines without X, and rendering and compression, which
+ *  take most of the time, are done on a pool of threads, so that many plots
+ *  are generated in parallel. Text cannot be drawn without a font, so the
+ *  title, the axis labels and the ranges of the axes are recorded in text
+ *  chunks of the file instead.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "colourmap.h"
+#include "yapp_png.h"
+#include <zlib.h>
+
+#define YAPP_PNG_BYTESPERPIXEL  3
+
+static void RenderImage(YAPP_PNG_PLOT *pstPlot, unsigned char *pcPixels);
+static void RenderLines(YAPP_PNG_PLOT *pstPlot, unsigned char *pcPixels);
+static void DrawLine(unsigned char *pcPixels,
+                     int iX0,
+                     int iY0,
+                     int iX1,
+                     int iY1,
+                     const unsigned char *pcColour);
+static void DrawFrame(unsigned char *pcPixels,
+                      int iLeft,
+                      int iTop,
+                      int iRight,
+                      int iBottom,
+                      const unsigned char *pcColour);
+static int WritePNG(YAPP_PNG_PLOT *pstPlot, unsigned char *pcPixels);
+static int WriteChunk(FILE *pFPNG,
+                      const char *pcType,
+                      const unsigned char *pcData,
+                      unsigned int iLen);
+static void* RenderPlots(void *pvPool);
+
+/* colour of lines, that of PGPLOT colour index PG_CI_PLOT */
+static const unsigned char g_acLineColour[YAPP_PNG_BYTESPERPIXEL]
+    = { 0, 128, 255 };
+
+/*
+ * Render a plot and write it to its file
+ */
+int YAPP_PNG_Render(YAPP_PNG_PLOT *pstPlot)
+{
+    unsigned char *pcPixels = NULL;
+    unsigned char cBackground = (pstPlot->iInvCols ? 255 : 0);
+    int iRet = YAPP_RET_SUCCESS;
+
+    pcPixels = (unsigned char *) malloc((size_t) YAPP_PNG_WIDTH
+                                        * YAPP_PNG_HEIGHT
+                                        * YAPP_PNG_BYTESPERPIXEL);
+    if (NULL == pcPixels)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    (void) memset(pcPixels,
+                  cBackground,
+                  (size_t) YAPP_PNG_WIDTH
+                  * YAPP_PNG_HEIGHT
+                  * YAPP_PNG_BYTESPERPIXEL);
+
+    if (YAPP_PNG_TYPE_IMAGE == pstPlot->iType)
+    {
+        RenderImage(pstPlot, pcPixels);
+    }
+    else
+    {
+        RenderLines(pstPlot, pcPixels);
+    }
+
+    iRet = WritePNG(pstPlot, pcPixels);
+    free(pcPixels);
+
+    return iRet;
+}
+
+
+/*
+ * Start a pool of rendering threads
+ */
+int YAPP_PNG_Start(YAPP_PNG_POOL *pstPool, int iNumThreads)
+{
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    (void) memset(pstPool, '\0', sizeof(YAPP_PNG_POOL));
+    pstPool->iRet = YAPP_RET_SUCCESS;
+    pstPool->iQueueLen = iNumThreads * YAPP_PNG_PLOTSPERTHREAD;
+    pstPool->pstQueue = (YAPP_PNG_PLOT *) malloc((size_t) pstPool->iQueueLen
+                                                 * sizeof(YAPP_PNG_PLOT));
+    pstPool->pstThreads = (pthread_t *) malloc((size_t) iNumThreads
+                                               * sizeof(pthread_t));
+    if ((NULL == pstPool->pstQueue) || (NULL == pstPool->pstThreads))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        free(pstPool->pstQueue);
+        free(pstPool->pstThreads);
+        return YAPP_RET_ERROR;
+    }
+    (void) pthread_mutex_init(&pstPool->stMutex, NULL);
+    (void) pthread_cond_init(&pstPool->stCond, NULL);
+
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        iRet = pthread_create(&pstPool->pstThreads[i],
+                              NULL,
+                              RenderPlots,
+                              (void *) pstPool);
+        if (iRet != 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Creating rendering thread failed! %s.\n",
+                           strerror(iRet));
+            /* stop the threads that have been started */
+            (void) YAPP_PNG_Stop(pstPool);
+            return YAPP_RET_ERROR;
+        }
+        ++pstPool->iNumThreads;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Queue a plot for rendering
+ */
+int YAPP_PNG_Submit(YAPP_PNG_POOL *pstPool, YAPP_PNG_PLOT *pstPlot)
+{
+    YAPP_PNG_PLOT *pstSlot = NULL;
+    size_t iDataSize = (size_t) pstPlot->iLenX * pstPlot->iLenY * sizeof(float);
+    float *pfData = NULL;
+    int iRet = YAPP_RET_SUCCESS;
+
+    /* the copy is freed by the thread that renders it */
+    pfData = (float *) malloc(iDataSize);
+    if (NULL == pfData)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    (void) memcpy(pfData, pstPlot->pfData, iDataSize);
+
+    (void) pthread_mutex_lock(&pstPool->stMutex);
+    while (pstPool->iCount == pstPool->iQueueLen)
+    {
+        (void) pthread_cond_wait(&pstPool->stCond, &pstPool->stMutex);
+    }
+    pstSlot = &pstPool->pstQueue[(pstPool->iHead + pstPool->iCount)
+                                 % pstPool->iQueueLen];
+    *pstSlot = *pstPlot;
+    pstSlot->pfData = pfData;
+    ++pstPool->iCount;
+    iRet = pstPool->iRet;
+    (void) pthread_cond_broadcast(&pstPool->stCond);
+    (void) pthread_mutex_unlock(&pstPool->stMutex);
+
+    return iRet;
+}
+
+
+/*
+ * Wait for the queued plots to be rendered, and stop the threads
+ */
+int YAPP_PNG_Stop(YAPP_PNG_POOL *pstPool)
+{
+    int i = 0;
+
+    (void) pthread_mutex_lock(&pstPool->stMutex);
+    pstPool->cStop = YAPP_TRUE;
+    (void) pthread_cond_broadcast(&pstPool->stCond);
+    (void) pthread_mutex_unlock(&pstPool->stMutex);
+
+    for (i = 0; i < pstPool->iNumThreads; ++i)
+    {
+        (void) pthread_join(pstPool->pstThreads[i], NULL);
+    }
+    pstPool->iNumThreads = 0;
+
+    (void) pthread_cond_destroy(&pstPool->stCond);
+    (void) pthread_mutex_destroy(&pstPool->stMutex);
+    free(pstPool->pstThreads);
+    pstPool->pstThreads = NULL;
+    free(pstPool->pstQueue);
+    pstPool->pstQueue = NULL;
+
+    return pstPool->iRet;
+}
+
+
+/*
+ * Render an image, with a colour wedge above it
+ */
+static void RenderImage(YAPP_PNG_PLOT *pstPlot, unsigned char *pcPixels)
+{
+    const float (*paafCMap)[3] = g_aaafCMap[pstPlot->iColourMap];
+    unsigned char cForeground = (pstPlot->iInvCols ? 0 : 255);
+    unsigned char acForeground[YAPP_PNG_BYTESPERPIXEL] = {0};
+    int iLeft = (int) (PG_2D_VP_ML * YAPP_PNG_WIDTH);
+    int iRight = (int) (PG_2D_VP_MR * YAPP_PNG_WIDTH);
+    int iTop = (int) ((1.0 - PG_2D_VP_MT) * YAPP_PNG_HEIGHT);
+    int iBottom = (int) ((1.0 - PG_2D_VP_MB) * YAPP_PNG_HEIGHT);
+    int iWedgeLeft = (int) (PG_WEDG_VP_ML * YAPP_PNG_WIDTH);
+    int iWedgeRight = (int) (PG_WEDG_VP_MR * YAPP_PNG_WIDTH);
+    int iWedgeTop = (int) (YAPP_PNG_WEDGE_MT * YAPP_PNG_HEIGHT);
+    int iWedgeBottom = (int) (YAPP_PNG_WEDGE_MB * YAPP_PNG_HEIGHT);
+    int aiCol[YAPP_PNG_WIDTH] = {0};    /* column of the data of each pixel */
+    float fScale = 0.0;
+    float fLevel = 0.0;
+    float *pfRow = NULL;
+    unsigned char *pcPixel = NULL;
+    int iLevel = 0;
+    int iRow = 0;
+    int i = 0;
+    int j = 0;
+
+    (void) memset(acForeground, cForeground, sizeof(acForeground));
+
+    /* map the data range on to the colour map, as cpgimag() does */
+    if (pstPlot->fDataMax > pstPlot->fDataMin)
+    {
+        fScale = (CMAP_LEVELS - 1)
+                 / (pstPlot->fDataMax - pstPlot->fDataMin);
+    }
+
+    for (i = iLeft; i < iRight; ++i)
+    {
+        aiCol[i] = (int) (((long) (i - iLeft) * pstPlot->iLenX)
+                          / (iRight - iLeft));
+    }
+    for (j = iTop; j < iBottom; ++j)
+    {
+        /* the first row of the data is at the bottom */
+        iRow = pstPlot->iLenY - 1
+               - (int) (((long) (j - iTop) * pstPlot->iLenY)
+                        / (iBottom - iTop));
+        pfRow = pstPlot->pfData + ((long) iRow * pstPlot->iLenX);
+        pcPixel = pcPixels + (((long) j * YAPP_PNG_WIDTH) + iLeft)
+                             * YAPP_PNG_BYTESPERPIXEL;
+        for (i = iLeft; i < iRight; ++i)
+        {
+            fLevel = (pfRow[aiCol[i]] - pstPlot->fDataMin) * fScale;
+            if (!(fLevel > 0.0))    /* also catches NaN */
+            {
+                fLevel = 0.0;
+            }
+            else if (fLevel > (CMAP_LEVELS - 1))
+            {
+                fLevel = CMAP_LEVELS - 1;
+            }
+            iLevel = (int) lrintf(fLevel);
+            pcPixel[0] = (unsigned char) lrintf(paafCMap[iLevel][0] * 255);
+            pcPixel[1] = (unsigned char) lrintf(paafCMap[iLevel][1] * 255);
+            pcPixel[2] = (unsigned char) lrintf(paafCMap[iLevel][2] * 255);
+            pcPixel += YAPP_PNG_BYTESPERPIXEL;
+        }
+    }
+    DrawFrame(pcPixels, iLeft, iTop, iRight, iBottom, acForeground);
+
+    /* draw the colour wedge */
+    for (j = iWedgeTop; j < iWedgeBottom; ++j)
+    {
+        pcPixel = pcPixels + (((long) j * YAPP_PNG_WIDTH) + iWedgeLeft)
+                             * YAPP_PNG_BYTESPERPIXEL;
+        for (i = iWedgeLeft; i < iWedgeRight; ++i)
+        {
+            iLevel = ((i - iWedgeLeft) * CMAP_LEVELS)
+                     / (iWedgeRight - iWedgeLeft);
+            pcPixel[0] = (unsigned char) lrintf(paafCMap[iLevel][0] * 255);
+            pcPixel[1] = (unsigned char) lrintf(paafCMap[iLevel][1] * 255);
+            pcPixel[2] = (unsigned char) lrintf(paafCMap[iLevel][2] * 255);
+            pcPixel += YAPP_PNG_BYTESPERPIXEL;
+        }
+    }
+    DrawFrame(pcPixels,
+              iWedgeLeft,
+              iWedgeTop,
+              iWedgeRight,
+              iWedgeBottom,
+              acForeground);
+
+    return;
+}
+
+
+/*
+ * Render lines
+ */
+static void RenderLines(YAPP_PNG_PLOT *pstPlot, unsigned char *pcPixels)
+{
+    unsigned char cForeground = (pstPlot->iInvCols ? 0 : 255);
+    unsigned char acForeground[YAPP_PNG_BYTESPERPIXEL] = {0};
+    int iLeft = (int) (PG_VP_ML * YAPP_PNG_WIDTH);
+    int iRight = (int) (PG_VP_MR * YAPP_PNG_WIDTH);
+    int iTop = (int) ((1.0 - PG_VP_MT) * YAPP_PNG_HEIGHT);
+    int iBottom = (int) ((1.0 - PG_VP_MB) * YAPP_PNG_HEIGHT);
+    float fScale = 0.0;
+    float fY = 0.0;
+    float *pfLine = NULL;
+    int iX = 0;
+    int iY = 0;
+    int iXPrev = 0;
+    int iYPrev = 0;
+    char cHavePrev = YAPP_FALSE;
+    int i = 0;
+    int j = 0;
+
+    (void) memset(acForeground, cForeground, sizeof(acForeground));
+
+    if (pstPlot->fDataMax > pstPlot->fDataMin)
+    {
+        fScale = (iBottom - iTop - 1)
+                 / (pstPlot->fDataMax - pstPlot->fDataMin);
+    }
+
+    for (j = 0; j < pstPlot->iLenY; ++j)
+    {
+        pfLine = pstPlot->pfData + ((long) j * pstPlot->iLenX);
+        cHavePrev = YAPP_FALSE;
+        for (i = 0; i < pstPlot->iLenX; ++i)
+        {
+            /* leave gaps at invalid values */
+            if (!isfinite(pfLine[i]))
+            {
+                cHavePrev = YAPP_FALSE;
+                continue;
+            }
+            iX = iLeft;
+            if (pstPlot->iLenX > 1)
+            {
+                iX += (int) (((long) i * (iRight - iLeft - 1))
+                             / (pstPlot->iLenX - 1));
+            }
+            /* clip to the viewport */
+            fY = (pfLine[i] - pstPlot->fDataMin) * fScale;
+            if (!(fY > 0.0))    /* also catches NaN */
+            {
+                fY = 0.0;
+            }
+            else if (fY > (iBottom - iTop - 1))
+            {
+                fY = iBottom - iTop - 1;
+            }
+            iY = iBottom - 1 - (int) lrintf(fY);
+            if (cHavePrev)
+            {
+                DrawLine(pcPixels, iXPrev, iYPrev, iX, iY, g_acLineColour);
+            }
+            else
+            {
+                DrawLine(pcPixels, iX, iY, iX, iY, g_acLineColour);
+            }
+            iXPrev = iX;
+            iYPrev = iY;
+            cHavePrev = YAPP_TRUE;
+        }
+    }
+    DrawFrame(pcPixels, iLeft, iTop, iRight, iBottom, acForeground);
+
+    return;
+}
+
+
+/*
+ * Draw a line between two pixels, inclusive, using Bresenham's algorithm
+ */
+static void DrawLine(unsigned char *pcPixels,
+                     int iX0,
+                     int iY0,
+                     int iX1,
+                     int iY1,
+                     const unsigned char *pcColour)
+{
+    int iDX = abs(iX1 - iX0);
+    int iDY = -abs(iY1 - iY0);
+    int iStepX = (iX0 < iX1) ? 1 : -1;
+    int iStepY = (iY0 < iY1) ? 1 : -1;
+    int iErr = iDX + iDY;
+    int iErr2 = 0;
+    unsigned char *pcPixel = NULL;
+
+    while (YAPP_TRUE)
+    {
+        pcPixel = pcPixels + (((long) iY0 * YAPP_PNG_WIDTH) + iX0)
+                             * YAPP_PNG_BYTESPERPIXEL;
+        (void) memcpy(pcPixel, pcColour, YAPP_PNG_BYTESPERPIXEL);
+        if ((iX0 == iX1) && (iY0 == iY1))
+        {
+            break;
+        }
+        iErr2 = 2 * iErr;
+        if (iErr2 >= iDY)
+        {
+            iErr += iDY;
+            iX0 += iStepX;
+        }
+        if (iErr2 <= iDX)
+        {
+            iErr += iDX;
+            iY0 += iStepY;
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * Draw a box just outside a rectangle
+ */
+static void DrawFrame(unsigned char *pcPixels,
+                      int iLeft,
+                      int iTop,
+                      int iRight,
+                      int iBottom,
+                      const unsigned char *pcColour)
+{
+    DrawLine(pcPixels, iLeft - 1, iTop - 1, iRight, iTop - 1, pcColour);
+    DrawLine(pcPixels, iLeft - 1, iBottom, iRight, iBottom, pcColour);
+    DrawLine(pcPixels, iLeft - 1, iTop - 1, iLeft - 1, iBottom, pcColour);
+    DrawLine(pcPixels, iRight, iTop - 1, iRight, iBottom, pcColour);
+
+    return;
+}
+
+
+/*
+ * Write a raster to a PNG file, with the description of the plot in text
+ * chunks
+ */
+static int WritePNG(YAPP_PNG_PLOT *pstPlot, unsigned char *pcPixels)
+{
+    static const unsigned char acSignature[] = { 0x89, 'P', 'N', 'G',
+                                                 '\r', '\n', 0x1A, '\n' };
+    unsigned char acHeader[13] = {0};
+    unsigned char acText[2 * LEN_GENSTRING] = {0};
+    size_t iRowLen = 1 + ((size_t) YAPP_PNG_WIDTH * YAPP_PNG_BYTESPERPIXEL);
+    size_t iRawLen = iRowLen * YAPP_PNG_HEIGHT;
+    unsigned char *pcRaw = NULL;
+    unsigned char *pcComp = NULL;
+    uLongf lCompLen = compressBound((uLong) iRawLen);
+    FILE *pFPNG = NULL;
+    int iLen = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    pcRaw = (unsigned char *) malloc(iRawLen);
+    pcComp = (unsigned char *) malloc(lCompLen);
+    if ((NULL == pcRaw) || (NULL == pcComp))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        free(pcRaw);
+        free(pcComp);
+        return YAPP_RET_ERROR;
+    }
+
+    /* each row is preceded by its filter type - none */
+    for (i = 0; i < YAPP_PNG_HEIGHT; ++i)
+    {
+        pcRaw[i * iRowLen] = 0;
+        (void) memcpy(pcRaw + (i * iRowLen) + 1,
+                      pcPixels + ((size_t) i * (iRowLen - 1)),
+                      iRowLen - 1);
+    }
+    /* plots are mostly flat areas, which compress well even at the fastest
+       level */
+    iRet = compress2(pcComp, &lCompLen, pcRaw, (uLong) iRawLen, Z_BEST_SPEED);
+    free(pcRaw);
+    if (iRet != Z_OK)
+    {
+        (void) fprintf(stderr, "ERROR: Compressing plot failed!\n");
+        free(pcComp);
+        return YAPP_RET_ERROR;
+    }
+
+    pFPNG = fopen(pstPlot->acFile, "w");
+    if (NULL == pFPNG)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pstPlot->acFile,
+                       strerror(errno));
+        free(pcComp);
+        return YAPP_RET_ERROR;
+    }
+
+    /* 8-bit RGB, not interlaced */
+    acHeader[0] = (YAPP_PNG_WIDTH >> 24) & 0xFF;
+    acHeader[1] = (YAPP_PNG_WIDTH >> 16) & 0xFF;
+    acHeader[2] = (YAPP_PNG_WIDTH >> 8) & 0xFF;
+    acHeader[3] = YAPP_PNG_WIDTH & 0xFF;
+    acHeader[4] = (YAPP_PNG_HEIGHT >> 24) & 0xFF;
+    acHeader[5] = (YAPP_PNG_HEIGHT >> 16) & 0xFF;
+    acHeader[6] = (YAPP_PNG_HEIGHT >> 8) & 0xFF;
+    acHeader[7] = YAPP_PNG_HEIGHT & 0xFF;
+    acHeader[8] = 8;        /* bit depth */
+    acHeader[9] = 2;        /* colour type - RGB */
+    iRet = (fwrite(acSignature, sizeof(acSignature), 1, pFPNG) != 1);
+    iRet |= WriteChunk(pFPNG, "IHDR", acHeader, sizeof(acHeader));
+
+    /* text chunks are a keyword, a null character, and the text */
+    iLen = snprintf((char *) acText, sizeof(acText), "Title%c%s",
+                    '\0', pstPlot->acTitle);
+    iRet |= WriteChunk(pFPNG, "tEXt", acText, (unsigned int) iLen);
+    iLen = snprintf((char *) acText, sizeof(acText), "X-Axis%c%s: %g to %g",
+                    '\0', pstPlot->acXLabel, pstPlot->fXMin, pstPlot->fXMax);
+    iRet |= WriteChunk(pFPNG, "tEXt", acText, (unsigned int) iLen);
+    iLen = snprintf((char *) acText, sizeof(acText), "Y-Axis%c%s: %g to %g",
+                    '\0', pstPlot->acYLabel, pstPlot->fYMin, pstPlot->fYMax);
+    iRet |= WriteChunk(pFPNG, "tEXt", acText, (unsigned int) iLen);
+    if (YAPP_PNG_TYPE_IMAGE == pstPlot->iType)
+    {
+        iLen = snprintf((char *) acText, sizeof(acText),
+                        "Colour-Range%c%g to %g",
+                        '\0', pstPlot->fDataMin, pstPlot->fDataMax);
+        iRet |= WriteChunk(pFPNG, "tEXt", acText, (unsigned int) iLen);
+    }
+
+    iRet |= WriteChunk(pFPNG, "IDAT", pcComp, (unsigned int) lCompLen);
+    iRet |= WriteChunk(pFPNG, "IEND", NULL, 0);
+    free(pcComp);
+
+    iRet |= (fclose(pFPNG) != 0);
+    if (iRet != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing file %s failed! %s.\n",
+                       pstPlot->acFile,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Write a PNG chunk - length, type, data and CRC of the type and data.
+ * Returns 0 on success, and 1 on failure.
+ */
+static int WriteChunk(FILE *pFPNG,
+                      const char *pcType,
+                      const unsigned char *pcData,
+                      unsigned int iLen)
+{
+    unsigned char acLen[4] = {0};
+    unsigned char acCRC[4] = {0};
+    uLong lCRC = crc32(0L, Z_NULL, 0);
+
+    acLen[0] = (iLen >> 24) & 0xFF;
+    acLen[1] = (iLen >> 16) & 0xFF;
+    acLen[2] = (iLen >> 8) & 0xFF;
+    acLen[3] = iLen & 0xFF;
+    lCRC = crc32(lCRC, (const Bytef *) pcType, 4);
+    if (iLen > 0)
+    {
+        lCRC = crc32(lCRC, pcData, iLen);
+    }
+    acCRC[0] = (lCRC >> 24) & 0xFF;
+    acCRC[1] = (lCRC >> 16) & 0xFF;
+    acCRC[2] = (lCRC >> 8) & 0xFF;
+    acCRC[3] = lCRC & 0xFF;
+
+    if ((fwrite(acLen, sizeof(acLen), 1, pFPNG) != 1)
+        || (fwrite(pcType, 4, 1, pFPNG) != 1)
+        || ((iLen > 0) && (fwrite(pcData, iLen, 1, pFPNG) != 1))
+        || (fwrite(acCRC, sizeof(acCRC), 1, pFPNG) != 1))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Rendering thread - renders queued plots until the pool is stopped and the
+ * queue is empty
+ */
+static void* RenderPlots(void *pvPool)
+{
+    YAPP_PNG_POOL *pstPool = (YAPP_PNG_POOL *) pvPool;
+    YAPP_PNG_PLOT stPlot;
+    int iRet = YAPP_RET_SUCCESS;
+
+    while (YAPP_TRUE)
+    {
+        (void) pthread_mutex_lock(&pstPool->stMutex);
+        while ((0 == pstPool->iCount) && !pstPool->cStop)
+        {
+            (void) pthread_cond_wait(&pstPool->stCond, &pstPool->stMutex);
+        }
+        if (0 == pstPool->iCount)
+        {
+            /* stopped, and nothing left to render */
+            (void) pthread_mutex_unlock(&pstPool->stMutex);
+            break;
+        }
+        stPlot = pstPool->pstQueue[pstPool->iHead];
+        pstPool->iHead = (pstPool->iHead + 1) % pstPool->iQueueLen;
+        --pstPool->iCount;
+        (void) pthread_cond_broadcast(&pstPool->stCond);
+        (void) pthread_mutex_unlock(&pstPool->stMutex);
+
+        iRet = YAPP_PNG_Render(&stPlot);
+        free(stPlot.pfData);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) pthread_mutex_lock(&pstPool->stMutex);
+            pstPool->iRet = YAPP_RET_ERROR;
+            (void) pthread_mutex_unlock(&pstPool->stMutex);
+        }
+    }
+
+    return NULL;
+}
+
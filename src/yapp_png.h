@@ -0,0 +1,111 @@
+/**
+ * @file yapp_png.h
+ * Header file for the PNG plotting routines - a raster backend that renders
+ *  the same waterfalls and profiles as the PGPLOT routines straight to PNG
+ *  files, without a graphics device, on a pool of threads
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_PNG_H__
+#define __YAPP_PNG_H__
+
+#include <pthread.h>
+
+#define EXT_PNG                 ".png"
+
+#define YAPP_PNG_WIDTH          800     /* size of a plot, in pixels */
+#define YAPP_PNG_HEIGHT         600
+#define YAPP_PNG_WEDGE_MT       0.02    /* top margin of the colour wedge, as
+                                           a fraction of the height - the
+                                           wedge sits above the image, as in
+                                           the PGPLOT plots */
+#define YAPP_PNG_WEDGE_MB       0.06    /* bottom margin of the colour wedge */
+#define YAPP_PNG_MAXTHREADS     64      /* maximum number of rendering
+                                           threads */
+#define YAPP_PNG_PLOTSPERTHREAD 2       /* number of plots queued per thread */
+
+/* plot types */
+#define YAPP_PNG_TYPE_IMAGE     0       /* two-dimensional image, as plotted by
+                                           Plot2D() */
+#define YAPP_PNG_TYPE_LINES     1       /* one or more lines, as plotted by
+                                           cpgline() */
+
+/**
+ * A plot to be rendered. The data of an image are laid out as for Plot2D() -
+ * iLenY rows of iLenX values, the first row at the bottom. The data of lines
+ * are iLenY lines of iLenX values each, plotted against a linear x-axis.
+ */
+typedef struct tagPNGPlot
+{
+    char acFile[LEN_GENSTRING];
+    int iType;
+    float *pfData;
+    int iLenX;
+    int iLenY;
+    float fDataMin;             /* range of the colour map, or of the y-axis
+                                   of lines */
+    float fDataMax;
+    float fXMin;                /* world co-ordinates of the edges of the
+                                   plot, recorded in the file */
+    float fXMax;
+    float fYMin;
+    float fYMax;
+    char acXLabel[LEN_GENSTRING];
+    char acYLabel[LEN_GENSTRING];
+    char acTitle[LEN_GENSTRING];
+    int iColourMap;
+    int iInvCols;               /* black on white instead of white on black */
+} YAPP_PNG_PLOT;
+
+/**
+ * Pool of rendering threads, fed through a bounded queue of plots
+ */
+typedef struct tagPNGPool
+{
+    pthread_t *pstThreads;
+    int iNumThreads;
+    YAPP_PNG_PLOT *pstQueue;
+    int iQueueLen;
+    int iHead;                  /* first plot in the queue */
+    int iCount;                 /* number of plots in the queue */
+    pthread_mutex_t stMutex;    /* protects the queue, and the fields below */
+    pthread_cond_t stCond;      /* signalled when the queue changes */
+    char cStop;                 /* set when no more plots will be queued */
+    int iRet;                   /* set if rendering a plot has failed */
+} YAPP_PNG_POOL;
+
+/**
+ * Render a plot and write it to its file
+ *
+ * @param[in]       pstPlot         Plot
+ */
+int YAPP_PNG_Render(YAPP_PNG_PLOT *pstPlot);
+
+/**
+ * Start a pool of rendering threads
+ *
+ * @param[out]      pstPool         Pool
+ * @param[in]       iNumThreads     Number of threads
+ */
+int YAPP_PNG_Start(YAPP_PNG_POOL *pstPool, int iNumThreads);
+
+/**
+ * Queue a plot for rendering, waiting if the queue is full. The data are
+ * copied, so the buffer can be reused as soon as this returns.
+ *
+ * @param[inout]    pstPool         Pool
+ * @param[in]       pstPlot         Plot
+ */
+int YAPP_PNG_Submit(YAPP_PNG_POOL *pstPool, YAPP_PNG_PLOT *pstPlot);
+
+/**
+ * Wait for the queued plots to be rendered, and stop the threads
+ *
+ * @param[inout]    pstPool         Pool
+ */
+int YAPP_PNG_Stop(YAPP_PNG_POOL *pstPool);
+
+#endif  /* __YAPP_PNG_H__ */
+
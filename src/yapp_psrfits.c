@@ -0,0 +1,946 @@
+/**
+ * @file yapp_psrfits.c
+ * PSRFITS search-mode data reading routines - subints are read from a
+ *  sequence of files, the scales, offsets and weights are applied, and one
+ *  polarization, or the sum of two, is selected, so that the data can be
+ *  read as a stream of filterbank data.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_psrfits.h"
+#include <ctype.h>
+
+static int GetNextFilename(const char *pcFileSpec, char *pcNext);
+static int DecodeSubInt(YAPP_PF_READER *pstReader, long int lSubInt);
+static ssize_t ReadStream(void *pvCookie, char *pcBuf, size_t lSize);
+static int SeekStream(void *pvCookie, off64_t *plOffset, int iWhence);
+static int CloseStream(void *pvCookie);
+
+/*
+ * Open a file at its SUBINT HDU, and find the columns
+ */
+int YAPP_PF_OpenSubInts(char *pcFileSpec,
+                        fitsfile **ppstFile,
+                        YAPP_PF_COLS *pstCols)
+{
+    char acErrMsg[LEN_GENSTRING] = {0};
+    int iStatus = 0;
+
+    /*  open PSRFITS file */
+    (void) fits_open_file(ppstFile, pcFileSpec, READONLY, &iStatus);
+    if  (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Opening file failed! %s\n",
+                       acErrMsg);
+        *ppstFile = NULL;
+        return YAPP_RET_ERROR;
+    }
+    (void) fits_movnam_hdu(*ppstFile,
+                           BINARY_TBL,
+                           YAPP_PF_HDUNAME_SUBINT,
+                           0,
+                           &iStatus);
+    (void) fits_get_colnum(*ppstFile,
+                           CASESEN,
+                           YAPP_PF_LABEL_DATA,
+                           &pstCols->iColData,
+                           &iStatus);
+    if (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Getting column number failed! %s\n",
+                       acErrMsg);
+        iStatus = 0;
+        (void) fits_close_file(*ppstFile, &iStatus);
+        *ppstFile = NULL;
+        return YAPP_RET_ERROR;
+    }
+
+    /* the scales, offsets, weights and zero offset are optional, and default
+       to leaving the data unchanged */
+    (void) fits_get_colnum(*ppstFile,
+                           CASESEN,
+                           YAPP_PF_LABEL_DATSCL,
+                           &pstCols->iColScl,
+                           &iStatus);
+    if (iStatus != 0)
+    {
+        pstCols->iColScl = 0;
+        iStatus = 0;
+    }
+    (void) fits_get_colnum(*ppstFile,
+                           CASESEN,
+                           YAPP_PF_LABEL_DATOFFS,
+                           &pstCols->iColOffs,
+                           &iStatus);
+    if (iStatus != 0)
+    {
+        pstCols->iColOffs = 0;
+        iStatus = 0;
+    }
+    (void) fits_get_colnum(*ppstFile,
+                           CASESEN,
+                           YAPP_PF_LABEL_DATWTS,
+                           &pstCols->iColWts,
+                           &iStatus);
+    if (iStatus != 0)
+    {
+        pstCols->iColWts = 0;
+        iStatus = 0;
+    }
+    (void) fits_read_key(*ppstFile,
+                         TFLOAT,
+                         YAPP_PF_LABEL_ZEROOFF,
+                         &pstCols->fZeroOff,
+                         NULL,
+                         &iStatus);
+    if (iStatus != 0)
+    {
+        pstCols->fZeroOff = 0.0;
+        iStatus = 0;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Read the number of subints in a file, and the number of samples per subint
+ */
+int YAPP_PF_GetNumSubInts(char *pcFileSpec,
+                          long int *plNumSubInts,
+                          int *piSampsPerSubInt)
+{
+    fitsfile *pstFileData = NULL;
+    char acErrMsg[LEN_GENSTRING] = {0};
+    int iStatus = 0;
+
+    /*  open PSRFITS file */
+    (void) fits_open_file(&pstFileData, pcFileSpec, READONLY, &iStatus);
+    if  (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Opening file failed! %s\n",
+                       acErrMsg);
+        return YAPP_RET_ERROR;
+    }
+    /* read SUBINT HDU header to get data parameters */
+    (void) fits_movnam_hdu(pstFileData,
+                           BINARY_TBL,
+                           YAPP_PF_HDUNAME_SUBINT,
+                           0,
+                           &iStatus);
+    (void) fits_read_key(pstFileData,
+                         TLONG,
+                         YAPP_PF_LABEL_NSUBINT,
+                         plNumSubInts,
+                         NULL,
+                         &iStatus);
+    (void) fits_read_key(pstFileData,
+                         TINT,
+                         YAPP_PF_LABEL_NSBLK,
+                         piSampsPerSubInt,
+                         NULL,
+                         &iStatus);
+    if  (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Reading number of subints failed for file "
+                       "%s! %s\n",
+                       pcFileSpec,
+                       acErrMsg);
+        iStatus = 0;
+        (void) fits_close_file(pstFileData, &iStatus);
+        return YAPP_RET_ERROR;
+    }
+    (void) fits_close_file(pstFileData, &iStatus);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Get the CFITSIO type of DATA, and the number of elements that hold a given
+ * number of samples
+ */
+int YAPP_PF_GetDataType(int iNumBits, long int lNumSamps, long int *plNumElems)
+{
+    switch (iNumBits)
+    {
+        case YAPP_SAMPSIZE_1:
+        case YAPP_SAMPSIZE_2:
+        case YAPP_SAMPSIZE_4:
+            /* more than one sample per element */
+            *plNumElems = (lNumSamps * iNumBits) / YAPP_BYTE2BIT_FACTOR;
+            return TBYTE;
+
+        case YAPP_SAMPSIZE_8:
+            *plNumElems = lNumSamps;
+            return TBYTE;
+
+        case YAPP_SAMPSIZE_16:
+            *plNumElems = lNumSamps;
+            return TSHORT;
+
+        case YAPP_SAMPSIZE_32:
+            *plNumElems = lNumSamps;
+            return TFLOAT;
+
+        default:
+            (void) fprintf(stderr,
+                           "ERROR: Unexpected number of bits!\n");
+            return YAPP_RET_ERROR;
+    }
+}
+
+
+/*
+ * Read the scales, offsets and weights of a subint
+ */
+int YAPP_PF_ReadScales(fitsfile *pstFile,
+                       YAPP_PF_COLS *pstCols,
+                       long int lRow,
+                       int iNumPol,
+                       int iNumChans,
+                       float *pfScl,
+                       float *pfOffs,
+                       float *pfWts)
+{
+    char acErrMsg[LEN_GENSTRING] = {0};
+    long int lNumScales = (long int) iNumPol * iNumChans;
+    int iStatus = 0;
+    long int i = 0;
+
+    if (pstCols->iColScl != 0)
+    {
+        (void) fits_read_col(pstFile,
+                             TFLOAT,
+                             pstCols->iColScl,
+                             lRow,
+                             1,
+                             lNumScales,
+                             NULL,
+                             pfScl,
+                             NULL,
+                             &iStatus);
+    }
+    else
+    {
+        for (i = 0; i < lNumScales; ++i)
+        {
+            pfScl[i] = 1.0;
+        }
+    }
+    if (pstCols->iColOffs != 0)
+    {
+        (void) fits_read_col(pstFile,
+                             TFLOAT,
+                             pstCols->iColOffs,
+                             lRow,
+                             1,
+                             lNumScales,
+                             NULL,
+                             pfOffs,
+                             NULL,
+                             &iStatus);
+    }
+    else
+    {
+        (void) memset(pfOffs, '\0', sizeof(float) * lNumScales);
+    }
+    if (pstCols->iColWts != 0)
+    {
+        (void) fits_read_col(pstFile,
+                             TFLOAT,
+                             pstCols->iColWts,
+                             lRow,
+                             1,
+                             iNumChans,
+                             NULL,
+                             pfWts,
+                             NULL,
+                             &iStatus);
+    }
+    else
+    {
+        for (i = 0; i < iNumChans; ++i)
+        {
+            pfWts[i] = 1.0;
+        }
+    }
+    if (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Reading scales of subint %ld failed! %s\n",
+                       lRow,
+                       acErrMsg);
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Combine the scale, offset and weight of each sample of a spectrum into a
+ * gain and a bias, so that each sample takes a multiply-add - DATA, DAT_SCL
+ * and DAT_OFFS all hold all the channels of one polarization, then those of
+ * the next
+ */
+void YAPP_PF_MakeGains(const float *pfScl,
+                       const float *pfOffs,
+                       const float *pfWts,
+                       float fZeroOff,
+                       int iNumPol,
+                       int iNumChans,
+                       float *pfGain,
+                       float *pfBias)
+{
+    int i = 0;
+    int k = 0;
+    int p = 0;
+
+    for (p = 0; p < iNumPol; ++p)
+    {
+        for (i = 0; i < iNumChans; ++i)
+        {
+            k = (p * iNumChans) + i;
+            pfGain[k] = pfScl[k] * pfWts[i];
+            pfBias[k] = (pfOffs[k] - (fZeroOff * pfScl[k])) * pfWts[i];
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * Convert raw samples to 32-bit floating-point and apply the gains and biases
+ */
+void YAPP_PF_Scale(const void *pvRaw,
+                   int iNumBits,
+                   long int lNumSamps,
+                   int iSpecLen,
+                   const float *pfGain,
+                   const float *pfBias,
+                   float *pfData)
+{
+    long int j = 0;
+    int i = 0;
+
+    switch (iNumBits)
+    {
+        case YAPP_SAMPSIZE_1:
+        case YAPP_SAMPSIZE_2:
+        case YAPP_SAMPSIZE_4:
+        {
+            const unsigned char *pcBuf = (const unsigned char *) pvRaw;
+            int iPerByte = YAPP_BYTE2BIT_FACTOR / iNumBits;
+            unsigned char cMask = (unsigned char) ((1 << iNumBits) - 1);
+            int k = 0;
+            for (j = 0; j < (lNumSamps / iPerByte); ++j)
+            {
+                for (k = 0; k < iPerByte; ++k)
+                {
+                    pfData[(j*iPerByte)+k] = (float) ((pcBuf[j]
+                                                       >> (k * iNumBits))
+                                                      & cMask);
+                }
+            }
+            for (j = 0; j < lNumSamps; j += iSpecLen)
+            {
+                for (i = 0; i < iSpecLen; ++i)
+                {
+                    pfData[j+i] = (pfData[j+i] * pfGain[i]) + pfBias[i];
+                }
+            }
+            break;
+        }
+
+        case YAPP_SAMPSIZE_8:
+        {
+            const unsigned char *pcBuf = (const unsigned char *) pvRaw;
+            for (j = 0; j < lNumSamps; j += iSpecLen)
+            {
+                for (i = 0; i < iSpecLen; ++i)
+                {
+                    pfData[j+i] = ((float) pcBuf[j+i] * pfGain[i])
+                                  + pfBias[i];
+                }
+            }
+            break;
+        }
+
+        case YAPP_SAMPSIZE_16:
+        {
+            const short int *psBuf = (const short int *) pvRaw;
+            for (j = 0; j < lNumSamps; j += iSpecLen)
+            {
+                for (i = 0; i < iSpecLen; ++i)
+                {
+                    pfData[j+i] = ((float) psBuf[j+i] * pfGain[i])
+                                  + pfBias[i];
+                }
+            }
+            break;
+        }
+
+        case YAPP_SAMPSIZE_32:
+        {
+            const float *pfBuf = (const float *) pvRaw;
+            for (j = 0; j < lNumSamps; j += iSpecLen)
+            {
+                for (i = 0; i < iSpecLen; ++i)
+                {
+                    pfData[j+i] = (pfBuf[j+i] * pfGain[i]) + pfBias[i];
+                }
+            }
+            break;
+        }
+
+        default:
+            assert(0);
+    }
+
+    return;
+}
+
+
+/*
+ * Get the polarization identifier from its name
+ */
+int YAPP_PF_GetPolFromName(const char *pcPol)
+{
+    if (0 == strcasecmp(pcPol, "X"))
+    {
+        return YAPP_PF_POL_X;
+    }
+    else if (0 == strcasecmp(pcPol, "Y"))
+    {
+        return YAPP_PF_POL_Y;
+    }
+    else if (0 == strcasecmp(pcPol, "sum"))
+    {
+        return YAPP_PF_POL_SUM;
+    }
+
+    (void) fprintf(stderr, "ERROR: Invalid polarization %s!\n", pcPol);
+    return YAPP_RET_ERROR;
+}
+
+
+/*
+ * Open a sequence of PSRFITS files as a stream of filterbank data
+ */
+FILE* YAPP_PF_Open(char *pcFileSpec, int iPol, YUM_t *pstYUM)
+{
+    YAPP_PF_READER *pstReader = NULL;
+    cookie_io_functions_t stFuncs = {0};
+    FILE *pFStream = NULL;
+    char acNext[LEN_GENSTRING] = {0};
+    struct stat stFileStats = {0};
+    char **ppcFiles = NULL;
+    long int *plFirstSubInt = NULL;
+    long int lNumSubInts = 0;
+    int iSampsPerSubInt = 0;
+    long int lSpecLen = 0;
+    long int lNumSamps = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    if ((pstYUM->iNumPol > 1)
+        && (iPol != YAPP_PF_POL_X)
+        && (iPol != YAPP_PF_POL_Y)
+        && (iPol != YAPP_PF_POL_SUM))
+    {
+        (void) fprintf(stderr, "ERROR: Invalid polarization!\n");
+        return NULL;
+    }
+    if ((1 == pstYUM->iNumPol) && (iPol != YAPP_PF_POL_SUM))
+    {
+        (void) printf("WARNING: Cannot select a polarization in "
+                      "single-polarization data!\n");
+    }
+
+    /* the reader is freed when the stream is closed, which may happen after
+       YAPP_CleanUp() has freed the memory allocated with YAPP_Malloc(), so
+       it is allocated with calloc() */
+    pstReader = (YAPP_PF_READER *) calloc(1, sizeof(YAPP_PF_READER));
+    if (NULL == pstReader)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return NULL;
+    }
+    pstReader->iFile = -1;
+    pstReader->lSubInt = -1;
+    pstReader->iPol = iPol;
+    pstReader->iNumBits = pstYUM->iNumBits;
+    pstReader->iNumPol = pstYUM->iNumPol;
+    pstReader->iNumChans = pstYUM->iNumChans;
+
+    /* build the list of files in the sequence */
+    (void) strncpy(acNext, pcFileSpec, LEN_GENSTRING - 1);
+    do
+    {
+        ppcFiles = (char **) realloc(pstReader->ppcFiles,
+                                     (pstReader->iNumFiles + 1)
+                                     * sizeof(char *));
+        plFirstSubInt = (long int *) realloc(pstReader->plFirstSubInt,
+                                             (pstReader->iNumFiles + 2)
+                                             * sizeof(long int));
+        if (ppcFiles != NULL)
+        {
+            pstReader->ppcFiles = ppcFiles;
+        }
+        if (plFirstSubInt != NULL)
+        {
+            pstReader->plFirstSubInt = plFirstSubInt;
+        }
+        if ((NULL == ppcFiles) || (NULL == plFirstSubInt))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            (void) CloseStream(pstReader);
+            return NULL;
+        }
+        pstReader->ppcFiles[pstReader->iNumFiles] = strdup(acNext);
+        if (NULL == pstReader->ppcFiles[pstReader->iNumFiles])
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            (void) CloseStream(pstReader);
+            return NULL;
+        }
+        i = pstReader->iNumFiles;
+        ++(pstReader->iNumFiles);
+        if (0 == i)
+        {
+            pstReader->plFirstSubInt[0] = 0;
+        }
+
+        /* NOTE: the number of rows may be different in the last file, so
+                 this needs to be read for every file */
+        iRet = YAPP_PF_GetNumSubInts(acNext, &lNumSubInts, &iSampsPerSubInt);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) CloseStream(pstReader);
+            return NULL;
+        }
+        if (0 == i)
+        {
+            pstReader->iSampsPerSubInt = iSampsPerSubInt;
+        }
+        else if (iSampsPerSubInt != pstReader->iSampsPerSubInt)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Number of samples per subint of %s differs "
+                           "from that of %s!\n",
+                           acNext,
+                           pcFileSpec);
+            (void) CloseStream(pstReader);
+            return NULL;
+        }
+        pstReader->plFirstSubInt[i+1] = pstReader->plFirstSubInt[i]
+                                        + lNumSubInts;
+    }
+    while ((YAPP_RET_SUCCESS == GetNextFilename(acNext, acNext))
+           && (0 == stat(acNext, &stFileStats)));
+    if (pstReader->iNumFiles > 1)
+    {
+        (void) printf("Reading %d files in sequence, %s to %s.\n",
+                      pstReader->iNumFiles,
+                      pstReader->ppcFiles[0],
+                      pstReader->ppcFiles[pstReader->iNumFiles-1]);
+    }
+
+    lSpecLen = (long int) pstReader->iNumPol * pstReader->iNumChans;
+    lNumSamps = lSpecLen * pstReader->iSampsPerSubInt;
+    pstReader->iDataType = YAPP_PF_GetDataType(pstReader->iNumBits,
+                                               lNumSamps,
+                                               &pstReader->lElemsPerSubInt);
+    if (YAPP_RET_ERROR == pstReader->iDataType)
+    {
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+
+    pstReader->pvRaw = malloc((size_t) ((float) lNumSamps
+                                        * ((float) pstReader->iNumBits
+                                           / YAPP_BYTE2BIT_FACTOR)));
+    pstReader->pfScl = (float *) malloc(sizeof(float) * lSpecLen);
+    pstReader->pfOffs = (float *) malloc(sizeof(float) * lSpecLen);
+    pstReader->pfWts = (float *) malloc(sizeof(float)
+                                        * pstReader->iNumChans);
+    pstReader->pfGain = (float *) malloc(sizeof(float) * lSpecLen);
+    pstReader->pfBias = (float *) malloc(sizeof(float) * lSpecLen);
+    pstReader->pfData = (float *) malloc(sizeof(float) * lNumSamps);
+    pstReader->pfOut = (float *) malloc(sizeof(float)
+                                        * pstReader->iNumChans
+                                        * pstReader->iSampsPerSubInt);
+    if ((NULL == pstReader->pvRaw)
+        || (NULL == pstReader->pfScl)
+        || (NULL == pstReader->pfOffs)
+        || (NULL == pstReader->pfWts)
+        || (NULL == pstReader->pfGain)
+        || (NULL == pstReader->pfBias)
+        || (NULL == pstReader->pfData)
+        || (NULL == pstReader->pfOut))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+
+    stFuncs.read = ReadStream;
+    stFuncs.write = NULL;
+    stFuncs.seek = SeekStream;
+    stFuncs.close = CloseStream;
+    pFStream = fopencookie(pstReader, "r", stFuncs);
+    if (NULL == pFStream)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening stream failed! %s.\n",
+                       strerror(errno));
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+
+    /* describe the stream - a headerless single-polarization filterbank
+       file of 32-bit floating-point samples */
+    pstYUM->iNumBits = YAPP_SAMPSIZE_32;
+    pstYUM->fSampSize = (float) pstYUM->iNumBits / YAPP_BYTE2BIT_FACTOR;
+    pstYUM->iNumPol = 1;
+    pstYUM->iHeaderLen = 0;
+    pstYUM->iTimeSamps = (int) (pstReader->plFirstSubInt[pstReader->iNumFiles]
+                                * pstReader->iSampsPerSubInt);
+    pstYUM->lDataSizeTotal = (long int) pstYUM->iNumChans
+                             * pstYUM->iTimeSamps
+                             * pstYUM->fSampSize;
+    pstReader->lSize = pstYUM->lDataSizeTotal;
+    if (NULL == pstYUM->pcIsChanGood)
+    {
+        pstYUM->pcIsChanGood = (char *) YAPP_Malloc((size_t) pstYUM->iNumChans,
+                                                    sizeof(char),
+                                                    YAPP_FALSE);
+        if (NULL == pstYUM->pcIsChanGood)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            (void) fclose(pFStream);
+            return NULL;
+        }
+        /* zero-weighted channels are zeroed when the data is scaled, so all
+           channels are marked good */
+        (void) memset(pstYUM->pcIsChanGood, YAPP_TRUE, pstYUM->iNumChans);
+        pstYUM->iNumGoodChans = pstYUM->iNumChans;
+    }
+
+    return pFStream;
+}
+
+
+/*
+ * Build the name of the file that follows a given file in a sequence, by
+ * adding one to the number before the extension - pcNext may be pcFileSpec
+ */
+static int GetNextFilename(const char *pcFileSpec, char *pcNext)
+{
+    char acName[LEN_GENSTRING] = {0};
+    char *pcExt = NULL;
+    char *pcDigit = NULL;
+    int iLen = 0;
+
+    /* leave room for a carry into another digit */
+    (void) snprintf(acName, LEN_GENSTRING - 1, "%s", pcFileSpec);
+    pcExt = strrchr(acName, '.');
+    if ((NULL == pcExt) || (pcExt == acName) || !isdigit(*(pcExt - 1)))
+    {
+        /* not part of a sequence */
+        return YAPP_RET_ERROR;
+    }
+
+    /* add one to the number, carrying to the left */
+    pcDigit = pcExt - 1;
+    while (YAPP_TRUE)
+    {
+        if (*pcDigit != '9')
+        {
+            ++(*pcDigit);
+            break;
+        }
+        *pcDigit = '0';
+        if ((pcDigit == acName) || !isdigit(*(pcDigit - 1)))
+        {
+            /* the number needs another digit */
+            iLen = strlen(pcDigit);
+            (void) memmove(pcDigit + 1, pcDigit, iLen + 1);
+            *pcDigit = '1';
+            break;
+        }
+        --pcDigit;
+    }
+
+    (void) strcpy(pcNext, acName);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Read a subint, scale it, and select the polarization
+ */
+static int DecodeSubInt(YAPP_PF_READER *pstReader, long int lSubInt)
+{
+    char acErrMsg[LEN_GENSTRING] = {0};
+    int iStatus = 0;
+    int iFile = 0;
+    long int lRow = 0;
+    int iNumPol = pstReader->iNumPol;
+    int iNumChans = pstReader->iNumChans;
+    int iSpecLen = pstReader->iNumPol * pstReader->iNumChans;
+    long int lNumSamps = (long int) pstReader->iNumChans
+                         * pstReader->iSampsPerSubInt;
+    float *pfData = pstReader->pfData;
+    float *pfOut = pstReader->pfOut;
+    const float *pfSpec = NULL;
+    int iRet = YAPP_RET_SUCCESS;
+    long int j = 0;
+    int i = 0;
+
+    /* find the file and row of the subint */
+    while (lSubInt >= pstReader->plFirstSubInt[iFile+1])
+    {
+        ++iFile;
+    }
+    lRow = lSubInt - pstReader->plFirstSubInt[iFile] + 1;
+
+    if (iFile != pstReader->iFile)
+    {
+        if (pstReader->pstFile != NULL)
+        {
+            (void) fits_close_file(pstReader->pstFile, &iStatus);
+            pstReader->pstFile = NULL;
+            pstReader->iFile = -1;
+        }
+        iRet = YAPP_PF_OpenSubInts(pstReader->ppcFiles[iFile],
+                                   &pstReader->pstFile,
+                                   &pstReader->stCols);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            return YAPP_RET_ERROR;
+        }
+        pstReader->iFile = iFile;
+    }
+
+    (void) fits_read_col(pstReader->pstFile,
+                         pstReader->iDataType,
+                         pstReader->stCols.iColData,
+                         lRow,
+                         1,
+                         pstReader->lElemsPerSubInt,
+                         NULL,
+                         pstReader->pvRaw,
+                         NULL,
+                         &iStatus);
+    if (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Reading subint %ld of file %s failed! %s\n",
+                       lRow,
+                       pstReader->ppcFiles[iFile],
+                       acErrMsg);
+        return YAPP_RET_ERROR;
+    }
+    iRet = YAPP_PF_ReadScales(pstReader->pstFile,
+                              &pstReader->stCols,
+                              lRow,
+                              pstReader->iNumPol,
+                              pstReader->iNumChans,
+                              pstReader->pfScl,
+                              pstReader->pfOffs,
+                              pstReader->pfWts);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    YAPP_PF_MakeGains(pstReader->pfScl,
+                      pstReader->pfOffs,
+                      pstReader->pfWts,
+                      pstReader->stCols.fZeroOff,
+                      pstReader->iNumPol,
+                      pstReader->iNumChans,
+                      pstReader->pfGain,
+                      pstReader->pfBias);
+    YAPP_PF_Scale(pstReader->pvRaw,
+                  pstReader->iNumBits,
+                  lNumSamps * iNumPol,
+                  iSpecLen,
+                  pstReader->pfGain,
+                  pstReader->pfBias,
+                  pfData);
+
+    /* each time sample holds all the channels of one polarization, then
+       those of the next - with four, the first two are the
+       auto-correlations, which sum to the total intensity */
+    if (1 == iNumPol)
+    {
+        (void) memcpy(pfOut, pfData, sizeof(float) * lNumSamps);
+    }
+    else if (YAPP_PF_POL_SUM == pstReader->iPol)
+    {
+        for (j = 0; j < pstReader->iSampsPerSubInt; ++j)
+        {
+            pfSpec = pfData + (j * iSpecLen);
+            for (i = 0; i < iNumChans; ++i)
+            {
+                pfOut[(j*iNumChans)+i] = pfSpec[i] + pfSpec[iNumChans+i];
+            }
+        }
+    }
+    else
+    {
+        for (j = 0; j < pstReader->iSampsPerSubInt; ++j)
+        {
+            pfSpec = pfData + (j * iSpecLen) + (pstReader->iPol * iNumChans);
+            (void) memcpy(pfOut + (j * iNumChans),
+                          pfSpec,
+                          sizeof(float) * iNumChans);
+        }
+    }
+    pstReader->lSubInt = lSubInt;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Stream read function - copies from the decoded subints
+ */
+static ssize_t ReadStream(void *pvCookie, char *pcBuf, size_t lSize)
+{
+    YAPP_PF_READER *pstReader = (YAPP_PF_READER *) pvCookie;
+    long int lSubIntLen = (long int) pstReader->iNumChans
+                          * pstReader->iSampsPerSubInt
+                          * sizeof(float);
+    long int lSubInt = 0;
+    long int lOffset = 0;
+    long int lLen = 0;
+    size_t lDone = 0;
+
+    while ((lDone < lSize) && (pstReader->lPos < pstReader->lSize))
+    {
+        lSubInt = pstReader->lPos / lSubIntLen;
+        lOffset = pstReader->lPos % lSubIntLen;
+        if (lSubInt != pstReader->lSubInt)
+        {
+            if (DecodeSubInt(pstReader, lSubInt) != YAPP_RET_SUCCESS)
+            {
+                pstReader->lSubInt = -1;
+                errno = EIO;
+                return -1;
+            }
+        }
+        lLen = lSubIntLen - lOffset;
+        if (lLen > (long int) (lSize - lDone))
+        {
+            lLen = (long int) (lSize - lDone);
+        }
+        (void) memcpy(pcBuf + lDone,
+                      (char *) pstReader->pfOut + lOffset,
+                      (size_t) lLen);
+        lDone += lLen;
+        pstReader->lPos += lLen;
+    }
+
+    return (ssize_t) lDone;
+}
+
+
+/*
+ * Stream seek function - only moves the position, the subint is decoded when
+ * it is read
+ */
+static int SeekStream(void *pvCookie, off64_t *plOffset, int iWhence)
+{
+    YAPP_PF_READER *pstReader = (YAPP_PF_READER *) pvCookie;
+    long int lPos = 0;
+
+    switch (iWhence)
+    {
+        case SEEK_SET:
+            lPos = *plOffset;
+            break;
+
+        case SEEK_CUR:
+            lPos = pstReader->lPos + *plOffset;
+            break;
+
+        case SEEK_END:
+            lPos = pstReader->lSize + *plOffset;
+            break;
+
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    if (lPos < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    pstReader->lPos = lPos;
+    *plOffset = lPos;
+
+    return 0;
+}
+
+
+/*
+ * Stream close function - closes the open file and frees the reader
+ */
+static int CloseStream(void *pvCookie)
+{
+    YAPP_PF_READER *pstReader = (YAPP_PF_READER *) pvCookie;
+    int iStatus = 0;
+    int i = 0;
+
+    if (pstReader->pstFile != NULL)
+    {
+        (void) fits_close_file(pstReader->pstFile, &iStatus);
+    }
+    for (i = 0; i < pstReader->iNumFiles; ++i)
+    {
+        free(pstReader->ppcFiles[i]);
+    }
+    free(pstReader->ppcFiles);
+    free(pstReader->plFirstSubInt);
+    free(pstReader->pvRaw);
+    free(pstReader->pfScl);
+    free(pstReader->pfOffs);
+    free(pstReader->pfWts);
+    free(pstReader->pfGain);
+    free(pstReader->pfBias);
+    free(pstReader->pfData);
+    free(pstReader->pfOut);
+    free(pstReader);
+
+    return 0;
+}
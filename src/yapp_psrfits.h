@@ -9,6 +9,8 @@
 #ifndef __YAPP_PSRFITS_H__
 #define __YAPP_PSRFITS_H__
 
+#include <fitsio.h>
+
 #define YAPP_PF_HDUNAME_AOGEN       "AOGEN"
 #define YAPP_PF_HDUNAME_PDEV        "PDEV"
 #define YAPP_PF_HDUNAME_SUBINT      "SUBINT"
@@ -36,7 +38,183 @@
 #define YAPP_PF_LABEL_NPOL          "NPOL"
 #define YAPP_PF_LABEL_DATA          "DATA"
 #define YAPP_PF_LABEL_DATFREQ       "DAT_FREQ"
+#define YAPP_PF_LABEL_DATSCL        "DAT_SCL"
+#define YAPP_PF_LABEL_DATOFFS       "DAT_OFFS"
+#define YAPP_PF_LABEL_DATWTS        "DAT_WTS"
+#define YAPP_PF_LABEL_ZEROOFF       "ZERO_OFF"  /* in SUBINT HDU */
 #define YAPP_PF_LABEL_NSUBINT       "NAXIS2"    /* in SUBINT HDU */
 
+/* polarizations read from data with more than one */
+#define YAPP_PF_POL_X               0
+#define YAPP_PF_POL_Y               1
+#define YAPP_PF_POL_SUM             2
+
+/**
+ * Columns of the SUBINT HDU of an open file
+ */
+typedef struct tagPFCols
+{
+    int iColData;
+    int iColScl;                /* 0 if the file has no DAT_SCL column */
+    int iColOffs;               /* 0 if the file has no DAT_OFFS column */
+    int iColWts;                /* 0 if the file has no DAT_WTS column */
+    float fZeroOff;
+} YAPP_PF_COLS;
+
+/**
+ * Reader for a sequence of PSRFITS files read as a stream of filterbank
+ * data - a subint at a time is decoded, scaled, and reduced to one
+ * polarization
+ */
+typedef struct tagPFReader
+{
+    char **ppcFiles;
+    int iNumFiles;
+    long int *plFirstSubInt;    /* first subint of each file, counted across
+                                   all files, with an extra entry for the
+                                   total */
+    int iNumBits;
+    int iNumPol;
+    int iNumChans;
+    int iSampsPerSubInt;
+    int iDataType;              /* CFITSIO type of DATA */
+    long int lElemsPerSubInt;   /* number of elements of DATA per subint */
+    int iPol;
+    fitsfile *pstFile;
+    int iFile;                  /* open file, or -1 */
+    YAPP_PF_COLS stCols;
+    void *pvRaw;                /* DATA of a subint */
+    float *pfScl;
+    float *pfOffs;
+    float *pfWts;
+    float *pfGain;
+    float *pfBias;
+    float *pfData;              /* scaled subint, all polarizations */
+    float *pfOut;               /* scaled subint, one polarization */
+    long int lSubInt;           /* subint in pfOut, or -1 */
+    long int lPos;              /* stream position, in bytes */
+    long int lSize;             /* stream length, in bytes */
+} YAPP_PF_READER;
+
+/**
+ * Open a file at its SUBINT HDU, and find the columns
+ *
+ * @param[in]       pcFileSpec      File name
+ * @param[out]      ppstFile        Open file
+ * @param[out]      pstCols         Columns, and zero offset
+ */
+int YAPP_PF_OpenSubInts(char *pcFileSpec,
+                        fitsfile **ppstFile,
+                        YAPP_PF_COLS *pstCols);
+
+/**
+ * Read the number of subints in a file, and the number of samples per subint
+ *
+ * @param[in]       pcFileSpec      File name
+ * @param[out]      plNumSubInts    Number of subints
+ * @param[out]      piSampsPerSubInt    Number of samples per subint
+ */
+int YAPP_PF_GetNumSubInts(char *pcFileSpec,
+                          long int *plNumSubInts,
+                          int *piSampsPerSubInt);
+
+/**
+ * Get the CFITSIO type of DATA, and the number of elements that hold a given
+ * number of samples
+ *
+ * @param[in]       iNumBits        Number of bits per sample
+ * @param[in]       lNumSamps       Number of samples
+ * @param[out]      plNumElems      Number of elements
+ */
+int YAPP_PF_GetDataType(int iNumBits, long int lNumSamps, long int *plNumElems);
+
+/**
+ * Read the scales, offsets and weights of a subint - missing columns give
+ * unit scales and weights, and zero offsets
+ *
+ * @param[in]       pstFile         Open file
+ * @param[in]       pstCols         Columns
+ * @param[in]       lRow            Row, counting from 1
+ * @param[in]       iNumPol         Number of polarizations
+ * @param[in]       iNumChans       Number of channels
+ * @param[out]      pfScl           Scales, iNumPol * iNumChans
+ * @param[out]      pfOffs          Offsets, iNumPol * iNumChans
+ * @param[out]      pfWts           Weights, iNumChans
+ */
+int YAPP_PF_ReadScales(fitsfile *pstFile,
+                       YAPP_PF_COLS *pstCols,
+                       long int lRow,
+                       int iNumPol,
+                       int iNumChans,
+                       float *pfScl,
+                       float *pfOffs,
+                       float *pfWts);
+
+/**
+ * Combine the scale, offset and weight of each sample of a spectrum into a
+ * gain and a bias. A spectrum holds all the channels of one polarization,
+ * then those of the next, as DATA does.
+ *
+ * @param[in]       pfScl           Scales
+ * @param[in]       pfOffs          Offsets
+ * @param[in]       pfWts           Weights
+ * @param[in]       fZeroOff        Zero offset of the raw data
+ * @param[in]       iNumPol         Number of polarizations
+ * @param[in]       iNumChans       Number of channels
+ * @param[out]      pfGain          Gains, iNumPol * iNumChans
+ * @param[out]      pfBias          Biases, iNumPol * iNumChans
+ */
+void YAPP_PF_MakeGains(const float *pfScl,
+                       const float *pfOffs,
+                       const float *pfWts,
+                       float fZeroOff,
+                       int iNumPol,
+                       int iNumChans,
+                       float *pfGain,
+                       float *pfBias);
+
+/**
+ * Convert raw samples to 32-bit floating-point and apply the gains and
+ * biases. The first of the sub-byte samples in a byte is in the least
+ * significant bits.
+ *
+ * @param[in]       pvRaw           Raw samples
+ * @param[in]       iNumBits        Number of bits per sample
+ * @param[in]       lNumSamps       Number of samples, a multiple of iSpecLen
+ * @param[in]       iSpecLen        Number of samples in a spectrum
+ * @param[in]       pfGain          Gains, iSpecLen
+ * @param[in]       pfBias          Biases, iSpecLen
+ * @param[out]      pfData          Scaled samples
+ */
+void YAPP_PF_Scale(const void *pvRaw,
+                   int iNumBits,
+                   long int lNumSamps,
+                   int iSpecLen,
+                   const float *pfGain,
+                   const float *pfBias,
+                   float *pfData);
+
+/**
+ * Get the polarization identifier from its name - 'X', 'Y', or 'sum'
+ *
+ * @param[in]       pcPol           Name
+ */
+int YAPP_PF_GetPolFromName(const char *pcPol);
+
+/**
+ * Open a PSRFITS file, and the files that follow it in sequence, as a stream
+ * of headerless 32-bit floating-point filterbank data, with the scales,
+ * offsets and weights applied. The names of files in a sequence differ only
+ * in the number before the extension, which goes up by one from file to
+ * file. The metadata, read from the first file, is updated to describe the
+ * stream.
+ *
+ * @param[in]       pcFileSpec      First file
+ * @param[in]       iPol            Polarization to read, for data with more
+ *                                  than one
+ * @param[inout]    pstYUM          Metadata
+ */
+FILE* YAPP_PF_Open(char *pcFileSpec, int iPol, YUM_t *pstYUM);
+
 #endif  /* __YAPP_PSRFITS_H__ */
 
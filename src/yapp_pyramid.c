@@ -0,0 +1,805 @@
+/*
+ * @file yapp_pyramid.c
+ * Decimation pyramid routines. The pyramid of a data file holds, for each
+ *  level k, the minimum, maximum and mean of each channel over every 2^k
+ *  samples. It is built in a single pass over the data - each spectrum is
+ *  added to the record being accumulated at the finest level, and each
+ *  completed record is added to the record being accumulated at the next
+ *  level - and stored in a sidecar file, next to the data file, or in a cache
+ *  directory if the directory of the data file is not writable.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_pyramid.h"
+
+static void AddToLevel(YAPP_PYR_BUILDER *pstBuilder,
+                       int iLevel,
+                       float *pfMin,
+                       float *pfMax,
+                       float *pfMean,
+                       long lNumSamps);
+static void EmitRecord(YAPP_PYR_BUILDER *pstBuilder, int iLevel);
+static int FlushLevel(YAPP_PYR_BUILDER *pstBuilder, int iLevel);
+static long GetNumRecs(YAPP_PYR_HEADER *pstHeader, int iLevel);
+static int WritePyramid(int iFdPyr,
+                        char *pcFilePyr,
+                        FILE *pFData,
+                        YUM_t *pstYUM,
+                        YAPP_PYR_HEADER *pstHeader);
+static FILE* OpenIfCurrent(char *pcFilePyr, YAPP_PYR_HEADER *pstHeader);
+static int GetCacheFilename(char *pcFileData, char *pcFilePyr);
+static int IsOwnDir(char *pcDir);
+static int IsDirWritable(char *pcFileData);
+
+/*
+ * Open the pyramid of a data file, building it first if needed
+ */
+int YAPP_PYR_Open(YAPP_PYR *pstPyr,
+                  char *pcFileData,
+                  FILE *pFData,
+                  YUM_t *pstYUM,
+                  int iMaxRecs)
+{
+    char acFilePyr[LEN_GENSTRING] = {0};
+    char acFileCache[LEN_GENSTRING] = {0};
+    YAPP_PYR_HEADER stHeader = {{0}};
+    struct stat stFileStats = {0};
+    off_t lOffset = 0;
+    size_t iRecSize = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    (void) snprintf(acFilePyr,
+                    LEN_GENSTRING,
+                    "%s%s",
+                    pcFileData,
+                    EXT_YAPP_PYRAMID);
+
+    iRet = stat(pcFileData, &stFileStats);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Failed to stat %s: %s!\n",
+                       pcFileData,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    /* describe the pyramid that the data should have - the coarsest level
+       summarises all the data in one record */
+    (void) memset(&stHeader, '\0', sizeof(stHeader));
+    (void) memcpy(stHeader.acMagic, YAPP_PYR_MAGIC, sizeof(stHeader.acMagic));
+    stHeader.iNumChans = pstYUM->iNumChans;
+    stHeader.iFirstLevel = YAPP_PYR_FIRSTLEVEL;
+    stHeader.lNumSamps = pstYUM->iTimeSamps;
+    do
+    {
+        ++stHeader.iNumLevels;
+    }
+    while (((1L << (stHeader.iFirstLevel + stHeader.iNumLevels - 1))
+            < stHeader.lNumSamps)
+           && (stHeader.iNumLevels < YAPP_PYR_MAXLEVELS));
+    stHeader.lDataSize = (int64_t) stFileStats.st_size;
+    stHeader.lMTimeSec = (int64_t) stFileStats.st_mtim.tv_sec;
+    stHeader.lMTimeNSec = (int64_t) stFileStats.st_mtim.tv_nsec;
+
+    /* use the existing pyramid, if it is that of the data as it is now,
+       looking next to the data file first, then in the cache */
+    pstPyr->pFPyr = OpenIfCurrent(acFilePyr, &stHeader);
+    if (NULL == pstPyr->pFPyr)
+    {
+        iRet = GetCacheFilename(pcFileData, acFileCache);
+        if (YAPP_RET_SUCCESS == iRet)
+        {
+            pstPyr->pFPyr = OpenIfCurrent(acFileCache, &stHeader);
+            if (pstPyr->pFPyr != NULL)
+            {
+                (void) strcpy(acFilePyr, acFileCache);
+            }
+        }
+        else
+        {
+            acFileCache[0] = '\0';
+        }
+    }
+    if (NULL == pstPyr->pFPyr)
+    {
+        /* build it next to the data file if possible, else in the cache */
+        if (!IsDirWritable(pcFileData))
+        {
+            if ('\0' == acFileCache[0])
+            {
+                (void) fprintf(stderr,
+                               "ERROR: No writable directory for the "
+                               "pyramid of %s!\n",
+                               pcFileData);
+                return YAPP_RET_ERROR;
+            }
+            (void) strcpy(acFilePyr, acFileCache);
+        }
+        (void) printf("Building decimation pyramid %s...\n", acFilePyr);
+        iRet = YAPP_PYR_Build(acFilePyr, pFData, pstYUM, &stHeader);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Building pyramid failed!\n");
+            return YAPP_RET_ERROR;
+        }
+        pstPyr->pFPyr = fopen(acFilePyr, "r");
+        if (NULL == pstPyr->pFPyr)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed! %s.\n",
+                           acFilePyr,
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+    }
+    pstPyr->stHeader = stHeader;
+
+    /* find the levels */
+    iRecSize = (size_t) YAPP_PYR_NUMSTATS * stHeader.iNumChans * sizeof(float);
+    lOffset = (off_t) sizeof(YAPP_PYR_HEADER);
+    for (i = 0; i < stHeader.iNumLevels; ++i)
+    {
+        pstPyr->alLevelOffset[i] = lOffset;
+        lOffset += (off_t) GetNumRecs(&stHeader, stHeader.iFirstLevel + i)
+                   * iRecSize;
+    }
+
+    pstPyr->iMaxRecs = iMaxRecs;
+    pstPyr->pfRecs = (float *) YAPP_Malloc((size_t) iMaxRecs
+                                           * YAPP_PYR_NUMSTATS
+                                           * stHeader.iNumChans,
+                                           sizeof(float),
+                                           YAPP_FALSE);
+    if (NULL == pstPyr->pfRecs)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) fclose(pstPyr->pFPyr);
+        pstPyr->pFPyr = NULL;
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Open a pyramid file, if it is that of the data as it is now
+ */
+static FILE* OpenIfCurrent(char *pcFilePyr, YAPP_PYR_HEADER *pstHeader)
+{
+    YAPP_PYR_HEADER stHeaderFile = {{0}};
+    FILE *pFPyr = NULL;
+
+    pFPyr = fopen(pcFilePyr, "r");
+    if (NULL == pFPyr)
+    {
+        return NULL;
+    }
+    if ((fread(&stHeaderFile, sizeof(stHeaderFile), 1, pFPyr) != 1)
+        || (memcmp(&stHeaderFile, pstHeader, sizeof(stHeaderFile)) != 0))
+    {
+        (void) fclose(pFPyr);
+        return NULL;
+    }
+
+    return pFPyr;
+}
+
+
+/*
+ * Get the name of the pyramid of a data file in the cache directory - the
+ * first of $XDG_CACHE_HOME/yapp and ~/.cache/yapp that is a directory of the
+ * user, created if need be. Shared directories such as /tmp are never used,
+ * as others could create files there under the names of pyramids. The name is
+ * made unique by a hash (FNV-1a) of the absolute path of the data file.
+ */
+static int GetCacheFilename(char *pcFileData, char *pcFilePyr)
+{
+    char acDir[LEN_GENSTRING] = {0};
+    char *pcPath = NULL;
+    char *pcBase = NULL;
+    char *pcEnv = NULL;
+    uint64_t lHash = 14695981039346656037ULL;
+    int iFound = YAPP_FALSE;
+    int i = 0;
+
+    pcPath = realpath(pcFileData, NULL);
+    if (NULL == pcPath)
+    {
+        return YAPP_RET_ERROR;
+    }
+    for (i = 0; pcPath[i] != '\0'; ++i)
+    {
+        lHash ^= (unsigned char) pcPath[i];
+        lHash *= 1099511628211ULL;
+    }
+    free(pcPath);
+
+    for (i = 0; (i < 2) && !iFound; ++i)
+    {
+        acDir[0] = '\0';
+        if (0 == i)
+        {
+            pcEnv = getenv("XDG_CACHE_HOME");
+            if ((pcEnv != NULL) && (pcEnv[0] != '\0'))
+            {
+                (void) mkdir(pcEnv, 0700);
+                (void) snprintf(acDir, sizeof(acDir), "%s/yapp", pcEnv);
+            }
+        }
+        else
+        {
+            pcEnv = getenv("HOME");
+            if ((pcEnv != NULL) && (pcEnv[0] != '\0'))
+            {
+                (void) snprintf(acDir, sizeof(acDir), "%s/.cache", pcEnv);
+                (void) mkdir(acDir, 0700);
+                (void) snprintf(acDir, sizeof(acDir), "%s/.cache/yapp", pcEnv);
+            }
+        }
+        if ('\0' == acDir[0])
+        {
+            continue;
+        }
+        (void) mkdir(acDir, 0700);
+        iFound = IsOwnDir(acDir);
+    }
+    if (!iFound)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    pcBase = strrchr(pcFileData, '/');
+    pcBase = (NULL == pcBase) ? pcFileData : (pcBase + 1);
+    (void) snprintf(pcFilePyr,
+                    LEN_GENSTRING,
+                    "%s/%.64s.%016llx%s",
+                    acDir,
+                    pcBase,
+                    (unsigned long long) lHash,
+                    EXT_YAPP_PYRAMID);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Check whether a path is a directory, not a symbolic link to one, that
+ * belongs to the user and can be written to
+ */
+static int IsOwnDir(char *pcDir)
+{
+    struct stat stDirStats = {0};
+
+    if (lstat(pcDir, &stDirStats) != 0)
+    {
+        return YAPP_FALSE;
+    }
+
+    return (S_ISDIR(stDirStats.st_mode)
+            && (stDirStats.st_uid == getuid())
+            && (0 == access(pcDir, W_OK | X_OK)));
+}
+
+
+/*
+ * Check whether a new file can be created next to a data file
+ */
+static int IsDirWritable(char *pcFileData)
+{
+    char acDir[LEN_GENSTRING] = {0};
+    char *pcSlash = NULL;
+
+    (void) snprintf(acDir, sizeof(acDir), "%s", pcFileData);
+    pcSlash = strrchr(acDir, '/');
+    if (NULL == pcSlash)
+    {
+        (void) strcpy(acDir, ".");
+    }
+    else if (pcSlash == acDir)
+    {
+        acDir[1] = '\0';
+    }
+    else
+    {
+        *pcSlash = '\0';
+    }
+
+    return (0 == access(acDir, W_OK | X_OK));
+}
+
+
+/*
+ * Build the pyramid of a data file
+ */
+int YAPP_PYR_Build(char *pcFilePyr,
+                   FILE *pFData,
+                   YUM_t *pstYUM,
+                   YAPP_PYR_HEADER *pstHeader)
+{
+    char acFileTemp[LEN_GENSTRING] = {0};
+    int iFdPyr = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    /* write to a new file of a unique name, readable and writable only by the
+       user, so that nothing already in place of the pyramid - a symbolic link
+       included - is written through, and move it into place once complete */
+    if ((size_t) snprintf(acFileTemp,
+                          sizeof(acFileTemp),
+                          "%s.XXXXXX",
+                          pcFilePyr) >= sizeof(acFileTemp))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Pyramid filename %s is too long!\n",
+                       pcFilePyr);
+        return YAPP_RET_ERROR;
+    }
+    iFdPyr = mkstemp(acFileTemp);
+    if (-1 == iFdPyr)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Creating file %s failed! %s.\n",
+                       acFileTemp,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    iRet = WritePyramid(iFdPyr, acFileTemp, pFData, pstYUM, pstHeader);
+    if ((YAPP_RET_SUCCESS == iRet) && (rename(acFileTemp, pcFilePyr) != 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Renaming file %s to %s failed! %s.\n",
+                       acFileTemp,
+                       pcFilePyr,
+                       strerror(errno));
+        iRet = YAPP_RET_ERROR;
+    }
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) unlink(acFileTemp);
+    }
+
+    return iRet;
+}
+
+
+/*
+ * Write the pyramid of a data file to a file open for writing, and close it
+ */
+static int WritePyramid(int iFdPyr,
+                        char *pcFilePyr,
+                        FILE *pFData,
+                        YUM_t *pstYUM,
+                        YAPP_PYR_HEADER *pstHeader)
+{
+    YAPP_PYR_BUILDER stBuilder = {0};
+    YAPP_PYR_HEADER stBlank = {{0}};
+    char *pcBuf = NULL;
+    float *pfBuf = NULL;
+    float *pfSpectrum = NULL;
+    size_t iBlockBytes = 0;
+    long lSampCount = 0;
+    int iNumChans = pstHeader->iNumChans;
+    int iNumLevels = pstHeader->iNumLevels;
+    int iReadSamps = 0;
+    int i = 0;
+
+    stBuilder.pstHeader = pstHeader;
+    stBuilder.iRet = YAPP_RET_SUCCESS;
+    stBuilder.iRecLen = YAPP_PYR_NUMSTATS * iNumChans;
+    stBuilder.iBufRecs = YAPP_PYR_BUFSIZE
+                         / (stBuilder.iRecLen * (int) sizeof(float));
+    if (stBuilder.iBufRecs < 1)
+    {
+        stBuilder.iBufRecs = 1;
+    }
+
+    /* allocate the accumulators and output buffers of all levels */
+    stBuilder.pfMin = (float *) YAPP_Malloc((size_t) iNumLevels * iNumChans,
+                                            sizeof(float),
+                                            YAPP_FALSE);
+    stBuilder.pfMax = (float *) YAPP_Malloc((size_t) iNumLevels * iNumChans,
+                                            sizeof(float),
+                                            YAPP_FALSE);
+    stBuilder.pdSum = (double *) YAPP_Malloc((size_t) iNumLevels * iNumChans,
+                                             sizeof(double),
+                                             YAPP_TRUE);
+    stBuilder.pfOut = (float *) YAPP_Malloc((size_t) iNumLevels
+                                            * stBuilder.iBufRecs
+                                            * stBuilder.iRecLen,
+                                            sizeof(float),
+                                            YAPP_FALSE);
+    /* read the data in blocks of DEF_SIZE_BLOCK spectra */
+    iBlockBytes = (size_t) (DEF_SIZE_BLOCK * iNumChans * pstYUM->fSampSize);
+    pcBuf = (char *) YAPP_Malloc(iBlockBytes, sizeof(char), YAPP_FALSE);
+    pfBuf = (float *) YAPP_Malloc((size_t) DEF_SIZE_BLOCK * iNumChans,
+                                  sizeof(float),
+                                  YAPP_FALSE);
+    if ((NULL == stBuilder.pfMin) || (NULL == stBuilder.pfMax)
+        || (NULL == stBuilder.pdSum) || (NULL == stBuilder.pfOut)
+        || (NULL == pcBuf) || (NULL == pfBuf))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) close(iFdPyr);
+        return YAPP_RET_ERROR;
+    }
+    for (i = 0; i < iNumLevels * iNumChans; ++i)
+    {
+        stBuilder.pfMin[i] = FLT_MAX;
+        stBuilder.pfMax[i] = -(FLT_MAX);
+    }
+
+    /* find the levels in the file */
+    stBuilder.alOffset[0] = (off_t) sizeof(YAPP_PYR_HEADER);
+    for (i = 1; i < iNumLevels; ++i)
+    {
+        stBuilder.alOffset[i] = stBuilder.alOffset[i-1]
+                                + ((off_t) GetNumRecs(pstHeader,
+                                                      pstHeader->iFirstLevel
+                                                      + i - 1)
+                                   * stBuilder.iRecLen
+                                   * sizeof(float));
+    }
+
+    stBuilder.pFPyr = fdopen(iFdPyr, "w");
+    if (NULL == stBuilder.pFPyr)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFilePyr,
+                       strerror(errno));
+        (void) close(iFdPyr);
+        return YAPP_RET_ERROR;
+    }
+    /* the header is written last, so that an incomplete pyramid is never
+       taken to be valid */
+    (void) fwrite(&stBlank, sizeof(stBlank), 1, stBuilder.pFPyr);
+
+    while (lSampCount < pstHeader->lNumSamps)
+    {
+        iReadSamps = (int) (fread(pcBuf, sizeof(char), iBlockBytes, pFData)
+                            / (iNumChans * pstYUM->fSampSize));
+        if (ferror(pFData))
+        {
+            (void) fprintf(stderr, "ERROR: File read failed!\n");
+            (void) fclose(stBuilder.pFPyr);
+            return YAPP_RET_ERROR;
+        }
+        if (0 == iReadSamps)
+        {
+            break;
+        }
+        if (iReadSamps > (pstHeader->lNumSamps - lSampCount))
+        {
+            iReadSamps = (int) (pstHeader->lNumSamps - lSampCount);
+        }
+        (void) YAPP_UnpackData(pcBuf,
+                               pfBuf,
+                               pstYUM->fSampSize,
+                               iReadSamps * iNumChans);
+
+        /* a spectrum is its own minimum, maximum and mean */
+        for (i = 0; i < iReadSamps; ++i)
+        {
+            pfSpectrum = pfBuf + ((long) i * iNumChans);
+            AddToLevel(&stBuilder, 0, pfSpectrum, pfSpectrum, pfSpectrum, 1);
+        }
+        lSampCount += iReadSamps;
+    }
+    if (lSampCount != pstHeader->lNumSamps)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Read %ld of %ld samples!\n",
+                       lSampCount,
+                       (long) pstHeader->lNumSamps);
+        (void) fclose(stBuilder.pFPyr);
+        return YAPP_RET_ERROR;
+    }
+
+    /* complete the partial records, finest first, as each adds to the next
+       level, and write out what is left in the buffers */
+    for (i = 0; i < iNumLevels; ++i)
+    {
+        if (stBuilder.aiNumInputs[i] > 0)
+        {
+            EmitRecord(&stBuilder, i);
+        }
+    }
+    for (i = 0; i < iNumLevels; ++i)
+    {
+        (void) FlushLevel(&stBuilder, i);
+        assert(stBuilder.alNumRecs[i]
+               == GetNumRecs(pstHeader, pstHeader->iFirstLevel + i));
+    }
+    if (stBuilder.iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fclose(stBuilder.pFPyr);
+        return YAPP_RET_ERROR;
+    }
+
+    (void) fseeko(stBuilder.pFPyr, 0, SEEK_SET);
+    if (fwrite(pstHeader, sizeof(YAPP_PYR_HEADER), 1, stBuilder.pFPyr) != 1)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing file %s failed! %s.\n",
+                       pcFilePyr,
+                       strerror(errno));
+        (void) fclose(stBuilder.pFPyr);
+        return YAPP_RET_ERROR;
+    }
+    if (fclose(stBuilder.pFPyr) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing file %s failed! %s.\n",
+                       pcFilePyr,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Get the level corresponding to a decimation factor
+ */
+int YAPP_PYR_GetLevel(YAPP_PYR *pstPyr, int iFactor)
+{
+    int i = 0;
+
+    for (i = 0; i < pstPyr->stHeader.iNumLevels; ++i)
+    {
+        if ((1L << (pstPyr->stHeader.iFirstLevel + i)) == iFactor)
+        {
+            return pstPyr->stHeader.iFirstLevel + i;
+        }
+    }
+
+    (void) fprintf(stderr,
+                   "ERROR: Decimation factor must be a power of two between "
+                   "%ld and %ld!\n",
+                   1L << pstPyr->stHeader.iFirstLevel,
+                   1L << (pstPyr->stHeader.iFirstLevel
+                          + pstPyr->stHeader.iNumLevels - 1));
+    return YAPP_RET_ERROR;
+}
+
+
+/*
+ * Read consecutive records of a level
+ */
+int YAPP_PYR_Read(YAPP_PYR *pstPyr,
+                  int iLevel,
+                  long lFirstRec,
+                  int iNumRecs,
+                  float *pfMin,
+                  float *pfMax,
+                  float *pfMean)
+{
+    int iNumChans = pstPyr->stHeader.iNumChans;
+    int iRecLen = YAPP_PYR_NUMSTATS * iNumChans;
+    long lNumRecs = GetNumRecs(&pstPyr->stHeader, iLevel);
+    float *pfRec = NULL;
+    size_t iChanBytes = (size_t) iNumChans * sizeof(float);
+    int iReadRecs = 0;
+    int i = 0;
+
+    assert(iNumRecs <= pstPyr->iMaxRecs);
+
+    if (lFirstRec >= lNumRecs)
+    {
+        return 0;
+    }
+    if (iNumRecs > (lNumRecs - lFirstRec))
+    {
+        iNumRecs = (int) (lNumRecs - lFirstRec);
+    }
+
+    (void) fseeko(pstPyr->pFPyr,
+                  pstPyr->alLevelOffset[iLevel-pstPyr->stHeader.iFirstLevel]
+                  + ((off_t) lFirstRec * iRecLen * sizeof(float)),
+                  SEEK_SET);
+    iReadRecs = (int) fread(pstPyr->pfRecs,
+                            (size_t) iRecLen * sizeof(float),
+                            (size_t) iNumRecs,
+                            pstPyr->pFPyr);
+    if (ferror(pstPyr->pFPyr))
+    {
+        (void) fprintf(stderr, "ERROR: Reading pyramid failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    for (i = 0; i < iReadRecs; ++i)
+    {
+        pfRec = pstPyr->pfRecs + ((long) i * iRecLen);
+        if (pfMin != NULL)
+        {
+            (void) memcpy(pfMin + ((long) i * iNumChans), pfRec, iChanBytes);
+        }
+        if (pfMax != NULL)
+        {
+            (void) memcpy(pfMax + ((long) i * iNumChans),
+                          pfRec + iNumChans,
+                          iChanBytes);
+        }
+        if (pfMean != NULL)
+        {
+            (void) memcpy(pfMean + ((long) i * iNumChans),
+                          pfRec + (2 * iNumChans),
+                          iChanBytes);
+        }
+    }
+
+    return iReadRecs * iNumChans;
+}
+
+
+/*
+ * Close a pyramid
+ */
+int YAPP_PYR_Close(YAPP_PYR *pstPyr)
+{
+    if (pstPyr->pFPyr != NULL)
+    {
+        (void) fclose(pstPyr->pFPyr);
+        pstPyr->pFPyr = NULL;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Add a record, or a spectrum, to the record being accumulated at a level,
+ * and complete the record if it has all its inputs
+ */
+static void AddToLevel(YAPP_PYR_BUILDER *pstBuilder,
+                       int iLevel,
+                       float *pfMin,
+                       float *pfMax,
+                       float *pfMean,
+                       long lNumSamps)
+{
+    int iNumChans = pstBuilder->pstHeader->iNumChans;
+    float *pfAccMin = pstBuilder->pfMin + ((long) iLevel * iNumChans);
+    float *pfAccMax = pstBuilder->pfMax + ((long) iLevel * iNumChans);
+    double *pdAccSum = pstBuilder->pdSum + ((long) iLevel * iNumChans);
+    int i = 0;
+
+    for (i = 0; i < iNumChans; ++i)
+    {
+        if (pfMin[i] < pfAccMin[i])
+        {
+            pfAccMin[i] = pfMin[i];
+        }
+        if (pfMax[i] > pfAccMax[i])
+        {
+            pfAccMax[i] = pfMax[i];
+        }
+        pdAccSum[i] += (double) pfMean[i] * lNumSamps;
+    }
+    pstBuilder->alNumSamps[iLevel] += lNumSamps;
+    ++pstBuilder->aiNumInputs[iLevel];
+
+    /* the finest level has 2^iFirstLevel spectra as inputs, and every other
+       level has two records of the level below */
+    if (pstBuilder->aiNumInputs[iLevel]
+        == ((0 == iLevel) ? (1 << pstBuilder->pstHeader->iFirstLevel) : 2))
+    {
+        EmitRecord(pstBuilder, iLevel);
+    }
+
+    return;
+}
+
+
+/*
+ * Complete the record being accumulated at a level, buffer it for writing,
+ * and add it to the next level
+ */
+static void EmitRecord(YAPP_PYR_BUILDER *pstBuilder, int iLevel)
+{
+    int iNumChans = pstBuilder->pstHeader->iNumChans;
+    float *pfAccMin = pstBuilder->pfMin + ((long) iLevel * iNumChans);
+    float *pfAccMax = pstBuilder->pfMax + ((long) iLevel * iNumChans);
+    double *pdAccSum = pstBuilder->pdSum + ((long) iLevel * iNumChans);
+    float *pfRec = NULL;
+    long lNumSamps = pstBuilder->alNumSamps[iLevel];
+    int i = 0;
+
+    if (pstBuilder->aiNumBuffered[iLevel] == pstBuilder->iBufRecs)
+    {
+        (void) FlushLevel(pstBuilder, iLevel);
+    }
+    pfRec = pstBuilder->pfOut
+            + (((long) iLevel * pstBuilder->iBufRecs
+                + pstBuilder->aiNumBuffered[iLevel])
+               * pstBuilder->iRecLen);
+    ++pstBuilder->aiNumBuffered[iLevel];
+
+    for (i = 0; i < iNumChans; ++i)
+    {
+        pfRec[i] = pfAccMin[i];
+        pfRec[iNumChans+i] = pfAccMax[i];
+        pfRec[(2*iNumChans)+i] = (float) (pdAccSum[i] / lNumSamps);
+    }
+
+    /* reset the accumulator */
+    for (i = 0; i < iNumChans; ++i)
+    {
+        pfAccMin[i] = FLT_MAX;
+        pfAccMax[i] = -(FLT_MAX);
+        pdAccSum[i] = 0.0;
+    }
+    pstBuilder->alNumSamps[iLevel] = 0;
+    pstBuilder->aiNumInputs[iLevel] = 0;
+
+    if ((iLevel + 1) < pstBuilder->pstHeader->iNumLevels)
+    {
+        AddToLevel(pstBuilder,
+                   iLevel + 1,
+                   pfRec,
+                   pfRec + iNumChans,
+                   pfRec + (2 * iNumChans),
+                   lNumSamps);
+    }
+
+    return;
+}
+
+
+/*
+ * Write out the buffered records of a level
+ */
+static int FlushLevel(YAPP_PYR_BUILDER *pstBuilder, int iLevel)
+{
+    size_t iRecSize = (size_t) pstBuilder->iRecLen * sizeof(float);
+    int iNumBuffered = pstBuilder->aiNumBuffered[iLevel];
+
+    if (0 == iNumBuffered)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    (void) fseeko(pstBuilder->pFPyr,
+                  pstBuilder->alOffset[iLevel]
+                  + ((off_t) pstBuilder->alNumRecs[iLevel] * iRecSize),
+                  SEEK_SET);
+    if (fwrite(pstBuilder->pfOut
+               + ((long) iLevel * pstBuilder->iBufRecs * pstBuilder->iRecLen),
+               iRecSize,
+               (size_t) iNumBuffered,
+               pstBuilder->pFPyr) != (size_t) iNumBuffered)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing pyramid failed! %s.\n",
+                       strerror(errno));
+        pstBuilder->iRet = YAPP_RET_ERROR;
+    }
+    /* the buffer is emptied even on failure, which is reported at the end */
+    pstBuilder->alNumRecs[iLevel] += iNumBuffered;
+    pstBuilder->aiNumBuffered[iLevel] = 0;
+
+    return pstBuilder->iRet;
+}
+
+
+/*
+ * Get the number of records of a level
+ */
+static long GetNumRecs(YAPP_PYR_HEADER *pstHeader, int iLevel)
+{
+    long lFactor = 1L << iLevel;
+
+    return (long) ((pstHeader->lNumSamps + lFactor - 1) / lFactor);
+}
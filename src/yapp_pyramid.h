@@ -0,0 +1,167 @@
+/**
+ * @file yapp_pyramid.h
+ * Header file for the decimation pyramid routines - a multiresolution summary
+ *  of filterbank or time series data, holding the minimum, maximum and mean of
+ *  each channel over every 2^k samples, for a range of k, stored in a sidecar
+ *  file (or in a per-user cache directory, if the directory of the data file
+ *  is not writable), so that any time range can be viewed at any zoom level by reading
+ *  only the corresponding level
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_PYRAMID_H__
+#define __YAPP_PYRAMID_H__
+
+#include <stdint.h>
+
+#define EXT_YAPP_PYRAMID        ".ypyr" /* decimation pyramid, appended to the
+                                           data filename */
+
+#define YAPP_PYR_MAGIC          "YPY1"  /* identifies a pyramid file, and its
+                                           version */
+#define YAPP_PYR_FIRSTLEVEL     4       /* the finest level summarises 2^4
+                                           samples - finer levels would take
+                                           more space than the data, and are
+                                           as quick to compute from it */
+#define YAPP_PYR_MAXLEVELS      32
+#define YAPP_PYR_NUMSTATS       3       /* minimum, maximum and mean */
+#define YAPP_PYR_BUFSIZE        65536   /* size of the output buffer of each
+                                           level, in bytes */
+
+/**
+ * Pyramid file header - the header is followed by the levels, finest first.
+ * Level k holds ceil(lNumSamps / 2^k) records, each summarising 2^k samples,
+ * except the last, which summarises the rest. A record is the minimum of each
+ * channel, followed by the maximum of each channel, followed by the mean of
+ * each channel, all as floats. The size and modification time of the data
+ * file are those when the pyramid was built, so that a pyramid that is out of
+ * date can be detected.
+ */
+typedef struct tagPyramidHeader
+{
+    char acMagic[4];        /* YAPP_PYR_MAGIC */
+    int32_t iNumChans;
+    int32_t iFirstLevel;
+    int32_t iNumLevels;
+    int64_t lNumSamps;      /* number of samples of the data */
+    int64_t lDataSize;      /* size of the data file */
+    int64_t lMTimeSec;      /* modification time of the data file */
+    int64_t lMTimeNSec;
+} YAPP_PYR_HEADER;
+
+/**
+ * Open pyramid
+ */
+typedef struct tagPyramid
+{
+    YAPP_PYR_HEADER stHeader;
+    FILE *pFPyr;
+    off_t alLevelOffset[YAPP_PYR_MAXLEVELS];
+                                /* offset of each level in the file, indexed
+                                   by k - iFirstLevel */
+    float *pfRecs;              /* read buffer */
+    int iMaxRecs;               /* capacity of the read buffer, in records */
+} YAPP_PYR;
+
+/**
+ * Pyramid being built - one record is accumulated at each level at a time
+ */
+typedef struct tagPyramidBuilder
+{
+    YAPP_PYR_HEADER *pstHeader;
+    FILE *pFPyr;
+    int iRecLen;                /* length of a record, in floats */
+    float *pfMin;               /* minimum of each channel, per level */
+    float *pfMax;               /* maximum of each channel, per level */
+    double *pdSum;              /* sum of each channel, per level */
+    long alNumSamps[YAPP_PYR_MAXLEVELS];
+                                /* number of samples accumulated */
+    int aiNumInputs[YAPP_PYR_MAXLEVELS];
+                                /* number of spectra or records accumulated */
+    float *pfOut;               /* completed records, per level */
+    int iBufRecs;               /* capacity of the buffer of a level, in
+                                   records */
+    int aiNumBuffered[YAPP_PYR_MAXLEVELS];
+    long alNumRecs[YAPP_PYR_MAXLEVELS];
+                                /* number of records written */
+    off_t alOffset[YAPP_PYR_MAXLEVELS];
+                                /* offset of each level in the file */
+    int iRet;                   /* set if writing has failed */
+} YAPP_PYR_BUILDER;
+
+/**
+ * Open the pyramid of a data file, building it first if it does not exist or
+ * is out of date. The pyramid is looked for next to the data file, then in
+ * the cache directory, and built next to the data file if its directory is
+ * writable, and in the cache directory otherwise. The cache directory is
+ * $XDG_CACHE_HOME/yapp, or ~/.cache/yapp, and must belong to the user.
+ *
+ * @param[out]      pstPyr          Pyramid
+ * @param[in]       pcFileData      Data filename
+ * @param[in]       pFData          Data stream, positioned at the start of the
+ *                                  data, used only if the pyramid is built
+ * @param[in]       pstYUM          Metadata of the data
+ * @param[in]       iMaxRecs        Maximum number of records read at a time
+ */
+int YAPP_PYR_Open(YAPP_PYR *pstPyr,
+                  char *pcFileData,
+                  FILE *pFData,
+                  YUM_t *pstYUM,
+                  int iMaxRecs);
+
+/**
+ * Build the pyramid of a data file, in one pass over the data. The pyramid is
+ * written to a new temporary file, readable and writable only by the user,
+ * next to the pyramid file, which is renamed to the pyramid file once
+ * complete, replacing any file or symbolic link of that name.
+ *
+ * @param[in]       pcFilePyr       Pyramid filename
+ * @param[in]       pFData          Data stream, positioned at the start of the
+ *                                  data
+ * @param[in]       pstYUM          Metadata of the data
+ * @param[in]       pstHeader       Pyramid header, with all but the levels
+ *                                  set
+ */
+int YAPP_PYR_Build(char *pcFilePyr,
+                   FILE *pFData,
+                   YUM_t *pstYUM,
+                   YAPP_PYR_HEADER *pstHeader);
+
+/**
+ * Get the level corresponding to a decimation factor
+ *
+ * @param[in]       pstPyr          Pyramid
+ * @param[in]       iFactor         Decimation factor, a power of two
+ */
+int YAPP_PYR_GetLevel(YAPP_PYR *pstPyr, int iFactor);
+
+/**
+ * Read consecutive records of a level, as three arrays of spectra
+ *
+ * @param[inout]    pstPyr          Pyramid
+ * @param[in]       iLevel          Level
+ * @param[in]       lFirstRec       First record to read
+ * @param[in]       iNumRecs        Number of records to read, not more than
+ *                                  the maximum given to YAPP_PYR_Open()
+ * @param[out]      pfMin           Minima, or NULL
+ * @param[out]      pfMax           Maxima, or NULL
+ * @param[out]      pfMean          Means, or NULL
+ */
+int YAPP_PYR_Read(YAPP_PYR *pstPyr,
+                  int iLevel,
+                  long lFirstRec,
+                  int iNumRecs,
+                  float *pfMin,
+                  float *pfMax,
+                  float *pfMean);
+
+/**
+ * Close a pyramid
+ *
+ * @param[inout]    pstPyr          Pyramid
+ */
+int YAPP_PYR_Close(YAPP_PYR *pstPyr);
+
+#endif  /* __YAPP_PYRAMID_H__ */
@@ -0,0 +1,278 @@
+/*
+ * @file yapp_querycands.c
+ * Program to look up candidates in a candidate database, by time, DM, S/N,
+ *  type and beam.
+ *
+ * @verbatim
+ * Usage: yapp_querycands [options] <database-file>
+ *     -h  --help                           Display this usage information
+ *     -a  --from <mjd>                     Start of the time range, in MJD
+ *                                          (default is no limit)
+ *     -b  --to <mjd>                       End of the time range, in MJD
+ *                                          (default is no limit)
+ *     -l  --dmlo <dm>                      Lowest DM
+ *                                          (default is no limit)
+ *     -u  --dmhi <dm>                      Highest DM
+ *                                          (default is no limit)
+ *     -t  --threshold <snr>                Lowest S/N
+ *                                          (default is no limit)
+ *     -y  --type <type>                    Candidate type, 'sp' for single
+ *                                          pulses or 'period' for
+ *                                          periodicity candidates
+ *                                          (default is both)
+ *     -m  --beam <beamid>                  Beam identifier
+ *                                          (default is all beams)
+ *     -c  --count                          Print only the number of
+ *                                          candidates found
+ *     -v  --version                        Display the version @endverbatim
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_canddb.h"
+
+/**
+ * The build version string, maintained in the file version.c, which is
+ * generated by makever.c.
+ */
+extern const char *g_pcVersion;
+
+static int PrintCand(YAPP_CDB_CAND *pstCand, void *pvArg);
+static int CountCand(YAPP_CDB_CAND *pstCand, void *pvArg);
+
+int main(int argc, char *argv[])
+{
+    char *pcFileDB = NULL;
+    YAPP_CDB_QUERY stQuery = {0};
+    char cCountOnly = YAPP_FALSE;
+    long lNumFound = 0;
+    const char *pcProgName = NULL;
+    int iNextOpt = 0;
+    /* valid short options */
+    const char* const pcOptsShort = "ha:b:l:u:t:y:m:cv";
+    /* valid long options */
+    const struct option stOptsLong[] = {
+        { "help",                   0, NULL, 'h' },
+        { "from",                   1, NULL, 'a' },
+        { "to",                     1, NULL, 'b' },
+        { "dmlo",                   1, NULL, 'l' },
+        { "dmhi",                   1, NULL, 'u' },
+        { "threshold",              1, NULL, 't' },
+        { "type",                   1, NULL, 'y' },
+        { "beam",                   1, NULL, 'm' },
+        { "count",                  0, NULL, 'c' },
+        { "version",                0, NULL, 'v' },
+        { NULL,                     0, NULL, 0   }
+    };
+
+    YAPP_CDB_InitQuery(&stQuery);
+
+    /* get the filename of the program from the argument list */
+    pcProgName = argv[0];
+
+    /* parse the input */
+    do
+    {
+        iNextOpt = getopt_long(argc, argv, pcOptsShort, stOptsLong, NULL);
+        switch (iNextOpt)
+        {
+            case 'h':   /* -h or --help */
+                /* print usage info and terminate */
+                PrintUsage(pcProgName);
+                return YAPP_RET_SUCCESS;
+
+            case 'a':   /* -a or --from */
+                /* set option */
+                stQuery.dMJDLo = atof(optarg);
+                break;
+
+            case 'b':   /* -b or --to */
+                /* set option */
+                stQuery.dMJDHi = atof(optarg);
+                break;
+
+            case 'l':   /* -l or --dmlo */
+                /* set option */
+                stQuery.fDMLo = atof(optarg);
+                break;
+
+            case 'u':   /* -u or --dmhi */
+                /* set option */
+                stQuery.fDMHi = atof(optarg);
+                break;
+
+            case 't':   /* -t or --threshold */
+                /* set option */
+                stQuery.fSNRMin = atof(optarg);
+                break;
+
+            case 'y':   /* -y or --type */
+                /* set option */
+                if (0 == strcmp(optarg, "sp"))
+                {
+                    stQuery.iTypes = YAPP_CDB_TYPE_SP;
+                }
+                else if (0 == strcmp(optarg, "period"))
+                {
+                    stQuery.iTypes = YAPP_CDB_TYPE_PERIOD;
+                }
+                else
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Candidate type must be 'sp' or "
+                                   "'period'!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'm':   /* -m or --beam */
+                /* set option */
+                stQuery.iBeam = atoi(optarg);
+                /* validate */
+                if (stQuery.iBeam < 0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Beam identifier must be >= 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'c':   /* -c or --count */
+                /* set option */
+                cCountOnly = YAPP_TRUE;
+                break;
+
+            case 'v':   /* -v or --version */
+                /* display the version */
+                (void) printf("%s\n", g_pcVersion);
+                return YAPP_RET_SUCCESS;
+
+            case '?':   /* user specified an invalid option */
+                /* print usage info and terminate with error */
+                (void) fprintf(stderr, "ERROR: Invalid option!\n");
+                PrintUsage(pcProgName);
+                return YAPP_RET_ERROR;
+
+            case -1:    /* done with options */
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+    } while (iNextOpt != -1);
+
+    /* no arguments */
+    if (argc <= optind)
+    {
+        (void) fprintf(stderr, "ERROR: Input file not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    pcFileDB = argv[optind];
+
+    if (cCountOnly)
+    {
+        lNumFound = YAPP_CDB_Query(pcFileDB, &stQuery, CountCand, NULL);
+        if (YAPP_RET_ERROR == lNumFound)
+        {
+            return YAPP_RET_ERROR;
+        }
+        (void) printf("%ld\n", lNumFound);
+    }
+    else
+    {
+        (void) printf("# MJD  Type  DM (cm^-3 pc)  S/N  Width/Period (s)  "
+                      "Beam\n");
+        lNumFound = YAPP_CDB_Query(pcFileDB, &stQuery, PrintCand, NULL);
+        if (YAPP_RET_ERROR == lNumFound)
+        {
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Print a candidate found by a query
+ */
+static int PrintCand(YAPP_CDB_CAND *pstCand, void *pvArg)
+{
+    (void) printf("%.10f %s %g %g %.10g %d\n",
+                  pstCand->dMJD,
+                  (YAPP_CDB_TYPE_SP == pstCand->cType) ? "sp" : "period",
+                  pstCand->fDM,
+                  pstCand->fSNR,
+                  pstCand->dParam,
+                  pstCand->iBeam);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Count a candidate found by a query - the query itself keeps count
+ */
+static int CountCand(YAPP_CDB_CAND *pstCand, void *pvArg)
+{
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Prints usage information
+ */
+void PrintUsage(const char *pcProgName)
+{
+    (void) printf("Usage: %s [options] <database-file>\n",
+                  pcProgName);
+    (void) printf("    -h  --help                          ");
+    (void) printf("Display this usage information\n");
+    (void) printf("    -a  --from <mjd>                    ");
+    (void) printf("Start of the time range, in MJD\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no limit)\n");
+    (void) printf("    -b  --to <mjd>                      ");
+    (void) printf("End of the time range, in MJD\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no limit)\n");
+    (void) printf("    -l  --dmlo <dm>                     ");
+    (void) printf("Lowest DM\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no limit)\n");
+    (void) printf("    -u  --dmhi <dm>                     ");
+    (void) printf("Highest DM\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no limit)\n");
+    (void) printf("    -t  --threshold <snr>               ");
+    (void) printf("Lowest S/N\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no limit)\n");
+    (void) printf("    -y  --type <type>                   ");
+    (void) printf("Candidate type, 'sp' for single\n");
+    (void) printf("                                        ");
+    (void) printf("pulses or 'period' for\n");
+    (void) printf("                                        ");
+    (void) printf("periodicity candidates\n");
+    (void) printf("                                        ");
+    (void) printf("(default is both)\n");
+    (void) printf("    -m  --beam <beamid>                 ");
+    (void) printf("Beam identifier\n");
+    (void) printf("                                        ");
+    (void) printf("(default is all beams)\n");
+    (void) printf("    -c  --count                         ");
+    (void) printf("Print only the number of\n");
+    (void) printf("                                        ");
+    (void) printf("candidates found\n");
+    (void) printf("    -v  --version                       ");
+    (void) printf("Display the version\n");
+
+    return;
+}
+
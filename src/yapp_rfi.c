@@ -0,0 +1,663 @@
+/*
+ * @file yapp_rfi.c
+ * RFI excision routines. Each block of filterbank data is cleaned as it is
+ *  read - channels whose spectral kurtosis is an outlier among the channels
+ *  are flagged, the zero-DM time series is optionally subtracted, and
+ *  samples whose zero-DM value is an outlier are flagged. Outliers are
+ *  judged against the median and the median absolute deviation, so that the
+ *  RFI itself does not inflate the threshold. The flags of each block are
+ *  written to a mask file, which can be read back and applied to the data,
+ *  block by block, as they are read.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_rfi.h"
+
+static void FlagOutliers(float *pfVal,
+                         int iLength,
+                         float *pfScratch,
+                         float fThreshold,
+                         float *pfIsValid,
+                         unsigned char *pcMask);
+static unsigned char* FindRecord(YAPP_RFI_MASK *pstMask, long lSamp);
+
+/*
+ * Initialise RFI excision
+ */
+int YAPP_RFI_Init(YAPP_RFI *pstRFI,
+                  int iNumChans,
+                  int iBlockSize,
+                  float fThreshold,
+                  char cZeroDM,
+                  char *pcFileMask,
+                  double dTSamp,
+                  double dTStart)
+{
+    YAPP_RFI_MASKHEADER stHeader = {{0}};
+
+    pstRFI->iNumChans = iNumChans;
+    pstRFI->iBlockSize = iBlockSize;
+    pstRFI->fThreshold = fThreshold;
+    pstRFI->cZeroDM = cZeroDM;
+    pstRFI->lNumChanFlags = 0;
+    pstRFI->lNumSampFlags = 0;
+    pstRFI->pFMask = NULL;
+
+    pstRFI->pdSum = (double *) YAPP_Malloc(iNumChans,
+                                           sizeof(double),
+                                           YAPP_FALSE);
+    pstRFI->pdSumSq = (double *) YAPP_Malloc(iNumChans,
+                                             sizeof(double),
+                                             YAPP_FALSE);
+    pstRFI->pfMean = (float *) YAPP_Malloc(iNumChans,
+                                           sizeof(float),
+                                           YAPP_FALSE);
+    pstRFI->pfSK = (float *) YAPP_Malloc(iNumChans,
+                                         sizeof(float),
+                                         YAPP_FALSE);
+    pstRFI->pfKeep = (float *) YAPP_Malloc(iNumChans,
+                                           sizeof(float),
+                                           YAPP_FALSE);
+    pstRFI->pfSub = (float *) YAPP_Malloc(iNumChans,
+                                          sizeof(float),
+                                          YAPP_FALSE);
+    pstRFI->pfFill = (float *) YAPP_Malloc(iNumChans,
+                                           sizeof(float),
+                                           YAPP_FALSE);
+    pstRFI->pfZeroDM = (float *) YAPP_Malloc(iBlockSize,
+                                             sizeof(float),
+                                             YAPP_FALSE);
+    pstRFI->pfScratch = (float *) YAPP_Malloc((iNumChans > iBlockSize)
+                                              ? iNumChans : iBlockSize,
+                                              sizeof(float),
+                                              YAPP_FALSE);
+    pstRFI->pcChanMask = (unsigned char *) YAPP_Malloc((iNumChans + 7) / 8,
+                                                       sizeof(unsigned char),
+                                                       YAPP_TRUE);
+    pstRFI->pcSampMask = (unsigned char *) YAPP_Malloc((iBlockSize + 7) / 8,
+                                                       sizeof(unsigned char),
+                                                       YAPP_TRUE);
+    if ((NULL == pstRFI->pdSum) || (NULL == pstRFI->pdSumSq)
+        || (NULL == pstRFI->pfMean) || (NULL == pstRFI->pfSK)
+        || (NULL == pstRFI->pfKeep) || (NULL == pstRFI->pfSub)
+        || (NULL == pstRFI->pfFill) || (NULL == pstRFI->pfZeroDM)
+        || (NULL == pstRFI->pfScratch) || (NULL == pstRFI->pcChanMask)
+        || (NULL == pstRFI->pcSampMask))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    if (pcFileMask != NULL)
+    {
+        pstRFI->pFMask = fopen(pcFileMask, "w");
+        if (NULL == pstRFI->pFMask)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed! %s.\n",
+                           pcFileMask,
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+        (void) memcpy(stHeader.acMagic,
+                      YAPP_RFI_MAGIC,
+                      sizeof(stHeader.acMagic));
+        stHeader.iNumChans = iNumChans;
+        stHeader.iBlockSize = iBlockSize;
+        stHeader.dTSamp = dTSamp;
+        stHeader.dTStart = dTStart;
+        if (fwrite(&stHeader, sizeof(stHeader), 1, pstRFI->pFMask) != 1)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Writing mask file header failed!\n");
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Excise RFI from a block of filterbank data
+ */
+int YAPP_RFI_Clean(YAPP_RFI *pstRFI,
+                   float *pfBuf,
+                   int iNumSamps,
+                   char *pcIsChanGood,
+                   long lFirstSamp)
+{
+    int iNumChans = pstRFI->iNumChans;
+    double *pdSum = pstRFI->pdSum;
+    double *pdSumSq = pstRFI->pdSumSq;
+    float *pfMean = pstRFI->pfMean;
+    float *pfKeep = pstRFI->pfKeep;
+    float *pfSub = pstRFI->pfSub;
+    float *pfFill = pstRFI->pfFill;
+    float *pfZeroDM = pstRFI->pfZeroDM;
+    float *pfSpectrum = NULL;
+    float fZeroDM = 0.0;
+    int iNumSubChans = 0;
+    int64_t lFirst = lFirstSamp;
+    int32_t aiRec[2] = {0};
+    int i = 0;
+    int j = 0;
+
+    if (iNumSamps < 2)
+    {
+        return YAPP_RET_SUCCESS;
+    }
+
+    (void) memset(pstRFI->pcChanMask, '\0', (iNumChans + 7) / 8);
+    (void) memset(pstRFI->pcSampMask, '\0', (pstRFI->iBlockSize + 7) / 8);
+
+    /* accumulate the sums and sums of squares of all channels - the inner
+       loops run over contiguous channels, so that they can be vectorised */
+    (void) memset(pdSum, '\0', sizeof(double) * iNumChans);
+    (void) memset(pdSumSq, '\0', sizeof(double) * iNumChans);
+    for (i = 0; i < iNumSamps; ++i)
+    {
+        pfSpectrum = pfBuf + i * iNumChans;
+        for (j = 0; j < iNumChans; ++j)
+        {
+            pdSum[j] += pfSpectrum[j];
+            pdSumSq[j] += (double) pfSpectrum[j] * pfSpectrum[j];
+        }
+    }
+
+    /* compute the spectral kurtosis estimator
+       SK = ((M + 1) / (M - 1)) * ((M * S2 / S1^2) - 1) of each good channel,
+       and flag the channels whose SK is an outlier - as the number of
+       spectra accumulated into a sample is not known, the SK of a channel is
+       compared with that of the other channels, rather than with its
+       expected value */
+    for (j = 0; j < iNumChans; ++j)
+    {
+        pfMean[j] = pdSum[j] / iNumSamps;
+        pfKeep[j] = (pcIsChanGood[j] && (pdSum[j] != 0.0)) ? 1.0 : 0.0;
+        if (pfKeep[j] != 0.0)
+        {
+            pstRFI->pfSK[j] = ((iNumSamps + 1.0) / (iNumSamps - 1.0))
+                              * (((iNumSamps * pdSumSq[j])
+                                  / (pdSum[j] * pdSum[j])) - 1.0);
+        }
+    }
+    if (pstRFI->fThreshold > 0.0)
+    {
+        FlagOutliers(pstRFI->pfSK,
+                     iNumChans,
+                     pstRFI->pfScratch,
+                     pstRFI->fThreshold,
+                     pfKeep,
+                     pstRFI->pcChanMask);
+    }
+    for (j = 0; j < iNumChans; ++j)
+    {
+        if (pcIsChanGood[j] && (0.0 == pfKeep[j]))
+        {
+            /* flagged by spectral kurtosis, or all zero */
+            pstRFI->pcChanMask[j/8] |= (1 << (j % 8));
+            pfFill[j] = pfMean[j];
+            pfSub[j] = 0.0;
+            ++pstRFI->lNumChanFlags;
+        }
+        else
+        {
+            pfFill[j] = 0.0;
+            pfSub[j] = pcIsChanGood[j] ? 1.0 : 0.0;
+            pfKeep[j] = 1.0;
+            iNumSubChans += (int) pfSub[j];
+        }
+    }
+    if (0 == iNumSubChans)
+    {
+        iNumSubChans = 1;
+    }
+
+    /* compute the zero-DM time series - the mean over the unflagged good
+       channels, of the data less the channel means */
+    for (i = 0; i < iNumSamps; ++i)
+    {
+        pfSpectrum = pfBuf + i * iNumChans;
+        fZeroDM = 0.0;
+        for (j = 0; j < iNumChans; ++j)
+        {
+            fZeroDM += pfSub[j] * (pfSpectrum[j] - pfMean[j]);
+        }
+        pfZeroDM[i] = fZeroDM / iNumSubChans;
+    }
+
+    /* flag the samples whose zero-DM value is an outlier */
+    if (pstRFI->fThreshold > 0.0)
+    {
+        FlagOutliers(pfZeroDM,
+                     iNumSamps,
+                     pstRFI->pfScratch,
+                     pstRFI->fThreshold,
+                     NULL,
+                     pstRFI->pcSampMask);
+    }
+
+    /* replace flagged samples with the channel means, and subtract the
+       zero-DM time series from the rest, if required - pfKeep, pfSub and
+       pfFill are (0, 0, mean) for flagged channels, (1, 1, 0) for unflagged
+       good channels and (1, 0, 0) for channels that were bad to begin with,
+       so that each row is updated without branches */
+    for (i = 0; i < iNumSamps; ++i)
+    {
+        pfSpectrum = pfBuf + i * iNumChans;
+        if (pstRFI->pcSampMask[i/8] & (1 << (i % 8)))
+        {
+            for (j = 0; j < iNumChans; ++j)
+            {
+                pfSpectrum[j] = ((pfKeep[j] - pfSub[j]) * pfSpectrum[j])
+                                + (pfSub[j] * pfMean[j]) + pfFill[j];
+            }
+            ++pstRFI->lNumSampFlags;
+            continue;
+        }
+        fZeroDM = pstRFI->cZeroDM ? pfZeroDM[i] : 0.0;
+        for (j = 0; j < iNumChans; ++j)
+        {
+            pfSpectrum[j] = (pfKeep[j] * pfSpectrum[j]) - (pfSub[j] * fZeroDM)
+                            + pfFill[j];
+        }
+    }
+    /* write the mask record of the block */
+    if (pstRFI->pFMask != NULL)
+    {
+        aiRec[0] = iNumSamps;
+        if ((fwrite(&lFirst, sizeof(lFirst), 1, pstRFI->pFMask) != 1)
+            || (fwrite(aiRec, sizeof(aiRec), 1, pstRFI->pFMask) != 1)
+            || (fwrite(pstRFI->pcChanMask,
+                       (iNumChans + 7) / 8,
+                       1,
+                       pstRFI->pFMask) != 1)
+            || (fwrite(pstRFI->pcSampMask,
+                       (pstRFI->iBlockSize + 7) / 8,
+                       1,
+                       pstRFI->pFMask) != 1))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Writing mask file failed!\n");
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Close the mask file
+ */
+int YAPP_RFI_Close(YAPP_RFI *pstRFI)
+{
+    if (pstRFI->pFMask != NULL)
+    {
+        if (fclose(pstRFI->pFMask) != 0)
+        {
+            pstRFI->pFMask = NULL;
+            (void) fprintf(stderr,
+                           "ERROR: Closing mask file failed! %s.\n",
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+        pstRFI->pFMask = NULL;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Read a mask file
+ */
+int YAPP_RFI_ReadMask(YAPP_RFI_MASK *pstMask,
+                      char *pcFileMask,
+                      int iNumChans,
+                      double dTSamp)
+{
+    FILE *pFMask = NULL;
+    long lFileSize = 0;
+
+    pFMask = fopen(pcFileMask, "r");
+    if (NULL == pFMask)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileMask,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    if ((fread(&pstMask->stHeader,
+               sizeof(YAPP_RFI_MASKHEADER),
+               1,
+               pFMask) != 1)
+        || (memcmp(pstMask->stHeader.acMagic,
+                   YAPP_RFI_MAGIC,
+                   sizeof(pstMask->stHeader.acMagic)) != 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid mask file %s!\n",
+                       pcFileMask);
+        (void) fclose(pFMask);
+        return YAPP_RET_ERROR;
+    }
+    if ((pstMask->stHeader.iNumChans != iNumChans)
+        || (fabs(pstMask->stHeader.dTSamp - dTSamp) > (1e-6 * dTSamp)))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Mask file %s does not match the data!\n",
+                       pcFileMask);
+        (void) fclose(pFMask);
+        return YAPP_RET_ERROR;
+    }
+
+    /* read all the block records */
+    pstMask->iRecSize = YAPP_RFI_RECHDRSIZE
+                        + ((iNumChans + 7) / 8)
+                        + ((pstMask->stHeader.iBlockSize + 7) / 8);
+    (void) fseek(pFMask, 0, SEEK_END);
+    lFileSize = ftell(pFMask);
+    pstMask->iNumRecs = (lFileSize - (long) sizeof(YAPP_RFI_MASKHEADER))
+                        / pstMask->iRecSize;
+    pstMask->iRec = 0;
+    pstMask->lNumFlags = 0;
+    pstMask->pcRecs = (unsigned char *) YAPP_Malloc(
+                                    (size_t) pstMask->iNumRecs + 1,
+                                    pstMask->iRecSize,
+                                    YAPP_FALSE);
+    pstMask->pfKeep = (float *) YAPP_Malloc(iNumChans,
+                                            sizeof(float),
+                                            YAPP_FALSE);
+    pstMask->pdSum = (double *) YAPP_Malloc(iNumChans,
+                                            sizeof(double),
+                                            YAPP_FALSE);
+    pstMask->piCount = (int *) YAPP_Malloc(iNumChans,
+                                           sizeof(int),
+                                           YAPP_FALSE);
+    if ((NULL == pstMask->pcRecs) || (NULL == pstMask->pfKeep)
+        || (NULL == pstMask->pdSum) || (NULL == pstMask->piCount))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) fclose(pFMask);
+        return YAPP_RET_ERROR;
+    }
+    (void) fseek(pFMask, sizeof(YAPP_RFI_MASKHEADER), SEEK_SET);
+    if (fread(pstMask->pcRecs,
+              pstMask->iRecSize,
+              pstMask->iNumRecs,
+              pFMask) != (size_t) pstMask->iNumRecs)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Reading mask file %s failed!\n",
+                       pcFileMask);
+        (void) fclose(pFMask);
+        return YAPP_RET_ERROR;
+    }
+    (void) fclose(pFMask);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Apply a mask to a block of filterbank data
+ */
+void YAPP_RFI_ApplyMask(YAPP_RFI_MASK *pstMask,
+                        float *pfBuf,
+                        int iNumSamps,
+                        long lFirstSamp)
+{
+    int iNumChans = pstMask->stHeader.iNumChans;
+    float *pfKeep = pstMask->pfKeep;
+    double *pdSum = pstMask->pdSum;
+    int *piCount = pstMask->piCount;
+    unsigned char *pcRec = NULL;
+    unsigned char *pcRecPrev = NULL;
+    unsigned char *pcChanMask = NULL;
+    unsigned char *pcSampMask = NULL;
+    int64_t lRecFirst = 0;
+    float *pfSpectrum = NULL;
+    float fMean = 0.0;
+    int iPass = 0;
+    long l = 0;
+    int i = 0;
+    int j = 0;
+
+    (void) memset(pdSum, '\0', sizeof(double) * iNumChans);
+    (void) memset(piCount, '\0', sizeof(int) * iNumChans);
+
+    /* in the first pass, accumulate the unflagged samples of each channel,
+       and in the second, replace the flagged samples with the channel
+       means - the channel flags are expanded into pfKeep whenever the
+       record changes, so that the inner loops are free of bit operations */
+    for (iPass = 0; iPass < 2; ++iPass)
+    {
+        if (1 == iPass)
+        {
+            /* a channel flagged for the whole block is replaced with its
+               mean over all samples of the block, as YAPP_RFI_Clean() does,
+               rather than with zeros */
+            for (j = 0; j < iNumChans; ++j)
+            {
+                if (0 == piCount[j])
+                {
+                    for (i = 0; i < iNumSamps; ++i)
+                    {
+                        pdSum[j] += pfBuf[i*iNumChans+j];
+                    }
+                    piCount[j] = iNumSamps;
+                }
+            }
+        }
+
+        pcRecPrev = NULL;
+        for (i = 0; i < iNumSamps; ++i)
+        {
+            pfSpectrum = pfBuf + i * iNumChans;
+            pcRec = FindRecord(pstMask, lFirstSamp + i);
+            if (NULL == pcRec)
+            {
+                /* not covered by the mask */
+                if (0 == iPass)
+                {
+                    for (j = 0; j < iNumChans; ++j)
+                    {
+                        pdSum[j] += pfSpectrum[j];
+                        ++piCount[j];
+                    }
+                }
+                continue;
+            }
+            if (pcRec != pcRecPrev)
+            {
+                pcChanMask = pcRec + YAPP_RFI_RECHDRSIZE;
+                pcSampMask = pcChanMask + ((iNumChans + 7) / 8);
+                for (j = 0; j < iNumChans; ++j)
+                {
+                    pfKeep[j] = (pcChanMask[j/8] & (1 << (j % 8))) ? 0.0 : 1.0;
+                }
+                (void) memcpy(&lRecFirst, pcRec, sizeof(lRecFirst));
+                pcRecPrev = pcRec;
+            }
+
+            l = lFirstSamp + i - lRecFirst;
+            if (pcSampMask[l/8] & (1 << (l % 8)))
+            {
+                /* the whole sample is flagged */
+                if (1 == iPass)
+                {
+                    for (j = 0; j < iNumChans; ++j)
+                    {
+                        pfSpectrum[j] = pdSum[j] / piCount[j];
+                    }
+                    pstMask->lNumFlags += iNumChans;
+                }
+                continue;
+            }
+
+            if (0 == iPass)
+            {
+                for (j = 0; j < iNumChans; ++j)
+                {
+                    pdSum[j] += pfKeep[j] * pfSpectrum[j];
+                    piCount[j] += (int) pfKeep[j];
+                }
+            }
+            else
+            {
+                for (j = 0; j < iNumChans; ++j)
+                {
+                    if (0.0 == pfKeep[j])
+                    {
+                        fMean = pdSum[j] / piCount[j];
+                        pfSpectrum[j] = fMean;
+                        ++pstMask->lNumFlags;
+                    }
+                }
+            }
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * Find the record of the block of a mask that contains a sample, or return
+ * NULL if there is none - lookups are usually of the same or the next
+ * record, so these are tried before a binary search
+ */
+static unsigned char* FindRecord(YAPP_RFI_MASK *pstMask, long lSamp)
+{
+    unsigned char *pcRec = NULL;
+    int64_t lFirst = 0;
+    int32_t iNumSamps = 0;
+    int iLo = 0;
+    int iHi = 0;
+    int iMid = 0;
+    int i = 0;
+
+    if (0 == pstMask->iNumRecs)
+    {
+        return NULL;
+    }
+
+    for (i = pstMask->iRec;
+         (i < (pstMask->iRec + 2)) && (i < pstMask->iNumRecs);
+         ++i)
+    {
+        pcRec = pstMask->pcRecs + ((size_t) i * pstMask->iRecSize);
+        (void) memcpy(&lFirst, pcRec, sizeof(lFirst));
+        (void) memcpy(&iNumSamps, pcRec + sizeof(lFirst), sizeof(iNumSamps));
+        if ((lSamp >= lFirst) && (lSamp < (lFirst + iNumSamps)))
+        {
+            pstMask->iRec = i;
+            return pcRec;
+        }
+    }
+
+    /* find the last record that starts at or before the sample */
+    iLo = 0;
+    iHi = pstMask->iNumRecs - 1;
+    while (iLo < iHi)
+    {
+        iMid = (iLo + iHi + 1) / 2;
+        pcRec = pstMask->pcRecs + ((size_t) iMid * pstMask->iRecSize);
+        (void) memcpy(&lFirst, pcRec, sizeof(lFirst));
+        if (lFirst <= lSamp)
+        {
+            iLo = iMid;
+        }
+        else
+        {
+            iHi = iMid - 1;
+        }
+    }
+    pcRec = pstMask->pcRecs + ((size_t) iLo * pstMask->iRecSize);
+    (void) memcpy(&lFirst, pcRec, sizeof(lFirst));
+    (void) memcpy(&iNumSamps, pcRec + sizeof(lFirst), sizeof(iNumSamps));
+    if ((lSamp >= lFirst) && (lSamp < (lFirst + iNumSamps)))
+    {
+        pstMask->iRec = iLo;
+        return pcRec;
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Flag the values that differ from the median by more than fThreshold times
+ * the median absolute deviation, scaled to sigmas - if pfIsValid is not
+ * NULL, only values for which it is non-zero are considered, and it is set
+ * to 0 for the values flagged
+ */
+static void FlagOutliers(float *pfVal,
+                         int iLength,
+                         float *pfScratch,
+                         float fThreshold,
+                         float *pfIsValid,
+                         unsigned char *pcMask)
+{
+    float fMedian = 0.0;
+    float fMAD = 0.0;
+    int iNumValid = 0;
+    int i = 0;
+
+    for (i = 0; i < iLength; ++i)
+    {
+        if ((NULL == pfIsValid) || (pfIsValid[i] != 0.0))
+        {
+            pfScratch[iNumValid] = pfVal[i];
+            ++iNumValid;
+        }
+    }
+    if (iNumValid < 2)
+    {
+        return;
+    }
+    fMedian = YAPP_CalcMedian(pfScratch, iNumValid);
+    iNumValid = 0;
+    for (i = 0; i < iLength; ++i)
+    {
+        if ((NULL == pfIsValid) || (pfIsValid[i] != 0.0))
+        {
+            pfScratch[iNumValid] = fabsf(pfVal[i] - fMedian);
+            ++iNumValid;
+        }
+    }
+    fMAD = YAPP_CalcMedian(pfScratch, iNumValid);
+    /* a MAD of 0 means that most values are identical, such as in
+       zero-filled data, in which case nothing is flagged */
+    if (0.0 == fMAD)
+    {
+        return;
+    }
+
+    for (i = 0; i < iLength; ++i)
+    {
+        if (((NULL == pfIsValid) || (pfIsValid[i] != 0.0))
+            && (fabsf(pfVal[i] - fMedian)
+                > (fThreshold * YAPP_RFI_MAD2SIGMA * fMAD)))
+        {
+            pcMask[i/8] |= (1 << (i % 8));
+            if (pfIsValid != NULL)
+            {
+                pfIsValid[i] = 0.0;
+            }
+        }
+    }
+
+    return;
+}
+
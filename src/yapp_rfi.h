@@ -0,0 +1,184 @@
+/**
+ * @file yapp_rfi.h
+ * Header file for the RFI excision routines - spectral kurtosis flagging of
+ *  channels, zero-DM subtraction, and clipping of broadband impulses, applied
+ *  to filterbank data block by block as it is read, and the writing and
+ *  applying of RFI mask files
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_RFI_H__
+#define __YAPP_RFI_H__
+
+#include <stdint.h>
+
+#define EXT_YAPP_RFIMASK        ".ymsk" /* RFI mask */
+
+#define YAPP_RFI_MAGIC          "YRM1"  /* identifies an RFI mask file, and
+                                           its version */
+#define YAPP_RFI_MAD2SIGMA      1.4826  /* ratio of the standard deviation
+                                           to the median absolute deviation,
+                                           for Gaussian noise */
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_RFI_THRESH          5.0     /**< @brief Default RFI threshold, in
+                                             sigmas */
+/* @} */
+
+/* size of a block record in a mask file, excluding the bitmaps */
+#define YAPP_RFI_RECHDRSIZE     (sizeof(int64_t) + sizeof(int32_t)            \
+                                 + sizeof(int32_t))
+
+/**
+ * RFI mask file header - the header is followed by one record per block of
+ * data, consisting of the first sample of the block (int64_t), the number of
+ * samples in the block (int32_t), a reserved field (int32_t), a bitmap of the
+ * flagged channels, (iNumChans + 7) / 8 bytes long, and a bitmap of the
+ * flagged samples, (iBlockSize + 7) / 8 bytes long. A sample of a channel is
+ * flagged if either the channel or the sample is flagged. Bit i of a bitmap
+ * is bit (i % 8) of byte (i / 8).
+ */
+typedef struct tagRFIMaskHeader
+{
+    char acMagic[4];        /* YAPP_RFI_MAGIC */
+    int32_t iNumChans;
+    int32_t iBlockSize;     /* maximum number of samples in a block */
+    int32_t iReserved;
+    double dTSamp;          /* in s */
+    double dTStart;         /* in MJD */
+} YAPP_RFI_MASKHEADER;
+
+/**
+ * RFI excision state
+ */
+typedef struct tagRFI
+{
+    int iNumChans;
+    int iBlockSize;
+    float fThreshold;           /* in sigmas, or 0 for no flagging */
+    char cZeroDM;               /* subtract the zero-DM time series */
+    double *pdSum;              /* sum of each channel */
+    double *pdSumSq;            /* sum of squares of each channel */
+    float *pfMean;              /* mean of each channel */
+    float *pfSK;                /* spectral kurtosis of each channel */
+    float *pfKeep;              /* 1 for unflagged channels, 0 otherwise */
+    float *pfSub;               /* 1 for channels from which the zero-DM
+                                   time series is subtracted, 0 otherwise */
+    float *pfFill;              /* value that replaces flagged samples of
+                                   each channel, 0 for unflagged channels */
+    float *pfZeroDM;            /* zero-DM time series of the block */
+    float *pfScratch;           /* median scratch buffer */
+    unsigned char *pcChanMask;  /* bitmap of flagged channels */
+    unsigned char *pcSampMask;  /* bitmap of flagged samples */
+    FILE *pFMask;               /* mask file, or NULL */
+    long lNumChanFlags;         /* number of channel-blocks flagged */
+    long lNumSampFlags;         /* number of samples flagged */
+} YAPP_RFI;
+
+/**
+ * RFI mask, read from a mask file, to be applied to data as it is read
+ */
+typedef struct tagRFIMask
+{
+    YAPP_RFI_MASKHEADER stHeader;
+    int iNumRecs;
+    int iRecSize;               /* size of a block record, in bytes */
+    unsigned char *pcRecs;      /* all block records */
+    int iRec;                   /* record found by the last lookup */
+    float *pfKeep;              /* 1 for channels not flagged in iRec, 0
+                                   otherwise */
+    double *pdSum;              /* sum of the unflagged samples of each
+                                   channel */
+    int *piCount;               /* number of unflagged samples of each
+                                   channel */
+    long lNumFlags;             /* number of samples of channels flagged */
+} YAPP_RFI_MASK;
+
+/**
+ * Initialise RFI excision, and open the mask file, if any
+ *
+ * @param[out]      pstRFI          RFI excision state
+ * @param[in]       iNumChans       Number of channels
+ * @param[in]       iBlockSize      Maximum number of samples in a block
+ * @param[in]       fThreshold      Threshold in sigmas, or 0 for no flagging
+ * @param[in]       cZeroDM         Subtract the zero-DM time series
+ * @param[in]       pcFileMask      Mask filename, or NULL
+ * @param[in]       dTSamp          Sampling interval, in s
+ * @param[in]       dTStart         Start time, in MJD
+ */
+int YAPP_RFI_Init(YAPP_RFI *pstRFI,
+                  int iNumChans,
+                  int iBlockSize,
+                  float fThreshold,
+                  char cZeroDM,
+                  char *pcFileMask,
+                  double dTSamp,
+                  double dTStart);
+
+/**
+ * Excise RFI from a block of filterbank data, in place, and write its mask
+ * record. Channels whose spectral kurtosis is an outlier among the channels
+ * of the block, and samples whose zero-DM value is an outlier in the block,
+ * are replaced with the channel means. Channels that are not good to begin
+ * with are neither used nor changed.
+ *
+ * @param[inout]    pstRFI          RFI excision state
+ * @param[inout]    pfBuf           Data, iNumSamps spectra of iNumChans
+ *                                  channels
+ * @param[in]       iNumSamps       Number of samples in the block
+ * @param[in]       pcIsChanGood    Channel goodness flags
+ * @param[in]       lFirstSamp      First sample of the block, counted from
+ *                                  the start of the data
+ */
+int YAPP_RFI_Clean(YAPP_RFI *pstRFI,
+                   float *pfBuf,
+                   int iNumSamps,
+                   char *pcIsChanGood,
+                   long lFirstSamp);
+
+/**
+ * Close the mask file, if any
+ *
+ * @param[inout]    pstRFI          RFI excision state
+ */
+int YAPP_RFI_Close(YAPP_RFI *pstRFI);
+
+/**
+ * Read a mask file
+ *
+ * @param[out]      pstMask         Mask
+ * @param[in]       pcFileMask      Mask filename
+ * @param[in]       iNumChans       Number of channels of the data
+ * @param[in]       dTSamp          Sampling interval of the data, in s
+ */
+int YAPP_RFI_ReadMask(YAPP_RFI_MASK *pstMask,
+                      char *pcFileMask,
+                      int iNumChans,
+                      double dTSamp);
+
+/**
+ * Apply a mask to a block of filterbank data, in place - flagged samples of
+ * each channel are replaced with the mean of the unflagged samples of that
+ * channel in the block, or, if the channel is flagged for the whole block,
+ * with its mean over all samples of the block. Samples not covered by the
+ * mask are not flagged.
+ *
+ * @param[inout]    pstMask         Mask
+ * @param[inout]    pfBuf           Data, iNumSamps spectra of iNumChans
+ *                                  channels
+ * @param[in]       iNumSamps       Number of samples in the block
+ * @param[in]       lFirstSamp      First sample of the block, counted from
+ *                                  the start of the data
+ */
+void YAPP_RFI_ApplyMask(YAPP_RFI_MASK *pstMask,
+                        float *pfBuf,
+                        int iNumSamps,
+                        long lFirstSamp);
+
+#endif  /* __YAPP_RFI_H__ */
+
@@ -0,0 +1,2302 @@
+/*
+ * @file yapp_search.c
+ * Program to search dedispersed time series data for periodic signals, using
+ *  an FFT with incoherent harmonic summing, optionally with a Fourier-domain
+ *  acceleration search. Multiple DM trials are searched in parallel, and the
+ *  candidates are sifted across DMs and harmonics into a single ranked list.
+ *
+ * @verbatim
+ * Usage: yapp_search [options] <data-files>
+ *     -h  --help                           Display this usage information
+ *     -s  --skip <time>                    The length of data in seconds, to be
+ *                                          skipped
+ *                                          (default is 0 s)
+ *     -p  --proc <time>                    The length of data in seconds, to be
+ *                                          processed
+ *                                          (default is all)
+ *     -n  --nsamp <samples>                FFT length - if less than the
+ *                                          length of the data, the power
+ *                                          spectra of consecutive segments
+ *                                          are stacked
+ *                                          (default is all)
+ *     -m  --nharm <numharm>                Maximum number of harmonics to sum
+ *                                          (1, 2, 4, 8, 16, or 32)
+ *                                          (default is 16)
+ *     -w  --medwin <bins>                  Running median window, in bins
+ *                                          (default is 512)
+ *     -l  --fmin <freq>                    Minimum frequency to search, in Hz
+ *                                          (default is 1 Hz)
+ *     -u  --fmax <freq>                    Maximum frequency to search, in Hz
+ *                                          (default is the Nyquist frequency)
+ *     -t  --threshold <sigmas>             Threshold in sigmas
+ *                                          (default is computed from the
+ *                                          number of bins and harmonic-
+ *                                          summing stages)
+ *     -c  --numcands <numcands>            Number of candidates to write
+ *                                          (default is 100)
+ *     -z  --zmax <z>                       Maximum Fourier frequency
+ *                                          derivative (drift in bins) for
+ *                                          an acceleration search
+ *                                          (default is 0, no acceleration
+ *                                          search)
+ *     -d  --dz <step>                      Step in Fourier frequency
+ *                                          derivative
+ *                                          (default is 2)
+ *     -j  --threads <numthreads>           Number of search threads
+ *                                          (default is the number of
+ *                                          processors)
+ *     -o  --ooc <memsize>                  Compute FFTs out of core, using
+ *                                          scratch files in the current
+ *                                          directory and at most memsize MB
+ *                                          per thread
+ *                                          (default is to compute FFTs in
+ *                                          memory)
+ *     -b  --db <database-file>             Also add the candidates to a
+ *                                          candidate database
+ *     -v  --version                        Display the version @endverbatim
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_search.h"
+#include "yapp_canddb.h"
+
+/**
+ * The build version string, maintained in the file version.c, which is
+ * generated by makever.c.
+ */
+extern const char *g_pcVersion;
+
+/* the following are global only to enable cleaning up in case of abnormal
+   termination, such as those triggered by SIGINT or SIGTERM */
+YAPP_SEARCH_WORKER *g_pstWorkers = NULL;
+int g_iNumWorkers = 0;
+YAPP_PCAND *g_pstCands = NULL;
+fftwf_plan g_stPlanFwd = {0};
+fftwf_complex *g_pfcKernels = NULL;
+fftwf_plan g_stPlanCorrFwd = {0};
+fftwf_plan g_stPlanCorrBwd = {0};
+
+static void CleanUp(void);
+static int RunThreads(void* (*pfnThread)(void *),
+                      int iNumThreads,
+                      YAPP_SEARCH_JOB *pstJob);
+static int YAPP_ReadSpectrum(YAPP_SEARCH_WORKER *pstWorker, int iFile);
+static int YAPP_MapSpectrum(YAPP_SEARCH_WORKER *pstWorker);
+static void YAPP_UnmapSpectrum(YAPP_SEARCH_WORKER *pstWorker);
+static int YAPP_SearchDMTrial(YAPP_SEARCH_WORKER *pstWorker, int iFile);
+static int YAPP_AccelSearchBlock(YAPP_SEARCH_WORKER *pstWorker, int iBlock);
+static double YAPP_CalcLogPowerTail(double dPower, int iNumPowers);
+static double YAPP_CalcLogGaussTail(double dSigma);
+static double YAPP_CalcSigmaFromLogTail(double dLogTail);
+
+int main(int argc, char *argv[])
+{
+    char *pcFileData = NULL;
+    char *pcFilename = NULL;
+    char acFileCand[LEN_GENSTRING] = {0};
+    char acDataDesc[LEN_GENSTRING] = {0};
+    char *pcFileDB = NULL;
+    YAPP_CDB_WRITER stCDB = {0};
+    YAPP_CDB_CAND stDBCand = {0};
+    int iFormat = DEF_FORMAT;
+    double dDataSkipTime = 0.0;
+    double dDataProcTime = 0.0;
+    YUM_t stYUM = {{0}};
+    YUM_t stYUMTrial = {{0}};
+    YAPP_SEARCH_JOB stJob = {0};
+    YAPP_SEARCH_WORKER *pstWorker = NULL;
+    double dTSampInSec = 0.0;   /* holds sampling time in s */
+    long lBytesToSkip = 0;
+    long lBytesToProc = 0;
+    int iTimeSampsSkip = 0;
+    int iTimeSampsToProc = 0;
+    int iBlockSize = 0;
+    int iNumBins = 0;
+    int iNumReads = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    double dTObs = 0.0;
+    int iNumHarm = DEF_SEARCH_NUMHARM;
+    int iMedWin = DEF_SEARCH_MEDWIN;
+    double dFMin = DEF_SEARCH_FMIN;
+    double dFMax = 0.0;
+    int iLoBin = 0;
+    int iHiBin = 0;
+    float fThreshold = 0.0;
+    int iNumCands = 0;
+    int iNumCandsOut = DEF_SEARCH_NUMCANDS;
+    int iNumFiles = 0;
+    int iNumThreads = 0;
+    int iOOCMemSize = 0;
+    double dZMax = 0.0;
+    double dZStep = DEF_SEARCH_ZSTEP;
+    double dNumTrials = 0.0;
+    fftwf_complex *pfcResp = NULL;
+    fftwf_complex *pfcKernel = NULL;
+    float fNorm = 0.0;
+    int iRespHalfWidth = 0;
+    int iCorrLen = 0;
+    int i = 0;
+    int j = 0;
+    const char *pcProgName = NULL;
+    int iNextOpt = 0;
+    /* valid short options */
+    const char* const pcOptsShort = "hs:p:n:m:w:l:u:t:c:z:d:j:o:b:v";
+    /* valid long options */
+    const struct option stOptsLong[] = {
+        { "help",                   0, NULL, 'h' },
+        { "skip",                   1, NULL, 's' },
+        { "proc",                   1, NULL, 'p' },
+        { "nsamp",                  1, NULL, 'n' },
+        { "nharm",                  1, NULL, 'm' },
+        { "medwin",                 1, NULL, 'w' },
+        { "fmin",                   1, NULL, 'l' },
+        { "fmax",                   1, NULL, 'u' },
+        { "threshold",              1, NULL, 't' },
+        { "numcands",               1, NULL, 'c' },
+        { "zmax",                   1, NULL, 'z' },
+        { "dz",                     1, NULL, 'd' },
+        { "threads",                1, NULL, 'j' },
+        { "ooc",                    1, NULL, 'o' },
+        { "db",                     1, NULL, 'b' },
+        { "version",                0, NULL, 'v' },
+        { NULL,                     0, NULL, 0   }
+    };
+
+    /* get the filename of the program from the argument list */
+    pcProgName = argv[0];
+
+    /* parse the input */
+    do
+    {
+        iNextOpt = getopt_long(argc, argv, pcOptsShort, stOptsLong, NULL);
+        switch (iNextOpt)
+        {
+            case 'h':   /* -h or --help */
+                /* print usage info and terminate */
+                PrintUsage(pcProgName);
+                return YAPP_RET_SUCCESS;
+
+            case 's':   /* -s or --skip */
+                /* set option */
+                dDataSkipTime = atof(optarg);
+                break;
+
+            case 'p':   /* -p or --proc */
+                /* set option */
+                dDataProcTime = atof(optarg);
+                break;
+
+            case 'n':   /* -n or --nsamp */
+                /* set option */
+                iBlockSize = atoi(optarg);
+                break;
+
+            case 'm':   /* -m or --nharm */
+                /* set option */
+                iNumHarm = atoi(optarg);
+                /* validate - must be a power of 2, not more than the
+                   maximum */
+                if ((iNumHarm < 1)
+                    || (iNumHarm > YAPP_SEARCH_MAXHARM)
+                    || ((iNumHarm & (iNumHarm - 1)) != 0))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of harmonics must be one of "
+                                   "1, 2, 4, 8, 16, or 32!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'w':   /* -w or --medwin */
+                /* set option */
+                iMedWin = atoi(optarg);
+                if (iMedWin < 2)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Running median window must be "
+                                   "> 1!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'l':   /* -l or --fmin */
+                /* set option */
+                dFMin = atof(optarg);
+                break;
+
+            case 'u':   /* -u or --fmax */
+                /* set option */
+                dFMax = atof(optarg);
+                break;
+
+            case 't':   /* -t or --threshold */
+                /* set option */
+                fThreshold = atof(optarg);
+                break;
+
+            case 'c':   /* -c or --numcands */
+                /* set option */
+                iNumCandsOut = atoi(optarg);
+                break;
+
+            case 'z':   /* -z or --zmax */
+                /* set option */
+                dZMax = fabs(atof(optarg));
+                break;
+
+            case 'd':   /* -d or --dz */
+                /* set option */
+                dZStep = atof(optarg);
+                if (dZStep <= 0.0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Step in Fourier frequency "
+                                   "derivative must be > 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'j':   /* -j or --threads */
+                /* set option */
+                iNumThreads = atoi(optarg);
+                if ((iNumThreads < 1)
+                    || (iNumThreads > YAPP_SEARCH_MAXTHREADS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of threads must be between "
+                                   "1 and %d!\n",
+                                   YAPP_SEARCH_MAXTHREADS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'o':   /* -o or --ooc */
+                /* set option */
+                iOOCMemSize = atoi(optarg);
+                if (iOOCMemSize < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Memory size must be at least "
+                                   "1 MB!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'b':   /* -b or --db */
+                /* set option */
+                pcFileDB = optarg;
+                break;
+
+            case 'v':   /* -v or --version */
+                /* display the version */
+                (void) printf("%s\n", g_pcVersion);
+                return YAPP_RET_SUCCESS;
+
+            case '?':   /* user specified an invalid option */
+                /* print usage info and terminate with error */
+                (void) fprintf(stderr, "ERROR: Invalid option!\n");
+                PrintUsage(pcProgName);
+                return YAPP_RET_ERROR;
+
+            case -1:    /* done with options */
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+    } while (iNextOpt != -1);
+
+    /* no arguments */
+    if (argc <= optind)
+    {
+        (void) fprintf(stderr, "ERROR: Input file not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* register the signal-handling function */
+    iRet = YAPP_RegisterSignalHandlers();
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Handler registration failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    /* each input file is one DM trial */
+    iNumFiles = argc - optind;
+    stJob.ppcFileData = &argv[optind];
+    stJob.iNumFiles = iNumFiles;
+    stJob.piHeaderLen = (int *) YAPP_Malloc((size_t) iNumFiles,
+                                            sizeof(int),
+                                            YAPP_FALSE);
+    stJob.pfSampSize = (float *) YAPP_Malloc((size_t) iNumFiles,
+                                             sizeof(float),
+                                             YAPP_FALSE);
+    stJob.pdDM = (double *) YAPP_Malloc((size_t) iNumFiles,
+                                        sizeof(double),
+                                        YAPP_FALSE);
+    if ((NULL == stJob.piHeaderLen)
+        || (NULL == stJob.pfSampSize)
+        || (NULL == stJob.pdDM))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* read the headers of all files - only the header is needed, so the
+       statistics computed by YAPP_ReadMetadata() are skipped */
+    for (i = 0; i < iNumFiles; ++i)
+    {
+        pcFileData = stJob.ppcFileData[i];
+
+        /* determine the file type */
+        iFormat = YAPP_GetFileType(pcFileData);
+        if (YAPP_RET_ERROR == iFormat)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: File type determination failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (iFormat != YAPP_FORMAT_DTS_TIM)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Invalid file type for file %s!\n",
+                           pcFileData);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        (void) memset(&stYUMTrial, '\0', sizeof(YUM_t));
+        iRet = YAPP_ReadSIGPROCHeader(pcFileData, iFormat, &stYUMTrial);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading metadata failed for file %s!\n",
+                           pcFileData);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        if (0 == i)
+        {
+            stYUM = stYUMTrial;
+        }
+        else if ((stYUMTrial.dTSamp != stYUM.dTSamp)
+                 || (stYUMTrial.iTimeSamps != stYUM.iTimeSamps))
+        {
+            /* all DM trials must share the same FFT length and bins */
+            (void) fprintf(stderr,
+                           "ERROR: Sampling interval or length of %s differs "
+                           "from that of %s!\n",
+                           pcFileData,
+                           stJob.ppcFileData[0]);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        stJob.piHeaderLen[i] = stYUMTrial.iHeaderLen;
+        stJob.pfSampSize[i] = stYUMTrial.fSampSize;
+        stJob.pdDM[i] = stYUMTrial.dDM;
+    }
+    pcFileData = stJob.ppcFileData[0];
+
+    /* convert sampling interval to seconds */
+    dTSampInSec = stYUM.dTSamp / 1e3;
+
+    if (0.0 == dDataProcTime)
+    {
+        dDataProcTime = (stYUM.iTimeSamps * dTSampInSec) - dDataSkipTime;
+    }
+    /* check if the input time duration is less than the length of the
+       data */
+    else if (dDataProcTime > (stYUM.iTimeSamps * dTSampInSec))
+    {
+        (void) fprintf(stderr,
+                       "WARNING: Input time is longer than length of "
+                       "data!\n");
+    }
+
+    lBytesToSkip = (long) floor((dDataSkipTime / dTSampInSec)
+                                                    /* number of samples */
+                           * stYUM.fSampSize);
+    lBytesToProc = (long) floor((dDataProcTime / dTSampInSec)
+                                                    /* number of samples */
+                           * stYUM.fSampSize);
+
+    if (lBytesToSkip >= stYUM.lDataSizeTotal)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Data to be skipped is greater than or equal to "
+                       "the size of the file!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    if ((lBytesToSkip + lBytesToProc) > stYUM.lDataSizeTotal)
+    {
+        (void) printf("WARNING: Total data to be read (skipped and processed) "
+                      "is more than the size of the file! ");
+        lBytesToProc = stYUM.lDataSizeTotal - lBytesToSkip;
+        dDataProcTime = ((double) lBytesToProc * dTSampInSec)
+                        / stYUM.fSampSize;
+        (void) printf("Newly calculated size of data to be processed: %ld "
+                      "bytes\n",
+                      lBytesToProc);
+    }
+
+    iTimeSampsSkip = (int) (lBytesToSkip / (stYUM.fSampSize));
+    iTimeSampsToProc = (int) (lBytesToProc / (stYUM.fSampSize));
+
+    /* an out-of-core FFT is only needed for transforming the whole time
+       series in one go */
+    if ((iOOCMemSize > 0) && (iBlockSize != 0)
+        && (iBlockSize < iTimeSampsToProc))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Out-of-core FFTs cannot be used with "
+                       "segments!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* by default, the whole time series is transformed in one go */
+    if ((0 == iBlockSize) || (iBlockSize > iTimeSampsToProc))
+    {
+        iBlockSize = iTimeSampsToProc;
+    }
+    /* use an even FFT length, so that the Nyquist bin is well-defined */
+    iBlockSize -= (iBlockSize % 2);
+    if (iOOCMemSize > 0)
+    {
+        /* use a length that the out-of-core FFT can split into short
+           transforms */
+        iBlockSize = (int) YAPP_OOCFFT_GoodLength((long) iBlockSize);
+    }
+    if (iBlockSize < (2 * iMedWin))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: FFT length must be at least twice the running "
+                       "median window!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    iNumBins = (iBlockSize / 2) + 1;
+
+    /* only whole segments are transformed */
+    iNumReads = iTimeSampsToProc / iBlockSize;
+    if ((iNumReads * iBlockSize) < iTimeSampsToProc)
+    {
+        (void) printf("WARNING: Ignoring the last %d time samples that do not "
+                      "make a whole segment!\n",
+                      iTimeSampsToProc - (iNumReads * iBlockSize));
+    }
+
+    /* compute the range of bins to be searched */
+    dTObs = iBlockSize * dTSampInSec;
+    iLoBin = (int) ceil(dFMin * dTObs);
+    if (iLoBin < 1)
+    {
+        iLoBin = 1;     /* never search the DC bin */
+    }
+    iHiBin = iNumBins;
+    if ((dFMax > 0.0) && ((int) floor(dFMax * dTObs) < iHiBin))
+    {
+        iHiBin = (int) floor(dFMax * dTObs);
+    }
+    if (iLoBin >= iHiBin)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid frequency range!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* set up the acceleration search - the template response covers the
+       drift of the signal, plus some padding on either side, and each
+       overlap-save block yields the correlation for all but the template
+       length of bins */
+    if (dZMax > 0.0)
+    {
+        if (iNumReads > 1)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Acceleration search needs the time series "
+                           "to be transformed in one go!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        stJob.iNumZ = (2 * (int) lround(dZMax / dZStep)) + 1;
+        stJob.dZStep = dZStep;
+        stJob.dZMax = ((stJob.iNumZ - 1) / 2) * dZStep;
+        iRespHalfWidth = (int) ceil(stJob.dZMax / 2) + YAPP_SEARCH_RESP_PAD;
+        iCorrLen = 1;
+        while (iCorrLen
+               < (YAPP_SEARCH_CORR_FACTOR * ((2 * iRespHalfWidth) + 1)))
+        {
+            iCorrLen *= 2;
+        }
+        stJob.iRespHalfWidth = iRespHalfWidth;
+        stJob.iCorrLen = iCorrLen;
+        /* one bin less than the valid output of the correlation, as the
+           harmonics of a block span one bin more than the block */
+        stJob.iBlockBins = iCorrLen - (2 * iRespHalfWidth) - 1;
+        stJob.iNumBlocks = (iNumBins - iLoBin + stJob.iBlockBins - 1)
+                           / stJob.iBlockBins;
+        (void) printf("Acceleration search over |z| <= %g in steps of %g, "
+                      "with %d-point overlap-save blocks.\n",
+                      stJob.dZMax,
+                      dZStep,
+                      iCorrLen);
+    }
+    else
+    {
+        stJob.iNumZ = 1;
+    }
+
+    if (iOOCMemSize > 0)
+    {
+        (void) printf("Computing FFTs out of core, using at most %d MB per "
+                      "thread.\n",
+                      iOOCMemSize);
+    }
+
+    /* use one thread per processor, but not more than there are DM
+       trials, or blocks, in the case of an acceleration search */
+    if (0 == iNumThreads)
+    {
+        iNumThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (iNumThreads < 1)
+        {
+            iNumThreads = 1;
+        }
+        else if (iNumThreads > YAPP_SEARCH_MAXTHREADS)
+        {
+            iNumThreads = YAPP_SEARCH_MAXTHREADS;
+        }
+    }
+    if ((0.0 == dZMax) && (iNumThreads > iNumFiles))
+    {
+        iNumThreads = iNumFiles;
+    }
+    else if ((dZMax > 0.0) && (iNumThreads > stJob.iNumBlocks))
+    {
+        iNumThreads = stJob.iNumBlocks;
+    }
+
+    (void) printf("Skipping\n"
+                  "    %ld of %ld bytes\n"
+                  "    %d of %d time samples\n"
+                  "    %.10g of %.10g seconds\n",
+                  lBytesToSkip,
+                  stYUM.lDataSizeTotal,
+                  iTimeSampsSkip,
+                  stYUM.iTimeSamps,
+                  (iTimeSampsSkip * dTSampInSec),
+                  (stYUM.iTimeSamps * dTSampInSec));
+    (void) printf("Processing\n"
+                  "    %ld of %ld bytes\n"
+                  "    %d of %d time samples\n"
+                  "    %.10g of %.10g seconds\n"
+                  "in %d segments of FFT length %d, for %d DM trial(s) "
+                  "using %d thread(s)...\n",
+                  lBytesToProc,
+                  stYUM.lDataSizeTotal,
+                  iTimeSampsToProc,
+                  stYUM.iTimeSamps,
+                  (iTimeSampsToProc * dTSampInSec),
+                  (stYUM.iTimeSamps * dTSampInSec),
+                  iNumReads,
+                  iBlockSize,
+                  iNumFiles,
+                  iNumThreads);
+
+    /* calculate the threshold - each z trial and each harmonic-summing stage
+       is a further set of trials */
+    if (0.0 == fThreshold)
+    {
+        dNumTrials = (double) (iHiBin - iLoBin) * stJob.iNumZ;
+        for (i = 2; i <= iNumHarm; i *= 2)
+        {
+            dNumTrials += (double) (iHiBin - iLoBin) * stJob.iNumZ;
+        }
+        if (dNumTrials > (double) INT_MAX)
+        {
+            dNumTrials = (double) INT_MAX;
+        }
+        fThreshold = (float) YAPP_CalcThresholdInSigmas((int) dNumTrials);
+        if ((float) YAPP_RET_ERROR == fThreshold)
+        {
+            (void) fprintf(stderr, "ERROR: Threshold calculation failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+    (void) printf("Threshold                         : %g sigma\n",
+                  fThreshold);
+
+    stJob.iTimeSampsSkip = iTimeSampsSkip;
+    stJob.iBlockSize = iBlockSize;
+    stJob.iNumSegs = iNumReads;
+    stJob.iNumBins = iNumBins;
+    stJob.iMedWin = iMedWin;
+    stJob.iNumHarm = iNumHarm;
+    stJob.iLoBin = iLoBin;
+    stJob.iHiBin = iHiBin;
+    stJob.dTObs = dTObs;
+    stJob.fThreshold = fThreshold;
+    stJob.lOOCMemSize = (size_t) iOOCMemSize * YAPP_MB2BYTE_FACTOR;
+    stJob.iRet = YAPP_RET_SUCCESS;
+
+    /* allocate memory for the per-thread buffers - all allocations are done
+       here, as YAPP_Malloc() is not thread-safe */
+    g_pstWorkers = (YAPP_SEARCH_WORKER *) YAPP_Malloc(
+                                                (size_t) iNumThreads,
+                                                sizeof(YAPP_SEARCH_WORKER),
+                                                YAPP_TRUE);
+    if (NULL == g_pstWorkers)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    g_iNumWorkers = iNumThreads;
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        pstWorker = &g_pstWorkers[i];
+        pstWorker->pstJob = &stJob;
+        pstWorker->pstCands = (YAPP_PCAND *) YAPP_Malloc(
+                                                (size_t) DEF_SEARCH_MAXCANDS,
+                                                sizeof(YAPP_PCAND),
+                                                YAPP_FALSE);
+        if (NULL == pstWorker->pstCands)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation for buffer failed! %s!\n",
+                           strerror(errno));
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+
+        /* in an out-of-core search, the spectra are held in scratch files,
+           mapped into memory when needed */
+        if (iOOCMemSize > 0)
+        {
+            pstWorker->pfScratch = (float *) YAPP_Malloc((size_t) iMedWin,
+                                                         sizeof(float),
+                                                         YAPP_FALSE);
+            if (NULL == pstWorker->pfScratch)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation for buffer failed! "
+                               "%s!\n",
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+        /* in an acceleration search, the spectrum of each DM trial is
+           computed in the main thread, using the buffers of the first
+           worker */
+        else if ((0 == i) || (0.0 == dZMax))
+        {
+            pstWorker->pcRawBuf = (char *) YAPP_Malloc((size_t) iBlockSize,
+                                                       sizeof(float),
+                                                       YAPP_FALSE);
+            pstWorker->pfPowSpec = (float *) YAPP_Malloc((size_t) iNumBins,
+                                                         sizeof(float),
+                                                         YAPP_FALSE);
+            pstWorker->pfSegSpec = (float *) YAPP_Malloc((size_t) iNumBins,
+                                                         sizeof(float),
+                                                         YAPP_FALSE);
+            pstWorker->pfSumSpec = (float *) YAPP_Malloc((size_t) iNumBins,
+                                                         sizeof(float),
+                                                         YAPP_FALSE);
+            pstWorker->pfScratch = (float *) YAPP_Malloc((size_t) iMedWin,
+                                                         sizeof(float),
+                                                         YAPP_FALSE);
+            if ((NULL == pstWorker->pcRawBuf)
+                || (NULL == pstWorker->pfPowSpec)
+                || (NULL == pstWorker->pfSegSpec)
+                || (NULL == pstWorker->pfSumSpec)
+                || (NULL == pstWorker->pfScratch))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation for buffer failed! "
+                               "%s!\n",
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+
+            /* FFT buffers are allocated with fftwf_malloc(), so that all of
+               them have the alignment the shared plan was created with */
+            pstWorker->pfBuf = (float *) fftwf_malloc(iBlockSize
+                                                      * sizeof(float));
+            pstWorker->pfcFFTBuf = (fftwf_complex *) fftwf_malloc(
+                                            iNumBins * sizeof(fftwf_complex));
+            if ((NULL == pstWorker->pfBuf) || (NULL == pstWorker->pfcFFTBuf))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+
+        if (dZMax > 0.0)
+        {
+            pstWorker->pfPlane = (float *) YAPP_Malloc(
+                                    (size_t) iNumHarm * stJob.iNumZ
+                                    * (stJob.iBlockBins + 1),
+                                    sizeof(float),
+                                    YAPP_FALSE);
+            pstWorker->pfBlockSum = (float *) YAPP_Malloc(
+                                    (size_t) stJob.iBlockBins,
+                                    sizeof(float),
+                                    YAPP_FALSE);
+            pstWorker->pfcCorrIn = (fftwf_complex *) fftwf_malloc(
+                                    iCorrLen * sizeof(fftwf_complex));
+            pstWorker->pfcCorrFFT = (fftwf_complex *) fftwf_malloc(
+                                    iCorrLen * sizeof(fftwf_complex));
+            pstWorker->pfcCorrOut = (fftwf_complex *) fftwf_malloc(
+                                    iCorrLen * sizeof(fftwf_complex));
+            if ((NULL == pstWorker->pfPlane)
+                || (NULL == pstWorker->pfBlockSum)
+                || (NULL == pstWorker->pfcCorrIn)
+                || (NULL == pstWorker->pfcCorrFFT)
+                || (NULL == pstWorker->pfcCorrOut))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
+                CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
+    }
+
+    /* create FFT plan - the planner is not thread-safe, so one plan is
+       created here, and each thread executes it on its own buffers */
+    /* NOTE: FFTW_MEASURE is prohibitively slow for FFTs the length of a
+             whole observation, so let FFTW estimate the plan */
+    if (0 == iOOCMemSize)
+    {
+        g_stPlanFwd = fftwf_plan_dft_r2c_1d(iBlockSize,
+                                            g_pstWorkers[0].pfBuf,
+                                            g_pstWorkers[0].pfcFFTBuf,
+                                            FFTW_ESTIMATE);
+        stJob.stPlanFwd = g_stPlanFwd;
+    }
+
+    if (dZMax > 0.0)
+    {
+        /* create the overlap-save plans - these are short and executed many
+           times, so it is worth measuring them */
+        g_stPlanCorrFwd = fftwf_plan_dft_1d(iCorrLen,
+                                            g_pstWorkers[0].pfcCorrIn,
+                                            g_pstWorkers[0].pfcCorrFFT,
+                                            FFTW_FORWARD,
+                                            FFTW_MEASURE);
+        g_stPlanCorrBwd = fftwf_plan_dft_1d(iCorrLen,
+                                            g_pstWorkers[0].pfcCorrIn,
+                                            g_pstWorkers[0].pfcCorrOut,
+                                            FFTW_BACKWARD,
+                                            FFTW_MEASURE);
+        stJob.stPlanCorrFwd = g_stPlanCorrFwd;
+        stJob.stPlanCorrBwd = g_stPlanCorrBwd;
+
+        /* compute the FFTs of the template bank - correlating the spectrum
+           with a template is done as a convolution with the reversed,
+           conjugated template, normalised to unit power so that noise powers
+           keep a unit mean, and scaled by 1/N for the unnormalised inverse
+           FFT */
+        g_pfcKernels = (fftwf_complex *) fftwf_malloc(
+                                                (size_t) stJob.iNumZ
+                                                * iCorrLen
+                                                * sizeof(fftwf_complex));
+        if (NULL == g_pfcKernels)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        stJob.pfcKernels = g_pfcKernels;
+        pfcResp = g_pstWorkers[0].pfcCorrOut;
+        pfcKernel = g_pstWorkers[0].pfcCorrIn;
+        for (i = 0; i < stJob.iNumZ; ++i)
+        {
+            (void) YAPP_CalcAccelResponse(-stJob.dZMax + (i * dZStep),
+                                          iRespHalfWidth,
+                                          pfcResp);
+            fNorm = 0.0;
+            for (j = 0; j < ((2 * iRespHalfWidth) + 1); ++j)
+            {
+                fNorm += (pfcResp[j][0] * pfcResp[j][0])
+                         + (pfcResp[j][1] * pfcResp[j][1]);
+            }
+            fNorm = sqrtf(fNorm) * iCorrLen;
+            (void) memset(pfcKernel, '\0', iCorrLen * sizeof(fftwf_complex));
+            for (j = -iRespHalfWidth; j <= iRespHalfWidth; ++j)
+            {
+                pfcKernel[(iCorrLen - j) % iCorrLen][0] =
+                                    pfcResp[j + iRespHalfWidth][0] / fNorm;
+                pfcKernel[(iCorrLen - j) % iCorrLen][1] =
+                                    -pfcResp[j + iRespHalfWidth][1] / fNorm;
+            }
+            fftwf_execute_dft(g_stPlanCorrFwd,
+                              pfcKernel,
+                              g_pfcKernels + ((long) i * iCorrLen));
+        }
+    }
+
+    /* search all DM trials */
+    (void) pthread_mutex_init(&stJob.stMutex, NULL);
+    if (0.0 == dZMax)
+    {
+        /* one DM trial per thread */
+        iRet = RunThreads(YAPP_SearchDMTrials, iNumThreads, &stJob);
+    }
+    else
+    {
+        /* the acceleration search of each DM trial is split across
+           threads */
+        for (i = 0; i < iNumFiles; ++i)
+        {
+            iRet = YAPP_ReadSpectrum(&g_pstWorkers[0], i);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                break;
+            }
+            stJob.pfcSpec = g_pstWorkers[0].pfcFFTBuf;
+            stJob.iCurFile = i;
+            stJob.iNextBlock = 0;
+            iRet = RunThreads(YAPP_AccelSearchBlocks, iNumThreads, &stJob);
+            YAPP_UnmapSpectrum(&g_pstWorkers[0]);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                break;
+            }
+
+            /* remove duplicates, so that the tables do not fill up with
+               adjacent bins and z trials of bright signals */
+            for (j = 0; j < iNumThreads; ++j)
+            {
+                g_pstWorkers[j].iNumCands = YAPP_SiftPeriodCands(
+                                                g_pstWorkers[j].pstCands,
+                                                g_pstWorkers[j].iNumCands);
+            }
+        }
+    }
+    (void) pthread_mutex_destroy(&stJob.stMutex);
+    (void) printf("\n");
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr, "ERROR: Searching failed!\n");
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        iNumCands += g_pstWorkers[i].iNumCands;
+    }
+
+    /* merge the candidates found by all threads */
+    g_pstCands = (YAPP_PCAND *) YAPP_Malloc((size_t) (iNumCands + 1),
+                                            sizeof(YAPP_PCAND),
+                                            YAPP_FALSE);
+    if (NULL == g_pstCands)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    iNumCands = 0;
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        (void) memcpy(g_pstCands + iNumCands,
+                      g_pstWorkers[i].pstCands,
+                      g_pstWorkers[i].iNumCands * sizeof(YAPP_PCAND));
+        iNumCands += g_pstWorkers[i].iNumCands;
+    }
+
+    /* rank the candidates, and remove duplicates across DMs and
+       harmonics */
+    iNumCands = YAPP_SiftPeriodCands(g_pstCands, iNumCands);
+    iNumCands = YAPP_SiftPeriodCandHarmonics(g_pstCands,
+                                             iNumCands,
+                                             YAPP_SEARCH_MAXHARM,
+                                             iNumCandsOut);
+    (void) printf("%d candidates found.\n", iNumCands);
+    if (iNumCands < iNumCandsOut)
+    {
+        iNumCandsOut = iNumCands;
+    }
+
+    /* build the name of the output candidate file - candidates from multiple
+       DM trials are written to one file, named after the first */
+    pcFilename = YAPP_GetFilenameFromPath(pcFileData);
+    (void) strcpy(acFileCand, pcFilename);
+    if (1 == iNumFiles)
+    {
+        (void) strcpy(acDataDesc, pcFileData);
+    }
+    else
+    {
+        (void) strcat(acFileCand, ".");
+        (void) strcat(acFileCand, INFIX_ALLDM);
+        (void) snprintf(acDataDesc,
+                        LEN_GENSTRING,
+                        "%s and %d other DM trial(s)",
+                        pcFileData,
+                        iNumFiles - 1);
+    }
+    (void) strcat(acFileCand, EXT_YAPP_PCAND);
+
+    iRet = YAPP_WritePeriodCands(acFileCand,
+                                 acDataDesc,
+                                 g_pstCands,
+                                 iNumCandsOut);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing candidates failed!\n");
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* add the candidates to the database - periodicity candidates are
+       timestamped with the start of the data searched */
+    if (pcFileDB != NULL)
+    {
+        iRet = YAPP_CDB_Open(&stCDB, pcFileDB);
+        for (i = 0; (YAPP_RET_SUCCESS == iRet) && (i < iNumCandsOut); ++i)
+        {
+            stDBCand.dMJD = stYUM.dTStart
+                            + (iTimeSampsSkip * dTSampInSec / 86400);
+            stDBCand.dParam = 1.0 / g_pstCands[i].dFreq;
+            stDBCand.fDM = (float) g_pstCands[i].dDM;
+            stDBCand.fSNR = g_pstCands[i].fSigma;
+            stDBCand.iBeam = stYUM.iBeamID;
+            stDBCand.cType = YAPP_CDB_TYPE_PERIOD;
+            iRet = YAPP_CDB_Add(&stCDB, &stDBCand);
+        }
+        if (YAPP_CDB_Close(&stCDB) != YAPP_RET_SUCCESS)
+        {
+            iRet = YAPP_RET_ERROR;
+        }
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Writing candidate database failed!\n");
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    (void) printf("DONE!\n");
+
+    CleanUp();
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Frees the FFT plan and buffers, and the rest of the memory
+ */
+static void CleanUp()
+{
+    int i = 0;
+
+    if (g_stPlanFwd != NULL)
+    {
+        fftwf_destroy_plan(g_stPlanFwd);
+        g_stPlanFwd = NULL;
+    }
+    if (g_stPlanCorrFwd != NULL)
+    {
+        fftwf_destroy_plan(g_stPlanCorrFwd);
+        g_stPlanCorrFwd = NULL;
+    }
+    if (g_stPlanCorrBwd != NULL)
+    {
+        fftwf_destroy_plan(g_stPlanCorrBwd);
+        g_stPlanCorrBwd = NULL;
+    }
+    if (g_pfcKernels != NULL)
+    {
+        fftwf_free(g_pfcKernels);
+        g_pfcKernels = NULL;
+    }
+    for (i = 0; i < g_iNumWorkers; ++i)
+    {
+        YAPP_UnmapSpectrum(&g_pstWorkers[i]);
+        if (g_pstWorkers[i].pfBuf != NULL)
+        {
+            fftwf_free(g_pstWorkers[i].pfBuf);
+        }
+        if (g_pstWorkers[i].pfcFFTBuf != NULL)
+        {
+            fftwf_free(g_pstWorkers[i].pfcFFTBuf);
+        }
+        if (g_pstWorkers[i].pfcCorrIn != NULL)
+        {
+            fftwf_free(g_pstWorkers[i].pfcCorrIn);
+        }
+        if (g_pstWorkers[i].pfcCorrFFT != NULL)
+        {
+            fftwf_free(g_pstWorkers[i].pfcCorrFFT);
+        }
+        if (g_pstWorkers[i].pfcCorrOut != NULL)
+        {
+            fftwf_free(g_pstWorkers[i].pfcCorrOut);
+        }
+    }
+    g_iNumWorkers = 0;
+    YAPP_CleanUp();
+
+    return;
+}
+
+
+/*
+ * Search thread
+ */
+void* YAPP_SearchDMTrials(void *pvWorker)
+{
+    YAPP_SEARCH_WORKER *pstWorker = (YAPP_SEARCH_WORKER *) pvWorker;
+    YAPP_SEARCH_JOB *pstJob = pstWorker->pstJob;
+    int iFile = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    while (YAPP_TRUE)
+    {
+        /* get the next DM trial from the queue */
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        iFile = pstJob->iNextFile;
+        ++(pstJob->iNextFile);
+        iRet = pstJob->iRet;
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+        if ((iFile >= pstJob->iNumFiles) || (iRet != YAPP_RET_SUCCESS))
+        {
+            break;
+        }
+
+        iRet = YAPP_SearchDMTrial(pstWorker, iFile);
+
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            pstJob->iRet = YAPP_RET_ERROR;
+        }
+        ++(pstJob->iNumDone);
+        (void) printf("\rSearched %d of %d DM trial(s).",
+                      pstJob->iNumDone,
+                      pstJob->iNumFiles);
+        (void) fflush(stdout);
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Run the search threads to completion
+ */
+static int RunThreads(void* (*pfnThread)(void *),
+                      int iNumThreads,
+                      YAPP_SEARCH_JOB *pstJob)
+{
+    int iRet = 0;
+    int i = 0;
+
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        iRet = pthread_create(&g_pstWorkers[i].stThread,
+                              NULL,
+                              pfnThread,
+                              (void *) &g_pstWorkers[i]);
+        if (iRet != 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Creating thread failed! %s!\n",
+                           strerror(iRet));
+            /* stop the threads that have already been created */
+            (void) pthread_mutex_lock(&pstJob->stMutex);
+            pstJob->iRet = YAPP_RET_ERROR;
+            (void) pthread_mutex_unlock(&pstJob->stMutex);
+            iNumThreads = i;
+            break;
+        }
+    }
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        (void) pthread_join(g_pstWorkers[i].stThread, NULL);
+    }
+
+    return pstJob->iRet;
+}
+
+
+/*
+ * Read one DM trial and compute its normalised power spectrum - in an
+ * acceleration search, the complex spectrum is normalised as well
+ */
+static int YAPP_ReadSpectrum(YAPP_SEARCH_WORKER *pstWorker, int iFile)
+{
+    YAPP_SEARCH_JOB *pstJob = pstWorker->pstJob;
+    char *pcFileData = pstJob->ppcFileData[iFile];
+    float fSampSize = pstJob->pfSampSize[iFile];
+    FILE *pFData = NULL;
+    int iBlockSize = pstJob->iBlockSize;
+    int iNumBins = pstJob->iNumBins;
+    int iBytesPerBlock = (int) (iBlockSize * fSampSize);
+    int iReadBytes = 0;
+    int iSeg = 0;
+    float fMean = 0.0;
+    float fScale = 0.0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    /* open the time series data file for reading - the stream is local to
+       this thread, so YAPP_ReadData(), which keeps a static buffer, is not
+       used */
+    pFData = fopen(pcFileData, "r");
+    if (NULL == pFData)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileData,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    /* skip the header */
+    (void) fseek(pFData, (long) pstJob->piHeaderLen[iFile], SEEK_SET);
+    /* skip data, if any are to be skipped */
+    (void) fseek(pFData,
+                 (long) (pstJob->iTimeSampsSkip * fSampSize),
+                 SEEK_CUR);
+
+    if (pstJob->lOOCMemSize > 0)
+    {
+        iRet = YAPP_MapSpectrum(pstWorker);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fclose(pFData);
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    (void) memset(pstWorker->pfPowSpec, '\0', iNumBins * sizeof(float));
+    for (iSeg = 0; iSeg < pstJob->iNumSegs; ++iSeg)
+    {
+        if (pstJob->lOOCMemSize > 0)
+        {
+            /* read and transform the data a tile at a time, into the
+               scratch file - the mean is not removed, as it would take
+               another pass over the data, and only affects the DC bin,
+               which is zeroed anyway */
+            iRet = YAPP_OOCFFT_R2C(pFData,
+                                   fSampSize,
+                                   (long) iBlockSize,
+                                   (long) iBlockSize,
+                                   pstWorker->iFdSpec,
+                                   pstJob->lOOCMemSize);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Out-of-core FFT of file %s failed!\n",
+                               pcFileData);
+                (void) fclose(pFData);
+                YAPP_UnmapSpectrum(pstWorker);
+                return YAPP_RET_ERROR;
+            }
+        }
+        else
+        {
+            /* read data */
+            iReadBytes = fread(pstWorker->pcRawBuf,
+                               sizeof(char),
+                               iBytesPerBlock,
+                               pFData);
+            if (iReadBytes != iBytesPerBlock)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Reading data from file %s failed!\n",
+                               pcFileData);
+                (void) fclose(pFData);
+                return YAPP_RET_ERROR;
+            }
+            (void) YAPP_UnpackData(pstWorker->pcRawBuf,
+                                   pstWorker->pfBuf,
+                                   fSampSize,
+                                   iBlockSize);
+
+            /* remove the mean, so that the DC bin does not leak into the
+               running median */
+            fMean = YAPP_CalcMean(pstWorker->pfBuf, iBlockSize, 0, 1);
+            for (i = 0; i < iBlockSize; ++i)
+            {
+                pstWorker->pfBuf[i] -= fMean;
+            }
+
+            fftwf_execute_dft_r2c(pstJob->stPlanFwd,
+                                  pstWorker->pfBuf,
+                                  pstWorker->pfcFFTBuf);
+        }
+
+        /* compute the power spectrum */
+        for (i = 0; i < iNumBins; ++i)
+        {
+            pstWorker->pfSegSpec[i] = (pstWorker->pfcFFTBuf[i][0]
+                                       * pstWorker->pfcFFTBuf[i][0])
+                                      + (pstWorker->pfcFFTBuf[i][1]
+                                         * pstWorker->pfcFFTBuf[i][1]);
+        }
+        pstWorker->pfSegSpec[0] = 0.0;
+
+        /* normalise, and stack with the spectra of previous segments */
+        (void) YAPP_NormalisePowSpec(pstWorker->pfSegSpec,
+                                     iNumBins,
+                                     pstJob->iMedWin,
+                                     pstWorker->pfScratch);
+        for (i = 0; i < iNumBins; ++i)
+        {
+            pstWorker->pfPowSpec[i] += pstWorker->pfSegSpec[i];
+        }
+    }
+    (void) fclose(pFData);
+
+    /* scale the complex spectrum by the same factor as the powers */
+    if (pstJob->dZMax > 0.0)
+    {
+        for (i = 0; i < iNumBins; ++i)
+        {
+            fScale = (pstWorker->pfcFFTBuf[i][0] * pstWorker->pfcFFTBuf[i][0])
+                     + (pstWorker->pfcFFTBuf[i][1]
+                        * pstWorker->pfcFFTBuf[i][1]);
+            if (fScale > 0.0)
+            {
+                fScale = sqrtf(pstWorker->pfPowSpec[i] / fScale);
+            }
+            pstWorker->pfcFFTBuf[i][0] *= fScale;
+            pstWorker->pfcFFTBuf[i][1] *= fScale;
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Create a scratch file for the spectra of one DM trial in an out-of-core
+ * search, and map it into memory - the pages are backed by the file, so they
+ * can be evicted under memory pressure
+ */
+static int YAPP_MapSpectrum(YAPP_SEARCH_WORKER *pstWorker)
+{
+    int iNumBins = pstWorker->pstJob->iNumBins;
+    fftwf_complex *pfcSpec = NULL;
+
+    pstWorker->iFdSpec = YAPP_OOCFFT_OpenScratch();
+    if (YAPP_RET_ERROR == pstWorker->iFdSpec)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    /* the complex spectrum, followed by the stacked, segment, and
+       harmonic-summed power spectra */
+    pstWorker->lSpecMapLen = (size_t) iNumBins
+                             * (sizeof(fftwf_complex) + (3 * sizeof(float)));
+    if (ftruncate(pstWorker->iFdSpec, (off_t) pstWorker->lSpecMapLen) != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Creating scratch file failed! %s.\n",
+                       strerror(errno));
+        (void) close(pstWorker->iFdSpec);
+        return YAPP_RET_ERROR;
+    }
+    pstWorker->pvSpecMap = mmap(NULL,
+                                pstWorker->lSpecMapLen,
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED,
+                                pstWorker->iFdSpec,
+                                0);
+    if (MAP_FAILED == pstWorker->pvSpecMap)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Mapping scratch file failed! %s.\n",
+                       strerror(errno));
+        pstWorker->pvSpecMap = NULL;
+        (void) close(pstWorker->iFdSpec);
+        return YAPP_RET_ERROR;
+    }
+
+    pfcSpec = (fftwf_complex *) pstWorker->pvSpecMap;
+    pstWorker->pfcFFTBuf = pfcSpec;
+    pstWorker->pfPowSpec = (float *) (pfcSpec + iNumBins);
+    pstWorker->pfSegSpec = pstWorker->pfPowSpec + iNumBins;
+    pstWorker->pfSumSpec = pstWorker->pfSegSpec + iNumBins;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Unmap and remove the scratch file of an out-of-core search, if any
+ */
+static void YAPP_UnmapSpectrum(YAPP_SEARCH_WORKER *pstWorker)
+{
+    if (pstWorker->pvSpecMap != NULL)
+    {
+        (void) munmap(pstWorker->pvSpecMap, pstWorker->lSpecMapLen);
+        (void) close(pstWorker->iFdSpec);
+        pstWorker->pvSpecMap = NULL;
+        pstWorker->pfcFFTBuf = NULL;
+        pstWorker->pfPowSpec = NULL;
+        pstWorker->pfSegSpec = NULL;
+        pstWorker->pfSumSpec = NULL;
+    }
+
+    return;
+}
+
+
+/*
+ * Search one DM trial, adding candidates to the thread's candidate table
+ */
+static int YAPP_SearchDMTrial(YAPP_SEARCH_WORKER *pstWorker, int iFile)
+{
+    YAPP_SEARCH_JOB *pstJob = pstWorker->pstJob;
+    int iNumBins = pstJob->iNumBins;
+    int iHarm = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    iRet = YAPP_ReadSpectrum(pstWorker, iFile);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        return YAPP_RET_ERROR;
+    }
+
+    /* search for candidates at each harmonic-summing stage */
+    for (iHarm = 1; iHarm <= pstJob->iNumHarm; iHarm *= 2)
+    {
+        (void) YAPP_HarmonicSum(pstWorker->pfPowSpec,
+                                iNumBins,
+                                iHarm,
+                                pstWorker->pfSumSpec);
+        (void) YAPP_FindPeriodCands(pstWorker->pfSumSpec,
+                                    0,
+                                    pstJob->iLoBin * iHarm,
+                                    ((pstJob->iHiBin < (iNumBins / iHarm))
+                                     ? (pstJob->iHiBin * iHarm)
+                                     : iNumBins),
+                                    iHarm,
+                                    pstJob->iNumSegs,
+                                    pstJob->dTObs,
+                                    pstJob->pdDM[iFile],
+                                    0.0,
+                                    pstJob->fThreshold,
+                                    pstWorker->pstCands,
+                                    &pstWorker->iNumCands,
+                                    DEF_SEARCH_MAXCANDS);
+    }
+
+    /* remove duplicates, so that the table does not fill up with adjacent
+       bins of bright signals over many DM trials */
+    pstWorker->iNumCands = YAPP_SiftPeriodCands(pstWorker->pstCands,
+                                                pstWorker->iNumCands);
+    YAPP_UnmapSpectrum(pstWorker);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Acceleration search thread
+ */
+void* YAPP_AccelSearchBlocks(void *pvWorker)
+{
+    YAPP_SEARCH_WORKER *pstWorker = (YAPP_SEARCH_WORKER *) pvWorker;
+    YAPP_SEARCH_JOB *pstJob = pstWorker->pstJob;
+    int iBlock = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    while (YAPP_TRUE)
+    {
+        /* get the next block from the queue */
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        iBlock = pstJob->iNextBlock;
+        ++(pstJob->iNextBlock);
+        iRet = pstJob->iRet;
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+        if ((iBlock >= pstJob->iNumBlocks) || (iRet != YAPP_RET_SUCCESS))
+        {
+            break;
+        }
+
+        iRet = YAPP_AccelSearchBlock(pstWorker, iBlock);
+
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            pstJob->iRet = YAPP_RET_ERROR;
+        }
+        (void) printf("\rSearched block %d of %d of DM trial %d of %d.",
+                      iBlock + 1,
+                      pstJob->iNumBlocks,
+                      pstJob->iCurFile + 1,
+                      pstJob->iNumFiles);
+        (void) fflush(stdout);
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Search one block of the frequency - frequency derivative plane of the
+ * current DM trial, adding candidates to the thread's candidate table
+ */
+static int YAPP_AccelSearchBlock(YAPP_SEARCH_WORKER *pstWorker, int iBlock)
+{
+    YAPP_SEARCH_JOB *pstJob = pstWorker->pstJob;
+    int iNumBins = pstJob->iNumBins;
+    int iNumHarm = pstJob->iNumHarm;
+    int iNumZ = pstJob->iNumZ;
+    int iHalfWidth = pstJob->iRespHalfWidth;
+    int iCorrLen = pstJob->iCorrLen;
+    int iRowLen = pstJob->iBlockBins + 1;
+    int iStart = pstJob->iLoBin + (iBlock * pstJob->iBlockBins);
+    int iEnd = iStart + pstJob->iBlockBins;
+    int aiBase[YAPP_SEARCH_MAXHARM+1] = {0};
+    int aiZLo[YAPP_SEARCH_MAXHARM+1] = {0};
+    int aiZHi[YAPP_SEARCH_MAXHARM+1] = {0};
+    fftwf_complex *pfcKernel = NULL;
+    float *pfRow = NULL;
+    double dZ = 0.0;
+    double dFrac = 0.0;
+    long lZ = 0;
+    int iLo = 0;
+    int iHi = 0;
+    int iHarm = 0;
+    int iBin = 0;
+    int h = 0;
+    int j = 0;
+    int k = 0;
+    int i = 0;
+
+    if (iEnd > iNumBins)
+    {
+        iEnd = iNumBins;
+    }
+
+    /* the summed bin i, at z trial k, of a stage of H harmonics is made up
+       of harmonics j = 1 to H at bin (i * j / H) and frequency derivative
+       (z_k * j / H), so compute the part of the plane at each fraction
+       h / iNumHarm of the block that the harmonics fall in, using only the
+       z trials needed */
+    for (h = 1; h <= iNumHarm; ++h)
+    {
+        aiBase[h] = (int) ((((long) iStart * h) + (iNumHarm / 2)) / iNumHarm);
+        dFrac = (double) h / iNumHarm;
+
+        /* load the part of the spectrum the block correlates over */
+        for (i = 0; i < iCorrLen; ++i)
+        {
+            iBin = aiBase[h] - iHalfWidth + i;
+            if ((iBin >= 0) && (iBin < iNumBins))
+            {
+                pstWorker->pfcCorrIn[i][0] = pstJob->pfcSpec[iBin][0];
+                pstWorker->pfcCorrIn[i][1] = pstJob->pfcSpec[iBin][1];
+            }
+            else
+            {
+                pstWorker->pfcCorrIn[i][0] = 0.0;
+                pstWorker->pfcCorrIn[i][1] = 0.0;
+            }
+        }
+        fftwf_execute_dft(pstJob->stPlanCorrFwd,
+                          pstWorker->pfcCorrIn,
+                          pstWorker->pfcCorrFFT);
+
+        aiZLo[h] = (int) lround(((-pstJob->dZMax * dFrac) + pstJob->dZMax)
+                                / pstJob->dZStep);
+        aiZHi[h] = (int) lround(((pstJob->dZMax * dFrac) + pstJob->dZMax)
+                                / pstJob->dZStep);
+        for (k = aiZLo[h]; k <= aiZHi[h]; ++k)
+        {
+            /* multiply by the template FFT, and transform back - the valid
+               part of the circular convolution starts at iHalfWidth */
+            pfcKernel = pstJob->pfcKernels + ((long) k * iCorrLen);
+            for (i = 0; i < iCorrLen; ++i)
+            {
+                pstWorker->pfcCorrIn[i][0] =
+                            (pstWorker->pfcCorrFFT[i][0] * pfcKernel[i][0])
+                            - (pstWorker->pfcCorrFFT[i][1] * pfcKernel[i][1]);
+                pstWorker->pfcCorrIn[i][1] =
+                            (pstWorker->pfcCorrFFT[i][0] * pfcKernel[i][1])
+                            + (pstWorker->pfcCorrFFT[i][1] * pfcKernel[i][0]);
+            }
+            fftwf_execute_dft(pstJob->stPlanCorrBwd,
+                              pstWorker->pfcCorrIn,
+                              pstWorker->pfcCorrOut);
+
+            pfRow = pstWorker->pfPlane + ((((long) (h - 1) * iNumZ) + k)
+                                          * iRowLen);
+            for (i = 0; i < iRowLen; ++i)
+            {
+                pfRow[i] = (pstWorker->pfcCorrOut[iHalfWidth + i][0]
+                            * pstWorker->pfcCorrOut[iHalfWidth + i][0])
+                           + (pstWorker->pfcCorrOut[iHalfWidth + i][1]
+                              * pstWorker->pfcCorrOut[iHalfWidth + i][1]);
+            }
+        }
+    }
+
+    /* search for candidates at each harmonic-summing stage */
+    for (iHarm = 1; iHarm <= iNumHarm; iHarm *= 2)
+    {
+        iLo = pstJob->iLoBin * iHarm;
+        if (iLo < iStart)
+        {
+            iLo = iStart;
+        }
+        iHi = (pstJob->iHiBin < (iNumBins / iHarm))
+              ? (pstJob->iHiBin * iHarm)
+              : iNumBins;
+        if (iHi > iEnd)
+        {
+            iHi = iEnd;
+        }
+        if (iLo >= iHi)
+        {
+            continue;
+        }
+
+        for (k = 0; k < iNumZ; ++k)
+        {
+            dZ = -pstJob->dZMax + (k * pstJob->dZStep);
+            (void) memset(pstWorker->pfBlockSum,
+                          '\0',
+                          (iHi - iLo) * sizeof(float));
+            for (j = 1; j <= iHarm; ++j)
+            {
+                h = j * (iNumHarm / iHarm);
+                dFrac = (double) h / iNumHarm;
+                lZ = lround(((dZ * dFrac) + pstJob->dZMax) / pstJob->dZStep);
+                if (lZ < aiZLo[h])
+                {
+                    lZ = aiZLo[h];
+                }
+                else if (lZ > aiZHi[h])
+                {
+                    lZ = aiZHi[h];
+                }
+                pfRow = pstWorker->pfPlane
+                        + ((((long) (h - 1) * iNumZ) + lZ) * iRowLen);
+                for (i = iLo; i < iHi; ++i)
+                {
+                    pstWorker->pfBlockSum[i-iLo] +=
+                            pfRow[((((long) i * j) + (iHarm / 2)) / iHarm)
+                                  - aiBase[h]];
+                }
+            }
+
+            /* the fundamental is at bin (i / H), with a frequency derivative
+               of (z_k / H) */
+            (void) YAPP_FindPeriodCands(pstWorker->pfBlockSum,
+                                        iLo,
+                                        iLo,
+                                        iHi,
+                                        iHarm,
+                                        1,
+                                        pstJob->dTObs,
+                                        pstJob->pdDM[pstJob->iCurFile],
+                                        dZ / iHarm,
+                                        pstJob->fThreshold,
+                                        pstWorker->pstCands,
+                                        &pstWorker->iNumCands,
+                                        DEF_SEARCH_MAXCANDS);
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Normalise a power spectrum by its running median
+ */
+int YAPP_NormalisePowSpec(float *pfPowSpec,
+                          int iNumBins,
+                          int iMedWin,
+                          float *pfScratch)
+{
+    int iNumWins = iNumBins / iMedWin;
+    float fMedPrev = 0.0;
+    float fMedNext = 0.0;
+    float fNorm = 0.0;
+    int iCentrePrev = 0;
+    int iCentreNext = 0;
+    int i = 0;
+    int j = 0;
+
+    /* compute the median at the centre of each window, and linearly
+       interpolate between window centres - for exponentially distributed
+       noise powers, the mean is the median divided by ln(2) */
+    (void) memcpy(pfScratch, pfPowSpec, iMedWin * sizeof(float));
+    fMedNext = YAPP_CalcMedian(pfScratch, iMedWin) / (float) M_LN2;
+    iCentreNext = iMedWin / 2;
+    fMedPrev = fMedNext;
+    iCentrePrev = 0;
+    j = 1;
+    for (i = 0; i < iNumBins; ++i)
+    {
+        if (i >= iCentreNext)
+        {
+            fMedPrev = fMedNext;
+            iCentrePrev = iCentreNext;
+            if (j < iNumWins)
+            {
+                (void) memcpy(pfScratch,
+                              pfPowSpec + (j * iMedWin),
+                              iMedWin * sizeof(float));
+                fMedNext = YAPP_CalcMedian(pfScratch, iMedWin)
+                           / (float) M_LN2;
+                iCentreNext = (j * iMedWin) + (iMedWin / 2);
+                ++j;
+            }
+            else
+            {
+                /* past the last window centre, hold the last median */
+                iCentreNext = iNumBins;
+            }
+        }
+
+        if (iCentreNext > iCentrePrev)
+        {
+            fNorm = fMedPrev + ((fMedNext - fMedPrev)
+                                * (i - iCentrePrev)
+                                / (iCentreNext - iCentrePrev));
+        }
+        else
+        {
+            fNorm = fMedPrev;
+        }
+        if (fNorm > 0.0)
+        {
+            pfPowSpec[i] /= fNorm;
+        }
+        else
+        {
+            pfPowSpec[i] = 0.0;
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Incoherently sum harmonics
+ */
+int YAPP_HarmonicSum(float *pfPowSpec,
+                     int iNumBins,
+                     int iNumHarm,
+                     float *pfSumSpec)
+{
+    int i = 0;
+    int j = 0;
+
+    /* bin i of the summed spectrum corresponds to a fundamental at the
+       fractional bin (i / iNumHarm), so that the j-th harmonic falls at
+       bin (i * j / iNumHarm), rounded to the nearest bin */
+    for (i = 0; i < iNumBins; ++i)
+    {
+        pfSumSpec[i] = 0.0;
+        for (j = 1; j <= iNumHarm; ++j)
+        {
+            pfSumSpec[i] += pfPowSpec[(((long) i * j) + (iNumHarm / 2))
+                                      / iNumHarm];
+        }
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Compute the Fourier response of a linearly drifting signal
+ */
+int YAPP_CalcAccelResponse(double dZ,
+                           int iHalfWidth,
+                           fftwf_complex *pfcResp)
+{
+    /* sample the signal finely enough to resolve the highest frequency in
+       the integrand */
+    int iNumSteps = 8 * ((int) ceil(fabs(dZ)) + (2 * iHalfWidth) + 1);
+    double dStep = 1.0 / iNumSteps;
+    double dU = 0.0;
+    double dPhase = 0.0;
+    double dPhaseNext = 0.0;
+    double dRe = 0.0;
+    double dIm = 0.0;
+    double dSumRe = 0.0;
+    double dSumIm = 0.0;
+    double dRotRe = 0.0;
+    double dRotIm = 0.0;
+    double dRotRotRe = cos(2 * M_PI * dZ * dStep * dStep);
+    double dRotRotIm = sin(2 * M_PI * dZ * dStep * dStep);
+    double dTemp = 0.0;
+    int k = 0;
+    int m = 0;
+
+    /* a signal whose frequency drifts from (r - z/2) to (r + z/2) bins over
+       the spectrum has a phase of 2 pi (r u + z (u^2 - u) / 2) at fractional
+       time u, so its response at bin (r + k) is the integral over u of
+       exp(2 pi i (z (u^2 - u) / 2 - k u)) - the phase is quadratic in u, so
+       the integrand is stepped with two complex rotations instead of
+       evaluating the exponential at every step */
+    for (k = -iHalfWidth; k <= iHalfWidth; ++k)
+    {
+        dU = 0.5 * dStep;
+        dPhase = 2 * M_PI * ((dZ * ((dU * dU) - dU) / 2) - (k * dU));
+        dU += dStep;
+        dPhaseNext = 2 * M_PI * ((dZ * ((dU * dU) - dU) / 2) - (k * dU));
+        dRe = cos(dPhase);
+        dIm = sin(dPhase);
+        dRotRe = cos(dPhaseNext - dPhase);
+        dRotIm = sin(dPhaseNext - dPhase);
+        dSumRe = 0.0;
+        dSumIm = 0.0;
+        for (m = 0; m < iNumSteps; ++m)
+        {
+            dSumRe += dRe;
+            dSumIm += dIm;
+            dTemp = (dRe * dRotRe) - (dIm * dRotIm);
+            dIm = (dRe * dRotIm) + (dIm * dRotRe);
+            dRe = dTemp;
+            dTemp = (dRotRe * dRotRotRe) - (dRotIm * dRotRotIm);
+            dRotIm = (dRotRe * dRotRotIm) + (dRotIm * dRotRotRe);
+            dRotRe = dTemp;
+        }
+        pfcResp[k + iHalfWidth][0] = (float) (dSumRe * dStep);
+        pfcResp[k + iHalfWidth][1] = (float) (dSumIm * dStep);
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Compute the natural logarithm of the probability that the sum of
+ * iNumPowers exponentially distributed noise powers with unit mean is at
+ * least dPower - twice the sum follows a chi-square distribution with
+ * (2 * iNumPowers) degrees of freedom, whose tail probability for an even
+ * number of degrees of freedom is exp(-P) * sum_{k < n} (P^k / k!)
+ */
+static double YAPP_CalcLogPowerTail(double dPower, int iNumPowers)
+{
+    double dLogTerm = 0.0;
+    double dLogMax = 0.0;
+    double dSum = 0.0;
+    int k = 0;
+
+    if (dPower <= 0.0)
+    {
+        return 0.0;
+    }
+
+    /* the terms rise up to k ~ P, so the largest is the last one, or the one
+       at floor(P) */
+    k = (dPower < (iNumPowers - 1)) ? (int) dPower : (iNumPowers - 1);
+    dLogMax = (k * log(dPower)) - lgamma(k + 1.0);
+    for (k = 0; k < iNumPowers; ++k)
+    {
+        dLogTerm = (k * log(dPower)) - lgamma(k + 1.0);
+        dSum += exp(dLogTerm - dLogMax);
+    }
+
+    return (-dPower + dLogMax + log(dSum));
+}
+
+
+/*
+ * Compute the natural logarithm of the single-sided tail probability of a
+ * Gaussian beyond dSigma, using the asymptotic expansion where erfc()
+ * underflows
+ */
+static double YAPP_CalcLogGaussTail(double dSigma)
+{
+    double dSigmaSq = dSigma * dSigma;
+
+    if (dSigma < 30.0)
+    {
+        return log(0.5 * erfc(dSigma / M_SQRT2));
+    }
+
+    return ((-dSigmaSq / 2) - log(dSigma * sqrt(2 * M_PI))
+            + log(1.0 - (1.0 / dSigmaSq) + (3.0 / (dSigmaSq * dSigmaSq))));
+}
+
+
+/*
+ * Convert the logarithm of a tail probability to the number of sigmas at
+ * which a Gaussian has the same single-sided tail probability
+ */
+static double YAPP_CalcSigmaFromLogTail(double dLogTail)
+{
+    double dLo = -10.0;
+    double dHi = sqrt(-2 * dLogTail) + 10.0;
+    double dMid = 0.0;
+    int i = 0;
+
+    if (dLogTail >= 0.0)
+    {
+        return dLo;
+    }
+
+    /* the tail probability falls monotonically with sigma */
+    for (i = 0; i < 64; ++i)
+    {
+        dMid = (dLo + dHi) / 2;
+        if (YAPP_CalcLogGaussTail(dMid) > dLogTail)
+        {
+            dLo = dMid;
+        }
+        else
+        {
+            dHi = dMid;
+        }
+    }
+
+    return ((dLo + dHi) / 2);
+}
+
+
+/*
+ * Add candidates above threshold to the candidate table
+ */
+int YAPP_FindPeriodCands(float *pfSumSpec,
+                         int iOffset,
+                         int iLoBin,
+                         int iHiBin,
+                         int iNumHarm,
+                         int iNumStacked,
+                         double dTObs,
+                         double dDM,
+                         double dZ,
+                         float fThreshold,
+                         YAPP_PCAND *pstCands,
+                         int *piNumCands,
+                         int iMaxCands)
+{
+    /* the sum of n exponentially distributed powers with unit mean has a
+       mean of n, and its significance is that of a Gaussian with the same
+       tail probability */
+    int iNumPowers = iNumHarm * iNumStacked;
+    double dLogTailThres = YAPP_CalcLogGaussTail(fThreshold);
+    double dPowLo = 0.0;
+    double dPowHi = (double) iNumPowers;
+    double dPowMid = 0.0;
+    float fPowThres = 0.0;
+    float fSigma = 0.0;
+    float *pfSum = NULL;
+    int iSlot = 0;
+    int i = 0;
+    int j = 0;
+
+    /* find the power at the threshold once, so that the tail probability is
+       computed only for candidates */
+    while (YAPP_CalcLogPowerTail(dPowHi, iNumPowers) > dLogTailThres)
+    {
+        dPowLo = dPowHi;
+        dPowHi *= 2;
+    }
+    for (i = 0; i < 64; ++i)
+    {
+        dPowMid = (dPowLo + dPowHi) / 2;
+        if (YAPP_CalcLogPowerTail(dPowMid, iNumPowers) > dLogTailThres)
+        {
+            dPowLo = dPowMid;
+        }
+        else
+        {
+            dPowHi = dPowMid;
+        }
+    }
+    fPowThres = (float) dPowLo;
+
+    for (i = iLoBin; i < iHiBin; ++i)
+    {
+        pfSum = pfSumSpec + (i - iOffset);
+
+        if (pfSum[0] < fPowThres)
+        {
+            continue;
+        }
+
+        /* only consider local maxima */
+        if (((i > iLoBin) && (pfSum[0] < pfSum[-1]))
+            || ((i < (iHiBin - 1)) && (pfSum[0] < pfSum[1])))
+        {
+            continue;
+        }
+
+        fSigma = (float) YAPP_CalcSigmaFromLogTail(
+                            YAPP_CalcLogPowerTail(pfSum[0], iNumPowers));
+        if (fSigma < fThreshold)
+        {
+            continue;
+        }
+
+        if (*piNumCands < iMaxCands)
+        {
+            iSlot = *piNumCands;
+            ++(*piNumCands);
+        }
+        else
+        {
+            /* table is full, replace the weakest candidate, if this one is
+               stronger */
+            iSlot = 0;
+            for (j = 1; j < iMaxCands; ++j)
+            {
+                if (pstCands[j].fSigma < pstCands[iSlot].fSigma)
+                {
+                    iSlot = j;
+                }
+            }
+            if (pstCands[iSlot].fSigma >= fSigma)
+            {
+                continue;
+            }
+        }
+
+        pstCands[iSlot].dBin = (double) i / iNumHarm;
+        pstCands[iSlot].dFreq = pstCands[iSlot].dBin / dTObs;
+        pstCands[iSlot].dDM = dDM;
+        pstCands[iSlot].dZ = dZ;
+        pstCands[iSlot].fPower = pfSum[0];
+        pstCands[iSlot].fSigma = fSigma;
+        pstCands[iSlot].iNumHarm = iNumHarm;
+    }
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Candidate comparison function for qsort()
+ */
+int YAPP_ComparePeriodCands(const void *pvCand1, const void *pvCand2)
+{
+    const YAPP_PCAND *pstCand1 = (const YAPP_PCAND *) pvCand1;
+    const YAPP_PCAND *pstCand2 = (const YAPP_PCAND *) pvCand2;
+
+    if (pstCand1->fSigma > pstCand2->fSigma)
+    {
+        return -1;
+    }
+    if (pstCand1->fSigma < pstCand2->fSigma)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Candidate comparison function for qsort(), by DM and Fourier bin
+ */
+static int YAPP_ComparePeriodCandBins(const void *pvCand1,
+                                      const void *pvCand2)
+{
+    const YAPP_PCAND *pstCand1 = (const YAPP_PCAND *) pvCand1;
+    const YAPP_PCAND *pstCand2 = (const YAPP_PCAND *) pvCand2;
+
+    if (pstCand1->dDM < pstCand2->dDM)
+    {
+        return -1;
+    }
+    if (pstCand1->dDM > pstCand2->dDM)
+    {
+        return 1;
+    }
+    if (pstCand1->dBin < pstCand2->dBin)
+    {
+        return -1;
+    }
+    if (pstCand1->dBin > pstCand2->dBin)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Sorts the candidate table and removes duplicates
+ */
+int YAPP_SiftPeriodCands(YAPP_PCAND *pstCands, int iNumCands)
+{
+    int iNumUnique = 0;
+    int i = 0;
+
+    if (0 == iNumCands)
+    {
+        return 0;
+    }
+
+    /* the same signal is detected in adjacent bins, and at multiple
+       harmonic-summing stages - sort by bin, and keep only the most
+       significant candidate of each cluster of adjacent bins */
+    qsort(pstCands, iNumCands, sizeof(YAPP_PCAND), YAPP_ComparePeriodCandBins);
+    for (i = 1; i < iNumCands; ++i)
+    {
+        if ((pstCands[i].dDM == pstCands[iNumUnique].dDM)
+            && ((pstCands[i].dBin - pstCands[iNumUnique].dBin)
+                <= YAPP_SEARCH_BIN_TOL))
+        {
+            if (pstCands[i].fSigma > pstCands[iNumUnique].fSigma)
+            {
+                pstCands[iNumUnique] = pstCands[i];
+            }
+        }
+        else
+        {
+            ++iNumUnique;
+            pstCands[iNumUnique] = pstCands[i];
+        }
+    }
+    ++iNumUnique;
+
+    /* rank by significance */
+    qsort(pstCands, iNumUnique, sizeof(YAPP_PCAND), YAPP_ComparePeriodCands);
+
+    return iNumUnique;
+}
+
+
+/*
+ * Removes candidates harmonically related to a more significant candidate
+ */
+int YAPP_SiftPeriodCandHarmonics(YAPP_PCAND *pstCands,
+                                 int iNumCands,
+                                 int iMaxHarm,
+                                 int iMaxOut)
+{
+    int iNumKept = 0;
+    char cIsHarm = YAPP_FALSE;
+    double dRatio = 0.0;
+    int i = 0;
+    int j = 0;
+    int m = 0;
+    int n = 0;
+
+    /* the table is in descending order of significance, so each candidate
+       need only be compared with those already kept - candidate i is taken
+       to be the (n/m)-th harmonic of candidate j if m times its bin is
+       within tolerance of n times the bin of j, and the same signal at a
+       different DM is the case m = n = 1 */
+    for (i = 0; (i < iNumCands) && (iNumKept < iMaxOut); ++i)
+    {
+        cIsHarm = YAPP_FALSE;
+        for (j = 0; (j < iNumKept) && (YAPP_FALSE == cIsHarm); ++j)
+        {
+            dRatio = pstCands[i].dBin / pstCands[j].dBin;
+            for (m = 1; m <= iMaxHarm; ++m)
+            {
+                n = (int) lround(dRatio * m);
+                if ((n >= 1) && (n <= iMaxHarm)
+                    && (fabs((m * pstCands[i].dBin) - (n * pstCands[j].dBin))
+                        <= (YAPP_SEARCH_BIN_TOL * ((m > n) ? m : n))))
+                {
+                    cIsHarm = YAPP_TRUE;
+                    break;
+                }
+            }
+        }
+        if (YAPP_FALSE == cIsHarm)
+        {
+            pstCands[iNumKept] = pstCands[i];
+            ++iNumKept;
+        }
+    }
+
+    return iNumKept;
+}
+
+
+/*
+ * Write a ranked candidate list to an ASCII file
+ */
+int YAPP_WritePeriodCands(char *pcFileCand,
+                          char *pcFileData,
+                          YAPP_PCAND *pstCands,
+                          int iNumCands)
+{
+    FILE *pFCand = NULL;
+    int i = 0;
+
+    pFCand = fopen(pcFileCand, "w");
+    if (NULL == pFCand)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileCand,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    /* write necessary metadata */
+    (void) fprintf(pFCand,
+                   "# Data file                         : %s\n",
+                   pcFileData);
+    (void) fprintf(pFCand,
+                   "# Number of candidates              : %d\n",
+                   iNumCands);
+    (void) fprintf(pFCand,
+                   "# Rank  Frequency (Hz)  Period (ms)  DM (cm^-3 pc)  z  "
+                   "Harmonics  Power  Sigma\n");
+    /* write candidates */
+    for (i = 0; i < iNumCands; ++i)
+    {
+        (void) fprintf(pFCand,
+                       "%d %.10g %.10g %g %g %d %g %g\n",
+                       i + 1,
+                       pstCands[i].dFreq,
+                       1e3 / pstCands[i].dFreq,
+                       pstCands[i].dDM,
+                       pstCands[i].dZ,
+                       pstCands[i].iNumHarm,
+                       pstCands[i].fPower,
+                       pstCands[i].fSigma);
+    }
+
+    (void) fclose(pFCand);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Prints usage information
+ */
+void PrintUsage(const char *pcProgName)
+{
+    (void) printf("Usage: %s [options] <data-files>\n",
+                  pcProgName);
+    (void) printf("    -h  --help                          ");
+    (void) printf("Display this usage information\n");
+    (void) printf("    -s  --skip <time>                   ");
+    (void) printf("The length of data in seconds, to be\n");
+    (void) printf("                                        ");
+    (void) printf("skipped\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 0 s)\n");
+    (void) printf("    -p  --proc <time>                   ");
+    (void) printf("The length of data in seconds, to be\n");
+    (void) printf("                                        ");
+    (void) printf("processed\n");
+    (void) printf("                                        ");
+    (void) printf("(default is all)\n");
+    (void) printf("    -n  --nsamp <samples>               ");
+    (void) printf("FFT length - if less than the length\n");
+    (void) printf("                                        ");
+    (void) printf("of the data, the power spectra of\n");
+    (void) printf("                                        ");
+    (void) printf("consecutive segments are stacked\n");
+    (void) printf("                                        ");
+    (void) printf("(default is all)\n");
+    (void) printf("    -m  --nharm <numharm>               ");
+    (void) printf("Maximum number of harmonics to sum\n");
+    (void) printf("                                        ");
+    (void) printf("(1, 2, 4, 8, 16, or 32)\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 16)\n");
+    (void) printf("    -w  --medwin <bins>                 ");
+    (void) printf("Running median window, in bins\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 512)\n");
+    (void) printf("    -l  --fmin <freq>                   ");
+    (void) printf("Minimum frequency to search, in Hz\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 1 Hz)\n");
+    (void) printf("    -u  --fmax <freq>                   ");
+    (void) printf("Maximum frequency to search, in Hz\n");
+    (void) printf("                                        ");
+    (void) printf("(default is the Nyquist frequency)\n");
+    (void) printf("    -t  --threshold <sigmas>            ");
+    (void) printf("Threshold in sigmas\n");
+    (void) printf("                                        ");
+    (void) printf("(default is computed from the number\n");
+    (void) printf("                                        ");
+    (void) printf("of bins and harmonic-summing stages)\n");
+    (void) printf("    -c  --numcands <numcands>           ");
+    (void) printf("Number of candidates to write\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 100)\n");
+    (void) printf("    -z  --zmax <z>                      ");
+    (void) printf("Maximum Fourier frequency derivative\n");
+    (void) printf("                                        ");
+    (void) printf("(drift in bins) for an acceleration\n");
+    (void) printf("                                        ");
+    (void) printf("search\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 0, no acceleration search)\n");
+    (void) printf("    -d  --dz <step>                     ");
+    (void) printf("Step in Fourier frequency derivative\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 2)\n");
+    (void) printf("    -j  --threads <numthreads>          ");
+    (void) printf("Number of search threads\n");
+    (void) printf("                                        ");
+    (void) printf("(default is the number of processors)\n");
+    (void) printf("    -o  --ooc <memsize>                 ");
+    (void) printf("Compute FFTs out of core, using\n");
+    (void) printf("                                        ");
+    (void) printf("scratch files in the current\n");
+    (void) printf("                                        ");
+    (void) printf("directory and at most memsize MB\n");
+    (void) printf("                                        ");
+    (void) printf("per thread\n");
+    (void) printf("                                        ");
+    (void) printf("(default is to compute FFTs in memory)\n");
+    (void) printf("    -b  --db <database-file>            ");
+    (void) printf("Also add the candidates to a\n");
+    (void) printf("                                        ");
+    (void) printf("candidate database\n");
+    (void) printf("    -v  --version                       ");
+    (void) printf("Display the version\n");
+
+    return;
+}
+
@@ -0,0 +1,282 @@
+/**
+ * @file yapp_search.h
+ * Header file for yapp_search
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_SEARCH_H__
+#define __YAPP_SEARCH_H__
+
+#include <limits.h>
+#include <pthread.h>
+#include <fftw3.h>
+#include "yapp_oocfft.h"
+
+#define EXT_YAPP_PCAND          ".ypc"  /* periodicity candidate list */
+
+#define YAPP_SEARCH_MAXHARM     32      /* maximum number of harmonics
+                                           summed */
+#define YAPP_SEARCH_MAXTHREADS  64      /* maximum number of search threads */
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_SEARCH_NUMHARM      16      /**< @brief Default number of harmonics
+                                             summed */
+#define DEF_SEARCH_MEDWIN       512     /**< @brief Default running median
+                                             window, in bins */
+#define DEF_SEARCH_FMIN         1.0     /**< @brief Default minimum frequency
+                                             searched, in Hz */
+#define DEF_SEARCH_NUMCANDS     100     /**< @brief Default number of
+                                             candidates written */
+#define DEF_SEARCH_MAXCANDS     65536   /**< @brief Capacity of the candidate
+                                             table */
+#define DEF_SEARCH_ZSTEP        2.0     /**< @brief Default step in Fourier
+                                             frequency derivative, in bins */
+/* @} */
+
+/* tolerance for two candidates to be considered the same, in Fourier bins */
+#define YAPP_SEARCH_BIN_TOL     1.1
+
+/* number of bins on either side of the drifted signal included in the
+   acceleration search template response */
+#define YAPP_SEARCH_RESP_PAD    8
+/* the correlation FFT length is at least this times the template length */
+#define YAPP_SEARCH_CORR_FACTOR 4
+
+/**
+ * Periodicity candidate
+ */
+typedef struct tagPeriodCand
+{
+    double dFreq;       /* fundamental frequency, in Hz */
+    double dBin;        /* fundamental Fourier bin */
+    double dDM;         /* in cm^-3 pc */
+    double dZ;          /* Fourier frequency derivative - drift in bins over
+                           the length of the spectrum */
+    float fPower;       /* summed normalised power */
+    float fSigma;       /* Gaussian-equivalent significance */
+    int iNumHarm;       /* number of harmonics summed */
+} YAPP_PCAND;
+
+/**
+ * Search parameters and work queue shared by all search threads
+ */
+typedef struct tagSearchJob
+{
+    char **ppcFileData;         /* time series files, one per DM trial */
+    int *piHeaderLen;           /* header length of each file */
+    float *pfSampSize;          /* sample size of each file, in bytes */
+    double *pdDM;               /* DM of each file */
+    int iNumFiles;
+    int iTimeSampsSkip;         /* time samples to be skipped in each file */
+    int iBlockSize;             /* FFT length */
+    int iNumSegs;               /* number of segments stacked */
+    int iNumBins;
+    int iMedWin;
+    int iNumHarm;
+    int iLoBin;
+    int iHiBin;
+    double dTObs;               /* length of a segment, in s */
+    float fThreshold;
+    fftwf_plan stPlanFwd;       /* shared plan, executed on per-thread
+                                   buffers */
+    size_t lOOCMemSize;         /* memory per thread for out-of-core FFTs,
+                                   in bytes, 0 for in-memory FFTs */
+    /* acceleration search */
+    double dZMax;               /* maximum |z|, 0 for no acceleration
+                                   search */
+    double dZStep;
+    int iNumZ;                  /* number of z trials */
+    int iRespHalfWidth;         /* half-width of the template response, in
+                                   bins */
+    int iCorrLen;               /* overlap-save FFT length */
+    int iBlockBins;             /* bins searched per overlap-save block */
+    int iNumBlocks;
+    fftwf_complex *pfcKernels;  /* FFTs of the template responses, iNumZ
+                                   rows of iCorrLen */
+    fftwf_plan stPlanCorrFwd;
+    fftwf_plan stPlanCorrBwd;
+    fftwf_complex *pfcSpec;     /* normalised spectrum of the current DM
+                                   trial */
+    int iCurFile;
+    pthread_mutex_t stMutex;    /* protects the fields below */
+    int iNextFile;              /* next DM trial to be searched */
+    int iNumDone;               /* number of DM trials searched */
+    int iNextBlock;             /* next acceleration search block */
+    int iRet;                   /* set to YAPP_RET_ERROR if any thread
+                                   fails */
+} YAPP_SEARCH_JOB;
+
+/**
+ * Per-thread search buffers and candidate table
+ */
+typedef struct tagSearchWorker
+{
+    YAPP_SEARCH_JOB *pstJob;
+    char *pcRawBuf;             /* raw data, iBlockSize samples */
+    float *pfBuf;               /* FFT input, allocated with fftwf_malloc() */
+    fftwf_complex *pfcFFTBuf;   /* FFT output, allocated with
+                                   fftwf_malloc() */
+    float *pfPowSpec;           /* stacked power spectrum */
+    float *pfSegSpec;           /* power spectrum of one segment */
+    float *pfSumSpec;           /* harmonic-summed spectrum */
+    float *pfScratch;           /* running median scratch buffer */
+    void *pvSpecMap;            /* in an out-of-core search, mapping of the
+                                   scratch file holding the complex spectrum,
+                                   followed by the power spectra */
+    size_t lSpecMapLen;
+    int iFdSpec;                /* scratch file descriptor */
+    fftwf_complex *pfcCorrIn;   /* overlap-save buffers, iCorrLen long */
+    fftwf_complex *pfcCorrFFT;
+    fftwf_complex *pfcCorrOut;
+    float *pfPlane;             /* power in the frequency - frequency
+                                   derivative plane, for each harmonic */
+    float *pfBlockSum;          /* harmonic-summed powers of one block */
+    YAPP_PCAND *pstCands;       /* candidate table */
+    int iNumCands;
+    pthread_t stThread;
+} YAPP_SEARCH_WORKER;
+
+/**
+ * Normalise a power spectrum by its running median, so that noise powers
+ * follow an exponential distribution with unit mean
+ *
+ * @param[inout]    pfPowSpec       Power spectrum
+ * @param[in]       iNumBins        Number of bins in the power spectrum
+ * @param[in]       iMedWin         Running median window, in bins
+ * @param[in]       pfScratch       Scratch buffer, iMedWin long
+ */
+int YAPP_NormalisePowSpec(float *pfPowSpec,
+                          int iNumBins,
+                          int iMedWin,
+                          float *pfScratch);
+
+/**
+ * Incoherently sum harmonics of a normalised power spectrum
+ *
+ * @param[in]       pfPowSpec       Normalised power spectrum
+ * @param[in]       iNumBins        Number of bins in the power spectrum
+ * @param[in]       iNumHarm        Number of harmonics to sum
+ * @param[out]      pfSumSpec       Harmonic-summed spectrum, iNumBins long,
+ *                                  with bin i corresponding to a
+ *                                  fundamental at bin (i / iNumHarm)
+ */
+int YAPP_HarmonicSum(float *pfPowSpec,
+                     int iNumBins,
+                     int iNumHarm,
+                     float *pfSumSpec);
+
+/**
+ * Compute the Fourier response of a signal whose frequency drifts linearly by
+ * dZ bins over the length of the spectrum, centred on its mean frequency
+ *
+ * @param[in]       dZ              Fourier frequency derivative
+ * @param[in]       iHalfWidth      Half-width of the response, in bins
+ * @param[out]      pfcResp         Response at bin offsets -iHalfWidth to
+ *                                  iHalfWidth, (2 * iHalfWidth + 1) long
+ */
+int YAPP_CalcAccelResponse(double dZ,
+                           int iHalfWidth,
+                           fftwf_complex *pfcResp);
+
+/**
+ * Add candidates above threshold in a harmonic-summed spectrum to the
+ * candidate table, replacing the weakest candidate if the table is full
+ *
+ * @param[in]       pfSumSpec       Harmonic-summed spectrum
+ * @param[in]       iOffset         Bin number of the first element of
+ *                                  pfSumSpec
+ * @param[in]       iLoBin          First bin of the summed spectrum to
+ *                                  search
+ * @param[in]       iHiBin          One past the last bin of the summed
+ *                                  spectrum to search
+ * @param[in]       iNumHarm        Number of harmonics summed
+ * @param[in]       iNumStacked     Number of spectra stacked
+ * @param[in]       dTObs           Length of the spectrum, in s
+ * @param[in]       dDM             DM of the time series
+ * @param[in]       dZ              Fourier frequency derivative
+ * @param[in]       fThreshold      Threshold in sigmas of a Gaussian with
+ *                                  the same tail probability
+ * @param[inout]    pstCands        Candidate table
+ * @param[inout]    piNumCands      Number of candidates in the table
+ * @param[in]       iMaxCands       Capacity of the candidate table
+ */
+int YAPP_FindPeriodCands(float *pfSumSpec,
+                         int iOffset,
+                         int iLoBin,
+                         int iHiBin,
+                         int iNumHarm,
+                         int iNumStacked,
+                         double dTObs,
+                         double dDM,
+                         double dZ,
+                         float fThreshold,
+                         YAPP_PCAND *pstCands,
+                         int *piNumCands,
+                         int iMaxCands);
+
+/**
+ * Candidate comparison function for qsort() - sorts in descending order of
+ * significance
+ */
+int YAPP_ComparePeriodCands(const void *pvCand1, const void *pvCand2);
+
+/**
+ * Sorts the candidate table and removes duplicates, returning the number of
+ * unique candidates
+ *
+ * @param[inout]    pstCands        Candidate table
+ * @param[in]       iNumCands       Number of candidates in the table
+ */
+int YAPP_SiftPeriodCands(YAPP_PCAND *pstCands, int iNumCands);
+
+/**
+ * Removes candidates that are harmonically related to a more significant
+ * candidate, including the same signal detected at a different DM, and
+ * returns the number of candidates kept
+ *
+ * @param[inout]    pstCands        Candidate table, sorted in descending
+ *                                  order of significance
+ * @param[in]       iNumCands       Number of candidates in the table
+ * @param[in]       iMaxHarm        Highest harmonic number considered
+ * @param[in]       iMaxOut         Maximum number of candidates to keep
+ */
+int YAPP_SiftPeriodCandHarmonics(YAPP_PCAND *pstCands,
+                                 int iNumCands,
+                                 int iMaxHarm,
+                                 int iMaxOut);
+
+/**
+ * Search thread - searches DM trials from the work queue until it is empty
+ *
+ * @param[in]       pvWorker        Pointer to a YAPP_SEARCH_WORKER
+ */
+void* YAPP_SearchDMTrials(void *pvWorker);
+
+/**
+ * Acceleration search thread - searches blocks of the current DM trial in
+ * the frequency - frequency derivative plane until none are left
+ *
+ * @param[in]       pvWorker        Pointer to a YAPP_SEARCH_WORKER
+ */
+void* YAPP_AccelSearchBlocks(void *pvWorker);
+
+/**
+ * Write a ranked candidate list to an ASCII file
+ *
+ * @param[in]       pcFileCand      Candidate filename
+ * @param[in]       pcFileData      Name of the searched data file
+ * @param[in]       pstCands        Candidate table
+ * @param[in]       iNumCands       Number of candidates to write
+ */
+int YAPP_WritePeriodCands(char *pcFileCand,
+                          char *pcFileData,
+                          YAPP_PCAND *pstCands,
+                          int iNumCands);
+
+#endif  /* __YAPP_SEARCH_H__ */
+
@@ -0,0 +1,780 @@
+/**
+ * @file yapp_shm.c
+ * Shared-memory ring buffer routines - a producer, such as a backend at the
+ *  telescope, writes blocks of data to a ring, and a tool attaches to it and
+ *  reads the blocks as a stream, as it would read a file, so that the data
+ *  is processed as it comes in.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_shm.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#define YAPP_SHM_ALIGN          4096    /* alignment of block 0 */
+#define YAPP_SHM_POLLINT        100000  /* interval at which a reader looks
+                                           for a ring that is not ready, in
+                                           us */
+
+static void GetObjectName(const char *pcName, char *pcObj);
+static void* MapObject(const char *pcObj, size_t *plMapSize);
+static int WaitForBlock(sem_t *pstSem, int iTimeout);
+static int NextBlock(YAPP_SHM_READER *pstReader);
+static void ReleaseBlock(YAPP_SHM_READER *pstReader);
+static ssize_t ReadStream(void *pvCookie, char *pcBuf, size_t lSize);
+static int SeekStream(void *pvCookie, off64_t *plOffset, int iWhence);
+static int CloseStream(void *pvCookie);
+
+/*
+ * Create a ring and make it ready for a reader to attach to
+ */
+YAPP_SHM_WRITER* YAPP_SHM_Create(const char *pcName,
+                                 const YAPP_SHM_HEADER *pstTemplate)
+{
+    YAPP_SHM_WRITER *pstWriter = NULL;
+    YAPP_SHM_HEADER *pstHdr = NULL;
+    long int lDataOffset = 0;
+    int iFD = 0;
+    void *pvMap = NULL;
+    int iRet = YAPP_RET_SUCCESS;
+
+    if ((pstTemplate->iNumBlocks <= 0) || (pstTemplate->lBlockSize <= 0))
+    {
+        (void) fprintf(stderr, "ERROR: Invalid ring size!\n");
+        return NULL;
+    }
+
+    pstWriter = (YAPP_SHM_WRITER *) calloc(1, sizeof(YAPP_SHM_WRITER));
+    if (NULL == pstWriter)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return NULL;
+    }
+    GetObjectName(pcName, pstWriter->acName);
+
+    /* the blocks are page-aligned after the headers */
+    lDataOffset = sizeof(YAPP_SHM_HEADER)
+                  + (pstTemplate->iNumBlocks * sizeof(YAPP_SHM_BLOCKHEADER));
+    lDataOffset = ((lDataOffset + YAPP_SHM_ALIGN - 1) / YAPP_SHM_ALIGN)
+                  * YAPP_SHM_ALIGN;
+    pstWriter->lMapSize = (size_t) lDataOffset
+                          + ((size_t) pstTemplate->iNumBlocks
+                             * pstTemplate->lBlockSize);
+
+    /* a ring left behind by a producer that did not exit cleanly is
+       replaced - a reader still attached to it keeps its mapping */
+    (void) shm_unlink(pstWriter->acName);
+    iFD = shm_open(pstWriter->acName, O_CREAT | O_EXCL | O_RDWR,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    if (iFD < 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Creating shared-memory object %s failed! %s.\n",
+                       pstWriter->acName,
+                       strerror(errno));
+        free(pstWriter);
+        return NULL;
+    }
+    iRet = ftruncate(iFD, (off_t) pstWriter->lMapSize);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Sizing shared-memory object %s failed! %s.\n",
+                       pstWriter->acName,
+                       strerror(errno));
+        (void) close(iFD);
+        (void) shm_unlink(pstWriter->acName);
+        free(pstWriter);
+        return NULL;
+    }
+    pvMap = mmap(NULL,
+                 pstWriter->lMapSize,
+                 PROT_READ | PROT_WRITE,
+                 MAP_SHARED,
+                 iFD,
+                 0);
+    (void) close(iFD);
+    if (MAP_FAILED == pvMap)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Mapping shared-memory object %s failed! %s.\n",
+                       pstWriter->acName,
+                       strerror(errno));
+        (void) shm_unlink(pstWriter->acName);
+        free(pstWriter);
+        return NULL;
+    }
+
+    pstHdr = (YAPP_SHM_HEADER *) pvMap;
+    (void) memcpy(pstHdr, pstTemplate, sizeof(YAPP_SHM_HEADER));
+    (void) memset(pstHdr->acMagic, '\0', YAPP_SHM_LEN_MAGIC);
+    pstHdr->iVersion = YAPP_SHM_VERSION;
+    pstHdr->lDataOffset = lDataOffset;
+    if ((sem_init(&pstHdr->stFree, 1, (unsigned int) pstHdr->iNumBlocks) != 0)
+        || (sem_init(&pstHdr->stFilled, 1, 0) != 0)
+        || (sem_init(&pstHdr->stAttached, 1, 0) != 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Initialising semaphores failed! %s.\n",
+                       strerror(errno));
+        (void) munmap(pvMap, pstWriter->lMapSize);
+        (void) shm_unlink(pstWriter->acName);
+        free(pstWriter);
+        return NULL;
+    }
+    pstWriter->pstHdr = pstHdr;
+    pstWriter->pstBlkHdr = (YAPP_SHM_BLOCKHEADER *) (pstHdr + 1);
+    pstWriter->pcData = (char *) pvMap + lDataOffset;
+
+    /* the magic string goes in last, once the rest of the header is
+       visible */
+    __sync_synchronize();
+    (void) memcpy(pstHdr->acMagic, YAPP_SHM_MAGIC, YAPP_SHM_LEN_MAGIC);
+
+    return pstWriter;
+}
+
+
+/*
+ * Write a block to a ring
+ */
+int YAPP_SHM_Write(YAPP_SHM_WRITER *pstWriter,
+                   const char *pcBuf,
+                   long int lLen,
+                   char cCanDrop)
+{
+    YAPP_SHM_HEADER *pstHdr = pstWriter->pstHdr;
+    int iRet = YAPP_RET_SUCCESS;
+
+    if ((lLen <= 0) || (lLen > pstHdr->lBlockSize))
+    {
+        (void) fprintf(stderr, "ERROR: Invalid block length %ld!\n", lLen);
+        return YAPP_RET_ERROR;
+    }
+
+    if (cCanDrop)
+    {
+        iRet = sem_trywait(&pstHdr->stFree);
+        if ((iRet != 0) && (EAGAIN == errno))
+        {
+            /* the reader is behind - drop the block, but count it, so that
+               the reader knows where the data that follows goes */
+            ++pstWriter->lSeq;
+            ++pstWriter->lNumDropped;
+            return YAPP_RET_SUCCESS;
+        }
+    }
+    else
+    {
+        do
+        {
+            iRet = sem_wait(&pstHdr->stFree);
+        }
+        while ((iRet != 0) && (EINTR == errno));
+    }
+    if (iRet != 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Waiting for a free block failed! %s.\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    (void) memcpy(pstWriter->pcData
+                  + ((size_t) pstWriter->iBlock * pstHdr->lBlockSize),
+                  pcBuf,
+                  (size_t) lLen);
+    pstWriter->pstBlkHdr[pstWriter->iBlock].lSeq = pstWriter->lSeq;
+    pstWriter->pstBlkHdr[pstWriter->iBlock].lLen = lLen;
+    (void) sem_post(&pstHdr->stFilled);
+
+    pstWriter->iBlock = (pstWriter->iBlock + 1) % pstHdr->iNumBlocks;
+    ++pstWriter->lSeq;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Mark the end of the data, and remove the ring
+ */
+int YAPP_SHM_Destroy(YAPP_SHM_WRITER *pstWriter)
+{
+    YAPP_SHM_HEADER *pstHdr = pstWriter->pstHdr;
+    int iRet = YAPP_RET_SUCCESS;
+
+    /* the end-of-data block needs a free block too, but the reader may be
+       gone, so it is not waited for indefinitely */
+    iRet = WaitForBlock(&pstHdr->stFree, DEF_SHM_TIMEOUT);
+    if (YAPP_RET_SUCCESS == iRet)
+    {
+        pstWriter->pstBlkHdr[pstWriter->iBlock].lSeq = pstWriter->lSeq;
+        pstWriter->pstBlkHdr[pstWriter->iBlock].lLen = 0;
+        (void) sem_post(&pstHdr->stFilled);
+    }
+    else
+    {
+        (void) fprintf(stderr,
+                       "WARNING: No free block for the end of the data!\n");
+    }
+
+    /* a reader started along with the producer may not have attached yet,
+       and could not once the ring is removed, so it is waited for, but not
+       indefinitely */
+    if (WaitForBlock(&pstHdr->stAttached, DEF_SHM_TIMEOUT)
+        != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "WARNING: No reader attached in %d s!\n",
+                       DEF_SHM_TIMEOUT);
+        iRet = YAPP_RET_ERROR;
+    }
+
+    /* the semaphores are not destroyed, as a reader may still be attached -
+       the memory is released once it detaches */
+    (void) munmap(pstHdr, pstWriter->lMapSize);
+    (void) shm_unlink(pstWriter->acName);
+    free(pstWriter);
+
+    return iRet;
+}
+
+
+/*
+ * Attach to a ring as a stream
+ */
+FILE* YAPP_SHM_Open(const char *pcName, int iDataType, YUM_t *pstYUM)
+{
+    YAPP_SHM_READER *pstReader = NULL;
+    YAPP_SHM_HEADER *pstHdr = NULL;
+    cookie_io_functions_t stFuncs = {0};
+    FILE *pFStream = NULL;
+    float fFChan1 = 0.0;
+    void *pvMap = NULL;
+
+    /* the reader is freed when the stream is closed, which may happen after
+       YAPP_CleanUp() has freed the memory allocated with YAPP_Malloc(), so
+       it is allocated with calloc() */
+    pstReader = (YAPP_SHM_READER *) calloc(1, sizeof(YAPP_SHM_READER));
+    if (NULL == pstReader)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return NULL;
+    }
+    GetObjectName(pcName, pstReader->acName);
+
+    pvMap = MapObject(pstReader->acName, &pstReader->lMapSize);
+    if (NULL == pvMap)
+    {
+        free(pstReader);
+        return NULL;
+    }
+    pstHdr = (YAPP_SHM_HEADER *) pvMap;
+    pstReader->pstHdr = pstHdr;
+
+    /* validate the header - the magic string has been checked in
+       MapObject() */
+    __sync_synchronize();
+    if (pstHdr->iVersion != YAPP_SHM_VERSION)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Unsupported ring buffer version %d!\n",
+                       pstHdr->iVersion);
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+    if ((pstHdr->iNumBlocks <= 0)
+        || (pstHdr->lBlockSize <= 0)
+        || (pstHdr->lDataOffset
+            < (int64_t) (sizeof(YAPP_SHM_HEADER)
+                         + (pstHdr->iNumBlocks
+                            * sizeof(YAPP_SHM_BLOCKHEADER))))
+        || ((size_t) (pstHdr->lDataOffset
+                      + (pstHdr->iNumBlocks * pstHdr->lBlockSize))
+            > pstReader->lMapSize))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid ring size in %s!\n",
+                       pstReader->acName);
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+    if (pstHdr->iDataType != iDataType)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: %s holds %s data!\n",
+                       pstReader->acName,
+                       (YAPP_SHM_DATA_RAW == pstHdr->iDataType)
+                       ? "baseband" : "filterbank");
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+    if ((pstHdr->lNumSamps <= 0)
+        || (pstHdr->iNumChans <= 0)
+        || (pstHdr->dTSamp <= 0.0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid metadata in %s!\n",
+                       pstReader->acName);
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+    pstReader->pstBlkHdr = (YAPP_SHM_BLOCKHEADER *) (pstHdr + 1);
+    pstReader->pcData = (char *) pvMap + pstHdr->lDataOffset;
+
+    /* fill in the metadata - the names are bounded, in case the producer
+       has not null-terminated them */
+    (void) snprintf(pstYUM->acPulsar,
+                    sizeof(pstYUM->acPulsar),
+                    "%.*s",
+                    (int) sizeof(pstYUM->acPulsar) - 1,
+                    pstHdr->acPulsar);
+    (void) snprintf(pstYUM->acSite,
+                    sizeof(pstYUM->acSite),
+                    "%.*s",
+                    YAPP_SHM_LEN_NAME - 1,
+                    pstHdr->acSite);
+    pstYUM->dTSamp = pstHdr->dTSamp * 1e3;      /* in ms */
+    pstYUM->dTStart = pstHdr->dTStart;
+    pstYUM->iNumIFs = 1;
+    pstYUM->iNumPol = 1;
+    pstYUM->iNumBands = 1;
+    pstYUM->iHeaderLen = 0;
+    pstYUM->iTimeSamps = (int) pstHdr->lNumSamps;
+    if (YAPP_SHM_DATA_RAW == pstHdr->iDataType)
+    {
+        pstYUM->iNumChans = 1;
+        pstYUM->iNumBits = pstHdr->iNumBits;
+        pstYUM->fSampSize = YAPP_SHM_NUMBYTES_RAW;
+        pstYUM->fFCentre = (float) pstHdr->dFChan1;
+        pstYUM->fBW = (float) (1.0 / (pstHdr->dTSamp * 1e6));
+    }
+    else
+    {
+        pstYUM->iNumChans = pstHdr->iNumChans;
+        pstYUM->iNumBits = pstHdr->iNumBits;
+        pstYUM->fSampSize = ((float) pstYUM->iNumBits) / YAPP_BYTE2BIT_FACTOR;
+        fFChan1 = (float) pstHdr->dFChan1;
+        pstYUM->fChanBW = (float) fabs(pstHdr->dChanBW);
+        if (pstHdr->dChanBW < 0.0)
+        {
+            pstYUM->cIsBandFlipped = YAPP_TRUE;
+            pstYUM->fFMax = fFChan1;
+            pstYUM->fFMin = pstYUM->fFMax
+                            - ((pstYUM->iNumChans - 1) * pstYUM->fChanBW);
+        }
+        else
+        {
+            pstYUM->cIsBandFlipped = YAPP_FALSE;
+            pstYUM->fFMin = fFChan1;
+            pstYUM->fFMax = pstYUM->fFMin
+                            + ((pstYUM->iNumChans - 1) * pstYUM->fChanBW);
+        }
+        pstYUM->fBW = (pstYUM->fFMax - pstYUM->fFMin) + pstYUM->fChanBW;
+        pstYUM->fFCentre = (pstYUM->fFMin - (pstYUM->fChanBW / 2))
+                           + (pstYUM->fBW / 2);
+    }
+    pstYUM->lDataSizeTotal = (long int) ((double) pstYUM->iNumChans
+                                         * pstYUM->iTimeSamps
+                                         * pstYUM->fSampSize);
+    pstReader->lSize = pstYUM->lDataSizeTotal;
+
+    stFuncs.read = ReadStream;
+    stFuncs.write = NULL;
+    stFuncs.seek = SeekStream;
+    stFuncs.close = CloseStream;
+    pFStream = fopencookie(pstReader, "r", stFuncs);
+    if (NULL == pFStream)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening stream failed! %s.\n",
+                       strerror(errno));
+        (void) CloseStream(pstReader);
+        return NULL;
+    }
+
+    if (NULL == pstYUM->pcIsChanGood)
+    {
+        pstYUM->pcIsChanGood = (char *) YAPP_Malloc((size_t) pstYUM->iNumChans,
+                                                    sizeof(char),
+                                                    YAPP_FALSE);
+        if (NULL == pstYUM->pcIsChanGood)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            (void) fclose(pFStream);
+            return NULL;
+        }
+        (void) memset(pstYUM->pcIsChanGood, YAPP_TRUE, pstYUM->iNumChans);
+        pstYUM->iNumGoodChans = pstYUM->iNumChans;
+    }
+
+    /* let the producer know that the ring can be removed once the data has
+       been written */
+    (void) sem_post(&pstHdr->stAttached);
+
+    return pFStream;
+}
+
+
+/*
+ * Map a ring, waiting for at most DEF_SHM_TIMEOUT s for its producer to create
+ * it and finish setting it up, so that the reader can be started at the same
+ * time as the producer
+ */
+static void* MapObject(const char *pcObj, size_t *plMapSize)
+{
+    struct stat stObjStats = {0};
+    struct timespec stNow = {0};
+    struct timespec stDeadline = {0};
+    void *pvMap = NULL;
+    int iFD = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &stDeadline);
+    stDeadline.tv_sec += DEF_SHM_TIMEOUT;
+    while (YAPP_TRUE)
+    {
+        /* the reader posts the free semaphore, so the object is opened for
+           writing */
+        iFD = shm_open(pcObj, O_RDWR, 0);
+        if ((iFD < 0) && (errno != ENOENT))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening shared-memory object %s failed! "
+                           "%s.\n",
+                           pcObj,
+                           strerror(errno));
+            return NULL;
+        }
+        if (iFD >= 0)
+        {
+            iRet = fstat(iFD, &stObjStats);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Failed to stat %s: %s!\n",
+                               pcObj,
+                               strerror(errno));
+                (void) close(iFD);
+                return NULL;
+            }
+            /* the producer sizes the object after creating it */
+            if (stObjStats.st_size >= (off_t) sizeof(YAPP_SHM_HEADER))
+            {
+                *plMapSize = (size_t) stObjStats.st_size;
+                pvMap = mmap(NULL,
+                             *plMapSize,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED,
+                             iFD,
+                             0);
+                if (MAP_FAILED == pvMap)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Mapping shared-memory object %s "
+                                   "failed! %s.\n",
+                                   pcObj,
+                                   strerror(errno));
+                    (void) close(iFD);
+                    return NULL;
+                }
+                /* the producer writes the magic string last */
+                if (0 == memcmp(((YAPP_SHM_HEADER *) pvMap)->acMagic,
+                                YAPP_SHM_MAGIC,
+                                YAPP_SHM_LEN_MAGIC))
+                {
+                    (void) close(iFD);
+                    return pvMap;
+                }
+                (void) munmap(pvMap, *plMapSize);
+            }
+            (void) close(iFD);
+        }
+
+        (void) clock_gettime(CLOCK_MONOTONIC, &stNow);
+        if ((stNow.tv_sec > stDeadline.tv_sec)
+            || ((stNow.tv_sec == stDeadline.tv_sec)
+                && (stNow.tv_nsec >= stDeadline.tv_nsec)))
+        {
+            break;
+        }
+        (void) usleep(YAPP_SHM_POLLINT);
+    }
+
+    (void) fprintf(stderr,
+                   "ERROR: %s is not a ring buffer, or no producer set it up "
+                   "in %d s!\n",
+                   pcObj,
+                   DEF_SHM_TIMEOUT);
+    return NULL;
+}
+
+
+/*
+ * Build the name of the shared-memory object, which begins with a slash
+ */
+static void GetObjectName(const char *pcName, char *pcObj)
+{
+    if (pcName[0] != '/')
+    {
+        pcObj[0] = '/';
+        (void) strncpy(pcObj + 1, pcName, LEN_GENSTRING - 2);
+    }
+    else
+    {
+        (void) strncpy(pcObj, pcName, LEN_GENSTRING - 1);
+    }
+
+    return;
+}
+
+
+/*
+ * Wait on a semaphore, for at most a given number of seconds
+ */
+static int WaitForBlock(sem_t *pstSem, int iTimeout)
+{
+    struct timespec stDeadline = {0};
+    int iRet = 0;
+
+    (void) clock_gettime(CLOCK_REALTIME, &stDeadline);
+    stDeadline.tv_sec += iTimeout;
+    do
+    {
+        iRet = sem_timedwait(pstSem, &stDeadline);
+    }
+    while ((iRet != 0) && (EINTR == errno));
+
+    return (0 == iRet) ? YAPP_RET_SUCCESS : YAPP_RET_ERROR;
+}
+
+
+/*
+ * Wait for the next block, and work out how many bytes of zeros stand in for
+ * the blocks dropped before it
+ */
+static int NextBlock(YAPP_SHM_READER *pstReader)
+{
+    YAPP_SHM_BLOCKHEADER *pstBlkHdr = NULL;
+    long int lNumDropped = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    iRet = WaitForBlock(&pstReader->pstHdr->stFilled, DEF_SHM_TIMEOUT);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "\nERROR: No data from producer in %d s!\n",
+                       DEF_SHM_TIMEOUT);
+        errno = ETIMEDOUT;
+        return YAPP_RET_ERROR;
+    }
+
+    pstBlkHdr = &pstReader->pstBlkHdr[pstReader->iBlock];
+    if (pstBlkHdr->lSeq < pstReader->lSeq)
+    {
+        (void) fprintf(stderr,
+                       "\nERROR: Block %ld is out of order!\n",
+                       (long int) pstBlkHdr->lSeq);
+        errno = EIO;
+        return YAPP_RET_ERROR;
+    }
+    lNumDropped = pstBlkHdr->lSeq - pstReader->lSeq;
+    if (lNumDropped > 0)
+    {
+        (void) fprintf(stderr,
+                       "\nWARNING: %ld blocks dropped by the producer, "
+                       "replaced with zeros!\n",
+                       lNumDropped);
+        pstReader->lNumDropped += lNumDropped;
+        pstReader->lNumZeros = lNumDropped * pstReader->pstHdr->lBlockSize;
+    }
+    pstReader->lSeq = pstBlkHdr->lSeq + 1;
+
+    if (0 == pstBlkHdr->lLen)
+    {
+        pstReader->cIsDone = YAPP_TRUE;
+        ReleaseBlock(pstReader);
+        return YAPP_SHM_RET_END;
+    }
+    pstReader->cHasBlock = YAPP_TRUE;
+    pstReader->lBlockLen = pstBlkHdr->lLen;
+    pstReader->lBlockOff = 0;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Hand the current block back to the producer
+ */
+static void ReleaseBlock(YAPP_SHM_READER *pstReader)
+{
+    pstReader->cHasBlock = YAPP_FALSE;
+    pstReader->iBlock = (pstReader->iBlock + 1)
+                        % pstReader->pstHdr->iNumBlocks;
+    (void) sem_post(&pstReader->pstHdr->stFree);
+
+    return;
+}
+
+
+/*
+ * Stream read function - copies out of the blocks as they come in, waiting
+ * only if nothing has been read yet
+ */
+static ssize_t ReadStream(void *pvCookie, char *pcBuf, size_t lSize)
+{
+    YAPP_SHM_READER *pstReader = (YAPP_SHM_READER *) pvCookie;
+    long int lLen = 0;
+    size_t lDone = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    while (lDone < lSize)
+    {
+        /* zeros for dropped blocks come before the block that follows them */
+        if ((0 == pstReader->lNumZeros) && !(pstReader->cHasBlock))
+        {
+            if ((pstReader->cIsDone) || (lDone > 0))
+            {
+                break;
+            }
+            iRet = NextBlock(pstReader);
+            if (YAPP_RET_ERROR == iRet)
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        if (pstReader->lNumZeros > 0)
+        {
+            lLen = pstReader->lNumZeros;
+        }
+        else
+        {
+            lLen = pstReader->lBlockLen - pstReader->lBlockOff;
+        }
+        if (pstReader->lPos < pstReader->lSkipTo)
+        {
+            /* discard data skipped over by a seek */
+            if (lLen > (pstReader->lSkipTo - pstReader->lPos))
+            {
+                lLen = pstReader->lSkipTo - pstReader->lPos;
+            }
+        }
+        else
+        {
+            if (lLen > (long int) (lSize - lDone))
+            {
+                lLen = (long int) (lSize - lDone);
+            }
+            if (pstReader->lNumZeros > 0)
+            {
+                (void) memset(pcBuf + lDone, '\0', (size_t) lLen);
+            }
+            else
+            {
+                (void) memcpy(pcBuf + lDone,
+                              pstReader->pcData
+                              + ((size_t) pstReader->iBlock
+                                 * pstReader->pstHdr->lBlockSize)
+                              + pstReader->lBlockOff,
+                              (size_t) lLen);
+            }
+            lDone += lLen;
+        }
+        pstReader->lPos += lLen;
+
+        if (pstReader->lNumZeros > 0)
+        {
+            pstReader->lNumZeros -= lLen;
+        }
+        else
+        {
+            pstReader->lBlockOff += lLen;
+            if (pstReader->lBlockOff == pstReader->lBlockLen)
+            {
+                ReleaseBlock(pstReader);
+            }
+        }
+    }
+
+    return (ssize_t) lDone;
+}
+
+
+/*
+ * Stream seek function - the stream can only be moved forward, and the data
+ * skipped over is discarded as it comes in
+ */
+static int SeekStream(void *pvCookie, off64_t *plOffset, int iWhence)
+{
+    YAPP_SHM_READER *pstReader = (YAPP_SHM_READER *) pvCookie;
+    long int lCur = 0;
+    long int lPos = 0;
+
+    lCur = (pstReader->lSkipTo > pstReader->lPos)
+           ? pstReader->lSkipTo
+           : pstReader->lPos;
+    switch (iWhence)
+    {
+        case SEEK_SET:
+            lPos = *plOffset;
+            break;
+
+        case SEEK_CUR:
+            lPos = lCur + *plOffset;
+            break;
+
+        case SEEK_END:
+            lPos = pstReader->lSize + *plOffset;
+            break;
+
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    if (lPos < lCur)
+    {
+        errno = ESPIPE;
+        return -1;
+    }
+    pstReader->lSkipTo = lPos;
+    *plOffset = lPos;
+
+    return 0;
+}
+
+
+/*
+ * Stream close function - detaches from the ring and frees the reader
+ */
+static int CloseStream(void *pvCookie)
+{
+    YAPP_SHM_READER *pstReader = (YAPP_SHM_READER *) pvCookie;
+
+    if (pstReader->lNumDropped > 0)
+    {
+        (void) fprintf(stderr,
+                       "WARNING: %ld blocks were dropped by the producer!\n",
+                       pstReader->lNumDropped);
+    }
+    if (pstReader->pstHdr != NULL)
+    {
+        (void) munmap(pstReader->pstHdr, pstReader->lMapSize);
+    }
+    free(pstReader);
+
+    return 0;
+}
+
@@ -0,0 +1,218 @@
+/**
+ * @file yapp_shm.h
+ * Header file for streaming data through a POSIX shared-memory ring buffer
+ *
+ * A ring buffer is a shared-memory object, named as in shm_open(), that holds
+ * a header, followed by an array of block headers, one per block, followed by
+ * the blocks themselves:
+ *
+ * @verbatim
+ * +------------------+ 0
+ * | YAPP_SHM_HEADER  |
+ * +------------------+ sizeof(YAPP_SHM_HEADER)
+ * | block header 0   |
+ * | ...              |
+ * | block header N-1 |
+ * +------------------+ lDataOffset
+ * | block 0          |
+ * | ...              |
+ * | block N-1        |
+ * +------------------+ lDataOffset + (N * lBlockSize) @endverbatim
+ *
+ * All fields are in the byte order of the host. The producer creates the
+ * object, fills in the header, initialises the three process-shared
+ * semaphores in it - one counting free blocks, starting at N, one counting
+ * filled blocks, starting at 0, and one that the reader posts once it has
+ * attached, starting at 0 - and writes the magic string last, so that a
+ * reader never attaches to a half-initialised ring. A reader that finds no
+ * ring, or one that is not yet set up, keeps looking for it for
+ * DEF_SHM_TIMEOUT s, so that the reader and the producer can be started
+ * together.
+ *
+ * The producer fills blocks in ring order, 0, 1, ..., N-1, 0, ..., waiting on
+ * the free semaphore before writing a block, and posting the filled semaphore
+ * after setting its block header. The reader takes blocks in the same order,
+ * waiting on the filled semaphore, and posts the free semaphore once it has
+ * copied a block out. A producer that cannot wait, such as a backend at the
+ * telescope, may instead drop the block it would have written when no block
+ * is free - it still counts the block in the sequence numbers, and the reader
+ * fills the gap with zeros, so that the time stamps of the data that follow
+ * stay right. A block header with a length of zero marks the end of the data.
+ * The producer then waits for at most DEF_SHM_TIMEOUT s for a reader to
+ * attach, if none has, before it removes the ring.
+ *
+ * Filterbank data is written spectrum by spectrum, as in a headerless
+ * SIGPROC .fil file, and every block but the last holds a whole number of
+ * spectra. Baseband data, as read by yapp_ft, is 8-bit, complex and
+ * dual-polarization, interleaved as Re(X), Im(X), Re(Y), Im(Y).
+ *
+ * There can be only one reader of a ring.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_SHM_H__
+#define __YAPP_SHM_H__
+
+#include <stdint.h>
+#include <semaphore.h>
+
+#define YAPP_SHM_MAGIC          "YSHM"
+#define YAPP_SHM_LEN_MAGIC      4
+#define YAPP_SHM_VERSION        2
+#define YAPP_SHM_LEN_NAME       32
+
+/* types of data */
+#define YAPP_SHM_DATA_FIL       0   /* filterbank */
+#define YAPP_SHM_DATA_RAW       1   /* baseband */
+
+#define YAPP_SHM_NUMBYTES_RAW   4   /* bytes per baseband sample */
+
+#define YAPP_SHM_RET_END        1   /* the end-of-data block was read */
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_SHM_TIMEOUT         10  /**< @brief Default time in seconds that a
+                                         reader waits for a ring to be set up
+                                         or for a block, and that a producer
+                                         waits for a reader to attach, before
+                                         giving up on the other */
+#define DEF_SHM_NUMBLOCKS       8   /**< @brief Default number of blocks in a
+                                         ring */
+/* @} */
+
+/**
+ * Header at the start of a ring
+ */
+typedef struct tagSHMHeader
+{
+    char acMagic[YAPP_SHM_LEN_MAGIC];   /* YAPP_SHM_MAGIC, not
+                                           null-terminated */
+    int32_t iVersion;                   /* YAPP_SHM_VERSION */
+    int32_t iDataType;                  /* YAPP_SHM_DATA_FIL or
+                                           YAPP_SHM_DATA_RAW */
+    int32_t iNumBlocks;
+    int64_t lBlockSize;                 /* in bytes */
+    int64_t lDataOffset;                /* offset of block 0, in bytes */
+    /* metadata */
+    char acPulsar[YAPP_SHM_LEN_NAME];   /* source name, null-terminated */
+    char acSite[YAPP_SHM_LEN_NAME];     /* observatory, null-terminated */
+    int32_t iNumChans;                  /* 1 for baseband data */
+    int32_t iNumBits;                   /* 8 for baseband data */
+    double dTSamp;                      /* in s */
+    double dFChan1;                     /* centre frequency of the first
+                                           channel, or of the band for
+                                           baseband data, in MHz */
+    double dChanBW;                     /* in MHz, negative if the first
+                                           channel is the highest */
+    double dTStart;                     /* in MJD */
+    int64_t lNumSamps;                  /* number of time samples the
+                                           producer will write */
+    /* state */
+    sem_t stFree;                       /* number of free blocks */
+    sem_t stFilled;                     /* number of filled blocks */
+    sem_t stAttached;                   /* posted by the reader once it has
+                                           attached */
+} YAPP_SHM_HEADER;
+
+/**
+ * Header of a block
+ */
+typedef struct tagSHMBlockHeader
+{
+    int64_t lSeq;                       /* number of the block, counting
+                                           dropped blocks, from 0 */
+    int64_t lLen;                       /* bytes of data in the block, 0 at
+                                           the end of the data */
+} YAPP_SHM_BLOCKHEADER;
+
+/**
+ * Producer end of a ring
+ */
+typedef struct tagSHMWriter
+{
+    char acName[LEN_GENSTRING];
+    YAPP_SHM_HEADER *pstHdr;
+    YAPP_SHM_BLOCKHEADER *pstBlkHdr;
+    char *pcData;
+    size_t lMapSize;
+    int iBlock;                 /* ring slot of the next block */
+    long int lSeq;              /* sequence number of the next block */
+    long int lNumDropped;
+} YAPP_SHM_WRITER;
+
+/**
+ * Reader end of a ring, read as a stream
+ */
+typedef struct tagSHMReader
+{
+    char acName[LEN_GENSTRING];
+    YAPP_SHM_HEADER *pstHdr;
+    YAPP_SHM_BLOCKHEADER *pstBlkHdr;
+    char *pcData;
+    size_t lMapSize;
+    int iBlock;                 /* ring slot of the next block */
+    long int lSeq;              /* sequence number of the next block */
+    char cHasBlock;             /* a block is being copied out */
+    long int lBlockLen;         /* length of that block */
+    long int lBlockOff;         /* bytes of that block copied out */
+    long int lNumZeros;         /* bytes of zeros owed for dropped blocks */
+    long int lNumDropped;
+    char cIsDone;               /* the end-of-data block has been read */
+    long int lPos;              /* stream position, in bytes */
+    long int lSkipTo;           /* data before this position is discarded */
+    long int lSize;             /* stream length, in bytes */
+} YAPP_SHM_READER;
+
+/**
+ * Create a ring and make it ready for a reader to attach to. The size of the
+ * ring, the type of data and the metadata are copied from a header filled in
+ * by the caller.
+ *
+ * @param[in]       pcName          Name of the shared-memory object
+ * @param[in]       pstTemplate     Header
+ */
+YAPP_SHM_WRITER* YAPP_SHM_Create(const char *pcName,
+                                 const YAPP_SHM_HEADER *pstTemplate);
+
+/**
+ * Write a block to a ring
+ *
+ * @param[in]       pstWriter       Producer end of the ring
+ * @param[in]       pcBuf           Data
+ * @param[in]       lLen            Length of the data, in bytes, at most the
+ *                                  block size
+ * @param[in]       cCanDrop        YAPP_TRUE if the block is to be dropped
+ *                                  instead of waiting for a free block
+ */
+int YAPP_SHM_Write(YAPP_SHM_WRITER *pstWriter,
+                   const char *pcBuf,
+                   long int lLen,
+                   char cCanDrop);
+
+/**
+ * Mark the end of the data, wait for a reader to attach if none has, and
+ * remove the ring - a reader that is still attached reads up to the end of
+ * the data
+ *
+ * @param[in]       pstWriter       Producer end of the ring
+ */
+int YAPP_SHM_Destroy(YAPP_SHM_WRITER *pstWriter);
+
+/**
+ * Attach to a ring as a stream, waiting for the producer to set it up if it
+ * has not yet. Filterbank data is read as a headerless filterbank file, and
+ * baseband data as a raw data file. The metadata is filled in from the
+ * header of the ring.
+ *
+ * @param[in]       pcName          Name of the shared-memory object
+ * @param[in]       iDataType       Type of data expected
+ * @param[out]      pstYUM          Metadata
+ */
+FILE* YAPP_SHM_Open(const char *pcName, int iDataType, YUM_t *pstYUM);
+
+#endif  /* __YAPP_SHM_H__ */
+
@@ -1,7 +1,8 @@
 /*
  * @file yapp_siftpulses.c
- * Program to generate a single-pulse diagnostic plot from given dedispersed
- *  time series data.
+ * Program to search dedispersed time series data for single pulses, group the
+ *  events into candidates, and optionally generate a single-pulse diagnostic
+ *  plot.
  *
  * @verbatim
  * Usage: yapp_siftpulses [options] <data-file-dm0> ... <data-file-dmN-1>
@@ -9,9 +10,33 @@
  *     -n  --nsamp <samples>                Number of samples read in one block
  *                                          (default is 4096 samples)
  *     -t  --threshold <sigmas>             Threshold in sigmas.
+ *     -w  --maxwidth <samples>             Maximum boxcar width, rounded down
+ *                                          to a power of 2
+ *                                          (default is 1 sample)
+ *     -k  --ttol <samples>                 Time linking length for clustering
+ *                                          (default is 8 samples)
+ *     -d  --dmtol <trials>                 DM linking length for clustering
+ *                                          (default is 1 DM trial)
+ *     -m  --statwin <blocks>               Length of the window over which the
+ *                                          median and median absolute
+ *                                          deviation are computed, for
+ *                                          normalisation
+ *                                          (default is 8 blocks)
+ *     -r  --detrend <samples>              Subtract a baseline interpolated
+ *                                          between the medians of chunks of
+ *                                          this length
+ *                                          (default is no detrending)
+ *     -b  --db <database-file>             Also add the candidates to a
+ *                                          candidate database
+ *     -j  --threads <numthreads>           Number of search threads
+ *                                          (default is the number of
+ *                                          processors)
+ *     -g  --graphics                       Plot the candidates
  *     -i  --invert                         Invert the background and foreground
  *                                          colours in plots
- *     -e  --non-interactive                Run in non-interactive mode
+ *     -e  --non-interactive                Accepted for compatibility; has no
+ *                                          effect, as the search is always
+ *                                          non-interactive
  *     -v  --version                        Display the version @endverbatim
  *
  * @author Jayanth Chennamangalam
@@ -20,6 +45,8 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_siftpulses.h"
+#include "yapp_canddb.h"
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -32,9 +59,31 @@ extern int g_iPGDev;
 
 /* the following are global only to enable cleaning up in case of abnormal
    termination, such as those triggered by SIGINT or SIGTERM */
-float **g_ppfBuf = NULL;
-float *g_pfOutBuf = NULL;
-float *g_pfXAxis = NULL;
+float *g_pfBuf = NULL;
+FILE *g_pFCandBin = NULL;
+FILE *g_pFCandCSV = NULL;
+YAPP_SP_WORKER *g_pstWorkers = NULL;
+YAPP_CDB_WRITER g_stCDB = {0};
+
+static int RunThreads(int iNumThreads);
+static void YAPP_SP_Detrend(float *pfData,
+                            int iNumSamps,
+                            int iChunkLen,
+                            float *pfScratch,
+                            float *pfTrend);
+static int YAPP_SP_WriteCands(YAPP_SP_CLUSTER *pstDone,
+                              int iNumDone,
+                              float *pfDM,
+                              double *pdTStart,
+                              double dTStartRef,
+                              YUM_t *pstYUM,
+                              int *piNumCands);
+static int YAPP_SP_PlotCands(char *pcFileCand,
+                             float fTEnd,
+                             float fDMLo,
+                             float fDMHi,
+                             int iInvCols);
+static void CleanUp(void);
 
 int main(int argc, char *argv[])
 {
@@ -43,45 +92,72 @@ int main(int argc, char *argv[])
     int iFormat = DEF_FORMAT;
     YUM_t stYUM = {{0}};
     float *pfDM = NULL;
+    double *pdTStart = NULL;
+    double dTStartRef = 0.0;
+    double dTSpan = 0.0;
     int iBlockSize = DEF_SIZE_BLOCK;
-    int iTotSampsPerBlock = 0;  /* iBlockSize */
     double dTSampInSec = 0.0;   /* holds sampling time in s */
     int iNumReads = 0;
     int iTotNumReads = 0;
     int iReadBlockCount = 0;
-    char cIsLastBlock = YAPP_FALSE;
     int iRet = YAPP_RET_SUCCESS;
-    int iReadItems = 0;
     int iNumSamps = 0;
-    int iDiff = 0;
-    int iNumRandEvents = 0;
-    int iNumEvents = 0;
-    float fMedian = 0.0;
-    float fRMS = 0.0;
+    double dNumRandEvents = 0.0;
+    long lNumEvents = 0;
+    long lNumDropped = 0;
     float fThreshold = 0.0;
-    double dTNow = 0.0;
     float fTemp = 0.0;
+    double dTemp = 0.0;
     FILE *pFTemp = NULL;
-    char cIsFirst = YAPP_TRUE;
+    int iMaxWidth = DEF_SP_MAXWIDTH;
+    int iNumWidths = 0;
+    YAPP_SP_JOB stJob = {0};
+    int iNumThreads = 0;
+    int iDMsPerThread = 0;
+    YAPP_SP_WORKER *pstWorker = NULL;
+    struct rlimit stLimit = {0};
+    YAPP_SP_EVENT *pstEvents = NULL;
+    int iNumBlockEvents = 0;
+    YAPP_SP_CLUSTERER stClr = {0};
+    YAPP_SP_CLUSTER *pstDone = NULL;
+    int iNumDone = 0;
+    int iNumCands = 0;
+    YAPP_SP_FILEHEADER stFileHeader = {{0}};
+    char acFileCand[LEN_GENSTRING] = {0};
+    char acFileCandBin[LEN_GENSTRING] = {0};
+    char *pcFileDB = NULL;
+    char *pcFilename = NULL;
     int i = 0;
     int j = 0;
+    int iGraphics = YAPP_FALSE;
     int iInvCols = YAPP_FALSE;
-    char cIsNonInteractive = YAPP_FALSE;
     const char *pcProgName = NULL;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hn:t:iev";
+    const char* const pcOptsShort = "hn:t:w:k:d:m:r:b:j:giev";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
         { "nsamp",                  1, NULL, 'n' },
         { "threshold",              1, NULL, 't' },
+        { "maxwidth",               1, NULL, 'w' },
+        { "ttol",                   1, NULL, 'k' },
+        { "dmtol",                  1, NULL, 'd' },
+        { "statwin",                1, NULL, 'm' },
+        { "detrend",                1, NULL, 'r' },
+        { "db",                     1, NULL, 'b' },
+        { "threads",                1, NULL, 'j' },
+        { "graphics",               0, NULL, 'g' },
         { "invert",                 0, NULL, 'i' },
         { "non-interactive",        0, NULL, 'e' },
         { "version",                0, NULL, 'v' },
         { NULL,                     0, NULL, 0   }
     };
 
+    stJob.iStatWin = DEF_SP_STATWIN;
+    stClr.lTTol = DEF_SP_TTOL;
+    stClr.iDMTol = DEF_SP_DMTOL;
+
     /* get the filename of the program from the argument list */
     pcProgName = argv[0];
 
@@ -113,14 +189,110 @@ int main(int argc, char *argv[])
                 fThreshold = atof(optarg);
                 break;
 
+            case 'w':   /* -w or --maxwidth */
+                /* set option */
+                iMaxWidth = atoi(optarg);
+                /* validate */
+                if (iMaxWidth < 1
+                    || iMaxWidth >= (1 << YAPP_SP_MAXWIDTHS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Maximum width must be > 0 and "
+                                   "< %d!\n",
+                                   1 << YAPP_SP_MAXWIDTHS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'k':   /* -k or --ttol */
+                /* set option */
+                stClr.lTTol = atol(optarg);
+                /* validate */
+                if (stClr.lTTol < 0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Time linking length must be "
+                                   ">= 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'd':   /* -d or --dmtol */
+                /* set option */
+                stClr.iDMTol = atoi(optarg);
+                /* validate */
+                if (stClr.iDMTol < 0)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: DM linking length must be "
+                                   ">= 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'm':   /* -m or --statwin */
+                /* set option */
+                stJob.iStatWin = atoi(optarg);
+                /* validate */
+                if (stJob.iStatWin < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Normalisation window must be "
+                                   "> 0!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'r':   /* -r or --detrend */
+                /* set option */
+                stJob.iDetrendLen = atoi(optarg);
+                /* validate */
+                if (stJob.iDetrendLen < 2)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Detrending length must be > 1!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'b':   /* -b or --db */
+                /* set option */
+                pcFileDB = optarg;
+                break;
+
+            case 'j':   /* -j or --threads */
+                /* set option */
+                iNumThreads = atoi(optarg);
+                if ((iNumThreads < 1)
+                    || (iNumThreads > YAPP_SP_MAXTHREADS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of threads must be between "
+                                   "1 and %d!\n",
+                                   YAPP_SP_MAXTHREADS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'g':   /* -g or --graphics */
+                /* set option */
+                iGraphics = YAPP_TRUE;
+                break;
+
             case 'i':  /* -i or --invert */
                 /* set option */
                 iInvCols = YAPP_TRUE;
                 break;
 
             case 'e':  /* -e or --non-interactive */
-                /* set option */
-                cIsNonInteractive = YAPP_TRUE;
+                /* the search no longer pauses for input, so there is nothing
+                   to set - accepted so that existing scripts keep working */
                 break;
 
             case 'v':   /* -v or --version */
@@ -159,6 +331,16 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
+    /* boxcar widths are powers of 2, up to the maximum width */
+    for (iNumWidths = 1; (1 << iNumWidths) <= iMaxWidth; ++iNumWidths)
+        ;
+    iMaxWidth = 1 << (iNumWidths - 1);
+    stJob.iBlockSize = iBlockSize;
+    stJob.iNumWidths = iNumWidths;
+    stJob.iHistLen = iMaxWidth - 1;
+    stJob.iRowLen = stJob.iHistLen + iBlockSize;
+    stJob.fThreshold = fThreshold;
+
     /* register the signal-handling function */
     iRet = YAPP_RegisterSignalHandlers();
     if (iRet != YAPP_RET_SUCCESS)
@@ -177,14 +359,14 @@ int main(int argc, char *argv[])
         {
             (void) fprintf(stderr,
                            "ERROR: File type determination failed!\n");
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
         if (iFormat != YAPP_FORMAT_DTS_TIM)
         {
             (void) fprintf(stderr,
                            "ERROR: Invalid file type!\n");
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
     }
@@ -192,17 +374,22 @@ int main(int argc, char *argv[])
     /* read metadata */
     /* NOTE: it is assumed that all files correspond to a single observation.
              the only information taken from all files except the last one is
-             the DM. general metadata is read from the last file */
-    /* allocate memory for the DM array */
+             the DM and the start time, which yapp_dedisperse corrects for
+             the dispersion delay at each DM. general metadata is read from
+             the last file */
+    /* allocate memory for the DM and start time arrays */
     pfDM = (float *) YAPP_Malloc((size_t) iNumDMs,
                                  sizeof(float),
                                  YAPP_FALSE);
-    if (NULL == pfDM)
+    pdTStart = (double *) YAPP_Malloc((size_t) iNumDMs,
+                                      sizeof(double),
+                                      YAPP_FALSE);
+    if ((NULL == pfDM) || (NULL == pdTStart))
     {
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
     for (i = optind; i < argc; ++i)
@@ -214,10 +401,11 @@ int main(int argc, char *argv[])
             (void) fprintf(stderr,
                            "ERROR: Reading metadata failed for file %s!\n",
                            argv[i]);
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
         pfDM[i-optind] = (float) stYUM.dDM;
+        pdTStart[i-optind] = stYUM.dTStart;
     }
 
     /* convert sampling interval to seconds */
@@ -226,20 +414,33 @@ int main(int argc, char *argv[])
     iNumReads = (int) ceilf(((float) stYUM.iTimeSamps) / iBlockSize);
     iTotNumReads = iNumReads;
 
-    /* optimisation - store some commonly used values in variables */
-    iTotSampsPerBlock = iBlockSize;
+    /* all time series files are kept open, so raise the limit on the number
+       of open files if necessary */
+    if (0 == getrlimit(RLIMIT_NOFILE, &stLimit))
+    {
+        rlim_t lNeeded = (rlim_t) iNumDMs + 16;   /* leave room for the
+                                                     standard streams,
+                                                     output files, etc. */
+        if (stLimit.rlim_cur < lNeeded)
+        {
+            stLimit.rlim_cur = (stLimit.rlim_max < lNeeded)
+                               ? stLimit.rlim_max
+                               : lNeeded;
+            (void) setrlimit(RLIMIT_NOFILE, &stLimit);
+        }
+    }
 
     /* open the time series data files for reading */
     /* allocate memory for the file pointer array */
     ppFIn = (FILE **) YAPP_Malloc((size_t) iNumDMs,
                                   sizeof(FILE *),
-                                  YAPP_FALSE);
+                                  YAPP_TRUE);
     if (NULL == ppFIn)
     {
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
     for (i = optind; i < argc; ++i)
@@ -251,7 +452,7 @@ int main(int argc, char *argv[])
                            "ERROR: Opening file %s failed! %s.\n",
                            argv[i],
                            strerror(errno));
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
 
@@ -271,6 +472,11 @@ int main(int argc, char *argv[])
                 pfDM[i] = pfDM[j];
                 pfDM[j] = fTemp;
 
+                /* swap start times */
+                dTemp = pdTStart[i];
+                pdTStart[i] = pdTStart[j];
+                pdTStart[j] = dTemp;
+
                 /* swap file handles */
                 pFTemp = ppFIn[i];
                 ppFIn[i] = ppFIn[j];
@@ -279,206 +485,739 @@ int main(int argc, char *argv[])
         }
     }
 
-    /* allocate memory for the buffer pointer array */
-    g_ppfBuf = (float **) YAPP_Malloc((size_t) iNumDMs,
-                                      sizeof(float *),
-                                      YAPP_FALSE);
-    if (NULL == g_ppfBuf)
+    /* candidate times are counted from the earliest start time, so that
+       candidates at all DMs are on a common time axis */
+    dTStartRef = pdTStart[0];
+    for (i = 1; i < iNumDMs; ++i)
+    {
+        if (pdTStart[i] < dTStartRef)
+        {
+            dTStartRef = pdTStart[i];
+        }
+    }
+    for (i = 0; i < iNumDMs; ++i)
+    {
+        if (((pdTStart[i] - dTStartRef) * 86400) > dTSpan)
+        {
+            dTSpan = (pdTStart[i] - dTStartRef) * 86400;
+        }
+    }
+
+    /* allocate memory for the buffer - one row per DM trial, each holding the
+       end of the previous block followed by the current block, in a single
+       allocation so that the number of DM trials is not limited by the
+       memory table */
+    g_pfBuf = (float *) YAPP_Malloc((size_t) iNumDMs * stJob.iRowLen,
+                                    sizeof(float),
+                                    YAPP_TRUE);
+    stJob.pfMedRing = (float *) YAPP_Malloc((size_t) iNumDMs
+                                            * stJob.iStatWin,
+                                            sizeof(float),
+                                            YAPP_FALSE);
+    stJob.pfMADRing = (float *) YAPP_Malloc((size_t) iNumDMs
+                                            * stJob.iStatWin,
+                                            sizeof(float),
+                                            YAPP_FALSE);
+    pstEvents = (YAPP_SP_EVENT *) YAPP_Malloc((size_t) DEF_SP_MAXEVENTS,
+                                              sizeof(YAPP_SP_EVENT),
+                                              YAPP_FALSE);
+    if ((NULL == g_pfBuf) || (NULL == stJob.pfMedRing)
+        || (NULL == stJob.pfMADRing) || (NULL == pstEvents))
     {
         (void) fprintf(stderr,
                        "ERROR: Memory allocation failed! %s!\n",
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
-    /* allocate memory for the buffer */
-    for (i = 0; i < iNumDMs; ++i)
+    stJob.ppFIn = ppFIn;
+    stJob.fSampSize = stYUM.fSampSize;
+    stJob.pfBuf = g_pfBuf;
+
+    /* use one thread per processor, but not more than there are DM
+       trials */
+    if (0 == iNumThreads)
     {
-        g_ppfBuf[i] = (float *) YAPP_Malloc((size_t) iBlockSize,
-                                            sizeof(float),
-                                            YAPP_FALSE);
-        if (NULL == g_ppfBuf[i])
+        iNumThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (iNumThreads < 1)
+        {
+            iNumThreads = 1;
+        }
+        else if (iNumThreads > YAPP_SP_MAXTHREADS)
+        {
+            iNumThreads = YAPP_SP_MAXTHREADS;
+        }
+    }
+    if (iNumThreads > iNumDMs)
+    {
+        iNumThreads = iNumDMs;
+    }
+    (void) printf("Searching %d DM trials using %d thread(s).\n",
+                  iNumDMs,
+                  iNumThreads);
+
+    /* set up the search threads - memory is allocated here, as
+       YAPP_Malloc() is not thread-safe, and each thread gets a contiguous
+       range of DM trials, and a share of the event buffer */
+    g_pstWorkers = (YAPP_SP_WORKER *) YAPP_Malloc((size_t) iNumThreads,
+                                                  sizeof(YAPP_SP_WORKER),
+                                                  YAPP_TRUE);
+    if (NULL == g_pstWorkers)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    iDMsPerThread = iNumDMs / iNumThreads;
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        pstWorker = &g_pstWorkers[i];
+        pstWorker->pstJob = &stJob;
+        pstWorker->iFirstDM = i * iDMsPerThread
+                              + ((i < iNumDMs % iNumThreads)
+                                 ? i
+                                 : iNumDMs % iNumThreads);
+        pstWorker->iNumDMs = iDMsPerThread
+                             + ((i < iNumDMs % iNumThreads) ? 1 : 0);
+        pstWorker->iMaxEvents = DEF_SP_MAXEVENTS / iNumThreads;
+        pstWorker->pstEvents = pstEvents + (size_t) i * pstWorker->iMaxEvents;
+        pstWorker->pcRawBuf = (char *) YAPP_Malloc((size_t) (iBlockSize
+                                                        * stYUM.fSampSize),
+                                                   sizeof(char),
+                                                   YAPP_FALSE);
+        pstWorker->pdCum = (double *) YAPP_Malloc((size_t) (stJob.iRowLen
+                                                            + 1),
+                                                  sizeof(double),
+                                                  YAPP_TRUE);
+        pstWorker->pfSNR = (float *) YAPP_Malloc((size_t) iBlockSize,
+                                                 sizeof(float),
+                                                 YAPP_FALSE);
+        pstWorker->pfScratch = (float *) YAPP_Malloc((size_t) iBlockSize,
+                                                     sizeof(float),
+                                                     YAPP_FALSE);
+        pstWorker->pfTrend = (float *) YAPP_Malloc((size_t) (iBlockSize / 2
+                                                             + 1),
+                                                   sizeof(float),
+                                                   YAPP_FALSE);
+        if ((NULL == pstWorker->pcRawBuf) || (NULL == pstWorker->pdCum)
+            || (NULL == pstWorker->pfSNR) || (NULL == pstWorker->pfScratch)
+            || (NULL == pstWorker->pfTrend))
         {
             (void) fprintf(stderr,
                            "ERROR: Memory allocation failed! %s!\n",
                            strerror(errno));
-            YAPP_CleanUp();
+            CleanUp();
             return YAPP_RET_ERROR;
         }
     }
 
-    /* allocate memory for single pulses */
-    /* compute number of events due to noise alone */
-    iNumRandEvents = iNumDMs * stYUM.iTimeSamps * sqrt(M_PI) * erfc(fThreshold);
-
-    if (1 == iNumReads)
-    {
-        cIsLastBlock = YAPP_TRUE;
-    }
-
-    /* open the PGPLOT graphics device */
-    g_iPGDev = cpgopen(PG_DEV);
-    if (g_iPGDev <= 0)
+    /* allocate memory for the clustering state */
+    stClr.iNumDMs = iNumDMs;
+    stClr.iNumWidths = iNumWidths;
+    stClr.iMaxClusters = DEF_SP_MAXCLUSTERS;
+    stClr.iFree = -1;
+    stClr.plCellLastSamp = (long *) YAPP_Malloc((size_t) iNumDMs * iNumWidths,
+                                                sizeof(long),
+                                                YAPP_FALSE);
+    stClr.piCellCluster = (int *) YAPP_Malloc((size_t) iNumDMs * iNumWidths,
+                                              sizeof(int),
+                                              YAPP_FALSE);
+    stClr.pstClusters = (YAPP_SP_CLUSTER *)
+                            YAPP_Malloc((size_t) stClr.iMaxClusters,
+                                        sizeof(YAPP_SP_CLUSTER),
+                                        YAPP_FALSE);
+    pstDone = (YAPP_SP_CLUSTER *) YAPP_Malloc((size_t) stClr.iMaxClusters,
+                                              sizeof(YAPP_SP_CLUSTER),
+                                              YAPP_FALSE);
+    if ((NULL == stClr.plCellLastSamp) || (NULL == stClr.piCellCluster)
+        || (NULL == stClr.pstClusters) || (NULL == pstDone))
     {
         (void) fprintf(stderr,
-                       "ERROR: Opening graphics device %s failed!\n",
-                       PG_DEV);
-        YAPP_CleanUp();
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        CleanUp();
         return YAPP_RET_ERROR;
     }
-
-    /* set the background colour to white and the foreground colour to
-       black, if user requires so */
-    if (YAPP_TRUE == iInvCols)
+    for (i = 0; i < iNumDMs * iNumWidths; ++i)
     {
-        cpgscr(0, 1.0, 1.0, 1.0);
-        cpgscr(1, 0.0, 0.0, 0.0);
+        stClr.plCellLastSamp[i] = -1;
     }
 
-    cpgsch(PG_CH);
-
-    /* set up the plot's X-axis */
-    g_pfXAxis = (float *) YAPP_Malloc(stYUM.iTimeSamps,
-                                      sizeof(float),
-                                      YAPP_FALSE);
-    if (NULL == g_pfXAxis)
+    /* open the candidate files - candidates from all DM trials are written
+       to one binary and one CSV file, named after the first input file */
+    pcFilename = YAPP_GetFilenameFromPath(argv[optind]);
+    (void) snprintf(acFileCand,
+                    LEN_GENSTRING,
+                    "%s.%s%s",
+                    pcFilename,
+                    INFIX_ALLDM,
+                    EXT_YAPP_SPCAND);
+    (void) strcpy(acFileCandBin, acFileCand);
+    g_pFCandBin = fopen(acFileCandBin, "w");
+    if (NULL == g_pFCandBin)
     {
         (void) fprintf(stderr,
-                       "ERROR: Memory allocation for X-axis failed! %s!\n",
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileCandBin,
                        strerror(errno));
-        YAPP_CleanUp();
+        CleanUp();
         return YAPP_RET_ERROR;
     }
-    for (i = 0; i < stYUM.iTimeSamps; ++i)
+    (void) snprintf(acFileCand,
+                    LEN_GENSTRING,
+                    "%s.%s%s",
+                    pcFilename,
+                    INFIX_ALLDM,
+                    EXT_CSV);
+    g_pFCandCSV = fopen(acFileCand, "w");
+    if (NULL == g_pFCandCSV)
     {
-        g_pfXAxis[i] = i * dTSampInSec;
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileCand,
+                       strerror(errno));
+        CleanUp();
+        return YAPP_RET_ERROR;
     }
 
-    /* allocate memory for the accumulation buffer */
-    g_pfOutBuf = (float *) YAPP_Malloc((size_t) iBlockSize,
-                                       sizeof(float),
-                                       YAPP_TRUE);
-    if (NULL == g_pfOutBuf)
+    /* write the file headers */
+    (void) memcpy(stFileHeader.acMagic,
+                  YAPP_SP_MAGIC,
+                  sizeof(stFileHeader.acMagic));
+    stFileHeader.iRecordSize = sizeof(YAPP_SP_CAND);
+    stFileHeader.iNumDMs = iNumDMs;
+    stFileHeader.fThreshold = fThreshold;
+    stFileHeader.dTSamp = dTSampInSec;
+    stFileHeader.dTStart = dTStartRef;
+    stFileHeader.iBeamID = stYUM.iBeamID;
+    stFileHeader.iNumBeams = stYUM.iNumBeams;
+    if (fwrite(&stFileHeader, sizeof(stFileHeader), 1, g_pFCandBin) != 1)
     {
         (void) fprintf(stderr,
-                       "ERROR: Memory allocation for plot buffer failed! "
-                       "%s!\n",
-                       strerror(errno));
-        YAPP_CleanUp();
+                       "ERROR: Writing candidate file header failed!\n");
+        CleanUp();
         return YAPP_RET_ERROR;
     }
+    (void) fprintf(g_pFCandCSV, "sample,time,dm,snr,width,events\n");
 
-    /* set up plot */
-    cpgsvp(PG_VP_ML, PG_VP_MR, PG_VP_MB, PG_VP_MT);
-    cpgswin(g_pfXAxis[0],
-            g_pfXAxis[stYUM.iTimeSamps-1],
-            pfDM[iNumDMs-1],
-            pfDM[0]);
-    cpglab("Time (s)", "DM (pc cm\\u-3\\d)", "");
-    cpgbox("BCNST", 0.0, 0, "BCNST", 0.0, 0);
-    cpgsci(PG_CI_PLOT);
+    /* open the candidate database */
+    if (pcFileDB != NULL)
+    {
+        iRet = YAPP_CDB_Open(&g_stCDB, pcFileDB);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening candidate database failed!\n");
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
+    /* compute number of events due to noise alone, over all DM trials and
+       boxcar widths, from the single-sided tail probability of a Gaussian */
+    dNumRandEvents = (double) iNumDMs * iNumWidths * stYUM.iTimeSamps
+                     * 0.5 * erfc(fThreshold / M_SQRT2);
 
     while (iNumReads > 0)
     {
-        /* read data */
+        /* read and search data */
         (void) printf("\rReading data block %d of %d.",
                       iReadBlockCount + 1,
                       iTotNumReads);
         (void) fflush(stdout);
-        for (i = 0; i < iNumDMs; ++i)
+        stJob.iStatIdx = iReadBlockCount % stJob.iStatWin;
+        if (stJob.iNumStats < stJob.iStatWin)
         {
-            iReadItems = YAPP_ReadData(ppFIn[i],
-                                       g_ppfBuf[i],
-                                       stYUM.fSampSize,
-                                       iTotSampsPerBlock);
-            if (YAPP_RET_ERROR == iReadItems)
-            {
-                (void) fprintf(stderr, "ERROR: Reading data failed!\n");
-                YAPP_CleanUp();
-                return YAPP_RET_ERROR;
-            }
-
-            if (iReadItems < iTotSampsPerBlock)
-            {
-                iDiff = iBlockSize - iReadItems;
-
-                /* reset remaining elements to '\0' */
-                (void) memset((g_ppfBuf[0] + iReadItems),
-                              '\0',
-                              (sizeof(float) * iDiff));
-            }
-
-            /* calculate the number of time samples in the block - this may not
-               be iBlockSize for the last block, and should be iBlockSize for
-               all other blocks */
-            iNumSamps = iReadItems;
+            ++stJob.iNumStats;
+        }
+        iRet = RunThreads(iNumThreads);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            CleanUp();
+            return YAPP_RET_ERROR;
         }
         --iNumReads;
         ++iReadBlockCount;
 
-        /* calculate the reference median and standard deviation */
-        if (cIsFirst)
+        /* calculate the number of time samples in the block - this may not
+           be iBlockSize for the last block, and should be iBlockSize for
+           all other blocks */
+        iNumSamps = g_pstWorkers[0].iNumSamps;
+
+        /* gather the events found by all threads */
+        iNumBlockEvents = 0;
+        for (i = 0; i < iNumThreads; ++i)
         {
-            for (i = 0; i < iNumDMs; ++i)
-            {
-                /* TODO: compute the median instead of the mean */
-                fMedian = YAPP_CalcMean(g_ppfBuf[i], iNumSamps, 0, 1);
-                fRMS = YAPP_CalcRMS(g_ppfBuf[i], iNumSamps, 0, 1, fMedian);
-            }
-            (void) printf("Mean: %g\n", fMedian);
-            (void) printf("Standard deviation: %g\n", fRMS);
-            cIsFirst = YAPP_FALSE;
+            (void) memmove(pstEvents + iNumBlockEvents,
+                           g_pstWorkers[i].pstEvents,
+                           g_pstWorkers[i].iNumEvents
+                           * sizeof(YAPP_SP_EVENT));
+            iNumBlockEvents += g_pstWorkers[i].iNumEvents;
+            lNumDropped += g_pstWorkers[i].lNumDropped;
+            g_pstWorkers[i].lNumDropped = 0;
         }
+        lNumEvents += iNumBlockEvents;
 
-        /* search for strong pulses */
-        for (i = 0; i < iNumSamps; ++i)
+        /* cluster the events in time order */
+        qsort(pstEvents,
+              iNumBlockEvents,
+              sizeof(YAPP_SP_EVENT),
+              YAPP_SP_CompareEvents);
+        for (i = 0; i < iNumBlockEvents; ++i)
         {
-            for (j = 0; j < iNumDMs; ++j)
+            iRet = YAPP_SP_AddEvent(&stClr, &pstEvents[i]);
+            if (iRet != YAPP_RET_SUCCESS)
             {
-                float fSNR = (g_ppfBuf[j][i] - fMedian) / fRMS;
-                if (fSNR > fThreshold)
+                /* the cluster table is full - write out the clusters that
+                   can no longer grow, and try again */
+                iNumDone = YAPP_SP_FinishClusters(&stClr,
+                                                  pstEvents[i].lSamp,
+                                                  pstDone,
+                                                  stClr.iMaxClusters);
+                iRet = YAPP_SP_WriteCands(pstDone,
+                                          iNumDone,
+                                          pfDM,
+                                          pdTStart,
+                                          dTStartRef,
+                                          &stYUM,
+                                          &iNumCands);
+                if (iRet != YAPP_RET_SUCCESS)
                 {
-                    float fLW = powf(3, fSNR - fThreshold);
-                    if (fLW < 1.0)
-                    {
-                        cpgsci(1);
-                        fLW = 1.0;
-                    }
-                    else if (fLW > 201.0)
-                    {
-                        cpgsci(2);
-                        fLW = 201.0;
-                    }
-                    else
-                    {
-                        cpgsci(PG_CI_PLOT);
-                    }
-                    cpgslw(fLW);
-                    cpgpt1((float) dTNow, pfDM[j], -1);
-                    ++iNumEvents;
+                    (void) fprintf(stderr,
+                                   "ERROR: Writing candidates failed!\n");
+                    CleanUp();
+                    return YAPP_RET_ERROR;
+                }
+                iRet = YAPP_SP_AddEvent(&stClr, &pstEvents[i]);
+                if (iRet != YAPP_RET_SUCCESS)
+                {
+                    ++lNumDropped;
                 }
             }
-            dTNow += dTSampInSec;
         }
+        stJob.lBlockStart += iNumSamps;
 
-        if (1 == iNumReads)
+        /* write out the clusters that events in the following blocks cannot
+           join, or all clusters after the last block */
+        iNumDone = YAPP_SP_FinishClusters(&stClr,
+                                          (iNumReads > 0)
+                                          ? stJob.lBlockStart
+                                          : LONG_MAX,
+                                          pstDone,
+                                          stClr.iMaxClusters);
+        iRet = YAPP_SP_WriteCands(pstDone,
+                                  iNumDone,
+                                  pfDM,
+                                  pdTStart,
+                                  dTStartRef,
+                                  &stYUM,
+                                  &iNumCands);
+        if (iRet != YAPP_RET_SUCCESS)
         {
-            cIsLastBlock = YAPP_TRUE;
+            (void) fprintf(stderr,
+                           "ERROR: Writing candidates failed!\n");
+            CleanUp();
+            return YAPP_RET_ERROR;
         }
     }
+    (void) printf("\n");
+
+    if (lNumDropped > 0)
+    {
+        (void) fprintf(stderr,
+                       "WARNING: %ld events dropped as the event buffer or "
+                       "cluster table was full! Consider raising the "
+                       "threshold.\n",
+                       lNumDropped);
+    }
+    (void) printf("%ld events of an expected %.0f detected.\n",
+                  lNumEvents,
+                  dNumRandEvents);
+    (void) printf("%d candidates written to %s.%s%s and %s.%s%s.\n",
+                  iNumCands,
+                  pcFilename,
+                  INFIX_ALLDM,
+                  EXT_YAPP_SPCAND,
+                  pcFilename,
+                  INFIX_ALLDM,
+                  EXT_CSV);
 
-    (void) printf("%d events of an expected %d detected.\n",
-                  iNumEvents,
-                  iNumRandEvents);
+    /* append the remaining candidates to the database */
+    iRet = YAPP_CDB_Close(&g_stCDB);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing candidate database failed!\n");
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* plot the candidates */
+    if (iGraphics)
+    {
+        (void) fclose(g_pFCandBin);
+        g_pFCandBin = NULL;
+        iRet = YAPP_SP_PlotCands(acFileCandBin,
+                                 ((stYUM.iTimeSamps - 1) * dTSampInSec)
+                                 + dTSpan,
+                                 pfDM[iNumDMs-1],
+                                 pfDM[0],
+                                 iInvCols);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Plotting candidates failed!\n");
+            CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
 
     (void) printf("DONE!\n");
 
-    YAPP_CleanUp();
+    CleanUp();
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Run the search threads on the current block
+ */
+static int RunThreads(int iNumThreads)
+{
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        iRet = pthread_create(&g_pstWorkers[i].stThread,
+                              NULL,
+                              YAPP_SP_SearchDMs,
+                              (void *) &g_pstWorkers[i]);
+        if (iRet != 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Creating thread failed! %s!\n",
+                           strerror(iRet));
+            iNumThreads = i;
+            iRet = YAPP_RET_ERROR;
+            break;
+        }
+    }
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        (void) pthread_join(g_pstWorkers[i].stThread, NULL);
+        if (g_pstWorkers[i].iRet != YAPP_RET_SUCCESS)
+        {
+            iRet = YAPP_RET_ERROR;
+        }
+    }
+
+    return iRet;
+}
+
+
+/*
+ * Search thread
+ */
+void* YAPP_SP_SearchDMs(void *pvWorker)
+{
+    YAPP_SP_WORKER *pstWorker = (YAPP_SP_WORKER *) pvWorker;
+    YAPP_SP_JOB *pstJob = pstWorker->pstJob;
+    int iHistLen = pstJob->iHistLen;
+    int iBytesPerBlock = (int) (pstJob->iBlockSize * pstJob->fSampSize);
+    float *pfRow = NULL;
+    float *pfData = NULL;
+    int iReadBytes = 0;
+    int iNumSamps = 0;
+    int i = 0;
+
+    pstWorker->iNumEvents = 0;
+    pstWorker->iRet = YAPP_RET_SUCCESS;
+
+    for (i = pstWorker->iFirstDM;
+         i < pstWorker->iFirstDM + pstWorker->iNumDMs;
+         ++i)
+    {
+        pfRow = pstJob->pfBuf + (size_t) i * pstJob->iRowLen;
+        pfData = pfRow + iHistLen;
+
+        /* read data - YAPP_ReadData() is not reentrant */
+        iReadBytes = fread(pstWorker->pcRawBuf,
+                           sizeof(char),
+                           iBytesPerBlock,
+                           pstJob->ppFIn[i]);
+        if (ferror(pstJob->ppFIn[i]))
+        {
+            (void) fprintf(stderr, "ERROR: File read failed!\n");
+            pstWorker->iRet = YAPP_RET_ERROR;
+            return NULL;
+        }
+        iNumSamps = (int) ((float) iReadBytes / pstJob->fSampSize);
+        (void) YAPP_UnpackData(pstWorker->pcRawBuf,
+                               pfData,
+                               pstJob->fSampSize,
+                               iNumSamps);
+        pstWorker->iNumSamps = iNumSamps;
+
+        /* remove slow baseline variations */
+        if (pstJob->iDetrendLen > 0)
+        {
+            YAPP_SP_Detrend(pfData,
+                            iNumSamps,
+                            pstJob->iDetrendLen,
+                            pstWorker->pfScratch,
+                            pstWorker->pfTrend);
+        }
+
+        /* normalise the row, and find boxcars above threshold */
+        YAPP_SP_SearchRow(pstWorker, i, iNumSamps);
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Subtract a baseline, interpolated linearly between the medians of chunks of
+ * the data
+ */
+static void YAPP_SP_Detrend(float *pfData,
+                            int iNumSamps,
+                            int iChunkLen,
+                            float *pfScratch,
+                            float *pfTrend)
+{
+    int iNumChunks = (iNumSamps + iChunkLen - 1) / iChunkLen;
+    int iLen = 0;
+    double dPos = 0.0;
+    int iChunk = 0;
+    int i = 0;
+
+    for (i = 0; i < iNumChunks; ++i)
+    {
+        iLen = (i < iNumChunks - 1) ? iChunkLen : iNumSamps - i * iChunkLen;
+        (void) memcpy(pfScratch,
+                      pfData + i * iChunkLen,
+                      iLen * sizeof(float));
+        pfTrend[i] = YAPP_CalcMedian(pfScratch, iLen);
+    }
+
+    /* the baseline is flat before the centre of the first chunk and after
+       the centre of the last */
+    for (i = 0; i < iNumSamps; ++i)
+    {
+        dPos = (i - (iChunkLen - 1) / 2.0) / iChunkLen;
+        if (dPos <= 0.0)
+        {
+            pfData[i] -= pfTrend[0];
+        }
+        else if (dPos >= iNumChunks - 1)
+        {
+            pfData[i] -= pfTrend[iNumChunks-1];
+        }
+        else
+        {
+            iChunk = (int) dPos;
+            pfData[i] -= pfTrend[iChunk]
+                         + (dPos - iChunk)
+                           * (pfTrend[iChunk+1] - pfTrend[iChunk]);
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * Write finished clusters to the candidate files
+ */
+static int YAPP_SP_WriteCands(YAPP_SP_CLUSTER *pstDone,
+                              int iNumDone,
+                              float *pfDM,
+                              double *pdTStart,
+                              double dTStartRef,
+                              YUM_t *pstYUM,
+                              int *piNumCands)
+{
+    YAPP_SP_CAND stCand = {0};
+    YAPP_CDB_CAND stDBCand = {0};
+    double dTSampInSec = pstYUM->dTSamp / 1e3;
+    int i = 0;
+
+    qsort(pstDone, iNumDone, sizeof(YAPP_SP_CLUSTER), YAPP_SP_ComparePeaks);
+    for (i = 0; i < iNumDone; ++i)
+    {
+        stCand.iWidth = 1 << pstDone[i].stPeak.iWidth;
+        stCand.lSamp = pstDone[i].stPeak.lSamp - stCand.iWidth + 1;
+        /* the time is counted from the reference start time, so that the
+           start time of the candidate's own DM trial is accounted for */
+        stCand.dTime = ((stCand.lSamp + (stCand.iWidth - 1) / 2.0)
+                        * dTSampInSec)
+                       + ((pdTStart[pstDone[i].stPeak.iDM] - dTStartRef)
+                          * 86400);
+        stCand.fDM = pfDM[pstDone[i].stPeak.iDM];
+        stCand.fSNR = pstDone[i].stPeak.fSNR;
+        stCand.iNumEvents = pstDone[i].iNumEvents;
+
+        if (fwrite(&stCand, sizeof(stCand), 1, g_pFCandBin) != 1)
+        {
+            return YAPP_RET_ERROR;
+        }
+        (void) fprintf(g_pFCandCSV,
+                       "%ld,%.9f,%g,%g,%d,%d\n",
+                       (long) stCand.lSamp,
+                       stCand.dTime,
+                       stCand.fDM,
+                       stCand.fSNR,
+                       stCand.iWidth,
+                       stCand.iNumEvents);
+
+        if (g_stCDB.pFDB != NULL)
+        {
+            stDBCand.dMJD = dTStartRef + (stCand.dTime / 86400);
+            stDBCand.dParam = stCand.iWidth * dTSampInSec;
+            stDBCand.fDM = stCand.fDM;
+            stDBCand.fSNR = stCand.fSNR;
+            stDBCand.iBeam = pstYUM->iBeamID;
+            stDBCand.cType = YAPP_CDB_TYPE_SP;
+            if (YAPP_CDB_Add(&g_stCDB, &stDBCand) != YAPP_RET_SUCCESS)
+            {
+                return YAPP_RET_ERROR;
+            }
+        }
+    }
+    *piNumCands += iNumDone;
 
     return YAPP_RET_SUCCESS;
 }
 
 
+/*
+ * Plot the candidates in a candidate file, with the line width indicating the
+ * S/N
+ */
+static int YAPP_SP_PlotCands(char *pcFileCand,
+                             float fTEnd,
+                             float fDMLo,
+                             float fDMHi,
+                             int iInvCols)
+{
+    FILE *pFCand = NULL;
+    YAPP_SP_FILEHEADER stFileHeader = {{0}};
+    YAPP_SP_CAND astCands[YAPP_SP_PLOTBATCH];
+    int iNumCands = 0;
+    float fLW = 0.0;
+    int i = 0;
+
+    pFCand = fopen(pcFileCand, "r");
+    if (NULL == pFCand)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileCand,
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    if ((fread(&stFileHeader, sizeof(stFileHeader), 1, pFCand) != 1)
+        || (memcmp(stFileHeader.acMagic,
+                   YAPP_SP_MAGIC,
+                   sizeof(stFileHeader.acMagic)) != 0)
+        || (stFileHeader.iRecordSize != sizeof(YAPP_SP_CAND)))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Invalid candidate file %s!\n",
+                       pcFileCand);
+        (void) fclose(pFCand);
+        return YAPP_RET_ERROR;
+    }
+
+    /* open the PGPLOT graphics device */
+    g_iPGDev = cpgopen(PG_DEV);
+    if (g_iPGDev <= 0)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening graphics device %s failed!\n",
+                       PG_DEV);
+        (void) fclose(pFCand);
+        return YAPP_RET_ERROR;
+    }
+
+    /* set the background colour to white and the foreground colour to
+       black, if user requires so */
+    if (YAPP_TRUE == iInvCols)
+    {
+        cpgscr(0, 1.0, 1.0, 1.0);
+        cpgscr(1, 0.0, 0.0, 0.0);
+    }
+
+    cpgsch(PG_CH);
+
+    /* set up plot */
+    cpgsvp(PG_VP_ML, PG_VP_MR, PG_VP_MB, PG_VP_MT);
+    cpgswin(0.0, fTEnd, fDMLo, fDMHi);
+    cpglab("Time (s)", "DM (pc cm\\u-3\\d)", "");
+    cpgbox("BCNST", 0.0, 0, "BCNST", 0.0, 0);
+    cpgsci(PG_CI_PLOT);
+
+    do
+    {
+        iNumCands = fread(astCands,
+                          sizeof(YAPP_SP_CAND),
+                          YAPP_SP_PLOTBATCH,
+                          pFCand);
+        for (i = 0; i < iNumCands; ++i)
+        {
+            fLW = powf(3, astCands[i].fSNR - stFileHeader.fThreshold);
+            if (fLW < 1.0)
+            {
+                cpgsci(1);
+                fLW = 1.0;
+            }
+            else if (fLW > 201.0)
+            {
+                cpgsci(2);
+                fLW = 201.0;
+            }
+            else
+            {
+                cpgsci(PG_CI_PLOT);
+            }
+            cpgslw(fLW);
+            cpgpt1((float) astCands[i].dTime, astCands[i].fDM, -1);
+        }
+    } while (YAPP_SP_PLOTBATCH == iNumCands);
+
+    (void) fclose(pFCand);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Cleans up the candidate files and all allocated memory
+ */
+static void CleanUp()
+{
+    if (g_pFCandBin != NULL)
+    {
+        (void) fclose(g_pFCandBin);
+        g_pFCandBin = NULL;
+    }
+    if (g_pFCandCSV != NULL)
+    {
+        (void) fclose(g_pFCandCSV);
+        g_pFCandCSV = NULL;
+    }
+    (void) YAPP_CDB_Close(&g_stCDB);
+    YAPP_CleanUp();
+
+    return;
+}
+
+
 /*
  * Prints usage information
  */
@@ -495,12 +1234,58 @@ void PrintUsage(const char *pcProgName)
     (void) printf("(default is 4096 samples)\n");
     (void) printf("    -t  --threshold                     ");
     (void) printf("Threshold in sigmas\n");
+    (void) printf("    -w  --maxwidth <samples>            ");
+    (void) printf("Maximum boxcar width, rounded down\n");
+    (void) printf("                                        ");
+    (void) printf("to a power of 2\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 1 sample)\n");
+    (void) printf("    -k  --ttol <samples>                ");
+    (void) printf("Time linking length for clustering\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 8 samples)\n");
+    (void) printf("    -d  --dmtol <trials>                ");
+    (void) printf("DM linking length for clustering\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 1 DM trial)\n");
+    (void) printf("    -m  --statwin <blocks>              ");
+    (void) printf("Length of the window over which the\n");
+    (void) printf("                                        ");
+    (void) printf("median and median absolute\n");
+    (void) printf("                                        ");
+    (void) printf("deviation are computed, for\n");
+    (void) printf("                                        ");
+    (void) printf("normalisation\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 8 blocks)\n");
+    (void) printf("    -r  --detrend <samples>             ");
+    (void) printf("Subtract a baseline interpolated\n");
+    (void) printf("                                        ");
+    (void) printf("between the medians of chunks of\n");
+    (void) printf("                                        ");
+    (void) printf("this length\n");
+    (void) printf("                                        ");
+    (void) printf("(default is no detrending)\n");
+    (void) printf("    -b  --db <database-file>            ");
+    (void) printf("Also add the candidates to a\n");
+    (void) printf("                                        ");
+    (void) printf("candidate database\n");
+    (void) printf("    -j  --threads <numthreads>          ");
+    (void) printf("Number of search threads\n");
+    (void) printf("                                        ");
+    (void) printf("(default is the number of processors)\n");
+    (void) printf("    -g  --graphics                      ");
+    (void) printf("Plot the candidates\n");
     (void) printf("    -i  --invert                        ");
     (void) printf("Invert background and foreground\n");
     (void) printf("                                        ");
     (void) printf("colours in plots\n");
     (void) printf("    -e  --non-interactive               ");
-    (void) printf("Run in non-interactive mode\n");
+    (void) printf("Accepted for compatibility; has no\n");
+    (void) printf("                                        ");
+    (void) printf("effect, as the search is always\n");
+    (void) printf("                                        ");
+    (void) printf("non-interactive\n");
     (void) printf("    -v  --version                       ");
     (void) printf("Display the version\n");
 
@@ -0,0 +1,235 @@
+/**
+ * @file yapp_siftpulses.h
+ * Header file for yapp_siftpulses
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_SIFTPULSES_H__
+#define __YAPP_SIFTPULSES_H__
+
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#define EXT_YAPP_SPCAND         ".ysp"  /* binary single-pulse candidate
+                                           list */
+
+#define YAPP_SP_MAGIC           "YSP2"  /* identifies a binary single-pulse
+                                           candidate file, and its version */
+#define YAPP_SP_MAXWIDTHS       16      /* maximum number of boxcar widths */
+#define YAPP_SP_MAXTHREADS      64      /* maximum number of search threads */
+#define YAPP_SP_PLOTBATCH       1024    /* candidates read at a time when
+                                           plotting */
+#define YAPP_SP_MAD2SIGMA       1.4826  /* ratio of the standard deviation
+                                           to the median absolute deviation,
+                                           for Gaussian noise */
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_SP_MAXWIDTH         1       /**< @brief Default maximum boxcar
+                                             width, in samples */
+#define DEF_SP_TTOL             8       /**< @brief Default time linking
+                                             length, in samples */
+#define DEF_SP_DMTOL            1       /**< @brief Default DM linking
+                                             length, in DM trials */
+#define DEF_SP_STATWIN          8       /**< @brief Default normalisation
+                                             window, in blocks */
+#define DEF_SP_MAXEVENTS        1048576 /**< @brief Capacity of the event
+                                             buffer of a block */
+#define DEF_SP_MAXCLUSTERS      65536   /**< @brief Capacity of the cluster
+                                             table */
+/* @} */
+
+/**
+ * Binary single-pulse candidate file header - the header is followed by
+ * YAPP_SP_CAND records, in the order the candidates were found, which is
+ * approximately time order
+ */
+typedef struct tagSPFileHeader
+{
+    char acMagic[4];        /* YAPP_SP_MAGIC */
+    int32_t iRecordSize;    /* sizeof(YAPP_SP_CAND) */
+    int32_t iNumDMs;        /* number of DM trials searched */
+    float fThreshold;       /* in sigmas */
+    double dTSamp;          /* in s */
+    double dTStart;         /* earliest start time of the DM trials, that
+                               candidate times are counted from, in MJD */
+    int32_t iBeamID;        /* beam identifier */
+    int32_t iNumBeams;      /* number of beams in the observation */
+} YAPP_SP_FILEHEADER;
+
+/**
+ * Single-pulse candidate - a cluster of above-threshold events, described by
+ * its brightest event
+ */
+typedef struct tagSPCand
+{
+    int64_t lSamp;          /* first sample of the boxcar at the peak, in
+                               the time series of its DM trial */
+    double dTime;           /* time of the centre of the boxcar at the peak,
+                               from the start time in the file header, in
+                               s */
+    float fDM;              /* in cm^-3 pc */
+    float fSNR;             /* peak S/N */
+    int32_t iWidth;         /* boxcar width at the peak, in samples */
+    int32_t iNumEvents;     /* number of events in the cluster */
+} YAPP_SP_CAND;
+
+/**
+ * Above-threshold event - the S/N of a boxcar in one DM trial
+ */
+typedef struct tagSPEvent
+{
+    long lSamp;             /* last sample of the boxcar */
+    float fSNR;
+    int iDM;                /* index of the DM trial */
+    int iWidth;             /* index of the boxcar width */
+} YAPP_SP_EVENT;
+
+/**
+ * Cluster of events, linked by friends-of-friends - merged clusters are kept
+ * in a list headed by the root, which holds the statistics
+ */
+typedef struct tagSPCluster
+{
+    int iParent;            /* index of the parent, the cluster itself for a
+                               root, or -1 for a free entry */
+    int iNext;              /* next cluster merged into the same root */
+    long lLastSamp;         /* latest sample of any event */
+    int iNumEvents;
+    YAPP_SP_EVENT stPeak;   /* brightest event */
+} YAPP_SP_CLUSTER;
+
+/**
+ * Friends-of-friends clustering state - for each DM trial and boxcar width,
+ * the latest event and its cluster are kept, so that an event need only be
+ * compared with one event in each neighbouring cell
+ */
+typedef struct tagSPClusterer
+{
+    int iNumDMs;
+    int iNumWidths;
+    long lTTol;             /* time linking length, in samples */
+    int iDMTol;             /* DM linking length, in DM trials */
+    long *plCellLastSamp;   /* latest event in each cell, iNumDMs x
+                               iNumWidths, or -1 */
+    int *piCellCluster;     /* cluster of the latest event in each cell */
+    YAPP_SP_CLUSTER *pstClusters;
+    int iMaxClusters;
+    int iNumUsed;           /* high-water mark of the cluster table */
+    int iFree;              /* head of the free list */
+} YAPP_SP_CLUSTERER;
+
+/**
+ * Search parameters and buffers shared by all search threads
+ */
+typedef struct tagSPJob
+{
+    FILE **ppFIn;               /* time series files, one per DM trial */
+    float fSampSize;            /* sample size, in bytes */
+    int iBlockSize;
+    int iHistLen;               /* number of samples of the previous block
+                                   kept for boxcars spanning blocks */
+    int iRowLen;                /* iHistLen + iBlockSize */
+    int iNumWidths;
+    float fThreshold;
+    float *pfBuf;               /* one row per DM trial */
+    int iDetrendLen;            /* length of the chunks whose medians form
+                                   the baseline, 0 for no detrending */
+    int iStatWin;               /* normalisation window, in blocks */
+    float *pfMedRing;           /* medians of the last iStatWin blocks of
+                                   each DM trial, iNumDMs x iStatWin */
+    float *pfMADRing;           /* median absolute deviations of the last
+                                   iStatWin blocks of each DM trial */
+    int iStatIdx;               /* slot of the current block in the rings */
+    int iNumStats;              /* number of valid slots, including the
+                                   current block */
+    long lBlockStart;           /* first sample of the current block */
+} YAPP_SP_JOB;
+
+/**
+ * Per-thread search buffers and events - each thread reads and searches a
+ * contiguous range of DM trials
+ */
+typedef struct tagSPWorker
+{
+    YAPP_SP_JOB *pstJob;
+    int iFirstDM;
+    int iNumDMs;
+    char *pcRawBuf;             /* raw data, iBlockSize samples */
+    double *pdCum;              /* cumulative sum of a row */
+    float *pfSNR;               /* boxcar S/N of a row */
+    float *pfScratch;           /* median scratch buffer, iBlockSize long */
+    float *pfTrend;             /* chunk medians of the baseline */
+    YAPP_SP_EVENT *pstEvents;   /* events of the current block */
+    int iMaxEvents;
+    int iNumEvents;
+    long lNumDropped;           /* events dropped as pstEvents was full */
+    int iNumSamps;              /* number of samples read in the current
+                                   block */
+    int iRet;
+    pthread_t stThread;
+} YAPP_SP_WORKER;
+
+/**
+ * Event comparison function for qsort() - sorts in time order, and then in
+ * DM order
+ */
+int YAPP_SP_CompareEvents(const void *pvEvent1, const void *pvEvent2);
+
+/**
+ * Cluster comparison function for qsort() - sorts in time order of the
+ * brightest event
+ */
+int YAPP_SP_ComparePeaks(const void *pvCluster1, const void *pvCluster2);
+
+/**
+ * Add an event to the clusters - events must be added in time order
+ *
+ * @param[inout]    pstClr          Clustering state
+ * @param[in]       pstEvent        Event
+ */
+int YAPP_SP_AddEvent(YAPP_SP_CLUSTERER *pstClr, YAPP_SP_EVENT *pstEvent);
+
+/**
+ * Remove the clusters that no event from sample lSamp on can join, and
+ * return their roots - all clusters are removed if lSamp is LONG_MAX
+ *
+ * @param[inout]    pstClr          Clustering state
+ * @param[in]       lSamp           First sample of the events still to come
+ * @param[out]      pstDone         Finished clusters, with the statistics
+ *                                  of the whole cluster
+ * @param[in]       iMaxDone        Capacity of pstDone
+ */
+int YAPP_SP_FinishClusters(YAPP_SP_CLUSTERER *pstClr,
+                           long lSamp,
+                           YAPP_SP_CLUSTER *pstDone,
+                           int iMaxDone);
+
+/**
+ * Normalise the current block of a DM trial by the median and the median
+ * absolute deviation over the normalisation window, and add the boxcars above
+ * threshold to the events of the worker. The block is in the row of the DM
+ * trial in the job buffer, after the history, which is updated.
+ *
+ * @param[inout]    pstWorker       Worker
+ * @param[in]       iDM             Index of the DM trial
+ * @param[in]       iNumSamps       Number of samples in the block
+ */
+void YAPP_SP_SearchRow(YAPP_SP_WORKER *pstWorker, int iDM, int iNumSamps);
+
+/**
+ * Search thread - reads the current block of a range of DM trials, normalises
+ * it, and finds boxcars above threshold
+ *
+ * @param[in]       pvWorker        Pointer to a YAPP_SP_WORKER
+ */
+void* YAPP_SP_SearchDMs(void *pvWorker);
+
+#endif  /* __YAPP_SIFTPULSES_H__ */
+
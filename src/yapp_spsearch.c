@@ -0,0 +1,338 @@
+/*
+ * @file yapp_spsearch.c
+ * Single-pulse search and clustering routines, shared by yapp_siftpulses,
+ *  which reads the dedispersed time series from files, and yapp_pipeline,
+ *  which gets them from the dedispersion stage in memory.
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_siftpulses.h"
+
+static int YAPP_SP_FindRoot(YAPP_SP_CLUSTER *pstClusters, int iCluster);
+
+
+/*
+ * Normalise a row and find boxcars above threshold
+ */
+void YAPP_SP_SearchRow(YAPP_SP_WORKER *pstWorker, int iDM, int iNumSamps)
+{
+    YAPP_SP_JOB *pstJob = pstWorker->pstJob;
+    int iHistLen = pstJob->iHistLen;
+    double *pdCum = pstWorker->pdCum;
+    float *pfRow = pstJob->pfBuf + (size_t) iDM * pstJob->iRowLen;
+    float *pfData = pfRow + iHistLen;
+    float *pfSNR = NULL;
+    float *pfMedRing = NULL;
+    float *pfMADRing = NULL;
+    float fMedian = 0.0;
+    float fMAD = 0.0;
+    float fInvSigma = 0.0;
+    float fNorm = 0.0;
+    int iWidth = 0;
+    int j = 0;
+    int k = 0;
+
+    /* compute the median and the median absolute deviation of the
+       block, and add them to the rings */
+    pfMedRing = pstJob->pfMedRing + (size_t) iDM * pstJob->iStatWin;
+    pfMADRing = pstJob->pfMADRing + (size_t) iDM * pstJob->iStatWin;
+    (void) memcpy(pstWorker->pfScratch, pfData, iNumSamps * sizeof(float));
+    fMedian = YAPP_CalcMedian(pstWorker->pfScratch, iNumSamps);
+    for (j = 0; j < iNumSamps; ++j)
+    {
+        pstWorker->pfScratch[j] = fabsf(pfData[j] - fMedian);
+    }
+    pfMedRing[pstJob->iStatIdx] = fMedian;
+    pfMADRing[pstJob->iStatIdx] = YAPP_CalcMedian(pstWorker->pfScratch,
+                                                  iNumSamps);
+
+    /* normalise by the medians of the statistics over the window, so
+       that neither a bright burst nor a short dropout affects them -
+       this and the boxcar loop below have no branches, so that they can
+       be vectorised */
+    (void) memcpy(pstWorker->pfScratch,
+                  pfMedRing,
+                  pstJob->iNumStats * sizeof(float));
+    fMedian = YAPP_CalcMedian(pstWorker->pfScratch, pstJob->iNumStats);
+    (void) memcpy(pstWorker->pfScratch,
+                  pfMADRing,
+                  pstJob->iNumStats * sizeof(float));
+    fMAD = YAPP_CalcMedian(pstWorker->pfScratch, pstJob->iNumStats);
+    fInvSigma = (fMAD > 0.0) ? (1.0 / (YAPP_SP_MAD2SIGMA * fMAD)) : 1.0;
+    for (j = 0; j < iNumSamps; ++j)
+    {
+        pfData[j] = (pfData[j] - fMedian) * fInvSigma;
+    }
+
+    /* boxcars wider than one sample are computed from the cumulative sum
+       of the row, so that boxcars spanning the previous block are
+       included */
+    if (pstJob->iNumWidths > 1)
+    {
+        pdCum[0] = 0.0;
+        for (j = 0; j < iHistLen + iNumSamps; ++j)
+        {
+            pdCum[j+1] = pdCum[j] + pfRow[j];
+        }
+    }
+
+    for (k = 0; k < pstJob->iNumWidths; ++k)
+    {
+        iWidth = 1 << k;
+        if (0 == k)
+        {
+            pfSNR = pfData;
+        }
+        else
+        {
+            double *pdEnd = pdCum + iHistLen + 1;
+            fNorm = 1.0 / sqrtf((float) iWidth);
+            pfSNR = pstWorker->pfSNR;
+            for (j = 0; j < iNumSamps; ++j)
+            {
+                pfSNR[j] = (float) (pdEnd[j] - pdEnd[j-iWidth]) * fNorm;
+            }
+        }
+
+        /* boxcars must not start before the first sample */
+        j = iWidth - 1 - (int) pstJob->lBlockStart;
+        if (j < 0)
+        {
+            j = 0;
+        }
+        for (; j < iNumSamps; ++j)
+        {
+            if (pfSNR[j] > pstJob->fThreshold)
+            {
+                if (pstWorker->iNumEvents == pstWorker->iMaxEvents)
+                {
+                    ++pstWorker->lNumDropped;
+                    continue;
+                }
+                pstWorker->pstEvents[pstWorker->iNumEvents].lSamp
+                                        = pstJob->lBlockStart + j;
+                pstWorker->pstEvents[pstWorker->iNumEvents].fSNR
+                                        = pfSNR[j];
+                pstWorker->pstEvents[pstWorker->iNumEvents].iDM = iDM;
+                pstWorker->pstEvents[pstWorker->iNumEvents].iWidth = k;
+                ++pstWorker->iNumEvents;
+            }
+        }
+    }
+
+    /* keep the end of the block for boxcars spanning blocks */
+    (void) memmove(pfRow, pfRow + iNumSamps, iHistLen * sizeof(float));
+
+    return;
+}
+
+
+/*
+ * Event comparison function for qsort()
+ */
+int YAPP_SP_CompareEvents(const void *pvEvent1, const void *pvEvent2)
+{
+    const YAPP_SP_EVENT *pstEvent1 = (const YAPP_SP_EVENT *) pvEvent1;
+    const YAPP_SP_EVENT *pstEvent2 = (const YAPP_SP_EVENT *) pvEvent2;
+
+    if (pstEvent1->lSamp != pstEvent2->lSamp)
+    {
+        return (pstEvent1->lSamp < pstEvent2->lSamp) ? -1 : 1;
+    }
+    if (pstEvent1->iDM != pstEvent2->iDM)
+    {
+        return (pstEvent1->iDM < pstEvent2->iDM) ? -1 : 1;
+    }
+
+    return pstEvent1->iWidth - pstEvent2->iWidth;
+}
+
+
+/*
+ * Cluster comparison function for qsort()
+ */
+int YAPP_SP_ComparePeaks(const void *pvCluster1, const void *pvCluster2)
+{
+    return YAPP_SP_CompareEvents(&((const YAPP_SP_CLUSTER *)
+                                        pvCluster1)->stPeak,
+                                 &((const YAPP_SP_CLUSTER *)
+                                        pvCluster2)->stPeak);
+}
+
+
+/*
+ * Find the root of a cluster, compressing the path
+ */
+static int YAPP_SP_FindRoot(YAPP_SP_CLUSTER *pstClusters, int iCluster)
+{
+    int iRoot = iCluster;
+    int iParent = 0;
+
+    while (pstClusters[iRoot].iParent != iRoot)
+    {
+        iRoot = pstClusters[iRoot].iParent;
+    }
+    while (iCluster != iRoot)
+    {
+        iParent = pstClusters[iCluster].iParent;
+        pstClusters[iCluster].iParent = iRoot;
+        iCluster = iParent;
+    }
+
+    return iRoot;
+}
+
+
+/*
+ * Add an event to the clusters
+ */
+int YAPP_SP_AddEvent(YAPP_SP_CLUSTERER *pstClr, YAPP_SP_EVENT *pstEvent)
+{
+    YAPP_SP_CLUSTER *pstClusters = pstClr->pstClusters;
+    int iRoot = -1;
+    int iOther = 0;
+    int iCell = 0;
+    int iTemp = 0;
+    int i = 0;
+    int j = 0;
+
+    /* since events arrive in time order, the latest event in a cell is the
+       closest in time, and any earlier event in the cell that is close
+       enough is already in the same cluster, so only the latest event in
+       each neighbouring cell needs to be checked. cells of finished clusters
+       are never linked to, as their latest events are too old */
+    for (i = pstEvent->iDM - pstClr->iDMTol;
+         i <= pstEvent->iDM + pstClr->iDMTol;
+         ++i)
+    {
+        if ((i < 0) || (i >= pstClr->iNumDMs))
+        {
+            continue;
+        }
+        for (j = pstEvent->iWidth - 1; j <= pstEvent->iWidth + 1; ++j)
+        {
+            if ((j < 0) || (j >= pstClr->iNumWidths))
+            {
+                continue;
+            }
+            iCell = i * pstClr->iNumWidths + j;
+            if ((pstClr->plCellLastSamp[iCell] < 0)
+                || (pstEvent->lSamp - pstClr->plCellLastSamp[iCell]
+                    > pstClr->lTTol))
+            {
+                continue;
+            }
+            iOther = YAPP_SP_FindRoot(pstClusters,
+                                      pstClr->piCellCluster[iCell]);
+            if (-1 == iRoot)
+            {
+                iRoot = iOther;
+            }
+            else if (iOther != iRoot)
+            {
+                /* merge the clusters, keeping the statistics in the root */
+                pstClusters[iOther].iParent = iRoot;
+                if (pstClusters[iOther].lLastSamp
+                    > pstClusters[iRoot].lLastSamp)
+                {
+                    pstClusters[iRoot].lLastSamp
+                                            = pstClusters[iOther].lLastSamp;
+                }
+                pstClusters[iRoot].iNumEvents
+                                            += pstClusters[iOther].iNumEvents;
+                if (pstClusters[iOther].stPeak.fSNR
+                    > pstClusters[iRoot].stPeak.fSNR)
+                {
+                    pstClusters[iRoot].stPeak = pstClusters[iOther].stPeak;
+                }
+                /* members are kept in circular lists, which are joined by
+                   swapping the successors of any one member of each */
+                iTemp = pstClusters[iRoot].iNext;
+                pstClusters[iRoot].iNext = pstClusters[iOther].iNext;
+                pstClusters[iOther].iNext = iTemp;
+            }
+        }
+    }
+
+    if (-1 == iRoot)
+    {
+        /* start a new cluster */
+        if (pstClr->iFree != -1)
+        {
+            iRoot = pstClr->iFree;
+            pstClr->iFree = pstClusters[iRoot].iNext;
+        }
+        else if (pstClr->iNumUsed < pstClr->iMaxClusters)
+        {
+            iRoot = pstClr->iNumUsed;
+            ++pstClr->iNumUsed;
+        }
+        else
+        {
+            return YAPP_RET_ERROR;
+        }
+        pstClusters[iRoot].iParent = iRoot;
+        pstClusters[iRoot].iNext = iRoot;
+        pstClusters[iRoot].lLastSamp = pstEvent->lSamp;
+        pstClusters[iRoot].iNumEvents = 1;
+        pstClusters[iRoot].stPeak = *pstEvent;
+    }
+    else
+    {
+        pstClusters[iRoot].lLastSamp = pstEvent->lSamp;
+        ++pstClusters[iRoot].iNumEvents;
+        if (pstEvent->fSNR > pstClusters[iRoot].stPeak.fSNR)
+        {
+            pstClusters[iRoot].stPeak = *pstEvent;
+        }
+    }
+
+    iCell = pstEvent->iDM * pstClr->iNumWidths + pstEvent->iWidth;
+    pstClr->plCellLastSamp[iCell] = pstEvent->lSamp;
+    pstClr->piCellCluster[iCell] = iRoot;
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Remove the clusters that can no longer grow
+ */
+int YAPP_SP_FinishClusters(YAPP_SP_CLUSTERER *pstClr,
+                           long lSamp,
+                           YAPP_SP_CLUSTER *pstDone,
+                           int iMaxDone)
+{
+    YAPP_SP_CLUSTER *pstClusters = pstClr->pstClusters;
+    int iNumDone = 0;
+    int iMember = 0;
+    int iNext = 0;
+    int i = 0;
+
+    for (i = 0; (i < pstClr->iNumUsed) && (iNumDone < iMaxDone); ++i)
+    {
+        if ((pstClusters[i].iParent != i)
+            || (lSamp - pstClusters[i].lLastSamp <= pstClr->lTTol))
+        {
+            continue;
+        }
+        pstDone[iNumDone] = pstClusters[i];
+        ++iNumDone;
+
+        /* return all members to the free list */
+        iMember = i;
+        do
+        {
+            iNext = pstClusters[iMember].iNext;
+            pstClusters[iMember].iParent = -1;
+            pstClusters[iMember].iNext = pstClr->iFree;
+            pstClr->iFree = iMember;
+            iMember = iNext;
+        } while (iMember != i);
+    }
+
+    return iNumDone;
+}
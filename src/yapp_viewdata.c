@@ -20,11 +20,30 @@
  *     -t  --period <period>                Period of the pulsar in ms
  *     -r  --phase <phase>                  Phase of the first pulse with
  *                                          respect to the first sample
+ *     -k  --mask <mask-file>               Replace the samples of filterbank
+ *                                          data flagged in this RFI mask file
+ *                                          with channel means
+ *     -l  --lod <factor>                   View the data decimated by this
+ *                                          factor, a power of two >= 16, as
+ *                                          the means of each channel (and
+ *                                          the range, for time series),
+ *                                          read from the decimation pyramid
+ *                                          of the data file, which is built
+ *                                          if needed
+ *     -y  --pol <pol>                      Polarization to read from
+ *                                          PSRFITS data - 'X', 'Y', or
+ *                                          'sum' (default is 'sum')
  *     -m  --colour-map <name>              Colour map for plotting
  *                                          (default is 'jet')
  *     -i  --invert                         Invert the background and foreground
  *                                          colours in plots
  *     -e  --non-interactive                Run in non-interactive mode
+ *     -o  --png                            Render the plots to PNG files,
+ *                                          without a graphics device
+ *     -j  --threads <numthreads>           Number of threads rendering PNG
+ *                                          files
+ *                                          (default is the number of
+ *                                          processors)
  *     -v  --version                        Display the version @endverbatim
  *
  * @author Jayanth Chennamangalam
@@ -37,6 +56,10 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_psrfits.h"   /* for PSRFITS file format support */
+#include "yapp_rfi.h"       /* for RFI masks */
+#include "yapp_pyramid.h"   /* for decimation pyramids */
+#include "yapp_png.h"       /* for plotting to PNG files */
 #include "colourmap.h"
 
 /**
@@ -112,12 +135,26 @@ int main(int argc, char *argv[])
     int m = 0;
     char acLabel[LEN_GENSTRING] = {0};
     int iColourMap = DEF_CMAP;
+    YAPP_RFI_MASK stMask = {{{0}}};
+    char *pcFileMaskIn = NULL;
     int iInvCols = YAPP_FALSE;
     char cIsNonInteractive = YAPP_FALSE;
     const char *pcProgName = NULL;
+    int iPol = YAPP_PF_POL_SUM;
+    int iLODFactor = 0;
+    int iLODLevel = 0;
+    YAPP_PYR stPyr = {{{0}}};
+    float *pfLODMin = NULL;
+    float *pfLODMax = NULL;
+    char cPlotToPNG = YAPP_FALSE;
+    int iNumThreads = 0;
+    YAPP_PNG_POOL stPool = {0};
+    YAPP_PNG_PLOT stPlot = {{0}};
+    float *pfPNGLines = NULL;
+    char *pcFilename = NULL;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hs:p:n:c:at:r:m:iev";
+    const char* const pcOptsShort = "hs:p:n:c:at:r:k:l:y:m:ieoj:v";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
@@ -128,9 +165,14 @@ int main(int argc, char *argv[])
         { "no-abs-range",           0, NULL, 'a' },
         { "period",                 1, NULL, 't' },
         { "phase",                  1, NULL, 'r' },
+        { "mask",                   1, NULL, 'k' },
+        { "lod",                    1, NULL, 'l' },
+        { "pol",                    1, NULL, 'y' },
         { "colour-map",             1, NULL, 'm' },
         { "invert",                 0, NULL, 'i' },
         { "non-interactive",        0, NULL, 'e' },
+        { "png",                    0, NULL, 'o' },
+        { "threads",                1, NULL, 'j' },
         { "version",                0, NULL, 'v' },
         { NULL,                     0, NULL, 0   }
     };
@@ -192,6 +234,38 @@ int main(int argc, char *argv[])
                 dStartPhase = atof(optarg);
                 break;
 
+            case 'k':   /* -k or --mask */
+                /* set option */
+                pcFileMaskIn = optarg;
+                break;
+
+            case 'l':   /* -l or --lod */
+                /* set option */
+                iLODFactor = atoi(optarg);
+                /* validate - the finest level of the pyramid summarises
+                   2^YAPP_PYR_FIRSTLEVEL samples */
+                if ((iLODFactor < (1 << YAPP_PYR_FIRSTLEVEL))
+                    || ((iLODFactor & (iLODFactor - 1)) != 0))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Decimation factor must be a power "
+                                   "of two >= %d!\n",
+                                   1 << YAPP_PYR_FIRSTLEVEL);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'y':   /* -y or --pol */
+                /* set option */
+                iPol = YAPP_PF_GetPolFromName(optarg);
+                if (YAPP_RET_ERROR == iPol)
+                {
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
             case 'm':   /* -m or --colour-map */
                 /* set option */
                 iColourMap = GetColourMapFromName(optarg);
@@ -207,6 +281,25 @@ int main(int argc, char *argv[])
                 cIsNonInteractive = YAPP_TRUE;
                 break;
 
+            case 'o':   /* -o or --png */
+                /* set option */
+                cPlotToPNG = YAPP_TRUE;
+                break;
+
+            case 'j':   /* -j or --threads */
+                /* set option */
+                iNumThreads = atoi(optarg);
+                if ((iNumThreads < 1) || (iNumThreads > YAPP_PNG_MAXTHREADS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of threads must be between "
+                                   "1 and %d!\n",
+                                   YAPP_PNG_MAXTHREADS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
             case 'v':   /* -v or --version */
                 /* display the version */
                 (void) printf("%s\n", g_pcVersion);
@@ -234,6 +327,20 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
+    /* render PNG files on one thread per processor, by default */
+    if (cPlotToPNG && (0 == iNumThreads))
+    {
+        iNumThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (iNumThreads < 1)
+        {
+            iNumThreads = 1;
+        }
+        else if (iNumThreads > YAPP_PNG_MAXTHREADS)
+        {
+            iNumThreads = YAPP_PNG_MAXTHREADS;
+        }
+    }
+
     /* register the signal-handling function */
     iRet = YAPP_RegisterSignalHandlers();
     if (iRet != YAPP_RET_SUCCESS)
@@ -265,6 +372,7 @@ int main(int argc, char *argv[])
     }
     if (!((YAPP_FORMAT_FIL == iFormat)
           || (YAPP_FORMAT_SPEC == iFormat)
+          || (YAPP_FORMAT_PSRFITS == iFormat)
           || (YAPP_FORMAT_DTS_TIM == iFormat)
           || (YAPP_FORMAT_DTS_DAT == iFormat)))
     {
@@ -272,6 +380,25 @@ int main(int argc, char *argv[])
                        "ERROR: Invalid file type!\n");
         return YAPP_RET_ERROR;
     }
+    /* the pyramid holds the data as they are in the file, so it cannot be
+       used for data that are processed sample by sample before plotting */
+    if (iLODFactor != 0)
+    {
+        if ((YAPP_FORMAT_SPEC == iFormat) || (YAPP_FORMAT_PSRFITS == iFormat))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Decimated viewing is supported only for "
+                           "SIGPROC filterbank and time series data!\n");
+            return YAPP_RET_ERROR;
+        }
+        if (pcFileMaskIn != NULL)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: RFI masks cannot be applied to decimated "
+                           "data!\n");
+            return YAPP_RET_ERROR;
+        }
+    }
 
     /* read metadata */
     iRet = YAPP_ReadMetadata(pcFileData, iFormat, &stYUM);
@@ -282,6 +409,21 @@ int main(int argc, char *argv[])
                        pcFileData);
         return YAPP_RET_ERROR;
     }
+    if (YAPP_FORMAT_PSRFITS == iFormat)
+    {
+        /* open the PSRFITS files as a stream of scaled, single-polarization
+           data, which is read as a headerless filterbank file from here on */
+        g_pFData = YAPP_PF_Open(pcFileData, iPol, &stYUM);
+        if (NULL == g_pFData)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening file %s failed!\n",
+                           pcFileData);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iFormat = YAPP_FORMAT_FIL;
+    }
     /* kludge: the rest of the code expects stYUM.iNumChans = 1 for time series
        data, so make it 1 */
     if ((YAPP_FORMAT_DTS_TIM == iFormat)
@@ -382,6 +524,30 @@ int main(int argc, char *argv[])
                   iNumReads,
                   iBlockSize);
 
+    if (iLODFactor != 0)
+    {
+        /* from here on, a sample is a record of the pyramid, summarising
+           iLODFactor samples of the data */
+        iTimeSampsToSkip /= iLODFactor;
+        iTimeSampsToProc = (iTimeSampsToProc + iLODFactor - 1) / iLODFactor;
+        stYUM.dTSamp *= iLODFactor;
+        dTSampInSec = stYUM.dTSamp / 1e3;
+        dDataSkipTime = iTimeSampsToSkip * dTSampInSec;
+        iNumReads = (int) ceilf((float) iTimeSampsToProc / iBlockSize);
+        iTotNumReads = iNumReads;
+        if (iTimeSampsToProc < iBlockSize)
+        {
+            iBlockSize = iTimeSampsToProc;
+        }
+        iTotSampsPerBlock = stYUM.iNumChans * iBlockSize;
+        (void) printf("Viewing at decimation factor %d, as %d points in %d "
+                      "reads with block size %d points...\n",
+                      iLODFactor,
+                      iTimeSampsToProc,
+                      iNumReads,
+                      iBlockSize);
+    }
+
     (void) printf("Observation start time: %.15g MJD\n", stYUM.dTStart);
 
     /* calculate the threshold */
@@ -419,7 +585,10 @@ int main(int argc, char *argv[])
     (void) memset(g_pcIsTimeGood, YAPP_TRUE, iTimeSampsToProc);
 
     /* open the data file for reading */
-    g_pFData = fopen(pcFileData, "r");
+    if (NULL == g_pFData)
+    {
+        g_pFData = fopen(pcFileData, "r");
+    }
     if (NULL == g_pFData)
     {
         (void) fprintf(stderr,
@@ -462,27 +631,102 @@ int main(int argc, char *argv[])
         (void) fseek(g_pFData, lBytesToSkip, SEEK_SET);
     }
 
-    /* open the PGPLOT graphics device */
-    g_iPGDev = cpgopen(PG_DEV);
-    if (g_iPGDev <= 0)
+    if (iLODFactor != 0)
     {
-        (void) fprintf(stderr,
-                       "ERROR: Opening graphics device %s failed!\n",
-                       PG_DEV);
-        YAPP_CleanUp();
-        return YAPP_RET_ERROR;
+        /* open the pyramid, building it from the start of the data, if
+           needed */
+        (void) fseek(g_pFData,
+                     (YAPP_FORMAT_DTS_DAT == iFormat)
+                     ? 0L
+                     : (long) stYUM.iHeaderLen,
+                     SEEK_SET);
+        iRet = YAPP_PYR_Open(&stPyr, pcFileData, g_pFData, &stYUM, iBlockSize);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening decimation pyramid failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iLODLevel = YAPP_PYR_GetLevel(&stPyr, iLODFactor);
+        if (YAPP_RET_ERROR == iLODLevel)
+        {
+            (void) YAPP_PYR_Close(&stPyr);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if ((YAPP_FORMAT_DTS_TIM == iFormat)
+            || (YAPP_FORMAT_DTS_DAT == iFormat))
+        {
+            /* allocate memory for the range of each point, to be plotted
+               around the means */
+            pfLODMin = (float *) YAPP_Malloc(iBlockSize,
+                                             sizeof(float),
+                                             YAPP_TRUE);
+            pfLODMax = (float *) YAPP_Malloc(iBlockSize,
+                                             sizeof(float),
+                                             YAPP_TRUE);
+            /* the means and the range are plotted as three lines in PNG
+               files */
+            if (cPlotToPNG)
+            {
+                pfPNGLines = (float *) YAPP_Malloc((size_t) 3 * iBlockSize,
+                                                   sizeof(float),
+                                                   YAPP_FALSE);
+            }
+            if ((NULL == pfLODMin) || (NULL == pfLODMax)
+                || (cPlotToPNG && (NULL == pfPNGLines)))
+            {
+                (void) fprintf(stderr,
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
+                (void) YAPP_PYR_Close(&stPyr);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+        }
     }
 
-    /* set the background colour to white and the foreground colour to
-       black, if user requires so */
-    if (YAPP_TRUE == iInvCols)
+    if (cPlotToPNG)
     {
-        cpgscr(0, 1.0, 1.0, 1.0);
-        cpgscr(1, 0.0, 0.0, 0.0);
+        /* start the threads that render the plots, instead of opening a
+           graphics device */
+        pcFilename = YAPP_GetFilenameFromPath(pcFileData);
+        iRet = YAPP_PNG_Start(&stPool, iNumThreads);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Starting rendering threads failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        stPlot.iColourMap = iColourMap;
+        stPlot.iInvCols = iInvCols;
     }
+    else
+    {
+        /* open the PGPLOT graphics device */
+        g_iPGDev = cpgopen(PG_DEV);
+        if (g_iPGDev <= 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Opening graphics device %s failed!\n",
+                           PG_DEV);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
 
-    /* set character height */
-    cpgsch(PG_CH);
+        /* set the background colour to white and the foreground colour to
+           black, if user requires so */
+        if (YAPP_TRUE == iInvCols)
+        {
+            cpgscr(0, 1.0, 1.0, 1.0);
+            cpgscr(1, 0.0, 0.0, 0.0);
+        }
+
+        /* set character height */
+        cpgsch(PG_CH);
+    }
 
     /* set up the plot's X-axis */
     g_pfXAxis = (float *) YAPP_Malloc(iBlockSize,
@@ -555,6 +799,30 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
+    /* read the RFI mask to be applied, if any */
+    if (pcFileMaskIn != NULL)
+    {
+        if ((iFormat != YAPP_FORMAT_FIL) && (iFormat != YAPP_FORMAT_SPEC))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: RFI masks can be applied only to "
+                           "filterbank data!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        iRet = YAPP_RFI_ReadMask(&stMask,
+                                 pcFileMaskIn,
+                                 stYUM.iNumChans,
+                                 dTSampInSec);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading RFI mask failed!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
     if (dPeriod != 0.0)
     {
         /* compute the phase difference between successive samples */
@@ -566,10 +834,24 @@ int main(int argc, char *argv[])
         /* read data */
         (void) printf("\rReading data block %d.", iReadBlockCount);
         (void) fflush(stdout);
-        iReadItems = YAPP_ReadData(g_pFData,
-                                   g_pfBuf,
-                                   stYUM.fSampSize,
-                                   iTotSampsPerBlock);
+        if (iLODFactor != 0)
+        {
+            iReadItems = YAPP_PYR_Read(&stPyr,
+                                       iLODLevel,
+                                       iTimeSampsToSkip
+                                       + ((long) iReadBlockCount * iBlockSize),
+                                       iBlockSize,
+                                       pfLODMin,
+                                       pfLODMax,
+                                       g_pfBuf);
+        }
+        else
+        {
+            iReadItems = YAPP_ReadData(g_pFData,
+                                       g_pfBuf,
+                                       stYUM.fSampSize,
+                                       iTotSampsPerBlock);
+        }
         if (YAPP_RET_ERROR == iReadItems)
         {
             (void) fprintf(stderr, "ERROR: Reading data failed!\n");
@@ -706,6 +988,16 @@ int main(int argc, char *argv[])
             }
         }
 
+        /* apply the RFI mask */
+        if (pcFileMaskIn != NULL)
+        {
+            YAPP_RFI_ApplyMask(&stMask,
+                               g_pfBuf,
+                               iNumSamps,
+                               iTimeSampsToSkip
+                               + ((long) (iReadBlockCount - 1) * iBlockSize));
+        }
+
         for (i = 0; i < iBlockSize; ++i)
         {
             g_pfXAxisOld[i] = g_pfXAxis[i];
@@ -756,41 +1048,60 @@ int main(int argc, char *argv[])
                 ++k;
             }
 
-            /* erase the previous x-axis */
-            if (!cIsFirst && !cIsNonInteractive)   /* kludge */
+            if (cPlotToPNG)
             {
-                cpgsvp(PG_2D_VP_ML, PG_2D_VP_MR, PG_2D_VP_MB, PG_2D_VP_MT);
-                cpgswin(g_pfXAxisOld[0],
-                        g_pfXAxisOld[iBlockSize-1],
-                        g_pfYAxis[0],
-                        g_pfYAxis[stYUM.iNumChans-1]);
+                stPlot.iType = YAPP_PNG_TYPE_IMAGE;
+                stPlot.pfData = g_pfPlotBuf;
+                stPlot.iLenX = iBlockSize;
+                stPlot.iLenY = stYUM.iNumChans;
+                stPlot.fDataMin = fDataMin;
+                stPlot.fDataMax = fDataMax;
+                stPlot.fYMin = g_pfYAxis[0];
+                stPlot.fYMax = g_pfYAxis[stYUM.iNumChans-1];
+                (void) strcpy(stPlot.acYLabel, "Frequency (MHz)");
+                (void) strcpy(stPlot.acTitle, "Dynamic Spectrum");
+            }
+            else
+            {
+                /* erase the previous x-axis */
+                if (!cIsFirst && !cIsNonInteractive)   /* kludge */
+                {
+                    cpgsvp(PG_2D_VP_ML, PG_2D_VP_MR, PG_2D_VP_MB, PG_2D_VP_MT);
+                    cpgswin(g_pfXAxisOld[0],
+                            g_pfXAxisOld[iBlockSize-1],
+                            g_pfYAxis[0],
+                            g_pfYAxis[stYUM.iNumChans-1]);
+                }
+                cpgsci(0);      /* background */
+                cpgaxis("N",
+                        g_pfXAxisOld[0], g_pfYAxis[0],
+                        g_pfXAxisOld[iBlockSize-1], g_pfYAxis[0],
+                        g_pfXAxisOld[0], g_pfXAxisOld[iBlockSize-1],
+                        0.0,
+                        0,
+                        0.5,
+                        0.0,
+                        0.5,
+                        0.5,
+                        0);
+                cpgbox("CST", 0.0, 0, "CST", 0.0, 0);
+                cIsFirst = YAPP_FALSE;
+                cpgsci(PG_CI_DEF);
+                Plot2D(g_pfPlotBuf, fDataMin, fDataMax,
+                       g_pfXAxis, iBlockSize, dTSampInSec,
+                       g_pfYAxis, stYUM.iNumChans, stYUM.fChanBW,
+                       "Time - Start Time (s)", "Frequency (MHz)", "Dynamic Spectrum",
+                       iColourMap);
             }
-            cpgsci(0);      /* background */
-            cpgaxis("N",
-                    g_pfXAxisOld[0], g_pfYAxis[0],
-                    g_pfXAxisOld[iBlockSize-1], g_pfYAxis[0],
-                    g_pfXAxisOld[0], g_pfXAxisOld[iBlockSize-1],
-                    0.0,
-                    0,
-                    0.5,
-                    0.0,
-                    0.5,
-                    0.5,
-                    0);
-            cpgbox("CST", 0.0, 0, "CST", 0.0, 0);
-            cIsFirst = YAPP_FALSE;
-            cpgsci(PG_CI_DEF);
-            Plot2D(g_pfPlotBuf, fDataMin, fDataMax,
-                   g_pfXAxis, iBlockSize, dTSampInSec,
-                   g_pfYAxis, stYUM.iNumChans, stYUM.fChanBW,
-                   "Time - Start Time (s)", "Frequency (MHz)", "Dynamic Spectrum",
-                   iColourMap);
         }
         else
         {
-            /* erase just before plotting, to reduce flicker */
-            cpgeras();
-            cpgsvp(PG_VP_ML, PG_VP_MR, PG_VP_MB, PG_VP_MT);
+            if (!cPlotToPNG)
+            {
+                /* erase just before plotting, to reduce flicker */
+                cpgeras();
+                cpgsvp(PG_VP_ML, PG_VP_MR, PG_VP_MB, PG_VP_MT);
+            }
             /* set minimum and maximum according to intrinsic values and clip
                level */
             if (cUseAbsScale)
@@ -826,16 +1137,97 @@ int main(int argc, char *argv[])
                         }
                     }
                 }
+                if (pfLODMin != NULL)
+                {
+                    /* include the range of each point */
+                    for (j = 0; j < iNumSamps; ++j)
+                    {
+                        if (pfLODMin[j] < fDataMin)
+                        {
+                            fDataMin = pfLODMin[j];
+                        }
+                        if (pfLODMax[j] > fDataMax)
+                        {
+                            fDataMax = pfLODMax[j];
+                        }
+                    }
+                }
             }
-            cpgswin(g_pfXAxis[0],
-                    g_pfXAxis[iBlockSize-1],
-                    fDataMin,
-                    fDataMax);
-            cpglab("Time - Start Time (s)", "", "Time Series");
-            cpgbox("BCNST", 0.0, 0, "BCNST", 0.0, 0);
-            cpgsci(PG_CI_PLOT);
-            cpgline(iBlockSize, g_pfXAxis, g_pfBuf);
-            cpgsci(PG_CI_DEF);
+            if (cPlotToPNG)
+            {
+                stPlot.iType = YAPP_PNG_TYPE_LINES;
+                stPlot.pfData = g_pfBuf;
+                stPlot.iLenX = iBlockSize;
+                stPlot.iLenY = 1;
+                if (pfLODMin != NULL)
+                {
+                    /* plot the minima and maxima as lines around the means */
+                    (void) memcpy(pfPNGLines,
+                                  g_pfBuf,
+                                  sizeof(float) * iBlockSize);
+                    (void) memcpy(pfPNGLines + iBlockSize,
+                                  pfLODMin,
+                                  sizeof(float) * iBlockSize);
+                    (void) memcpy(pfPNGLines + (2 * iBlockSize),
+                                  pfLODMax,
+                                  sizeof(float) * iBlockSize);
+                    stPlot.pfData = pfPNGLines;
+                    stPlot.iLenY = 3;
+                }
+                stPlot.fDataMin = fDataMin;
+                stPlot.fDataMax = fDataMax;
+                stPlot.fYMin = fDataMin;
+                stPlot.fYMax = fDataMax;
+                (void) strcpy(stPlot.acYLabel, "");
+                (void) strcpy(stPlot.acTitle, "Time Series");
+            }
+            else
+            {
+                cpgswin(g_pfXAxis[0],
+                        g_pfXAxis[iBlockSize-1],
+                        fDataMin,
+                        fDataMax);
+                cpglab("Time - Start Time (s)", "", "Time Series");
+                cpgbox("BCNST", 0.0, 0, "BCNST", 0.0, 0);
+                if (pfLODMin != NULL)
+                {
+                    /* plot the range of each point behind the means */
+                    cpgsci(PG_CI_DEF);
+                    cpgerry(iNumSamps, g_pfXAxis, pfLODMax, pfLODMin, 0.0);
+                }
+                cpgsci(PG_CI_PLOT);
+                cpgline(iBlockSize, g_pfXAxis, g_pfBuf);
+                cpgsci(PG_CI_DEF);
+            }
+        }
+
+        if (cPlotToPNG)
+        {
+            /* queue the plot, and go on to the next block while it is being
+               rendered - the period markers, the plot number and the buttons
+               are not drawn */
+            (void) snprintf(stPlot.acFile,
+                            LEN_GENSTRING,
+                            "%s.%06d%s",
+                            pcFilename,
+                            iReadBlockCount,
+                            EXT_PNG);
+            stPlot.fXMin = g_pfXAxis[0];
+            stPlot.fXMax = g_pfXAxis[iBlockSize-1];
+            (void) strcpy(stPlot.acXLabel, "Time - Start Time (s)");
+            iRet = YAPP_PNG_Submit(&stPool, &stPlot);
+            if (iRet != YAPP_RET_SUCCESS)
+            {
+                (void) fprintf(stderr, "ERROR: Rendering plot failed!\n");
+                (void) YAPP_PNG_Stop(&stPool);
+                YAPP_CleanUp();
+                return YAPP_RET_ERROR;
+            }
+            if (1 == iNumReads)
+            {
+                cIsLastBlock = YAPP_TRUE;
+            }
+            continue;
         }
 
         if (dPeriod != 0.0)
@@ -924,6 +1316,7 @@ int main(int argc, char *argv[])
                         (void) usleep(PG_BUT_CL_SLEEP);
 
                         cpgclos();
+                        (void) YAPP_PYR_Close(&stPyr);
                         YAPP_CleanUp();
                         return YAPP_RET_SUCCESS;
                     }
@@ -942,9 +1335,26 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (cPlotToPNG)
+    {
+        /* wait for the plots to be rendered */
+        iRet = YAPP_PNG_Stop(&stPool);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr, "ERROR: Rendering plots failed!\n");
+            (void) YAPP_PYR_Close(&stPyr);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+    }
+
     (void) printf("DONE!\n");
 
-    cpgclos();
+    if (!cPlotToPNG)
+    {
+        cpgclos();
+    }
+    (void) YAPP_PYR_Close(&stPyr);
     YAPP_CleanUp();
 
     return YAPP_RET_SUCCESS;
@@ -987,6 +1397,30 @@ void PrintUsage(const char *pcProgName)
     (void) printf("Phase of the first pulse with respect\n");
     (void) printf("                                        ");
     (void) printf("to the first sample\n");
+    (void) printf("    -k  --mask <mask-file>              ");
+    (void) printf("Replace the samples of filterbank\n");
+    (void) printf("                                        ");
+    (void) printf("data flagged in this RFI mask file\n");
+    (void) printf("                                        ");
+    (void) printf("with channel means\n");
+    (void) printf("    -l  --lod <factor>                  ");
+    (void) printf("View the data decimated by this\n");
+    (void) printf("                                        ");
+    (void) printf("factor, a power of two >= 16, as the\n");
+    (void) printf("                                        ");
+    (void) printf("means of each channel (and the range,\n");
+    (void) printf("                                        ");
+    (void) printf("for time series), read from the\n");
+    (void) printf("                                        ");
+    (void) printf("decimation pyramid of the data file,\n");
+    (void) printf("                                        ");
+    (void) printf("which is built if needed\n");
+    (void) printf("    -y  --pol <pol>                     ");
+    (void) printf("Polarization to read from PSRFITS\n");
+    (void) printf("                                        ");
+    (void) printf("data - 'X', 'Y', or 'sum'\n");
+    (void) printf("                                        ");
+    (void) printf("(default is 'sum')\n");
     (void) printf("    -m  --colour-map <name>             ");
     (void) printf("Colour map for plotting\n");
     (void) printf("                                        ");
@@ -997,6 +1431,14 @@ void PrintUsage(const char *pcProgName)
     (void) printf("colours in plots\n");
     (void) printf("    -e  --non-interactive               ");
     (void) printf("Run in non-interactive mode\n");
+    (void) printf("    -o  --png                           ");
+    (void) printf("Render the plots to PNG files, without\n");
+    (void) printf("                                        ");
+    (void) printf("a graphics device\n");
+    (void) printf("    -j  --threads <numthreads>          ");
+    (void) printf("Number of threads rendering PNG files\n");
+    (void) printf("                                        ");
+    (void) printf("(default is the number of processors)\n");
     (void) printf("    -v  --version                       ");
     (void) printf("Display the version\n");
 
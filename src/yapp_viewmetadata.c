@@ -6,6 +6,16 @@
  * @verbatim
  * Usage: yapp_viewmetadata [options] <data-file>
  *     -h  --help                           Display this usage information
+ *     -b  --batch                          Print a table, with one line per
+ *                                          file
+ *     -j  --jobs <jobs>                    Number of files read at a time in
+ *                                          batch mode
+ *                                          (default is the number of
+ *                                          processors)
+ *     -r  --recompute                      Recompute statistics, ignoring
+ *                                          cached values
+ *     -c  --cache                          Cache statistics in an extended
+ *                                          attribute of each file
  *     -v  --version                        Display the version @endverbatim
  *
  * @author Jayanth Chennamangalam
@@ -14,6 +24,14 @@
 
 #include "yapp.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define LEN_ROW             (2 * LEN_GENSTRING)     /* length of a line of the
+                                                       batch-mode table */
+
+static int PrintTable(char **ppcFiles, int iNumFiles, int iNumJobs);
+static void MakeRow(char *pcFileSpec, char *pcRow);
 
 /**
  * The build version string, maintained in the file version.c, which is
@@ -21,19 +39,31 @@
  */
 extern const char *g_pcVersion;
 
+/* flag to use cached statistics */
+extern char g_cUseStatsCache;
+
+/* flag to cache statistics */
+extern char g_cWriteStatsCache;
+
 int main(int argc, char *argv[])
 {
     char *pcFileSpec = NULL;
     int iFormat = DEF_FORMAT;
     int iRet = YAPP_RET_SUCCESS;
     YUM_t stYUM = {{0}};
+    char cIsBatch = YAPP_FALSE;
+    int iNumJobs = 0;
     const char *pcProgName = NULL;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hv";
+    const char* const pcOptsShort = "hbj:rcv";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
+        { "batch",                  0, NULL, 'b' },
+        { "jobs",                   1, NULL, 'j' },
+        { "recompute",              0, NULL, 'r' },
+        { "cache",                  0, NULL, 'c' },
         { "version",                0, NULL, 'v' },
         { NULL,                     0, NULL, 0   }
     };
@@ -52,6 +82,34 @@ int main(int argc, char *argv[])
                 PrintUsage(pcProgName);
                 return YAPP_RET_SUCCESS;
 
+            case 'b':   /* -b or --batch */
+                /* set option flag */
+                cIsBatch = YAPP_TRUE;
+                break;
+
+            case 'j':   /* -j or --jobs */
+                /* set option flag and read the value */
+                iNumJobs = atoi(optarg);
+                if (iNumJobs < 1)
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of jobs must be "
+                                   "positive!\n");
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'r':   /* -r or --recompute */
+                /* set option flag */
+                g_cUseStatsCache = YAPP_FALSE;
+                break;
+
+            case 'c':   /* -c or --cache */
+                /* set option flag */
+                g_cWriteStatsCache = YAPP_TRUE;
+                break;
+
             case 'v':   /* -v or --version */
                 /* display the version */
                 (void) printf("%s\n", g_pcVersion);
@@ -79,6 +137,11 @@ int main(int argc, char *argv[])
         return YAPP_RET_ERROR;
     }
 
+    if (cIsBatch)
+    {
+        return PrintTable(&argv[optind], argc - optind, iNumJobs);
+    }
+
     /* handle expanded wildcards */
     iNextOpt = optind;
     while ((argc - iNextOpt) != 0)
@@ -228,8 +291,10 @@ int main(int argc, char *argv[])
         }
         ++iNextOpt;
 
-        /* clear stYUM before loading it again */
+        /* clear stYUM before loading it again, and free its memory, so that
+           any number of files can be read */
         (void) memset(&stYUM, '\0', sizeof(YUM_t));
+        YAPP_CleanUp();
     }
 
     /* clean up */
@@ -238,6 +303,179 @@ int main(int argc, char *argv[])
     return YAPP_RET_SUCCESS;
 }
 
+/*
+ * Prints a table of the metadata and statistics of many files, with one line
+ * per file, reading the files in parallel - the metadata-reading functions use
+ * global state, so the files are read by separate processes, which write their
+ * lines to shared memory
+ */
+static int PrintTable(char **ppcFiles, int iNumFiles, int iNumJobs)
+{
+    char *pcRows = NULL;
+    pid_t *piPIDs = NULL;
+    int iStatus = 0;
+    int iRet = YAPP_RET_SUCCESS;
+    int i = 0;
+    int j = 0;
+
+    /* use one process per processor, but not more than there are files */
+    if (0 == iNumJobs)
+    {
+        iNumJobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (iNumJobs < 1)
+        {
+            iNumJobs = 1;
+        }
+    }
+    if (iNumJobs > iNumFiles)
+    {
+        iNumJobs = iNumFiles;
+    }
+
+    pcRows = (char *) mmap(NULL,
+                           (size_t) iNumFiles * LEN_ROW,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS,
+                           -1,
+                           0);
+    if (MAP_FAILED == pcRows)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+    piPIDs = (pid_t *) YAPP_Malloc((size_t) iNumJobs,
+                                   sizeof(pid_t),
+                                   YAPP_TRUE);
+    if (NULL == piPIDs)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        (void) munmap(pcRows, (size_t) iNumFiles * LEN_ROW);
+        return YAPP_RET_ERROR;
+    }
+
+    /* make sure that nothing buffered is written by the children as well */
+    (void) fflush(stdout);
+
+    /* start the jobs, each reading every iNumJobs-th file */
+    for (i = 0; i < iNumJobs; ++i)
+    {
+        piPIDs[i] = fork();
+        if (-1 == piPIDs[i])
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Starting job failed! %s!\n",
+                           strerror(errno));
+            iRet = YAPP_RET_ERROR;
+            break;
+        }
+        if (0 == piPIDs[i])
+        {
+            for (j = i; j < iNumFiles; j += iNumJobs)
+            {
+                MakeRow(ppcFiles[j], pcRows + ((size_t) j * LEN_ROW));
+                YAPP_CleanUp();
+            }
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    /* wait for the jobs */
+    for (j = 0; j < i; ++j)
+    {
+        if ((waitpid(piPIDs[j], &iStatus, 0) != piPIDs[j])
+            || !WIFEXITED(iStatus)
+            || (WEXITSTATUS(iStatus) != EXIT_SUCCESS))
+        {
+            (void) fprintf(stderr, "ERROR: Job %d failed!\n", j);
+            iRet = YAPP_RET_ERROR;
+        }
+    }
+
+    if (YAPP_RET_SUCCESS == iRet)
+    {
+        (void) printf("# %-12s %-12s %10s %12s %6s %4s %10s %10s %11s %11s "
+                      "%11s %11s %s\n",
+                      "Site",
+                      "Source",
+                      "DM",
+                      "TSamp(ms)",
+                      "Chans",
+                      "Bits",
+                      "Samples",
+                      "Time(s)",
+                      "Min",
+                      "Max",
+                      "Mean",
+                      "RMS",
+                      "File");
+        for (j = 0; j < iNumFiles; ++j)
+        {
+            (void) printf("%s\n", pcRows + ((size_t) j * LEN_ROW));
+        }
+    }
+
+    (void) munmap(pcRows, (size_t) iNumFiles * LEN_ROW);
+    YAPP_CleanUp();
+
+    return iRet;
+}
+
+/*
+ * Makes the line of the batch-mode table for a file
+ */
+static void MakeRow(char *pcFileSpec, char *pcRow)
+{
+    int iFormat = DEF_FORMAT;
+    YUM_t stYUM = {{0}};
+    int iRet = YAPP_RET_SUCCESS;
+
+    /* determine the file type */
+    iFormat = YAPP_GetFileType(pcFileSpec);
+    if (!((YAPP_FORMAT_PSRFITS == iFormat)
+          || (YAPP_FORMAT_FIL == iFormat)
+          || (YAPP_FORMAT_SPEC == iFormat)
+          || (YAPP_FORMAT_DTS_TIM == iFormat)
+          || (YAPP_FORMAT_DTS_DAT == iFormat)))
+    {
+        (void) snprintf(pcRow, LEN_ROW, "# Invalid file type: %s", pcFileSpec);
+        return;
+    }
+
+    iRet = YAPP_ReadMetadata(pcFileSpec, iFormat, &stYUM);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) snprintf(pcRow,
+                        LEN_ROW,
+                        "# Reading metadata failed: %s",
+                        pcFileSpec);
+        return;
+    }
+
+    (void) snprintf(pcRow,
+                    LEN_ROW,
+                    "  %-12s %-12s %10g %12.6g %6d %4d %10d %10g %11.5g %11.5g "
+                    "%11.5g %11.5g %s",
+                    stYUM.acSite,
+                    stYUM.acPulsar,
+                    stYUM.dDM,
+                    stYUM.dTSamp,
+                    stYUM.iNumChans,
+                    stYUM.iNumBits,
+                    stYUM.iTimeSamps,
+                    (stYUM.iTimeSamps * (stYUM.dTSamp / 1e3)),
+                    stYUM.fMin,
+                    stYUM.fMax,
+                    stYUM.fMean,
+                    stYUM.fRMS,
+                    pcFileSpec);
+
+    return;
+}
+
 /*
  * Prints usage information
  */
@@ -247,6 +485,26 @@ void PrintUsage(const char *pcProgName)
                   pcProgName);
     (void) printf("    -h  --help                          ");
     (void) printf("Display this usage information\n");
+    (void) printf("    -b  --batch                         ");
+    (void) printf("Print a table, with one line per\n");
+    (void) printf("                                        ");
+    (void) printf("file\n");
+    (void) printf("    -j  --jobs <jobs>                   ");
+    (void) printf("Number of files read at a time in\n");
+    (void) printf("                                        ");
+    (void) printf("batch mode\n");
+    (void) printf("                                        ");
+    (void) printf("(default is the number of\n");
+    (void) printf("                                        ");
+    (void) printf("processors)\n");
+    (void) printf("    -r  --recompute                     ");
+    (void) printf("Recompute statistics, ignoring\n");
+    (void) printf("                                        ");
+    (void) printf("cached values\n");
+    (void) printf("    -c  --cache                         ");
+    (void) printf("Cache statistics in an extended\n");
+    (void) printf("                                        ");
+    (void) printf("attribute of each file\n");
     (void) printf("    -v  --version                       ");
     (void) printf("Display the version\n");
 
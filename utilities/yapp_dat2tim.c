@@ -133,8 +133,9 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    /* open .tim file and write data */
-    pFTim = fopen(acFileTim, "a");
+    /* open .tim file and write data after the header - the file is not opened
+       in append mode, as the kernel does not copy data into such files */
+    pFTim = fopen(acFileTim, "r+");
     if (NULL == pFTim)
     {
         fprintf(stderr,
@@ -143,7 +144,8 @@ int main(int argc, char *argv[])
                 strerror(errno));
         return EXIT_FAILURE;
     }
-    iRet = YAPP_CopyData(pcFileData, pFTim);
+    (void) fseek(pFTim, 0, SEEK_END);
+    iRet = YAPP_CopyFileData(pcFileData, 0, pFTim);
     if (iRet != EXIT_SUCCESS)
     {
         fprintf(stderr,
@@ -159,73 +161,6 @@ int main(int argc, char *argv[])
 
 
 
-int YAPP_CopyData(char *pcFileData, FILE *pFTim)
-{
-    FILE *pFData = NULL;
-    struct stat stFileStats = {0};
-    off_t lByteCount = 0;
-    char *pcBuf = NULL;
-    int iRet = EXIT_SUCCESS;
-
-    /* get the file size */
-    iRet = stat(pcFileData, &stFileStats);
-    if (iRet != EXIT_SUCCESS)
-    {
-        (void) fprintf(stderr,
-                       "ERROR: Failed to stat %s: %s!\n",
-                       pcFileData,
-                       strerror(errno));
-        (void) fclose(pFData);
-        return EXIT_FAILURE;
-    }
-
-    /* open the file */
-    pFData = fopen(pcFileData, "r");
-    if (NULL == pFData)
-    {
-        fprintf(stderr,
-                "ERROR: Opening file %s failed! %s.\n",
-                pcFileData,
-                strerror(errno));
-        return EXIT_FAILURE;
-    }
-
-    /* allocate memory for the buffer */
-    pcBuf = (char *) malloc(SIZE_BUF);
-    if (NULL == pcBuf)
-    {
-        (void) fprintf(stderr,
-                       "ERROR: Memory allocation for buffer failed! %s!\n",
-                       strerror(errno));
-        (void) fclose(pFData);
-        return EXIT_FAILURE;
-    }
-
-    /* copy data */
-    do
-    {
-        iRet = fread(pcBuf, 1, SIZE_BUF, pFData);
-        lByteCount += iRet;
-        (void) fwrite(pcBuf, 1, iRet, pFTim);
-    }
-    while (SIZE_BUF == iRet);
-
-    free(pcBuf);
-
-    /* check if all data has been copied */
-    if (lByteCount != stFileStats.st_size)
-    {
-        (void) fprintf(stderr, "ERROR: Data copy failed!\n");
-        printf("%ld, %ld\n", lByteCount, stFileStats.st_size);
-        (void) fclose(pFData);
-        return EXIT_FAILURE;
-    }
-
-    (void) fclose(pFData);
-
-    return EXIT_SUCCESS;
-}
-
 /*
  * Prints usage information
  */
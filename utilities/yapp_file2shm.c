@@ -0,0 +1,414 @@
+/*
+ * @file yapp_file2shm.c
+ * Program to play a data file into a shared-memory ring buffer, standing in
+ *  for a backend at the telescope, so that the tools that read ring buffers
+ *  can be run on recorded data. SIGPROC .fil files are written as filterbank
+ *  data, and files of any other type as 8-bit, complex, dual-polarization
+ *  baseband data, as read by yapp_ft.
+ *
+ * @verbatim
+ * Usage: yapp_file2shm [options] <data-file> <ring-name>
+ *     -h  --help                           Display this usage information
+ *     -n  --nsamp <samples>                Number of samples in one block
+ *                                          (default is 4096 samples)
+ *     -b  --nblocks <blocks>               Number of blocks in the ring
+ *                                          (default is 8 blocks)
+ *     -r  --real-time                      Write the blocks at the rate at
+ *                                          which the data was taken,
+ *                                          dropping those that the reader is
+ *                                          not ready for
+ *     -l  --tsamp <tsamp>                  Sampling time in s, for baseband
+ *                                          data
+ *     -f  --centre-freq <freq>             Centre frequency of observing band,
+ *                                          in MHz, for baseband data
+ *     -v  --version                        Display the version @endverbatim
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#include "yapp.h"
+#include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
+#include "yapp_file2shm.h"
+#include <time.h>
+
+/**
+ * The build version string, maintained in the file version.c, which is
+ * generated by makever.c.
+ */
+extern const char *g_pcVersion;
+
+/* data file */
+extern FILE *g_pFData;
+
+int main(int argc, char *argv[])
+{
+    char *pcFileSpec = NULL;
+    char *pcRing = NULL;
+    char *pcExt = NULL;
+    YUM_t stYUM = {{0}};
+    YAPP_SHM_HEADER stHdr = {{0}};
+    YAPP_SHM_WRITER *pstWriter = NULL;
+    struct stat stFileStats = {0};
+    struct timespec stNext = {0};
+    char *pcBuf = NULL;
+    int iNumSamps = DEF_F2S_NUMSAMPS;
+    int iNumBlocks = DEF_SHM_NUMBLOCKS;
+    double dTSampInSec = 0.0;
+    double dFreqCen = 0.0;
+    double dTBlock = 0.0;
+    long int lBlockSize = 0;
+    long int lReadLen = 0;
+    int iBlockCount = 0;
+    char cIsRealTime = YAPP_FALSE;
+    int iRet = YAPP_RET_SUCCESS;
+    const char *pcProgName = NULL;
+    int iNextOpt = 0;
+    /* valid short options */
+    const char* const pcOptsShort = "hn:b:rl:f:v";
+    /* valid long options */
+    const struct option stOptsLong[] = {
+        { "help",                   0, NULL, 'h' },
+        { "nsamp",                  1, NULL, 'n' },
+        { "nblocks",                1, NULL, 'b' },
+        { "real-time",              0, NULL, 'r' },
+        { "tsamp",                  1, NULL, 'l' },
+        { "centre-freq",            1, NULL, 'f' },
+        { "version",                0, NULL, 'v' },
+        { NULL,                     0, NULL, 0   }
+    };
+
+    /* get the filename of the program from the argument list */
+    pcProgName = argv[0];
+
+    /* parse the input */
+    do
+    {
+        iNextOpt = getopt_long(argc, argv, pcOptsShort, stOptsLong, NULL);
+        switch (iNextOpt)
+        {
+            case 'h':   /* -h or --help */
+                /* print usage info and terminate */
+                PrintUsage(pcProgName);
+                return YAPP_RET_SUCCESS;
+
+            case 'n':   /* -n or --nsamp */
+                /* set option */
+                iNumSamps = atoi(optarg);
+                break;
+
+            case 'b':   /* -b or --nblocks */
+                /* set option */
+                iNumBlocks = atoi(optarg);
+                break;
+
+            case 'r':   /* -r or --real-time */
+                /* set option */
+                cIsRealTime = YAPP_TRUE;
+                break;
+
+            case 'l':   /* -l or --tsamp */
+                /* set option */
+                dTSampInSec = atof(optarg);
+                break;
+
+            case 'f':   /* -f or --centre-freq */
+                /* set option */
+                dFreqCen = atof(optarg);
+                break;
+
+            case 'v':   /* -v or --version */
+                /* display the version */
+                (void) printf("%s\n", g_pcVersion);
+                return YAPP_RET_SUCCESS;
+
+            case '?':   /* user specified an invalid option */
+                /* print usage info and terminate with error */
+                (void) fprintf(stderr, "ERROR: Invalid option!\n");
+                PrintUsage(pcProgName);
+                return YAPP_RET_ERROR;
+
+            case -1:    /* done with options */
+                break;
+
+            default:    /* unexpected */
+                assert(0);
+        }
+    } while (iNextOpt != -1);
+
+    /* no arguments */
+    if (argc <= (optind + 1))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Input file or ring buffer not specified!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* user input validation */
+    if ((iNumSamps <= 0) || (iNumBlocks <= 0))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Number of samples and number of blocks must be "
+                       "greater than 0!\n");
+        PrintUsage(pcProgName);
+        return YAPP_RET_ERROR;
+    }
+
+    /* register the signal-handling function */
+    iRet = YAPP_RegisterSignalHandlers();
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Handler registration failed!\n");
+        return YAPP_RET_ERROR;
+    }
+
+    /* get the input filename and the name of the ring */
+    pcFileSpec = argv[optind];
+    pcRing = argv[optind+1];
+
+    /* describe the data in the header of the ring */
+    pcExt = strrchr(pcFileSpec, '.');
+    if ((pcExt != NULL) && (0 == strcmp(pcExt, EXT_FIL)))
+    {
+        iRet = YAPP_ReadMetadata(pcFileSpec, YAPP_FORMAT_FIL, &stYUM);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading metadata failed for file %s!\n",
+                           pcFileSpec);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if ((((long int) iNumSamps * stYUM.iNumChans * stYUM.iNumBits)
+             % YAPP_BYTE2BIT_FACTOR) != 0)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Block does not end on a byte boundary!\n");
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        stHdr.iDataType = YAPP_SHM_DATA_FIL;
+        stHdr.iNumChans = stYUM.iNumChans;
+        stHdr.iNumBits = stYUM.iNumBits;
+        stHdr.dTSamp = stYUM.dTSamp / 1e3;
+        if (stYUM.cIsBandFlipped)
+        {
+            stHdr.dFChan1 = stYUM.fFMax;
+            stHdr.dChanBW = -stYUM.fChanBW;
+        }
+        else
+        {
+            stHdr.dFChan1 = stYUM.fFMin;
+            stHdr.dChanBW = stYUM.fChanBW;
+        }
+        stHdr.dTStart = stYUM.dTStart;
+        stHdr.lNumSamps = stYUM.iTimeSamps;
+        (void) snprintf(stHdr.acPulsar,
+                        sizeof(stHdr.acPulsar),
+                        "%s",
+                        stYUM.acPulsar);
+        (void) snprintf(stHdr.acSite,
+                        sizeof(stHdr.acSite),
+                        "%.*s",
+                        (int) sizeof(stHdr.acSite) - 1,
+                        stYUM.acSite);
+    }
+    else
+    {
+        if ((0.0 == dTSampInSec) || (0.0 == dFreqCen))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Sampling interval and centre frequency "
+                           "must be specified for baseband data!\n");
+            PrintUsage(pcProgName);
+            return YAPP_RET_ERROR;
+        }
+        iRet = stat(pcFileSpec, &stFileStats);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Failed to stat %s: %s!\n",
+                           pcFileSpec,
+                           strerror(errno));
+            return YAPP_RET_ERROR;
+        }
+        stHdr.iDataType = YAPP_SHM_DATA_RAW;
+        stHdr.iNumChans = 1;
+        stHdr.iNumBits = YAPP_SAMPSIZE_8;
+        stHdr.dTSamp = dTSampInSec;
+        stHdr.dFChan1 = dFreqCen;
+        stHdr.dChanBW = 1.0 / (dTSampInSec * 1e6);
+        stHdr.lNumSamps = (long int) stFileStats.st_size
+                          / YAPP_SHM_NUMBYTES_RAW;
+        stYUM.iHeaderLen = 0;
+    }
+    if (YAPP_SHM_DATA_RAW == stHdr.iDataType)
+    {
+        lBlockSize = (long int) iNumSamps * YAPP_SHM_NUMBYTES_RAW;
+    }
+    else
+    {
+        lBlockSize = ((long int) iNumSamps * stHdr.iNumChans * stHdr.iNumBits)
+                     / YAPP_BYTE2BIT_FACTOR;
+    }
+    stHdr.iNumBlocks = iNumBlocks;
+    stHdr.lBlockSize = lBlockSize;
+    dTBlock = iNumSamps * stHdr.dTSamp;
+
+    pcBuf = (char *) YAPP_Malloc((size_t) lBlockSize,
+                                 sizeof(char),
+                                 YAPP_FALSE);
+    if (NULL == pcBuf)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* open the data file for reading, and skip the header */
+    g_pFData = fopen(pcFileSpec, "r");
+    if (NULL == g_pFData)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       pcFileSpec,
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    (void) fseek(g_pFData, (long) stYUM.iHeaderLen, SEEK_SET);
+
+    pstWriter = YAPP_SHM_Create(pcRing, &stHdr);
+    if (NULL == pstWriter)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Creating ring buffer %s failed!\n",
+                       pcRing);
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    (void) printf("Writing %ld time samples to %s, in blocks of %d samples "
+                  "(%g s)...\n",
+                  (long int) stHdr.lNumSamps,
+                  pstWriter->acName,
+                  iNumSamps,
+                  dTBlock);
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &stNext);
+    while (YAPP_TRUE)
+    {
+        lReadLen = (long int) fread(pcBuf,
+                                    sizeof(char),
+                                    (size_t) lBlockSize,
+                                    g_pFData);
+        if (ferror(g_pFData))
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Reading data failed! %s.\n",
+                           strerror(errno));
+            (void) YAPP_SHM_Destroy(pstWriter);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (0 == lReadLen)
+        {
+            break;
+        }
+
+        if (cIsRealTime)
+        {
+            /* wait until the block would have been taken */
+            stNext.tv_nsec += (long int) ((dTBlock - floor(dTBlock)) * 1e9);
+            stNext.tv_sec += (time_t) floor(dTBlock)
+                             + (stNext.tv_nsec / 1000000000L);
+            stNext.tv_nsec %= 1000000000L;
+            do
+            {
+                iRet = clock_nanosleep(CLOCK_MONOTONIC,
+                                       TIMER_ABSTIME,
+                                       &stNext,
+                                       NULL);
+            }
+            while (EINTR == iRet);
+        }
+
+        iRet = YAPP_SHM_Write(pstWriter, pcBuf, lReadLen, cIsRealTime);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr, "ERROR: Writing block failed!\n");
+            (void) YAPP_SHM_Destroy(pstWriter);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        ++iBlockCount;
+        (void) printf("\rWrote block %d.", iBlockCount);
+        (void) fflush(stdout);
+    }
+
+    (void) printf("\n");
+    if (pstWriter->lNumDropped > 0)
+    {
+        (void) printf("WARNING: %ld of %d blocks dropped!\n",
+                      pstWriter->lNumDropped,
+                      iBlockCount);
+    }
+    iRet = YAPP_SHM_Destroy(pstWriter);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "WARNING: The reader did not read to the end of the "
+                       "data!\n");
+    }
+
+    YAPP_CleanUp();
+
+    (void) printf("DONE!\n");
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Prints usage information
+ */
+void PrintUsage(const char *pcProgName)
+{
+    (void) printf("Usage: %s [options] <data-file> <ring-name>\n",
+                  pcProgName);
+    (void) printf("    -h  --help                           ");
+    (void) printf("Display this usage information\n");
+    (void) printf("    -n  --nsamp <samples>                ");
+    (void) printf("Number of samples in one block\n");
+    (void) printf("                                         ");
+    (void) printf("(default is 4096 samples)\n");
+    (void) printf("    -b  --nblocks <blocks>               ");
+    (void) printf("Number of blocks in the ring\n");
+    (void) printf("                                         ");
+    (void) printf("(default is 8 blocks)\n");
+    (void) printf("    -r  --real-time                      ");
+    (void) printf("Write the blocks at the rate at\n");
+    (void) printf("                                         ");
+    (void) printf("which the data was taken,\n");
+    (void) printf("                                         ");
+    (void) printf("dropping those that the reader is\n");
+    (void) printf("                                         ");
+    (void) printf("not ready for\n");
+    (void) printf("    -l  --tsamp <tsamp>                  ");
+    (void) printf("Sampling time in s, for baseband\n");
+    (void) printf("                                         ");
+    (void) printf("data\n");
+    (void) printf("    -f  --centre-freq <freq>             ");
+    (void) printf("Centre frequency of observing band,\n");
+    (void) printf("                                         ");
+    (void) printf("in MHz, for baseband data\n");
+    (void) printf("    -v  --version                        ");
+    (void) printf("Display the version\n");
+
+    return;
+}
+
@@ -0,0 +1,23 @@
+/**
+ * @file yapp_file2shm.h
+ * Header file for yapp_file2shm
+ *
+ * @author agent
+ * @date 2026.10.19
+ */
+
+#ifndef __YAPP_FILE2SHM_H__
+#define __YAPP_FILE2SHM_H__
+
+#include "yapp_shm.h"
+
+/**
+ * @ingroup Defaults
+ */
+/* @{ */
+#define DEF_F2S_NUMSAMPS        4096    /**< @brief Default number of samples
+                                             in a block */
+/* @} */
+
+#endif  /* __YAPP_FILE2SHM_H__ */
+
@@ -1,12 +1,20 @@
 /*
  * @file yapp_fits2fil.c
  * Program to convert multiple PSRFITS files to a single filterbank file.
+ *  Subints are read, scaled and split into polarizations by a pool of
+ *  threads, reading ahead across file boundaries, and written in order.
  *
  * @verbatim
  * Usage: yapp_fits2fil [options] <data-files>
  *     -h  --help                           Display this usage information
  *     -s  --sum                            Sum polarizations in the case of
  *                                          dual-polarization data
+ *     -j  --threads <numthreads>           Number of conversion threads
+ *                                          (default is the number of
+ *                                          processors)
+ *     -r  --raw                            Write the raw samples, without
+ *                                          applying DAT_SCL, DAT_OFFS and
+ *                                          DAT_WTS
  *     -v  --version                        Display the version @endverbatim
  *
  * @author Jayanth Chennamangalam
@@ -14,11 +22,15 @@
  */
 
 #include "yapp.h"
-#include "yapp_fits2fil.h"
 #include "yapp_sigproc.h"   /* for SIGPROC filterbank file format support */
 #include "yapp_psrfits.h"
+#include "yapp_fits2fil.h"
 #include <fitsio.h>
 
+static int StartWorkers(int iNumThreads);
+static void StopWorkers(void);
+static void CleanUp(void);
+
 /**
  * The build version string, maintained in the file version.c, which is
  * generated by makever.c.
@@ -30,10 +42,9 @@ extern FILE *g_pFData;
 
 /* the following are global only to enable cleaning up in case of abnormal
    termination, such as those triggered by SIGINT or SIGTERM */
-void *g_pvBuf = NULL;
-void *g_pvPolX = NULL;
-void *g_pvPolY = NULL;
-void *g_pvPolSum = NULL;
+YAPP_FITS2FIL_JOB g_stJob;
+YAPP_FITS2FIL_WORKER *g_pstWorkers = NULL;
+int g_iNumWorkers = 0;      /* number of conversion threads running */
 FILE *g_pFDataSec = NULL;
 
 int main(int argc, char *argv[])
@@ -41,28 +52,33 @@ int main(int argc, char *argv[])
     char *pcFileSpec = NULL;
     char *pcFileOut = NULL;
     char acFileOut[LEN_GENSTRING] = {0};
-    fitsfile *pstFileData = NULL;
     int iFormat = DEF_FORMAT;
     YUM_t stYUM = {{0}};
     int iRet = YAPP_RET_SUCCESS;
-    int iNumSubInt = 0;
-    int iColNum = 0;
-    char acErrMsg[LEN_GENSTRING] = {0};
+    long int lNumSubInts = 0;
     int iSampsPerSubInt = 0;
-    long int lBytesPerSubInt = 0;
-    int iStatus = 0;
+    int iNumFiles = 0;
+    int iNumThreads = 0;
+    YAPP_FITS2FIL_JOB *pstJob = &g_stJob;
+    YAPP_FITS2FIL_SLOT *pstSlot = NULL;
+    long int lSubInt = 0;
+    long int lElemsPerSubInt = 0;
+    long int lBytesPerPol = 0;
+    int iDataBits = 0;
+    int iFile = -1;
     int i = 0;
-    int iDataType = 0;
     char cToSum = YAPP_FALSE;
-    char cIsFirst = YAPP_TRUE;
+    char cToScale = YAPP_TRUE;
     const char *pcProgName = NULL;
     int iNextOpt = 0;
     /* valid short options */
-    const char* const pcOptsShort = "hsv";
+    const char* const pcOptsShort = "hsj:rv";
     /* valid long options */
     const struct option stOptsLong[] = {
         { "help",                   0, NULL, 'h' },
         { "sum",                    0, NULL, 's' },
+        { "threads",                1, NULL, 'j' },
+        { "raw",                    0, NULL, 'r' },
         { "version",                0, NULL, 'v' },
         { NULL,                     0, NULL, 0   }
     };
@@ -86,6 +102,26 @@ int main(int argc, char *argv[])
                 cToSum = YAPP_TRUE;
                 break;
 
+            case 'j':   /* -j or --threads */
+                /* set option */
+                iNumThreads = atoi(optarg);
+                if ((iNumThreads < 1)
+                    || (iNumThreads > YAPP_FITS2FIL_MAXTHREADS))
+                {
+                    (void) fprintf(stderr,
+                                   "ERROR: Number of threads must be between "
+                                   "1 and %d!\n",
+                                   YAPP_FITS2FIL_MAXTHREADS);
+                    PrintUsage(pcProgName);
+                    return YAPP_RET_ERROR;
+                }
+                break;
+
+            case 'r':   /* -r or --raw */
+                /* set option */
+                cToScale = YAPP_FALSE;
+                break;
+
             case 'v':   /* -v or --version */
                 /* display the version */
                 (void) printf("%s\n", g_pcVersion);
@@ -123,17 +159,29 @@ int main(int argc, char *argv[])
     }
 
     /* handle expanded wildcards */
-    iNextOpt = optind;
-    while ((argc - iNextOpt) != 0)
+    iNumFiles = argc - optind;
+    (void) memset(pstJob, '\0', sizeof(YAPP_FITS2FIL_JOB));
+    pstJob->ppcFiles = &argv[optind];
+    pstJob->iNumFiles = iNumFiles;
+    pstJob->plFirstSubInt = (long int *) YAPP_Malloc((size_t) iNumFiles + 1,
+                                                     sizeof(long int),
+                                                     YAPP_TRUE);
+    if (NULL == pstJob->plFirstSubInt)
     {
-        /* get the input filename */
-        pcFileSpec = argv[iNextOpt];
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
 
-        if ((argc - optind) > 1)    /* more than one input file */
-        {
-            (void) printf("\rProcessing file %s.", pcFileSpec);
-            (void) fflush(stdout);
-        }
+    /* read the metadata of the first file, and the number of subints in
+       every file, so that the subints of all files can be read in parallel
+       and written in order */
+    for (i = 0; i < iNumFiles; ++i)
+    {
+        /* get the input filename */
+        pcFileSpec = argv[optind+i];
 
         /* determine the file type */
         iFormat = YAPP_GetFileType(pcFileSpec);
@@ -141,16 +189,18 @@ int main(int argc, char *argv[])
         {
             (void) fprintf(stderr,
                            "ERROR: File type determination failed!\n");
+            YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
         if (iFormat != YAPP_FORMAT_PSRFITS)
         {
             (void) fprintf(stderr,
                            "ERROR: Invalid file type!\n");
+            YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
 
-        if (cIsFirst)
+        if (0 == i)
         {
             /* read metadata */
             iRet = YAPP_ReadMetadata(pcFileSpec, iFormat, &stYUM);
@@ -159,14 +209,16 @@ int main(int argc, char *argv[])
                 (void) fprintf(stderr,
                                "ERROR: Reading metadata failed for file %s!\n",
                                pcFileSpec);
+                YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
 
-            if (stYUM.iNumPol > YAPP_MAX_NPOL)
+            if ((stYUM.iNumPol > YAPP_MAX_NPOL) || (3 == stYUM.iNumPol))
             {
                 (void) fprintf(stderr,
                                "ERROR: Unsupported number of polarizations!"
                                "\n");
+                YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
 
@@ -174,403 +226,987 @@ int main(int argc, char *argv[])
             {
                 (void) printf("WARNING: Cannot sum polarizations in "
                               "single-polarization data!\n");
+                cToSum = YAPP_FALSE;
             }
-
-            /* build output file name */
-            pcFileOut = YAPP_GetFilenameFromPath(pcFileSpec);
-            (void) strcpy(acFileOut, pcFileOut);
-            if ((YAPP_MAX_NPOL == stYUM.iNumPol)
-                && (!cToSum))
+            if (YAPP_MAX_NPOL == stYUM.iNumPol)
             {
-                (void) strcat(acFileOut, ".X");
+                (void) printf("WARNING: Using only the first two of the four "
+                              "polarizations!\n");
             }
-            (void) strcat(acFileOut, EXT_FIL);
+        }
 
-            /* write metadata */
-            iFormat = YAPP_FORMAT_FIL;
-            iRet = YAPP_WriteMetadata(acFileOut, iFormat, stYUM);
-            if (iRet != YAPP_RET_SUCCESS)
-            {
-                (void) fprintf(stderr,
-                               "ERROR: Writing metadata failed for file %s!\n",
-                               acFileOut);
-                YAPP_CleanUp();
-                return YAPP_RET_ERROR;
-            }
+        /* NOTE: the number of rows may be different in the last file, so this
+                 needs to be read for every file */
+        iRet = YAPP_PF_GetNumSubInts(pcFileSpec,
+                                     &lNumSubInts,
+                                     &iSampsPerSubInt);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (0 == i)
+        {
+            pstJob->iSampsPerSubInt = iSampsPerSubInt;
         }
+        else if (iSampsPerSubInt != pstJob->iSampsPerSubInt)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Number of samples per subint of %s differs "
+                           "from that of %s!\n",
+                           pcFileSpec,
+                           argv[optind]);
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        pstJob->plFirstSubInt[i+1] = pstJob->plFirstSubInt[i] + lNumSubInts;
+    }
+    pstJob->lNumSubInts = pstJob->plFirstSubInt[iNumFiles];
+    if (0 == pstJob->lNumSubInts)
+    {
+        (void) fprintf(stderr, "ERROR: No subints in input!\n");
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    pstJob->iNumBits = stYUM.iNumBits;
+    pstJob->iNumPol = stYUM.iNumPol;
+    pstJob->iNumChans = stYUM.iNumChans;
+    pstJob->cToSum = cToSum;
+    pstJob->cToScale = cToScale;
+    lElemsPerSubInt = (long int) stYUM.iNumPol * stYUM.iNumChans
+                      * pstJob->iSampsPerSubInt;
+    pstJob->lBytesPerSubInt = (long int) (lElemsPerSubInt
+                                          * ((float) stYUM.iNumBits
+                                             / YAPP_BYTE2BIT_FACTOR));
+    pstJob->iDataType = YAPP_PF_GetDataType(stYUM.iNumBits,
+                                            lElemsPerSubInt,
+                                            &pstJob->lElemsPerSubInt);
+    if (YAPP_RET_ERROR == pstJob->iDataType)
+    {
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* scaled data is written as 32-bit floating-point samples, sub-byte
+       samples are written one to a byte, except 4-bit samples, and sums are
+       written at a larger sample size than the input */
+    if (cToScale)
+    {
+        stYUM.iNumBits = YAPP_SAMPSIZE_32;
+    }
+    iDataBits = stYUM.iNumBits;
+    pstJob->iOutBits = YAPP_FITS2FIL_GetOutBits(iDataBits, cToSum);
+    stYUM.iNumBits = pstJob->iOutBits;
+    /* length of the output for each polarization, or the sum */
+    lBytesPerPol = (long int) (((long int) stYUM.iNumChans
+                                * pstJob->iSampsPerSubInt)
+                               * ((float) stYUM.iNumBits
+                                  / YAPP_BYTE2BIT_FACTOR));
+
+    /* build output file name */
+    pcFileOut = YAPP_GetFilenameFromPath(argv[optind]);
+    (void) strcpy(acFileOut, pcFileOut);
+    if ((stYUM.iNumPol > 1)
+        && (!cToSum))
+    {
+        (void) strcat(acFileOut, ".X");
+    }
+    (void) strcat(acFileOut, EXT_FIL);
+
+    /* write metadata */
+    iFormat = YAPP_FORMAT_FIL;
+    iRet = YAPP_WriteMetadata(acFileOut, iFormat, stYUM);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Writing metadata failed for file %s!\n",
+                       acFileOut);
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    /* open .fil file */
+    g_pFData = fopen(acFileOut, "a");
+    if (NULL == g_pFData)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Opening file %s failed! %s.\n",
+                       acFileOut,
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+
+    if ((stYUM.iNumPol > 1)
+        && (!cToSum))
+    {
+        /* open second .fil file */
+        (void) strcpy(acFileOut, pcFileOut);
+        (void) strcat(acFileOut, ".Y");
+        (void) strcat(acFileOut, EXT_FIL);
 
-        /*  open PSRFITS file */
-        (void) fits_open_file(&pstFileData, pcFileSpec, READONLY, &iStatus);
-        if  (iStatus != 0)
+        /* write metadata */
+        iRet = YAPP_WriteMetadata(acFileOut, iFormat, stYUM);
+        if (iRet != YAPP_RET_SUCCESS)
         {
-            fits_get_errstatus(iStatus, acErrMsg); 
             (void) fprintf(stderr,
-                           "ERROR: Opening file failed! %s\n",
-                           acErrMsg);
+                           "ERROR: Writing metadata failed for file "
+                           "%s!\n",
+                           acFileOut);
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
-        /* read SUBINT HDU header to get data parameters */
-        (void) fits_movnam_hdu(pstFileData,
-                               BINARY_TBL,
-                               YAPP_PF_HDUNAME_SUBINT,
-                               0,
-                               &iStatus);
-        if  (iStatus != 0)
+
+        g_pFDataSec = fopen(acFileOut, "a");
+        if (NULL == g_pFDataSec)
         {
-            fits_get_errstatus(iStatus, acErrMsg); 
             (void) fprintf(stderr,
-                           "ERROR: Moving to HDU %s failed! %s\n",
-                           YAPP_PF_HDUNAME_SUBINT,
-                           acErrMsg);
-            (void) fits_close_file(pstFileData, &iStatus);
+                           "ERROR: Opening file %s failed! %s.\n",
+                           acFileOut,
+                           strerror(errno));
             YAPP_CleanUp();
             return YAPP_RET_ERROR;
         }
-        /* NOTE: the number of rows may be different in the last file, so this
-                 needs to be read for every file */
-        (void) fits_read_key(pstFileData,
-                             TINT,
-                             YAPP_PF_LABEL_NSUBINT,
-                             &iNumSubInt,
-                             NULL,
-                             &iStatus);
-        if (cIsFirst)
-        {
-            (void) fits_read_key(pstFileData,
-                                 TINT,
-                                 YAPP_PF_LABEL_NSBLK,
-                                 &iSampsPerSubInt,
-                                 NULL,
-                                 &iStatus);
-            (void) fits_get_colnum(pstFileData,
-                                   CASESEN,
-                                   YAPP_PF_LABEL_DATA,
-                                   &iColNum,
-                                   &iStatus);
-            if (iStatus != 0)
+    }
+
+    /* use one thread per processor, but not more than there are subints */
+    if (0 == iNumThreads)
+    {
+        iNumThreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (iNumThreads < 1)
+        {
+            iNumThreads = 1;
+        }
+        else if (iNumThreads > YAPP_FITS2FIL_MAXTHREADS)
+        {
+            iNumThreads = YAPP_FITS2FIL_MAXTHREADS;
+        }
+    }
+    if (iNumThreads > pstJob->lNumSubInts)
+    {
+        iNumThreads = (int) pstJob->lNumSubInts;
+    }
+    /* CFITSIO can be called from multiple threads only if it was built to
+       be reentrant */
+    if ((iNumThreads > 1) && !fits_is_reentrant())
+    {
+        (void) printf("WARNING: CFITSIO is not reentrant, using one "
+                      "thread!\n");
+        iNumThreads = 1;
+    }
+
+    /* allocate the subint slots */
+    pstJob->iNumSlots = YAPP_FITS2FIL_SLOTSPERTHREAD * iNumThreads;
+    pstJob->pstSlots = (YAPP_FITS2FIL_SLOT *) YAPP_Malloc(
+                                                (size_t) pstJob->iNumSlots,
+                                                sizeof(YAPP_FITS2FIL_SLOT),
+                                                YAPP_TRUE);
+    if (NULL == pstJob->pstSlots)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        YAPP_CleanUp();
+        return YAPP_RET_ERROR;
+    }
+    for (i = 0; i < pstJob->iNumSlots; ++i)
+    {
+        pstSlot = &pstJob->pstSlots[i];
+        pstSlot->cState = YAPP_FITS2FIL_SLOT_FREE;
+        pstSlot->pvRaw = YAPP_Malloc((size_t) pstJob->lBytesPerSubInt,
+                                     sizeof(char),
+                                     YAPP_FALSE);
+        if (NULL == pstSlot->pvRaw)
+        {
+            (void) fprintf(stderr,
+                           "ERROR: Memory allocation failed! %s!\n",
+                           strerror(errno));
+            YAPP_CleanUp();
+            return YAPP_RET_ERROR;
+        }
+        if (cToScale)
+        {
+            pstSlot->pfScl = (float *) YAPP_Malloc(
+                                        (size_t) stYUM.iNumPol
+                                        * stYUM.iNumChans,
+                                        sizeof(float),
+                                        YAPP_FALSE);
+            pstSlot->pfOffs = (float *) YAPP_Malloc(
+                                        (size_t) stYUM.iNumPol
+                                        * stYUM.iNumChans,
+                                        sizeof(float),
+                                        YAPP_FALSE);
+            pstSlot->pfWts = (float *) YAPP_Malloc((size_t) stYUM.iNumChans,
+                                                   sizeof(float),
+                                                   YAPP_FALSE);
+            pstSlot->pfGain = (float *) YAPP_Malloc(
+                                        (size_t) stYUM.iNumPol
+                                        * stYUM.iNumChans,
+                                        sizeof(float),
+                                        YAPP_FALSE);
+            pstSlot->pfBias = (float *) YAPP_Malloc(
+                                        (size_t) stYUM.iNumPol
+                                        * stYUM.iNumChans,
+                                        sizeof(float),
+                                        YAPP_FALSE);
+            pstSlot->pfData = (float *) YAPP_Malloc((size_t) lElemsPerSubInt,
+                                                    sizeof(float),
+                                                    YAPP_FALSE);
+            if ((NULL == pstSlot->pfScl) || (NULL == pstSlot->pfOffs)
+                || (NULL == pstSlot->pfWts) || (NULL == pstSlot->pfGain)
+                || (NULL == pstSlot->pfBias) || (NULL == pstSlot->pfData))
             {
-                fits_get_errstatus(iStatus, acErrMsg); 
                 (void) fprintf(stderr,
-                               "ERROR: Getting column number failed! %s\n",
-                               acErrMsg);
-                (void) fits_close_file(pstFileData, &iStatus);
+                               "ERROR: Memory allocation failed! %s!\n",
+                               strerror(errno));
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
-
-            /* allocate memory for data array */
-            lBytesPerSubInt = (long int) stYUM.iNumPol * iSampsPerSubInt
-                              * stYUM.iNumChans
-                              * ((float) stYUM.iNumBits
-                                 / YAPP_BYTE2BIT_FACTOR);
-            g_pvBuf = YAPP_Malloc(lBytesPerSubInt, sizeof(char), YAPP_FALSE);
-            if (NULL == g_pvBuf)
+        }
+        if (cToSum)
+        {
+            pstSlot->pvPolSum = YAPP_Malloc((size_t) lBytesPerPol,
+                                            sizeof(char),
+                                            YAPP_FALSE);
+            if (NULL == pstSlot->pvPolSum)
             {
                 (void) fprintf(stderr,
                                "ERROR: Memory allocation failed! %s!\n",
                                strerror(errno));
-                (void) fits_close_file(pstFileData, &iStatus);
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
-
-            if (YAPP_MAX_NPOL == stYUM.iNumPol)
-            {
-                g_pvPolX = YAPP_Malloc((lBytesPerSubInt / 2),
-                                       sizeof(char),
-                                       YAPP_FALSE);
-                if (NULL == g_pvPolX)
-                {
-                    (void) fprintf(stderr,
-                                   "ERROR: Memory allocation failed! %s!\n",
-                                   strerror(errno));
-                    (void) fits_close_file(pstFileData, &iStatus);
-                    YAPP_CleanUp();
-                    return YAPP_RET_ERROR;
-                }
-                g_pvPolY = YAPP_Malloc((lBytesPerSubInt / 2),
-                                       sizeof(char),
-                                       YAPP_FALSE);
-                if (NULL == g_pvPolY)
-                {
-                    (void) fprintf(stderr,
-                                   "ERROR: Memory allocation failed! %s!\n",
-                                   strerror(errno));
-                    (void) fits_close_file(pstFileData, &iStatus);
-                    YAPP_CleanUp();
-                    return YAPP_RET_ERROR;
-                }
-                if (cToSum)
-                {
-                    g_pvPolSum = YAPP_Malloc((lBytesPerSubInt / 2),
-                                             sizeof(char),
-                                             YAPP_FALSE);
-                    if (NULL == g_pvPolSum)
-                    {
-                        (void) fprintf(stderr,
-                                       "ERROR: Memory allocation failed! "
-                                       "%s!\n",
-                                       strerror(errno));
-                        (void) fits_close_file(pstFileData, &iStatus);
-                        YAPP_CleanUp();
-                        return YAPP_RET_ERROR;
-                    }
-                }
-            }
-
-            /* open .fil file */
-            g_pFData = fopen(acFileOut, "a");
-            if (NULL == g_pFData)
+        }
+        else if ((stYUM.iNumPol > 1) || (pstJob->iOutBits != iDataBits))
+        {
+            pstSlot->pvPolX = YAPP_Malloc((size_t) lBytesPerPol,
+                                          sizeof(char),
+                                          YAPP_FALSE);
+            if (NULL == pstSlot->pvPolX)
             {
                 (void) fprintf(stderr,
-                               "ERROR: Opening file %s failed! %s.\n",
-                               acFileOut,
+                               "ERROR: Memory allocation failed! %s!\n",
                                strerror(errno));
-                (void) fits_close_file(pstFileData, &iStatus);
                 YAPP_CleanUp();
                 return YAPP_RET_ERROR;
             }
-
-            if ((YAPP_MAX_NPOL == stYUM.iNumPol)
-                && (!cToSum))
+            if (stYUM.iNumPol > 1)
             {
-                /* open second .fil file */
-                (void) strcpy(acFileOut, pcFileOut);
-                (void) strcat(acFileOut, ".Y");
-                (void) strcat(acFileOut, EXT_FIL);
-            
-                /* write metadata */
-                iRet = YAPP_WriteMetadata(acFileOut, iFormat, stYUM);
-                if (iRet != YAPP_RET_SUCCESS)
+                pstSlot->pvPolY = YAPP_Malloc((size_t) lBytesPerPol,
+                                              sizeof(char),
+                                              YAPP_FALSE);
+                if (NULL == pstSlot->pvPolY)
                 {
                     (void) fprintf(stderr,
-                                   "ERROR: Writing metadata failed for file "
+                                   "ERROR: Memory allocation failed! "
                                    "%s!\n",
-                                   acFileOut);
-                    YAPP_CleanUp();
-                    return YAPP_RET_ERROR;
-                }
-
-                g_pFDataSec = fopen(acFileOut, "a");
-                if (NULL == g_pFDataSec)
-                {
-                    (void) fprintf(stderr,
-                                   "ERROR: Opening file %s failed! %s.\n",
-                                   acFileOut,
                                    strerror(errno));
-                    (void) fits_close_file(pstFileData, &iStatus);
                     YAPP_CleanUp();
                     return YAPP_RET_ERROR;
                 }
             }
+        }
+    }
 
-            /* read data */
-            switch (stYUM.iNumBits)
-            {
-                case YAPP_SAMPSIZE_4:
-                    iDataType = TBYTE;
-                    /* update iSampsPerSubInt */
-                    iSampsPerSubInt /= 2;
-                    break;
-
-                case YAPP_SAMPSIZE_8:
-                    iDataType = TBYTE;
-                    break;
+    (void) printf("Converting %ld subints from %d file(s), using %d "
+                  "thread(s)...\n",
+                  pstJob->lNumSubInts,
+                  iNumFiles,
+                  iNumThreads);
 
-                case YAPP_SAMPSIZE_16:
-                    iDataType = TSHORT;
-                    break;
+    /* start the conversion threads */
+    iRet = StartWorkers(iNumThreads);
+    if (iRet != YAPP_RET_SUCCESS)
+    {
+        CleanUp();
+        return YAPP_RET_ERROR;
+    }
 
-                case YAPP_SAMPSIZE_32:
-                    iDataType = TLONG;
-                    break;
+    /* write the subints in order, as they become ready */
+    for (lSubInt = 0; lSubInt < pstJob->lNumSubInts; ++lSubInt)
+    {
+        if ((iNumFiles > 1)
+            && (lSubInt == pstJob->plFirstSubInt[iFile+1]))
+        {
+            ++iFile;
+            (void) printf("\rProcessing file %s.", argv[optind+iFile]);
+            (void) fflush(stdout);
+        }
 
-                default:
-                    (void) fprintf(stderr,
-                                   "ERROR: Unexpected number of bits!\n");
-                    (void) fits_close_file(pstFileData, &iStatus);
-                    YAPP_CleanUp();
-                    return YAPP_RET_ERROR;
-            }
+        pstSlot = &pstJob->pstSlots[lSubInt % pstJob->iNumSlots];
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        while ((pstSlot->cState != YAPP_FITS2FIL_SLOT_DONE)
+               || (pstSlot->lSubInt != lSubInt))
+        {
+            (void) pthread_cond_wait(&pstJob->stCond, &pstJob->stMutex);
         }
-        for (i = 1; i <= iNumSubInt; ++i)
-        {
-            (void) fits_read_col(pstFileData,
-                                 iDataType,
-                                 iColNum,
-                                 i,
-                                 1,
-                                 ((long int) stYUM.iNumPol * stYUM.iNumChans 
-                                  * iSampsPerSubInt),
-                                 NULL,
-                                 g_pvBuf,
-                                 NULL,
-                                 &iStatus);
-            if (iStatus != 0)
-            {
-                fits_get_errstatus(iStatus, acErrMsg); 
-                (void) fprintf(stderr,
-                               "ERROR: Getting column number failed! %s\n",
-                               acErrMsg);
-                (void) fits_close_file(pstFileData, &iStatus);
-                YAPP_CleanUp();
-                return YAPP_RET_ERROR;
-            }
-            if (YAPP_MAX_NPOL == stYUM.iNumPol)
-            {
-                (void) YAPP_WritePolSelection(stYUM.iNumBits,
-                                              lBytesPerSubInt,
-                                              cToSum);
-            }
-            else
-            {
-                (void) fwrite(g_pvBuf,
-                              sizeof(char),
-                              lBytesPerSubInt,
-                              g_pFData);
-            }
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+        if (pstSlot->iRet != YAPP_RET_SUCCESS)
+        {
+            (void) fprintf(stderr, "ERROR: Converting subint %ld failed!\n",
+                           lSubInt);
+            CleanUp();
+            return YAPP_RET_ERROR;
         }
 
-        (void) fits_close_file(pstFileData, &iStatus);
-        cIsFirst = YAPP_FALSE;
-        ++iNextOpt;
+        (void) fwrite(pstSlot->pvOut,
+                      sizeof(char),
+                      pstSlot->lOutLen,
+                      g_pFData);
+        if (pstSlot->pvOutSec != NULL)
+        {
+            (void) fwrite(pstSlot->pvOutSec,
+                          sizeof(char),
+                          pstSlot->lOutLen,
+                          g_pFDataSec);
+        }
+
+        /* hand the slot back to the threads */
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        pstSlot->cState = YAPP_FITS2FIL_SLOT_FREE;
+        (void) pthread_cond_broadcast(&pstJob->stCond);
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
     }
 
     (void) printf("\n");
 
     /* clean up */
-    YAPP_CleanUp();
+    CleanUp();
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Conversion thread
+ */
+void* YAPP_FITS2FIL_ConvertSubInts(void *pvWorker)
+{
+    YAPP_FITS2FIL_WORKER *pstWorker = (YAPP_FITS2FIL_WORKER *) pvWorker;
+    YAPP_FITS2FIL_JOB *pstJob = pstWorker->pstJob;
+    YAPP_FITS2FIL_SLOT *pstSlot = NULL;
+    long int lSubInt = 0;
+    int iStatus = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    while (YAPP_TRUE)
+    {
+        /* claim the next subint, once its slot has been written out */
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        while ((!pstJob->cStop)
+               && (pstJob->lNextSubInt < pstJob->lNumSubInts)
+               && (pstJob->pstSlots[pstJob->lNextSubInt
+                                    % pstJob->iNumSlots].cState
+                   != YAPP_FITS2FIL_SLOT_FREE))
+        {
+            (void) pthread_cond_wait(&pstJob->stCond, &pstJob->stMutex);
+        }
+        if ((pstJob->cStop) || (pstJob->lNextSubInt >= pstJob->lNumSubInts))
+        {
+            (void) pthread_mutex_unlock(&pstJob->stMutex);
+            break;
+        }
+        lSubInt = pstJob->lNextSubInt;
+        ++(pstJob->lNextSubInt);
+        pstSlot = &pstJob->pstSlots[lSubInt % pstJob->iNumSlots];
+        pstSlot->lSubInt = lSubInt;
+        pstSlot->cState = YAPP_FITS2FIL_SLOT_BUSY;
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+
+        iRet = YAPP_FITS2FIL_ReadSubInt(pstWorker, pstSlot);
+
+        (void) pthread_mutex_lock(&pstJob->stMutex);
+        pstSlot->iRet = iRet;
+        pstSlot->cState = YAPP_FITS2FIL_SLOT_DONE;
+        (void) pthread_cond_broadcast(&pstJob->stCond);
+        (void) pthread_mutex_unlock(&pstJob->stMutex);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    if (pstWorker->pstFile != NULL)
+    {
+        (void) fits_close_file(pstWorker->pstFile, &iStatus);
+        pstWorker->pstFile = NULL;
+        pstWorker->iFile = -1;
+    }
+
+    return NULL;
+}
+
+
+/*
+ * Read a subint into a slot, and scale and split it
+ */
+int YAPP_FITS2FIL_ReadSubInt(YAPP_FITS2FIL_WORKER *pstWorker,
+                             YAPP_FITS2FIL_SLOT *pstSlot)
+{
+    YAPP_FITS2FIL_JOB *pstJob = pstWorker->pstJob;
+    char acErrMsg[LEN_GENSTRING] = {0};
+    int iStatus = 0;
+    int iFile = 0;
+    long int lRow = 0;
+    void *pvData = NULL;
+    int iNumBits = pstJob->iNumBits;
+    long int lSampsPerPol = 0;
+    int iRet = YAPP_RET_SUCCESS;
+
+    /* find the file and row of the subint */
+    while (pstSlot->lSubInt >= pstJob->plFirstSubInt[iFile+1])
+    {
+        ++iFile;
+    }
+    lRow = pstSlot->lSubInt - pstJob->plFirstSubInt[iFile] + 1;
+
+    if (iFile != pstWorker->iFile)
+    {
+        if (pstWorker->pstFile != NULL)
+        {
+            (void) fits_close_file(pstWorker->pstFile, &iStatus);
+            pstWorker->pstFile = NULL;
+            pstWorker->iFile = -1;
+        }
+
+        iRet = YAPP_PF_OpenSubInts(pstJob->ppcFiles[iFile],
+                                   &pstWorker->pstFile,
+                                   &pstWorker->stCols);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            return YAPP_RET_ERROR;
+        }
+        pstWorker->iFile = iFile;
+    }
+
+    /* read data */
+    (void) fits_read_col(pstWorker->pstFile,
+                         pstJob->iDataType,
+                         pstWorker->stCols.iColData,
+                         lRow,
+                         1,
+                         pstJob->lElemsPerSubInt,
+                         NULL,
+                         pstSlot->pvRaw,
+                         NULL,
+                         &iStatus);
+    if (iStatus != 0)
+    {
+        fits_get_errstatus(iStatus, acErrMsg);
+        (void) fprintf(stderr,
+                       "ERROR: Reading subint %ld of file %s failed! %s\n",
+                       lRow,
+                       pstJob->ppcFiles[iFile],
+                       acErrMsg);
+        return YAPP_RET_ERROR;
+    }
+
+    pvData = pstSlot->pvRaw;
+    if (pstJob->cToScale)
+    {
+        iRet = YAPP_PF_ReadScales(pstWorker->pstFile,
+                                  &pstWorker->stCols,
+                                  lRow,
+                                  pstJob->iNumPol,
+                                  pstJob->iNumChans,
+                                  pstSlot->pfScl,
+                                  pstSlot->pfOffs,
+                                  pstSlot->pfWts);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            return YAPP_RET_ERROR;
+        }
+        YAPP_PF_MakeGains(pstSlot->pfScl,
+                          pstSlot->pfOffs,
+                          pstSlot->pfWts,
+                          pstWorker->stCols.fZeroOff,
+                          pstJob->iNumPol,
+                          pstJob->iNumChans,
+                          pstSlot->pfGain,
+                          pstSlot->pfBias);
+        YAPP_PF_Scale(pstSlot->pvRaw,
+                      pstJob->iNumBits,
+                      (long int) pstJob->iNumPol * pstJob->iNumChans
+                      * pstJob->iSampsPerSubInt,
+                      pstJob->iNumPol * pstJob->iNumChans,
+                      pstSlot->pfGain,
+                      pstSlot->pfBias,
+                      pstSlot->pfData);
+        pvData = pstSlot->pfData;
+        iNumBits = YAPP_SAMPSIZE_32;
+    }
+
+    lSampsPerPol = (long int) pstJob->iNumChans * pstJob->iSampsPerSubInt;
+    pstSlot->lOutLen = (long int) (lSampsPerPol
+                                   * ((float) pstJob->iOutBits
+                                      / YAPP_BYTE2BIT_FACTOR));
+    if ((1 == pstJob->iNumPol) && (iNumBits == pstJob->iOutBits))
+    {
+        pstSlot->pvOut = pvData;
+        pstSlot->pvOutSec = NULL;
+    }
+    else
+    {
+        iRet = YAPP_SelectPols(iNumBits,
+                               pstJob->iNumPol,
+                               pstJob->iNumChans,
+                               lSampsPerPol,
+                               pstJob->cToSum,
+                               pvData,
+                               pstSlot->pvPolX,
+                               pstSlot->pvPolY,
+                               pstSlot->pvPolSum);
+        if (iRet != YAPP_RET_SUCCESS)
+        {
+            return YAPP_RET_ERROR;
+        }
+        if (pstJob->cToSum)
+        {
+            pstSlot->pvOut = pstSlot->pvPolSum;
+            pstSlot->pvOutSec = NULL;
+        }
+        else
+        {
+            pstSlot->pvOut = pstSlot->pvPolX;
+            pstSlot->pvOutSec = pstSlot->pvPolY;
+        }
+    }
 
     return YAPP_RET_SUCCESS;
 }
 
 
 /*
- * Write the selected polarization output format to file
+ * Unpack sub-byte samples to one byte each - the first of the samples in a
+ * byte is in the least significant bits
  */
-int YAPP_WritePolSelection(int iNumBits, long int lLen, char cToSum)
+static inline void UnpackSamps(const unsigned char *pcIn,
+                               int iNumBits,
+                               long int lNumSamps,
+                               unsigned char *pcOut)
 {
+    int iPerByte = YAPP_BYTE2BIT_FACTOR / iNumBits;
+    unsigned char cMask = (unsigned char) ((1 << iNumBits) - 1);
     long int i = 0;
-    long int j = 0;
-    long int lNumSamps = 0;
+    int k = 0;
+
+    for (i = 0; i < (lNumSamps / iPerByte); ++i)
+    {
+        for (k = 0; k < iPerByte; ++k)
+        {
+            pcOut[(i*iPerByte)+k] = (pcIn[i] >> (k * iNumBits)) & cMask;
+        }
+    }
+
+    return;
+}
 
-    lNumSamps = (int) ((float) lLen
-                       / ((float) iNumBits / YAPP_BYTE2BIT_FACTOR));
+
+/*
+ * Split or sum a run of samples of the first two polarizations. The runs are
+ * contiguous, so the loops have unit stride and no branches or dependencies
+ * between iterations, and the compiler can vectorise them. Sums are written
+ * at a larger sample size than the input, so that they cannot overflow - 8
+ * bits for sub-byte samples, 16 bits for 8-bit samples, and 32-bit
+ * floating-point for 16- and 32-bit samples. Sub-byte samples are unpacked
+ * before the call.
+ */
+static inline void SelectRun(int iNumBits,
+                             long int lNumSamps,
+                             char cToSum,
+                             const void *pvX,
+                             const void *pvY,
+                             void *pvPolX,
+                             void *pvPolY,
+                             void *pvPolSum)
+{
+    long int i = 0;
 
     switch (iNumBits)
     {
+        case YAPP_SAMPSIZE_1:
+        case YAPP_SAMPSIZE_2:
         case YAPP_SAMPSIZE_4:
         {
-            unsigned char *pcBuf = (unsigned char *) g_pvBuf;
-            unsigned char *pcPolX = (unsigned char *) g_pvPolX;
-            unsigned char *pcPolY = (unsigned char *) g_pvPolY;
-            unsigned char *pcPolSum = (unsigned char *) g_pvPolSum;
-            j = 0;
-            for (i = 0; i < lNumSamps; i += 2)
+            const unsigned char *pcX = (const unsigned char *) pvX;
+            const unsigned char *pcY = (const unsigned char *) pvY;
+            unsigned char *pcPolX = (unsigned char *) pvPolX;
+            unsigned char *pcPolY = (unsigned char *) pvPolY;
+            unsigned char *pcPolSum = (unsigned char *) pvPolSum;
+            if (cToSum)
             {
-                pcPolX[j] = pcBuf[i] & 0x0F;
-                pcPolY[j] = (pcBuf[i] & 0xF0) >> 4;
-                pcPolX[j] |= ((pcBuf[i+1] & 0x0F) << 4);
-                pcPolY[j] |= (pcBuf[i+1] & 0xF0);
-                if (cToSum)
+                for (i = 0; i < lNumSamps; ++i)
                 {
-                    /* NOTE: the assumption is that there are no overflows */
-                    pcPolSum[j] = pcPolX[j] + pcPolY[j];
+                    pcPolSum[i] = pcX[i] + pcY[i];
+                }
+            }
+            else if (YAPP_SAMPSIZE_4 == iNumBits)
+            {
+                /* repack, two samples to a byte */
+                for (i = 0; i < (lNumSamps / 2); ++i)
+                {
+                    pcPolX[i] = pcX[2*i] | (pcX[(2*i)+1] << 4);
+                }
+                if (pcY != NULL)
+                {
+                    for (i = 0; i < (lNumSamps / 2); ++i)
+                    {
+                        pcPolY[i] = pcY[2*i] | (pcY[(2*i)+1] << 4);
+                    }
+                }
+            }
+            else
+            {
+                (void) memcpy(pcPolX, pcX, lNumSamps);
+                if (pcY != NULL)
+                {
+                    (void) memcpy(pcPolY, pcY, lNumSamps);
                 }
-                ++j;
             }
             break;
         }
 
         case YAPP_SAMPSIZE_8:
         {
-            char *pcBuf = (char *) g_pvBuf;
-            char *pcPolX = (char *) g_pvPolX;
-            char *pcPolY = (char *) g_pvPolY;
-            char *pcPolSum = (char *) g_pvPolSum;
-            j = 0;
-            for (i = 0; i < lNumSamps; i += 2)
+            /* PSRFITS 8-bit samples are unsigned */
+            const unsigned char *pcX = (const unsigned char *) pvX;
+            const unsigned char *pcY = (const unsigned char *) pvY;
+            short int *psPolSum = (short int *) pvPolSum;
+            if (cToSum)
+            {
+                for (i = 0; i < lNumSamps; ++i)
+                {
+                    psPolSum[i] = (short int) pcX[i] + (short int) pcY[i];
+                }
+            }
+            else
             {
-                pcPolX[j] = pcBuf[i];
-                pcPolY[j] = pcBuf[i+1];
-                if (cToSum)
+                (void) memcpy(pvPolX, pcX, lNumSamps);
+                if (pcY != NULL)
                 {
-                    pcPolSum[j] = pcPolX[j] + pcPolY[j];
+                    (void) memcpy(pvPolY, pcY, lNumSamps);
                 }
-                ++j;
             }
             break;
         }
 
         case YAPP_SAMPSIZE_16:
         {
-            short int *psBuf = (short int *) g_pvBuf;
-            short int *psPolX = (short int *) g_pvPolX;
-            short int *psPolY = (short int *) g_pvPolY;
-            short int *psPolSum = (short int *) g_pvPolSum;
-            j = 0;
-            for (i = 0; i < lNumSamps; i += 2)
+            const short int *psX = (const short int *) pvX;
+            const short int *psY = (const short int *) pvY;
+            float *pfPolSum = (float *) pvPolSum;
+            if (cToSum)
             {
-                psPolX[j] = psBuf[i];
-                psPolY[j] = psBuf[i+1];
-                if (cToSum)
+                for (i = 0; i < lNumSamps; ++i)
                 {
-                    psPolSum[j] = psPolX[j] + psPolY[j];
+                    pfPolSum[i] = (float) psX[i] + (float) psY[i];
+                }
+            }
+            else
+            {
+                (void) memcpy(pvPolX, psX, sizeof(short int) * lNumSamps);
+                if (psY != NULL)
+                {
+                    (void) memcpy(pvPolY, psY, sizeof(short int) * lNumSamps);
                 }
-                ++j;
             }
             break;
         }
 
         case YAPP_SAMPSIZE_32:
         {
-            int *piBuf = (int *) g_pvBuf;
-            int *piPolX = (int *) g_pvPolX;
-            int *piPolY = (int *) g_pvPolY;
-            int *piPolSum = (int *) g_pvPolSum;
-            j = 0;
-            for (i = 0; i < lNumSamps; i += 2)
+            const float *pfX = (const float *) pvX;
+            const float *pfY = (const float *) pvY;
+            float *pfPolSum = (float *) pvPolSum;
+            if (cToSum)
             {
-                piPolX[j] = piBuf[i];
-                piPolY[j] = piBuf[i+1];
-                if (cToSum)
+                for (i = 0; i < lNumSamps; ++i)
                 {
-                    piPolSum[j] = piPolX[j] + piPolY[j];
+                    pfPolSum[i] = pfX[i] + pfY[i];
+                }
+            }
+            else
+            {
+                (void) memcpy(pvPolX, pfX, sizeof(float) * lNumSamps);
+                if (pfY != NULL)
+                {
+                    (void) memcpy(pvPolY, pfY, sizeof(float) * lNumSamps);
                 }
-                ++j;
             }
             break;
         }
 
         default:
+            assert(0);
+    }
+
+    return;
+}
+
+
+/*
+ * Split or sum the first two polarizations of each time sample, which holds
+ * all the channels of one polarization, then those of the next. Sub-byte
+ * samples are unpacked a chunk at a time.
+ */
+static void SelectSpectra(int iNumBits,
+                          int iNumPol,
+                          int iNumChans,
+                          long int lNumSamps,
+                          char cToSum,
+                          const void *pvBuf,
+                          void *pvPolX,
+                          void *pvPolY,
+                          void *pvPolSum)
+{
+    unsigned char acUnpacked[YAPP_FITS2FIL_CHUNK];
+    const char *pcBuf = (const char *) pvBuf;
+    /* half of the unpacking buffer for each polarization, a whole number of
+       bytes of output */
+    long int lChunkLen = YAPP_FITS2FIL_CHUNK / 2;
+    long int lNumSpectra = lNumSamps / iNumChans;
+    int iOutBits = YAPP_FITS2FIL_GetOutBits(iNumBits, cToSum);
+    const void *pvX = NULL;
+    const void *pvY = NULL;
+    long int lIn = 0;
+    long int lOutOff = 0;
+    long int lLen = 0;
+    long int j = 0;
+    long int i = 0;
+
+    for (j = 0; j < lNumSpectra; ++j)
+    {
+        for (i = 0; i < iNumChans; i += lChunkLen)
+        {
+            lLen = lChunkLen;
+            if (lLen > (iNumChans - i))
+            {
+                lLen = iNumChans - i;
+            }
+            /* sample index of the run of the first polarization */
+            lIn = (j * iNumPol * iNumChans) + i;
+            pvX = pcBuf + ((lIn * iNumBits) / YAPP_BYTE2BIT_FACTOR);
+            pvY = NULL;
+            if (iNumPol > 1)
+            {
+                pvY = pcBuf + (((lIn + iNumChans) * iNumBits)
+                               / YAPP_BYTE2BIT_FACTOR);
+            }
+            if (iNumBits < YAPP_SAMPSIZE_8)
+            {
+                UnpackSamps((const unsigned char *) pvX,
+                            iNumBits,
+                            lLen,
+                            acUnpacked);
+                pvX = acUnpacked;
+                if (pvY != NULL)
+                {
+                    UnpackSamps((const unsigned char *) pvY,
+                                iNumBits,
+                                lLen,
+                                acUnpacked + lChunkLen);
+                    pvY = acUnpacked + lChunkLen;
+                }
+            }
+            lOutOff = (((j * iNumChans) + i) * iOutBits)
+                      / YAPP_BYTE2BIT_FACTOR;
+            SelectRun(iNumBits,
+                      lLen,
+                      cToSum,
+                      pvX,
+                      pvY,
+                      (NULL == pvPolX) ? NULL : (char *) pvPolX + lOutOff,
+                      (NULL == pvPolY) ? NULL : (char *) pvPolY + lOutOff,
+                      (NULL == pvPolSum) ? NULL : (char *) pvPolSum + lOutOff);
+        }
+    }
+
+    return;
+}
+
+
+/*
+ * Split multi-polarization data into the first two polarizations, or sum
+ * them
+ */
+int YAPP_SelectPols(int iNumBits,
+                    int iNumPol,
+                    int iNumChans,
+                    long int lNumSamps,
+                    char cToSum,
+                    const void *pvBuf,
+                    void *pvPolX,
+                    void *pvPolY,
+                    void *pvPolSum)
+{
+    if (!((YAPP_SAMPSIZE_1 == iNumBits)
+          || (YAPP_SAMPSIZE_2 == iNumBits)
+          || (YAPP_SAMPSIZE_4 == iNumBits)
+          || (YAPP_SAMPSIZE_8 == iNumBits)
+          || (YAPP_SAMPSIZE_16 == iNumBits)
+          || (YAPP_SAMPSIZE_32 == iNumBits)))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Unexpected number of bits!\n");
+        return YAPP_RET_ERROR;
+    }
+    if ((iNumPol != 1) && (iNumPol != 2) && (iNumPol != 4))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Unsupported number of polarizations!\n");
+        return YAPP_RET_ERROR;
+    }
+    /* the channels of each polarization start on a byte, and, for 4-bit
+       output, fill whole bytes */
+    if ((((long int) iNumChans * iNumBits) % YAPP_BYTE2BIT_FACTOR != 0)
+        || ((YAPP_SAMPSIZE_4 == iNumBits) && (iNumChans % 2 != 0)))
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Unsupported number of channels %d for "
+                       "%d-bit data!\n",
+                       iNumChans,
+                       iNumBits);
+        return YAPP_RET_ERROR;
+    }
+    if (1 == iNumPol)
+    {
+        cToSum = YAPP_FALSE;
+        pvPolY = NULL;
+        pvPolSum = NULL;
+    }
+
+    SelectSpectra(iNumBits,
+                  iNumPol,
+                  iNumChans,
+                  lNumSamps,
+                  cToSum,
+                  pvBuf,
+                  pvPolX,
+                  pvPolY,
+                  pvPolSum);
+
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Get the sample size of the output - sub-byte samples other than 4-bit
+ * are written one to a byte, and sums at a larger sample size than the
+ * input
+ */
+int YAPP_FITS2FIL_GetOutBits(int iNumBits, char cToSum)
+{
+    if (cToSum)
+    {
+        switch (iNumBits)
+        {
+            case YAPP_SAMPSIZE_1:
+            case YAPP_SAMPSIZE_2:
+            case YAPP_SAMPSIZE_4:
+                return YAPP_SAMPSIZE_8;
+
+            case YAPP_SAMPSIZE_8:
+                return YAPP_SAMPSIZE_16;
+
+            default:
+                return YAPP_SAMPSIZE_32;
+        }
+    }
+
+    if (iNumBits < YAPP_SAMPSIZE_4)
+    {
+        return YAPP_SAMPSIZE_8;
+    }
+
+    return iNumBits;
+}
+
+
+/*
+ * Start the conversion threads
+ */
+static int StartWorkers(int iNumThreads)
+{
+    YAPP_FITS2FIL_JOB *pstJob = &g_stJob;
+    int iRet = 0;
+    int i = 0;
+
+    g_pstWorkers = (YAPP_FITS2FIL_WORKER *) YAPP_Malloc(
+                                                (size_t) iNumThreads,
+                                                sizeof(YAPP_FITS2FIL_WORKER),
+                                                YAPP_TRUE);
+    if (NULL == g_pstWorkers)
+    {
+        (void) fprintf(stderr,
+                       "ERROR: Memory allocation failed! %s!\n",
+                       strerror(errno));
+        return YAPP_RET_ERROR;
+    }
+
+    (void) pthread_mutex_init(&pstJob->stMutex, NULL);
+    (void) pthread_cond_init(&pstJob->stCond, NULL);
+    for (i = 0; i < iNumThreads; ++i)
+    {
+        g_pstWorkers[i].pstJob = pstJob;
+        g_pstWorkers[i].iFile = -1;
+        iRet = pthread_create(&g_pstWorkers[i].stThread,
+                              NULL,
+                              YAPP_FITS2FIL_ConvertSubInts,
+                              (void *) &g_pstWorkers[i]);
+        if (iRet != 0)
         {
             (void) fprintf(stderr,
-                           "ERROR: Unexpected number of bits!\n");
+                           "ERROR: Creating thread failed! %s!\n",
+                           strerror(iRet));
             return YAPP_RET_ERROR;
         }
+        ++g_iNumWorkers;
     }
 
-    if (!cToSum)
+    return YAPP_RET_SUCCESS;
+}
+
+
+/*
+ * Stop the conversion threads
+ */
+static void StopWorkers()
+{
+    YAPP_FITS2FIL_JOB *pstJob = &g_stJob;
+    int i = 0;
+
+    if (NULL == g_pstWorkers)
     {
-        (void) fwrite(g_pvPolX,
-                      sizeof(char),
-                      (lLen / 2),
-                      g_pFData);
-        (void) fwrite(g_pvPolY,
-                      sizeof(char),
-                      (lLen / 2),
-                      g_pFDataSec);
+        return;
     }
-    else
+
+    (void) pthread_mutex_lock(&pstJob->stMutex);
+    pstJob->cStop = YAPP_TRUE;
+    (void) pthread_cond_broadcast(&pstJob->stCond);
+    (void) pthread_mutex_unlock(&pstJob->stMutex);
+    for (i = 0; i < g_iNumWorkers; ++i)
     {
-        (void) fwrite(g_pvPolSum,
-                      sizeof(char),
-                      (lLen / 2),
-                      g_pFData);
+        (void) pthread_join(g_pstWorkers[i].stThread, NULL);
     }
+    g_iNumWorkers = 0;
+    (void) pthread_cond_destroy(&pstJob->stCond);
+    (void) pthread_mutex_destroy(&pstJob->stMutex);
+    g_pstWorkers = NULL;
 
-    return YAPP_RET_SUCCESS;
+    return;
+}
+
+
+/*
+ * Stop the conversion threads, if running, and clean up
+ */
+static void CleanUp()
+{
+    StopWorkers();
+    YAPP_CleanUp();
+
+    return;
 }
 
 
@@ -587,9 +1223,20 @@ void PrintUsage(const char *pcProgName)
     (void) printf("Sum polarizations in the case of\n");
     (void) printf("                                         ");
     (void) printf("dual-polarization data\n");
+    (void) printf("    -j  --threads <numthreads>           ");
+    (void) printf("Number of conversion threads\n");
+    (void) printf("                                         ");
+    (void) printf("(default is the number of\n");
+    (void) printf("                                         ");
+    (void) printf("processors)\n");
+    (void) printf("    -r  --raw                            ");
+    (void) printf("Write the raw samples, without\n");
+    (void) printf("                                         ");
+    (void) printf("applying DAT_SCL, DAT_OFFS and\n");
+    (void) printf("                                         ");
+    (void) printf("DAT_WTS\n");
     (void) printf("    -v  --version                        ");
     (void) printf("Display the version\n");
 
     return;
 }
-
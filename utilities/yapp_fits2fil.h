@@ -9,9 +9,145 @@
 #ifndef __YAPP_FITS2FIL_H__
 #define __YAPP_FITS2FIL_H__
 
-#define YAPP_MAX_NPOL           2
+#include <pthread.h>
+#include <fitsio.h>
 
-int YAPP_WritePolSelection(int iNumBits, long int lLen, char cToSum);
+#define YAPP_MAX_NPOL           4
 
-#endif  /* __YAPP_FITS2FIL_H__ */
+#define YAPP_FITS2FIL_CHUNK     8192    /* number of samples split or summed
+                                           at a time - small enough for a
+                                           chunk to stay in the L1 cache */
+
+#define YAPP_FITS2FIL_MAXTHREADS    16  /* maximum number of conversion
+                                           threads */
+#define YAPP_FITS2FIL_SLOTSPERTHREAD 2  /* number of subints in flight per
+                                           thread */
+
+/* subint slot states */
+#define YAPP_FITS2FIL_SLOT_FREE     0   /* available to a thread */
+#define YAPP_FITS2FIL_SLOT_BUSY     1   /* being read and scaled */
+#define YAPP_FITS2FIL_SLOT_DONE     2   /* ready to be written */
+
+/**
+ * A subint in flight - read and scaled by a thread, and written by the main
+ * thread
+ */
+typedef struct tagFits2FilSlot
+{
+    long int lSubInt;           /* subint, counted across all files */
+    char cState;
+    int iRet;
+    void *pvRaw;                /* DATA of the subint */
+    float *pfScl;               /* DAT_SCL, iNumPol * iNumChans */
+    float *pfOffs;              /* DAT_OFFS, iNumPol * iNumChans */
+    float *pfWts;               /* DAT_WTS, iNumChans */
+    float *pfGain;              /* combined scale and weight of each sample
+                                   in a spectrum */
+    float *pfBias;              /* combined offset and weight of each sample
+                                   in a spectrum */
+    float *pfData;              /* scaled data */
+    void *pvPolX;
+    void *pvPolY;
+    void *pvPolSum;
+    void *pvOut;                /* data to be written to the first file */
+    void *pvOutSec;             /* data to be written to the second file, or
+                                   NULL */
+    long int lOutLen;           /* length of each output, in bytes */
+} YAPP_FITS2FIL_SLOT;
 
+/**
+ * Conversion job, shared by the threads
+ */
+typedef struct tagFits2FilJob
+{
+    char **ppcFiles;
+    int iNumFiles;
+    long int *plFirstSubInt;    /* first subint of each file, counted across
+                                   all files, with an extra entry for the
+                                   total */
+    long int lNumSubInts;
+    int iNumBits;
+    int iNumPol;
+    int iNumChans;
+    int iSampsPerSubInt;
+    int iDataType;              /* CFITSIO type of DATA */
+    long int lElemsPerSubInt;   /* number of elements of DATA read per
+                                   subint */
+    long int lBytesPerSubInt;
+    char cToSum;
+    char cToScale;
+    int iOutBits;               /* sample size of the output */
+    YAPP_FITS2FIL_SLOT *pstSlots;
+    int iNumSlots;
+    pthread_mutex_t stMutex;    /* protects the fields below, and the slot
+                                   states */
+    pthread_cond_t stCond;      /* signalled when a slot changes state */
+    long int lNextSubInt;       /* next subint to be read */
+    char cStop;                 /* set to stop the threads */
+} YAPP_FITS2FIL_JOB;
+
+/**
+ * Per-thread state - each thread opens the files independently
+ */
+typedef struct tagFits2FilWorker
+{
+    YAPP_FITS2FIL_JOB *pstJob;
+    fitsfile *pstFile;
+    int iFile;                  /* open file, or -1 */
+    YAPP_PF_COLS stCols;
+    pthread_t stThread;
+} YAPP_FITS2FIL_WORKER;
+
+/**
+ * Conversion thread - reads, scales and splits subints in order, into the
+ * free slots, until all subints have been claimed
+ *
+ * @param[in]       pvWorker        Pointer to a YAPP_FITS2FIL_WORKER
+ */
+void* YAPP_FITS2FIL_ConvertSubInts(void *pvWorker);
+
+/**
+ * Read a subint into a slot, and scale and split it
+ *
+ * @param[inout]    pstWorker       Thread state
+ * @param[inout]    pstSlot         Slot, with lSubInt set
+ */
+int YAPP_FITS2FIL_ReadSubInt(YAPP_FITS2FIL_WORKER *pstWorker,
+                             YAPP_FITS2FIL_SLOT *pstSlot);
+
+/**
+ * Split multi-polarization data into the first two polarizations, or sum
+ * them. As in PSRFITS DATA, each time sample holds all the channels of one
+ * polarization, then those of the next. Sub-byte samples are unpacked, and,
+ * except for 4-bit samples, written one to a byte; sums are written at a
+ * larger sample size than the input (see YAPP_FITS2FIL_GetOutBits()).
+ *
+ * @param[in]       iNumBits        Number of bits per sample
+ * @param[in]       iNumPol         Number of polarizations - 1, 2 or 4
+ * @param[in]       iNumChans       Number of channels
+ * @param[in]       lNumSamps       Number of samples of each polarization
+ * @param[in]       cToSum          Flag to sum the polarizations
+ * @param[in]       pvBuf           Input
+ * @param[out]      pvPolX          First polarization
+ * @param[out]      pvPolY          Second polarization
+ * @param[out]      pvPolSum        Sum, if cToSum is set
+ */
+int YAPP_SelectPols(int iNumBits,
+                    int iNumPol,
+                    int iNumChans,
+                    long int lNumSamps,
+                    char cToSum,
+                    const void *pvBuf,
+                    void *pvPolX,
+                    void *pvPolY,
+                    void *pvPolSum);
+
+/**
+ * Get the sample size of the output, for a given input sample size
+ *
+ * @param[in]       iNumBits        Number of bits per input sample
+ * @param[in]       cToSum          Flag to sum the polarizations
+ */
+int YAPP_FITS2FIL_GetOutBits(int iNumBits, char cToSum);
+
+#endif  /* __YAPP_FITS2FIL_H__ */